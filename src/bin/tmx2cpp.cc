@@ -0,0 +1,87 @@
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include <tmx/Map.h>
+
+namespace fs = boost::filesystem;
+
+static std::string makeIdentifier(const std::string& str) {
+  std::string identifier;
+
+  for (char c : str) {
+    identifier += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+  }
+
+  if (identifier.empty() || std::isdigit(static_cast<unsigned char>(identifier[0]))) {
+    identifier.insert(0, "map_");
+  }
+
+  return identifier;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 3 && argc != 4) {
+    std::printf("Usage: tmx2cpp <file.tmx> <file.h> [name]\n");
+    return EXIT_FAILURE;
+  }
+
+  fs::path input(argv[1]);
+  fs::path output(argv[2]);
+  std::string name = makeIdentifier(argc == 4 ? argv[3] : input.stem().string());
+
+  auto map = tmx::Map::parseFile(input);
+
+  if (!map) {
+    return EXIT_FAILURE;
+  }
+
+  std::vector<char> data = tmx::CompiledMap::compile(*map);
+
+  std::ofstream out(output.string().c_str());
+
+  if (!out) {
+    std::printf("Could not open '%s'. Exiting.\n", output.string().c_str());
+    return EXIT_FAILURE;
+  }
+
+  std::string guard = "TMX2CPP_" + makeIdentifier(output.filename().string());
+
+  for (auto& c : guard) {
+    c = std::toupper(static_cast<unsigned char>(c));
+  }
+
+  out << "// Generated by tmx2cpp from " << input.filename().string() << ", do not edit.\n";
+  out << "#ifndef " << guard << '\n';
+  out << "#define " << guard << "\n\n";
+  out << "#include <memory>\n\n";
+  out << "#include <tmx/CompiledMap.h>\n\n";
+  out << "// The data has the byte order of the machine that generated this file.\n";
+  out << "inline const tmx::CompiledMap& " << name << "() {\n";
+  out << "  alignas(8) static constexpr unsigned char data[" << data.size() << "] = {";
+
+  for (std::size_t i = 0; i < data.size(); ++i) {
+    if (i % 16 == 0) {
+      out << "\n   ";
+    }
+
+    out << ' ' << static_cast<unsigned>(static_cast<unsigned char>(data[i])) << ',';
+  }
+
+  out << "\n  };\n\n";
+  out << "  static const std::unique_ptr<tmx::CompiledMap> map = tmx::CompiledMap::fromMemory(data, sizeof data);\n";
+  out << "  return *map;\n";
+  out << "}\n\n";
+  out << "#endif // " << guard << '\n';
+
+  if (!out) {
+    std::printf("Could not write '%s'. Exiting.\n", output.string().c_str());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,37 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include <boost/filesystem.hpp>
+
+#include <tmx/Map.h>
+
+namespace fs = boost::filesystem;
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    std::printf("Usage: tmx_compile <file.tmx> <file.tmxc>\n");
+    return EXIT_FAILURE;
+  }
+
+  fs::path input(argv[1]);
+  fs::path output(argv[2]);
+
+  auto map = tmx::Map::parseFile(input);
+
+  if (!map) {
+    return EXIT_FAILURE;
+  }
+
+  if (!map->saveCompiled(output)) {
+    return EXIT_FAILURE;
+  }
+
+  auto compiled = tmx::Map::openCompiled(output);
+
+  if (!compiled) {
+    return EXIT_FAILURE;
+  }
+
+  std::printf("%s: %zu bytes, %zu tilesets, %zu layers\n", output.string().c_str(), compiled->getSize(), compiled->getTileSetCount(), compiled->getLayerCount());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,147 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <zlib.h>
+
+#include <tmx/CompressionDictionary.h>
+#include <tmx/Map.h>
+#include <tmx/TileLayer.h>
+
+namespace fs = boost::filesystem;
+
+static std::vector<uint8_t> compress(const std::vector<uint8_t>& input, const tmx::CompressionDictionary *dictionary) {
+  z_stream stream;
+  std::memset(&stream, 0, sizeof(stream));
+  deflateInit(&stream, Z_DEFAULT_COMPRESSION);
+
+  if (dictionary != nullptr) {
+    deflateSetDictionary(&stream, dictionary->getData(), dictionary->getSize());
+  }
+
+  std::vector<uint8_t> output(deflateBound(&stream, input.size()));
+  stream.next_in = input.data();
+  stream.avail_in = input.size();
+  stream.next_out = output.data();
+  stream.avail_out = output.size();
+  deflate(&stream, Z_FINISH);
+  output.resize(stream.total_out);
+  deflateEnd(&stream);
+  return output;
+}
+
+static double decode(const std::vector<std::vector<uint8_t>>& inputs, const std::vector<std::vector<uint8_t>>& samples, const tmx::CompressionDictionary *dictionary) {
+  std::vector<uint8_t> output;
+  auto start = std::chrono::steady_clock::now();
+
+  for (std::size_t i = 0; i < inputs.size(); ++i) {
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    inflateInit(&stream);
+
+    output.resize(samples[i].size());
+    stream.next_in = inputs[i].data();
+    stream.avail_in = inputs[i].size();
+    stream.next_out = output.data();
+    stream.avail_out = output.size();
+
+    int err = inflate(&stream, Z_FINISH);
+
+    if (err == Z_NEED_DICT) {
+      inflateSetDictionary(&stream, dictionary->getData(), dictionary->getSize());
+      err = inflate(&stream, Z_FINISH);
+    }
+
+    inflateEnd(&stream);
+
+    if (err != Z_STREAM_END || output != samples[i]) {
+      std::printf("Error! Wrong decoded data\n");
+      std::exit(EXIT_FAILURE);
+    }
+  }
+
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+  int first = 1;
+  std::size_t size = tmx::CompressionDictionary::DefaultSize;
+
+  if (argc > 2 && std::strcmp(argv[1], "-s") == 0) {
+    size = std::strtoul(argv[2], nullptr, 10);
+    first = 3;
+  }
+
+  if (argc - first < 2) {
+    std::printf("Usage: tmx_dictionary [-s size] <dictionary> <file.tmx>...\n");
+    return EXIT_FAILURE;
+  }
+
+  fs::path output(argv[first]);
+  std::vector<std::vector<uint8_t>> samples;
+
+  for (int i = first + 1; i < argc; ++i) {
+    auto map = tmx::Map::parseFile(argv[i]);
+
+    if (!map) {
+      return EXIT_FAILURE;
+    }
+
+    for (auto& flattened : map->getFlattenedLayers()) {
+      auto tileLayer = dynamic_cast<const tmx::TileLayer *>(flattened.layer);
+
+      if (tileLayer == nullptr) {
+        continue;
+      }
+
+      std::vector<uint8_t> sample;
+      sample.reserve(tileLayer->getCellCount() * 4);
+
+      for (auto cell : *tileLayer) {
+        unsigned gid = cell.getRawGID();
+        sample.push_back(gid & 0xFF);
+        sample.push_back((gid >> 8) & 0xFF);
+        sample.push_back((gid >> 16) & 0xFF);
+        sample.push_back((gid >> 24) & 0xFF);
+      }
+
+      samples.push_back(std::move(sample));
+    }
+  }
+
+  auto dictionary = tmx::CompressionDictionary::train(samples, size);
+
+  if (!dictionary || !dictionary->save(output)) {
+    return EXIT_FAILURE;
+  }
+
+  std::vector<std::vector<uint8_t>> plain, preset;
+  std::size_t raw = 0, plainSize = 0, presetSize = 0;
+
+  for (auto& sample : samples) {
+    plain.push_back(compress(sample, nullptr));
+    preset.push_back(compress(sample, dictionary.get()));
+    raw += sample.size();
+    plainSize += plain.back().size();
+    presetSize += preset.back().size();
+  }
+
+  // decode a few times to measure something on small corpora
+  const int rounds = 10;
+  double plainTime = 0, presetTime = 0;
+
+  for (int i = 0; i < rounds; ++i) {
+    plainTime += decode(plain, samples, nullptr);
+    presetTime += decode(preset, samples, dictionary.get());
+  }
+
+  std::printf("%s: %zu bytes, trained on %zu layers (%zu bytes)\n", output.string().c_str(), dictionary->getSize(), samples.size(), raw);
+  std::printf("zlib:            %zu bytes, %.1f MB/s decoded\n", plainSize, raw * rounds / plainTime / 1e6);
+  std::printf("zlib+dictionary: %zu bytes, %.1f MB/s decoded\n", presetSize, raw * rounds / presetTime / 1e6);
+  std::printf("size: %.1f%%, decode time: %.1f%%\n", 100.0 * presetSize / plainSize, 100.0 * presetTime / plainTime);
+  return EXIT_SUCCESS;
+}
@@ -42,7 +42,19 @@ public:
 
     QImage image(width * tilewidth, height * tileheight, QImage::Format_ARGB32);
     painter.begin(&image);
-    map->visitLayers(*this);
+
+    for (auto& flattened : map->getFlattenedLayers()) {
+      if (!flattened.visible) {
+        continue;
+      }
+
+      painter.save();
+      painter.setOpacity(flattened.opacity);
+      painter.translate(flattened.offset.x, flattened.offset.y);
+      flattened.layer->accept(*map, *this);
+      painter.restore();
+    }
+
     painter.end();
 
     std::printf("Saving image...\n");
@@ -53,15 +65,21 @@ private:
   QPainter painter;
   QCache<QString, QImage> cache;
 
-  const QImage getTexture(const fs::path& path) {
-    QString str(path.string().c_str());
+  const QImage getTexture(const tmx::Image& image) {
+    // an embedded image has no source, its data identifies it
+    QString str = image.hasData() ? QString::number(reinterpret_cast<quintptr>(image.getData())) : QString(image.getSource().string().c_str());
     QImage *img = cache.object(str);
 
     if (img != nullptr) {
       return *img;
     }
 
-    img = new QImage(str);
+    if (image.hasData()) {
+      img = new QImage(QImage::fromData(image.getData(), static_cast<int>(image.getDataSize())));
+    } else {
+      img = new QImage(str);
+    }
+
     assert(!img->isNull());
 
     cache.insert(str, img);
@@ -83,7 +101,7 @@ private:
       auto image = tileset->getImage();
       assert(image);
 
-      const QImage texture = getTexture(image->getSource());
+      const QImage texture = getTexture(*image);
 
       tmx::Size size;
 
@@ -115,7 +133,7 @@ private:
       auto image = tile->getImage();
       assert(image);
 
-      const QImage texture = getTexture(image->getSource());
+      const QImage texture = getTexture(*image);
       painter.drawImage(origin, texture);
 
     }
@@ -0,0 +1,51 @@
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+
+#include <boost/filesystem.hpp>
+
+#include <tmx/MapServer.h>
+
+namespace fs = boost::filesystem;
+
+static tmx::MapServer *server = nullptr;
+
+static void handleSignal(int sig) {
+  if (server != nullptr) {
+    server->stop();
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    std::printf("Usage: tmx_served <root> <socket> [map...]\n");
+    return EXIT_FAILURE;
+  }
+
+  fs::path root(argv[1]);
+  fs::path socket(argv[2]);
+
+  tmx::MapServer instance(root);
+
+  for (int i = 3; i < argc; ++i) {
+    if (!instance.preload(argv[i])) {
+      std::printf("Could not load '%s'. Exiting.\n", argv[i]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (!instance.listen(socket)) {
+    return EXIT_FAILURE;
+  }
+
+  server = &instance;
+  std::signal(SIGINT, handleSignal);
+  std::signal(SIGTERM, handleSignal);
+
+  std::printf("Serving maps from '%s' on '%s'\n", root.string().c_str(), socket.string().c_str());
+  instance.run();
+
+  server = nullptr;
+  std::printf("Served %zu maps\n", instance.getMapCount());
+  return EXIT_SUCCESS;
+}
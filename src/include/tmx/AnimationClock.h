@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_ANIMATION_CLOCK_H
+#define TMX_ANIMATION_CLOCK_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Map.h"
+
+namespace tmx {
+
+  /**
+   * @brief A clock that gives the current frame of the animated tiles of a map.
+   *
+   * The clock keeps a table from a global id to the global id of the frame
+   * to show. The table is updated once per tick, with a single pass over
+   * the animated tiles of the map, whatever the number of cells that show
+   * them. Then, getting the frame of a global id is a lookup in the table,
+   * and a whole layer can be remapped with remap().
+   *
+   * The clock must not be updated while another thread reads it.
+   *
+   * @sa Tile::getAnimation
+   */
+  class AnimationClock {
+  public:
+    /**
+     * @brief Constructor.
+     *
+     * The clock starts at time zero, with the first frame of each animation.
+     *
+     * @param map the map with the animated tiles
+     */
+    explicit AnimationClock(const Map& map);
+
+    /**
+     * @brief Get the number of animated tiles.
+     *
+     * @returns the number of animated tiles
+     */
+    std::size_t getAnimationCount() const noexcept {
+      return m_animations.size();
+    }
+
+    /**
+     * @brief Set the time of the clock.
+     *
+     * The animations loop, so the time can grow forever.
+     *
+     * @param time the time since the start of the animations
+     */
+    void update(std::chrono::milliseconds time);
+
+    /**
+     * @brief Get the global id of the current frame of a tile.
+     *
+     * @param gid the global id of the tile, without the flip flags
+     * @returns the global id of the current frame, or gid if the tile is not animated
+     */
+    unsigned getFrameGID(unsigned gid) const noexcept {
+      return gid < m_table.size() ? m_table[gid] : gid;
+    }
+
+    /**
+     * @brief Replace the global ids of an array of cells by their current frame.
+     *
+     * The cells are raw global ids, with their flip flags, like in a
+     * compiled layer. The flip flags are kept. The input and the output
+     * may be the same array.
+     *
+     * @param raw the raw global ids
+     * @param out the raw global ids of the current frames
+     * @param count the number of cells
+     *
+     * @sa Cell::getRawGID
+     */
+    void remap(const uint32_t *raw, uint32_t *out, std::size_t count) const noexcept;
+
+  private:
+    struct Animation {
+      uint32_t gid;
+      uint32_t period;
+      uint32_t first;
+      uint32_t count;
+    };
+
+    std::vector<Animation> m_animations;
+    std::vector<uint32_t> m_frameEnds;  // the end of each frame in its period, in milliseconds
+    std::vector<uint32_t> m_frameGIDs;
+    std::vector<uint32_t> m_table;
+  };
+
+}
+
+#endif // TMX_ANIMATION_CLOCK_H
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_ASSET_PACK_H
+#define TMX_ASSET_PACK_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "FileSystem.h"
+
+namespace tmx {
+
+  /**
+   * @brief An asset pack is a file system inside a single file.
+   *
+   * The pack file is mapped in memory once when the pack is opened. Then
+   * opening, reading and mapping a file of the pack only needs a lookup in
+   * the index of the pack, without any system call.
+   *
+   * The files are identified by their path relative to the root directory
+   * of the pack, in generic format (e.g. `maps/level1.tmx`). The paths given
+   * to the pack are normalized before the lookup. An absolute path, or a
+   * path that goes above the root with `..`, is never found in a pack and
+   * can not be added to a pack.
+   */
+  class AssetPack : public FileSystem {
+  public:
+    /**
+     * @brief AssetPack destructor.
+     */
+    virtual ~AssetPack();
+
+    virtual std::unique_ptr<File> open(const boost::filesystem::path& path) override;
+    virtual bool list(const boost::filesystem::path& directory, std::vector<boost::filesystem::path>& files) override;
+
+    /**
+     * @brief Get the number of files in the pack.
+     *
+     * @returns the number of files
+     */
+    std::size_t getFileCount() const noexcept {
+      return m_index.size();
+    }
+
+    /**
+     * @brief Open an asset pack.
+     *
+     * @param filename the name of the pack file
+     * @returns the pack, or nullptr in case of error
+     */
+    static std::unique_ptr<AssetPack> openPack(const boost::filesystem::path& filename);
+
+    /**
+     * @brief Create an asset pack from native files.
+     *
+     * @param filename the name of the pack file
+     * @param root the root directory of the files
+     * @param files the paths of the files, relative to the root directory
+     * @returns true if the pack has been created, false if a file can not be
+     * read or if its path is not relative to the root directory
+     */
+    static bool createPack(const boost::filesystem::path& filename, const boost::filesystem::path& root,
+        const std::vector<boost::filesystem::path>& files);
+
+  private:
+    struct Entry {
+      uint64_t offset;
+      uint64_t size;
+    };
+
+    struct Mapping;
+
+    AssetPack(std::unique_ptr<Mapping> mapping);
+
+  private:
+    std::unique_ptr<Mapping> m_mapping;
+    std::unordered_map<std::string, Entry> m_index;
+  };
+
+}
+
+#endif // TMX_ASSET_PACK_H
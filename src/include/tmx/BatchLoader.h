@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_BATCH_LOADER_H
+#define TMX_BATCH_LOADER_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "Executor.h"
+#include "FileSystem.h"
+#include "Map.h"
+
+namespace tmx {
+
+  /**
+   * @brief Some counters about a batch loading.
+   */
+  struct BatchStatistics {
+    std::size_t maps;                     /**< the number of maps successfully loaded */
+    std::size_t failures;                 /**< the number of maps that could not be loaded */
+    uintmax_t bytes;                      /**< the number of bytes read from the map and tileset files */
+    std::chrono::nanoseconds duration;    /**< the wall-clock duration of the loading */
+
+    /**
+     * @brief Get the throughput in megabytes per second.
+     *
+     * @returns the number of megabytes read per second
+     */
+    double getMegabytesPerSecond() const noexcept;
+
+    /**
+     * @brief Get the throughput in maps per second.
+     *
+     * @returns the number of maps loaded per second
+     */
+    double getMapsPerSecond() const noexcept;
+  };
+
+  /**
+   * @brief A batch loader loads many maps in parallel.
+   *
+   * Each map is parsed in its own task on an executor. The threads of the
+   * executor reuse their XML document from one map to the next, and the
+   * external tilesets are read and decoded only once for the whole batch,
+   * whatever the number of maps that reference them and their first gid
+   * in these maps.
+   */
+  class BatchLoader {
+  public:
+    /**
+     * @brief BatchLoader constructor.
+     *
+     * @param executor the executor that runs the parsing
+     */
+    explicit BatchLoader(Executor& executor = Executor::getDefault());
+
+    /**
+     * @brief Set the file system of the files.
+     *
+     * By default, the files are opened with the default file system.
+     *
+     * @param filesystem the file system
+     */
+    void setFileSystem(FileSystem& filesystem) noexcept {
+      m_filesystem = &filesystem;
+    }
+
+    /**
+     * @name Files
+     * @{
+     */
+    /**
+     * @brief Add a file to the batch.
+     *
+     * @param filename the name of the TMX file
+     */
+    void addFile(const boost::filesystem::path& filename);
+
+    /**
+     * @brief Add the files of a directory whose name matches a pattern.
+     *
+     * The pattern may contain `*` (any sequence of characters) and `?` (any
+     * character). The files are added in lexicographic order. The
+     * directory is not searched recursively.
+     *
+     * @param directory the directory
+     * @param pattern the pattern of the file names, e.g. `"*.tmx"`
+     * @returns the number of added files
+     */
+    std::size_t addFiles(const boost::filesystem::path& directory, const std::string& pattern = "*.tmx");
+
+    /**
+     * @brief Get the files of the batch.
+     *
+     * @returns the files in the order of addition
+     */
+    const std::vector<boost::filesystem::path>& getFiles() const noexcept {
+      return m_files;
+    }
+    /** @} */
+
+    /**
+     * @name Loading
+     * @{
+     */
+    /**
+     * @brief Load all the files of the batch.
+     *
+     * This function blocks until all the maps are loaded, so it must not be
+     * called from a task of the executor.
+     *
+     * @returns the maps in the order of the files, with a null map for each
+     * file that could not be loaded
+     */
+    std::vector<std::unique_ptr<Map>> load();
+
+    /**
+     * @brief Get the statistics of the last loading.
+     *
+     * @returns the statistics
+     */
+    const BatchStatistics& getStatistics() const noexcept {
+      return m_stats;
+    }
+    /** @} */
+
+  private:
+    Executor& m_executor;
+    FileSystem *m_filesystem;
+    std::vector<boost::filesystem::path> m_files;
+    BatchStatistics m_stats;
+  };
+
+}
+
+#endif // TMX_BATCH_LOADER_H
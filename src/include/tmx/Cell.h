@@ -68,6 +68,52 @@ namespace tmx {
       return m_dflip;
     }
 
+    /**
+     * @brief Get the global id of the tile with the flip flags.
+     *
+     * This is the representation used in the TMX format: the three most
+     * significant bits are the horizontal, vertical and diagonal flip flags.
+     *
+     * @returns the global id with the flip flags
+     */
+    unsigned getRawGID() const noexcept {
+      unsigned raw = m_gid;
+
+      if (m_hflip) {
+        raw |= HFLIP_FLAG;
+      }
+
+      if (m_vflip) {
+        raw |= VFLIP_FLAG;
+      }
+
+      if (m_dflip) {
+        raw |= DFLIP_FLAG;
+      }
+
+      return raw;
+    }
+
+    /**
+     * @brief Create a cell from a global id with the flip flags.
+     *
+     * @param raw the global id with the flip flags
+     * @returns the corresponding cell
+     * @sa getRawGID()
+     */
+    static Cell fromRawGID(unsigned raw) noexcept {
+      return Cell(raw & ~(HFLIP_FLAG | VFLIP_FLAG | DFLIP_FLAG), (raw & HFLIP_FLAG) != 0, (raw & VFLIP_FLAG) != 0, (raw & DFLIP_FLAG) != 0);
+    }
+
+    /**
+     * @brief The flip flags in a raw global id.
+     */
+    enum : unsigned {
+      HFLIP_FLAG = 0x80000000, /**< the horizontal flip flag */
+      VFLIP_FLAG = 0x40000000, /**< the vertical flip flag */
+      DFLIP_FLAG = 0x20000000, /**< the diagonal flip flag */
+    };
+
   private:
     unsigned m_gid;
     bool m_hflip;
@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_CHUNK_PAGER_H
+#define TMX_CHUNK_PAGER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <condition_variable>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "Cell.h"
+#include "CompiledMap.h"
+#include "Executor.h"
+#include "FileSystem.h"
+#include "Geometry.h"
+
+namespace tmx {
+
+  /**
+   * @brief A chunk of a tile layer, loaded by a pager.
+   */
+  class TileChunk {
+  public:
+    /**
+     * @brief TileChunk constructor.
+     *
+     * @param rect the rectangle of the chunk in the map, in tiles
+     * @param cells the raw cells of the chunk, in row-major order
+     */
+    TileChunk(const Rect& rect, std::vector<uint32_t> cells)
+    : m_rect(rect), m_cells(std::move(cells))
+    {
+    }
+
+    /**
+     * @brief Get the rectangle of the chunk.
+     *
+     * @returns the rectangle of the chunk in the map, in tiles
+     */
+    const Rect& getRect() const noexcept {
+      return m_rect;
+    }
+
+    /**
+     * @brief Get a raw cell of the chunk.
+     *
+     * @param x the x coordinate of the cell in the map
+     * @param y the y coordinate of the cell in the map
+     * @returns the global id of the cell with the flip flags
+     */
+    unsigned getRawGID(unsigned x, unsigned y) const noexcept {
+      return m_cells[(y - m_rect.y) * m_rect.width + (x - m_rect.x)];
+    }
+
+    /**
+     * @brief Get a cell of the chunk.
+     *
+     * @param x the x coordinate of the cell in the map
+     * @param y the y coordinate of the cell in the map
+     * @returns the cell
+     */
+    Cell getCell(unsigned x, unsigned y) const noexcept {
+      return Cell::fromRawGID(getRawGID(x, y));
+    }
+
+    /**
+     * @brief Get the memory used by the chunk.
+     *
+     * @returns the number of bytes used by the chunk
+     */
+    std::size_t getMemorySize() const noexcept {
+      return sizeof(TileChunk) + m_cells.size() * sizeof(uint32_t);
+    }
+
+  private:
+    const Rect m_rect;
+    const std::vector<uint32_t> m_cells;
+  };
+
+  /**
+   * @brief The statistics of a pager.
+   */
+  struct PagerStatistics {
+    uint64_t hits;              /**< the number of requests of a resident or loading chunk */
+    uint64_t misses;            /**< the number of requests that started a load */
+    uint64_t evictions;         /**< the number of evicted chunks */
+    uint64_t prefetches;        /**< the number of loads started by a prefetch */
+    std::size_t residentBytes;  /**< the memory used by the resident chunks */
+    std::size_t residentChunks; /**< the number of resident chunks */
+  };
+
+  /**
+   * @brief A chunk pager keeps a working set of chunks of a compiled map in memory.
+   *
+   * The pager reads the chunks of the tile layers of a compiled map file on
+   * demand. The first request of a chunk starts an asynchronous load on an
+   * executor. The loaded chunks stay resident while the memory they use is
+   * under the budget of the pager, then the least recently used chunks are
+   * evicted. A chunk that is still used outside the pager stays alive until
+   * it is released, even if it has been evicted.
+   *
+   * Layers are designated by their index in the compiled map. All the
+   * functions of the pager can be called from several threads.
+   *
+   * @sa CompiledMap
+   */
+  class ChunkPager {
+  public:
+    /**
+     * @brief A future chunk.
+     *
+     * The chunk is nullptr if it could not be loaded.
+     */
+    typedef std::shared_future<std::shared_ptr<const TileChunk>> future_chunk;
+
+    /**
+     * @brief ChunkPager destructor.
+     *
+     * The destructor waits for the loads in progress.
+     */
+    ~ChunkPager();
+
+    /**
+     * @brief Get the header of the compiled map.
+     *
+     * @returns the header of the compiled map
+     */
+    const compiled::Header& getHeader() const noexcept {
+      return m_header;
+    }
+
+    /**
+     * @brief Get the memory budget.
+     *
+     * @returns the maximum number of bytes used by the resident chunks
+     */
+    std::size_t getBudget() const;
+
+    /**
+     * @brief Set the memory budget.
+     *
+     * Chunks are evicted if the new budget is lower than the memory in use.
+     *
+     * @param budget the maximum number of bytes used by the resident chunks
+     */
+    void setBudget(std::size_t budget);
+
+    /**
+     * @brief Request a chunk.
+     *
+     * If the chunk is not resident, its load is started and the function
+     * returns immediately.
+     *
+     * @param layer the index of a tile layer
+     * @param cx the x coordinate of the chunk, in chunks
+     * @param cy the y coordinate of the chunk, in chunks
+     * @returns the future chunk
+     */
+    future_chunk requestChunk(unsigned layer, unsigned cx, unsigned cy);
+
+    /**
+     * @brief Get the chunk that contains a cell.
+     *
+     * The function waits for the chunk if it is not resident.
+     *
+     * @param layer the index of a tile layer
+     * @param x the x coordinate of the cell
+     * @param y the y coordinate of the cell
+     * @returns the chunk or nullptr if it could not be loaded
+     */
+    std::shared_ptr<const TileChunk> getChunkAt(unsigned layer, unsigned x, unsigned y);
+
+    /**
+     * @brief Get a cell.
+     *
+     * The function waits for the chunk of the cell if it is not resident.
+     *
+     * @param layer the index of a tile layer
+     * @param x the x coordinate of the cell
+     * @param y the y coordinate of the cell
+     * @returns the cell, or an empty cell if the chunk could not be loaded
+     */
+    Cell getCell(unsigned layer, unsigned x, unsigned y);
+
+    /**
+     * @brief Get a cell if its chunk is resident.
+     *
+     * If the chunk is not resident, its load is started.
+     *
+     * @param layer the index of a tile layer
+     * @param x the x coordinate of the cell
+     * @param y the y coordinate of the cell
+     * @param cell the cell, set if the chunk is resident
+     * @returns true if the chunk is resident
+     */
+    bool tryGetCell(unsigned layer, unsigned x, unsigned y, Cell& cell);
+
+    /**
+     * @brief Prefetch the chunks ahead of a moving position.
+     *
+     * The chunk of the position and the chunks in the direction of the
+     * movement are loaded if they are not resident. A prefetch does not count
+     * as a hit or a miss.
+     *
+     * @param layer the index of a tile layer
+     * @param position the current position, in tiles
+     * @param direction the direction of the movement
+     * @param distance the number of chunks to prefetch ahead
+     */
+    void prefetch(unsigned layer, const Vector2u& position, const Vector2i& direction, unsigned distance = 2);
+
+    /**
+     * @brief Get the statistics of the pager.
+     *
+     * @returns the statistics
+     */
+    PagerStatistics getStatistics() const;
+
+    /**
+     * @brief Open a compiled map file for paging.
+     *
+     * @param filename the filename of the compiled map
+     * @param budget the maximum number of bytes used by the resident chunks
+     * @param executor the executor that loads the chunks
+     * @param filesystem the file system used to open the file
+     * @returns a pager or nullptr if the file is not a valid compiled map
+     */
+    static std::unique_ptr<ChunkPager> open(const boost::filesystem::path& filename, std::size_t budget,
+        Executor& executor = Executor::getDefault(), FileSystem& filesystem = FileSystem::getDefault());
+
+  private:
+    enum class Request {
+      QUERY,
+      PREFETCH,
+    };
+
+    struct Entry {
+      future_chunk chunk;
+      std::size_t size;   // 0 while loading
+      std::list<uint64_t>::iterator position;
+    };
+
+    ChunkPager(std::unique_ptr<File> file, std::size_t budget, Executor& executor);
+
+    future_chunk request(unsigned layer, unsigned cx, unsigned cy, Request kind);
+    std::shared_ptr<const TileChunk> load(unsigned layer, unsigned cx, unsigned cy);
+    void loaded(uint64_t key, const std::shared_ptr<const TileChunk>& chunk);
+    void evict();
+
+  private:
+    std::unique_ptr<File> m_file;
+    std::mutex m_fileMutex;
+    compiled::Header m_header;
+    std::vector<compiled::Layer> m_layers;
+    unsigned m_chunksPerRow;
+    unsigned m_chunksPerColumn;
+    Executor& m_executor;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_done;
+    std::size_t m_budget;
+    std::unordered_map<uint64_t, Entry> m_entries;
+    std::list<uint64_t> m_lru; // most recently used first
+    std::size_t m_loading;
+    PagerStatistics m_stats;
+  };
+
+}
+
+#endif // TMX_CHUNK_PAGER_H
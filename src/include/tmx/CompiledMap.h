@@ -0,0 +1,1226 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_COMPILED_MAP_H
+#define TMX_COMPILED_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <boost/range/iterator_range.hpp>
+
+#include "Cell.h"
+#include "Geometry.h"
+
+namespace tmx {
+  class Map;
+  class CompiledMap;
+  class CompiledLayer;
+
+  enum class Orientation;
+  enum class RenderOrder;
+  enum class StaggerAxis;
+  enum class StaggerIndex;
+  enum class DrawOrder;
+
+  /**
+   * @brief The raw layout of a compiled map.
+   *
+   * A compiled map is a single block of memory that starts with a header.
+   * All the references inside the block are offsets or indices, so that the
+   * block can be used wherever it is in memory. The sections are aligned on
+   * 8 bytes and the integers are stored in the byte order of the machine
+   * that compiled the map (checked at opening).
+   *
+   * The layers are stored in depth-first order: a group layer is followed by
+   * all the layers inside the group. Each layer keeps its own opacity,
+   * visibility and offset, the values of its groups are not applied.
+   *
+   * Tile layers and object layers are cut in square chunks of tiles. The
+   * cells of a chunk are contiguous and each chunk of an object layer lists
+   * the objects that intersect it, so that a region of the map can be read
+   * without reading the rest.
+   */
+  namespace compiled {
+
+    const char Magic[8] = { 'T', 'M', 'X', 'C', 'M', 'A', 'P', '\0' }; /**< the magic string at the beginning */
+    const uint32_t Version = 6;               /**< the version of the format */
+    const uint32_t ByteOrderMark = 0x01020304; /**< the byte order mark */
+    const uint32_t None = 0;                  /**< the value of an absent optional index */
+    const uint32_t DefaultChunkSize = 32;     /**< the default size of the side of a chunk, in tiles */
+
+    /**
+     * @brief A range of elements in a section.
+     */
+    struct Range {
+      uint32_t first; /**< the index of the first element */
+      uint32_t count; /**< the number of elements */
+    };
+
+    /**
+     * @brief A section of the compiled map.
+     */
+    struct Section {
+      uint64_t offset;  /**< the offset of the section from the beginning */
+      uint64_t count;   /**< the number of elements in the section */
+    };
+
+    /**
+     * @brief The identifiers of the sections.
+     */
+    enum SectionId : uint32_t {
+      STRING_OFFSETS,     /**< uint32_t: offsets of the strings in STRING_DATA */
+      STRING_DATA,        /**< char: null-terminated strings */
+      PROPERTIES,         /**< Property */
+      IMAGES,             /**< Image */
+      TERRAINS,           /**< Terrain */
+      TILES,              /**< Tile */
+      TILESETS,           /**< TileSet */
+      LAYERS,             /**< Layer */
+      CHUNKS,             /**< Chunk */
+      CELLS,              /**< uint32_t: global ids with flip flags, chunk by chunk */
+      OBJECT_KINDS,       /**< uint8_t: Object::Kind */
+      OBJECT_VISIBLE,     /**< uint8_t: 0 or 1 */
+      OBJECT_IDS,         /**< uint32_t */
+      OBJECT_NAMES,       /**< uint32_t: string */
+      OBJECT_TYPES,       /**< uint32_t: string */
+      OBJECT_ORIGINS,     /**< Vector2u */
+      OBJECT_ROTATIONS,   /**< double */
+      OBJECT_SIZES,       /**< Size: for rectangles and ellipses */
+      OBJECT_GIDS,        /**< uint32_t: for tiles, global id with flip flags */
+      OBJECT_POINTS,      /**< Range in POINTS: for polylines and polygons */
+      OBJECT_PROPERTIES,  /**< Range in PROPERTIES */
+      POINTS,             /**< Vector2i */
+      OBJECT_BOUNDS,      /**< Bounds */
+      OBJECT_REFS,        /**< uint32_t: index of an object */
+      FRAMES,             /**< Frame */
+      TILE_LAYERS,        /**< Layer: the object layers of the tiles */
+      IMAGE_DATA,         /**< uint8_t: the bytes of the embedded images */
+      SECTION_COUNT,      /**< the number of sections */
+    };
+
+    /**
+     * @brief The header of the compiled map.
+     */
+    struct Header {
+      char magic[8];          /**< the magic string */
+      uint32_t version;       /**< the version of the format */
+      uint32_t byteOrder;     /**< the byte order mark */
+      uint64_t size;          /**< the total size of the compiled map */
+      Section sections[SECTION_COUNT]; /**< the sections */
+
+      uint32_t mapVersion;    /**< string */
+      uint32_t orientation;
+      uint32_t width;
+      uint32_t height;
+      uint32_t tilewidth;
+      uint32_t tileheight;
+      uint32_t backgroundColor; /**< string */
+      uint32_t renderOrder;
+      uint32_t hexSideLength;
+      uint32_t staggerAxis;
+      uint32_t staggerIndex;
+      uint32_t nextObjectId;
+      Range properties;       /**< range in PROPERTIES */
+      uint32_t chunkSize;     /**< the size of the side of a chunk, in tiles */
+    };
+
+    /**
+     * @brief A chunk of a layer.
+     *
+     * The chunks of a layer are stored row by row. The chunks on the right
+     * and bottom edges of the map may be smaller than the chunk size.
+     */
+    struct Chunk {
+      uint64_t cells;   /**< tile layer: index of the first cell in CELLS, in row-major order inside the chunk */
+      Range objects;    /**< object layer: range in OBJECT_REFS of the objects that intersect the chunk */
+    };
+
+    /**
+     * @brief The axis-aligned bounds of an object, in pixels.
+     *
+     * The bounds of a rotated object contain all its possible rotations.
+     */
+    struct Bounds {
+      int32_t left;
+      int32_t top;
+      int32_t right;
+      int32_t bottom;
+    };
+
+    /**
+     * @brief A property.
+     */
+    struct Property {
+      uint32_t key;   /**< string */
+      uint32_t value; /**< string */
+    };
+
+    /**
+     * @brief An image.
+     */
+    struct Image {
+      uint32_t format;  /**< string */
+      uint32_t source;  /**< string */
+      uint32_t trans;   /**< string */
+      uint32_t width;
+      uint32_t height;
+      Range data;       /**< range in IMAGE_DATA of the embedded image */
+    };
+
+    /**
+     * @brief A terrain.
+     */
+    struct Terrain {
+      uint32_t name;    /**< string */
+      uint32_t tile;
+      Range properties; /**< range in PROPERTIES */
+    };
+
+    /**
+     * @brief A frame of a tile animation.
+     */
+    struct Frame {
+      uint32_t tileId;    /**< the local id of the tile to show */
+      uint32_t duration;  /**< the duration of the frame, in milliseconds */
+    };
+
+    /**
+     * @brief A tile.
+     */
+    struct Tile {
+      uint32_t id;
+      uint32_t terrain[4];
+      uint32_t probability;
+      uint32_t image;   /**< index in IMAGES plus one, or None */
+      Range properties; /**< range in PROPERTIES */
+      Range frames;     /**< range in FRAMES */
+      uint32_t objects; /**< index in TILE_LAYERS plus one, or None */
+    };
+
+    /**
+     * @brief A tileset.
+     */
+    struct TileSet {
+      uint32_t firstgid;
+      uint32_t name;    /**< string */
+      uint32_t tilewidth;
+      uint32_t tileheight;
+      uint32_t spacing;
+      uint32_t margin;
+      uint32_t tilecount;
+      int32_t offsetX;
+      int32_t offsetY;
+      uint32_t image;   /**< index in IMAGES plus one, or None */
+      Range terrains;   /**< range in TERRAINS */
+      Range tiles;      /**< range in TILES */
+      Range properties; /**< range in PROPERTIES */
+    };
+
+    /**
+     * @brief The kinds of layers.
+     */
+    enum LayerKind : uint32_t {
+      TILE_LAYER,
+      OBJECT_LAYER,
+      IMAGE_LAYER,
+      GROUP_LAYER,
+    };
+
+    /**
+     * @brief A layer.
+     */
+    struct Layer {
+      uint32_t kind;      /**< LayerKind */
+      uint32_t name;      /**< string */
+      double opacity;
+      uint32_t visible;
+      uint32_t image;     /**< image layer: index in IMAGES plus one, or None */
+      Range properties;   /**< range in PROPERTIES */
+      Range content;      /**< object layer: range of objects, group layer: range in LAYERS of the layers inside the group */
+      Range chunks;       /**< tile layer and object layer: range in CHUNKS */
+      uint32_t color;     /**< object layer: string */
+      uint32_t drawOrder; /**< object layer: DrawOrder */
+      Vector2f offset;    /**< the offset of the layer, in pixels */
+      uint32_t parent;    /**< index in LAYERS of the group plus one, or None */
+    };
+
+  }
+
+  /**
+   * @brief A read-only view on a compiled image.
+   */
+  class CompiledImage {
+  public:
+    /**
+     * @brief CompiledImage constructor.
+     */
+    CompiledImage(const CompiledMap& map, const compiled::Image& data)
+      : m_map(&map), m_data(&data)
+    {
+    }
+
+    /**
+     * @brief Get the format of the file (if provided).
+     *
+     * @returns the format of the file or empty string
+     */
+    const char *getFormat() const noexcept;
+
+    /**
+     * @brief Get the path to the image file.
+     *
+     * @returns the path to the image file
+     */
+    const char *getSource() const noexcept;
+
+    /**
+     * @brief Get the transparent color (if provided)
+     *
+     * @returns the transparent color
+     */
+    const char *getTransparent() const noexcept;
+
+    /**
+     * @brief Get the width of the image (if provided)
+     *
+     * @returns the width of the image
+     */
+    unsigned getWidth() const noexcept {
+      return m_data->width;
+    }
+
+    /**
+     * @brief Get the height of the image (if provided)
+     *
+     * @returns the height of the image
+     */
+    unsigned getHeight() const noexcept {
+      return m_data->height;
+    }
+
+    /**
+     * @brief Tell whether the image is embedded in the map.
+     *
+     * @returns true if the image has data
+     */
+    bool hasData() const noexcept {
+      return m_data->data.count > 0;
+    }
+
+    /**
+     * @brief Get the encoded bytes of an embedded image.
+     *
+     * @returns the bytes of the image
+     */
+    const uint8_t *getData() const noexcept;
+
+    /**
+     * @brief Get the size of an embedded image.
+     *
+     * @returns the number of bytes of the image
+     */
+    std::size_t getDataSize() const noexcept {
+      return m_data->data.count;
+    }
+
+  private:
+    const CompiledMap *m_map;
+    const compiled::Image *m_data;
+  };
+
+  /**
+   * @brief The properties of a compiled element.
+   */
+  class CompiledComponent {
+  public:
+    /**
+     * @brief CompiledComponent constructor.
+     */
+    CompiledComponent(const CompiledMap& map, compiled::Range properties)
+      : m_map(&map), m_properties(properties)
+    {
+    }
+
+    /**
+     * @brief Tell if the element has a given property.
+     *
+     * @param key the property key
+     * @returns true if the element has the given property
+     */
+    bool hasProperty(const char *key) const noexcept {
+      return findProperty(key) != nullptr;
+    }
+
+    /**
+     * @brief Get a property value.
+     *
+     * @param key the property key
+     * @param def a default value if the property does not exist
+     * @returns the value of the given property
+     */
+    const char *getProperty(const char *key, const char *def) const noexcept;
+
+    /**
+     * @brief Get the properties.
+     *
+     * @returns the properties, sorted by key
+     */
+    boost::iterator_range<const compiled::Property *> getProperties() const noexcept;
+
+  protected:
+    const CompiledMap& getMap() const noexcept {
+      return *m_map;
+    }
+
+  private:
+    const compiled::Property *findProperty(const char *key) const noexcept;
+
+  private:
+    const CompiledMap *m_map;
+    compiled::Range m_properties;
+  };
+
+  /**
+   * @brief A read-only view on a compiled terrain.
+   */
+  class CompiledTerrain : public CompiledComponent {
+  public:
+    /**
+     * @brief CompiledTerrain constructor.
+     */
+    CompiledTerrain(const CompiledMap& map, const compiled::Terrain& data)
+      : CompiledComponent(map, data.properties), m_data(&data)
+    {
+    }
+
+    /**
+     * @brief Get the name of the terrain.
+     *
+     * @returns the name of the terrain
+     */
+    const char *getName() const noexcept;
+
+    /**
+     * @brief Get the representing tile for the terrain.
+     *
+     * @returns the representing tile
+     */
+    unsigned getTile() const noexcept {
+      return m_data->tile;
+    }
+
+  private:
+    const compiled::Terrain *m_data;
+  };
+
+  /**
+   * @brief A read-only view on a compiled tile.
+   */
+  class CompiledTile : public CompiledComponent {
+  public:
+    /**
+     * @brief CompiledTile constructor.
+     */
+    CompiledTile(const CompiledMap& map, const compiled::Tile& data)
+      : CompiledComponent(map, data.properties), m_data(&data)
+    {
+    }
+
+    /**
+     * @brief Get the local id of the tile.
+     *
+     * @return the local id of the tile
+     */
+    unsigned getId() const noexcept {
+      return m_data->id;
+    }
+
+    /**
+     * @brief Get the terrain of a corner.
+     *
+     * @param corner the corner (top left, top right, bottom left, bottom right)
+     * @returns the terrain of the corner
+     */
+    unsigned getTerrain(unsigned corner) const noexcept {
+      return m_data->terrain[corner];
+    }
+
+    /**
+     * @brief Get the probability of this tile.
+     *
+     * @return the probability of this tile
+     */
+    unsigned getProbability() const noexcept {
+      return m_data->probability;
+    }
+
+    /**
+     * @brief Tell whether the tile has an image.
+     *
+     * @returns true if the tile has an image
+     */
+    bool hasImage() const noexcept {
+      return m_data->image != compiled::None;
+    }
+
+    /**
+     * @brief Get the image of this tile.
+     *
+     * @returns the image of this tile
+     */
+    CompiledImage getImage() const noexcept;
+
+    /**
+     * @brief Tell whether the tile is animated.
+     *
+     * @returns true if the tile has an animation
+     */
+    bool hasAnimation() const noexcept {
+      return m_data->frames.count > 0;
+    }
+
+    /**
+     * @brief Get the frames of the animation of the tile.
+     *
+     * @returns the frames of the animation, in order
+     */
+    boost::iterator_range<const compiled::Frame *> getAnimation() const noexcept;
+
+    /**
+     * @brief Tell whether the tile has collision shapes.
+     *
+     * @returns true if the tile has an object layer
+     */
+    bool hasObjects() const noexcept {
+      return m_data->objects != compiled::None;
+    }
+
+    /**
+     * @brief Get the collision shapes of the tile.
+     *
+     * @returns the object layer of the tile
+     */
+    CompiledLayer getObjects() const noexcept;
+
+  private:
+    const compiled::Tile *m_data;
+  };
+
+  /**
+   * @brief A read-only view on a compiled tileset.
+   */
+  class CompiledTileSet : public CompiledComponent {
+  public:
+    /**
+     * @brief CompiledTileSet constructor.
+     */
+    CompiledTileSet(const CompiledMap& map, const compiled::TileSet& data)
+      : CompiledComponent(map, data.properties), m_data(&data)
+    {
+    }
+
+    /**
+     * @brief Get the raw data of the tileset.
+     *
+     * @returns the raw data
+     */
+    const compiled::TileSet& getData() const noexcept {
+      return *m_data;
+    }
+
+    /**
+     * @brief Get the first global id of this tileset.
+     *
+     * @return the first global id of the tileset
+     */
+    unsigned getFirstGID() const noexcept {
+      return m_data->firstgid;
+    }
+
+    /**
+     * @brief Get the name of the tileset.
+     *
+     * @return the name of the tileset
+     */
+    const char *getName() const noexcept;
+
+    /**
+     * @brief Get the width of the tiles.
+     *
+     * @return the width of the tiles
+     */
+    unsigned getTileWidth() const noexcept {
+      return m_data->tilewidth;
+    }
+
+    /**
+     * @brief Get the height of the tiles.
+     *
+     * @return the height of the tiles
+     */
+    unsigned getTileHeight() const noexcept {
+      return m_data->tileheight;
+    }
+
+    /**
+     * @brief Get the tile count
+     *
+     * @returns the tile count
+     */
+    unsigned getTileCount() const noexcept {
+      return m_data->tilecount;
+    }
+
+    /**
+     * @brief Tell whether the tileset has an image.
+     *
+     * @returns true if the tileset has an image
+     */
+    bool hasImage() const noexcept {
+      return m_data->image != compiled::None;
+    }
+
+    /**
+     * @brief Get the image associated to the tileset.
+     *
+     * @returns the image associated to the tileset
+     */
+    CompiledImage getImage() const noexcept;
+
+    /**
+     * @brief Get the number of terrains.
+     *
+     * @returns the number of terrains
+     */
+    std::size_t getTerrainCount() const noexcept {
+      return m_data->terrains.count;
+    }
+
+    /**
+     * @brief Get a terrain.
+     *
+     * @param index the index of the terrain
+     * @returns the terrain
+     */
+    CompiledTerrain getTerrain(std::size_t index) const noexcept;
+
+    /**
+     * @brief Get the number of tiles with specific information.
+     *
+     * @returns the number of tiles
+     */
+    std::size_t getTileInfoCount() const noexcept {
+      return m_data->tiles.count;
+    }
+
+    /**
+     * @brief Get a tile with specific information.
+     *
+     * @param index the index of the tile (not its id)
+     * @returns the tile
+     */
+    CompiledTile getTileInfo(std::size_t index) const noexcept;
+
+    /**
+     * @brief Find the tile corresponding to an id.
+     *
+     * @param id the id of the tile
+     * @returns the index of the tile, or getTileInfoCount() if there is none
+     */
+    std::size_t findTileInfo(unsigned id) const noexcept;
+
+  private:
+    const compiled::TileSet *m_data;
+  };
+
+  /**
+   * @brief A read-only view on a compiled object.
+   *
+   * The objects are stored as a structure of arrays, an object is an index
+   * in these arrays.
+   */
+  class CompiledObject : public CompiledComponent {
+  public:
+    /**
+     * @brief CompiledObject constructor.
+     */
+    CompiledObject(const CompiledMap& map, std::size_t index);
+
+    /**
+     * @brief Get the kind of the object.
+     *
+     * @returns the kind of the object (see Object::Kind)
+     */
+    unsigned getKind() const noexcept;
+
+    /**
+     * @brief Get the id of the object.
+     *
+     * @returns the id of the object
+     */
+    unsigned getId() const noexcept;
+
+    /**
+     * @brief Get the name of the object.
+     *
+     * @return the name of the object
+     */
+    const char *getName() const noexcept;
+
+    /**
+     * @brief Get the type of the object.
+     *
+     * @return the type of the object.
+     */
+    const char *getType() const noexcept;
+
+    /**
+     * @brief Get the origin.
+     *
+     * @return the origin
+     */
+    Vector2u getOrigin() const noexcept;
+
+    /**
+     * @brief Get the rotation of the object.
+     *
+     * @return the angle of rotation in degrees clockwise
+     */
+    double getRotation() const noexcept;
+
+    /**
+     * @brief Tell whether this object is visible.
+     *
+     * @returns true if the object is visible
+     */
+    bool isVisible() const noexcept;
+
+    /**
+     * @brief Get the size of the box (rectangles and ellipses).
+     *
+     * @returns the size of the box
+     */
+    Size getSize() const noexcept;
+
+    /**
+     * @brief Get the cell of a tile object.
+     *
+     * @returns the global id and flip flags of the tile
+     */
+    Cell getCell() const noexcept;
+
+    /**
+     * @brief Get the points of a chain (polylines and polygons).
+     *
+     * @returns the points of the chain
+     */
+    boost::iterator_range<const Vector2i *> getPoints() const noexcept;
+
+  private:
+    std::size_t m_index;
+  };
+
+  /**
+   * @brief A read-only view on a compiled layer.
+   */
+  class CompiledLayer : public CompiledComponent {
+  public:
+    /**
+     * @brief CompiledLayer constructor.
+     */
+    CompiledLayer(const CompiledMap& map, const compiled::Layer& data)
+      : CompiledComponent(map, data.properties), m_data(&data)
+    {
+    }
+
+    /**
+     * @brief Get the raw data of the layer.
+     *
+     * @returns the raw data
+     */
+    const compiled::Layer& getData() const noexcept {
+      return *m_data;
+    }
+
+    /**
+     * @brief Tell whether this layer is a tile layer.
+     *
+     * @returns true if the layer is a tile layer
+     */
+    bool isTileLayer() const noexcept {
+      return m_data->kind == compiled::TILE_LAYER;
+    }
+
+    /**
+     * @brief Tell whether this layer is an object layer.
+     *
+     * @returns true if the layer is an object layer
+     */
+    bool isObjectLayer() const noexcept {
+      return m_data->kind == compiled::OBJECT_LAYER;
+    }
+
+    /**
+     * @brief Tell whether this layer is an image layer.
+     *
+     * @returns true if the layer is an image layer
+     */
+    bool isImageLayer() const noexcept {
+      return m_data->kind == compiled::IMAGE_LAYER;
+    }
+
+    /**
+     * @brief Tell whether this layer is a group layer.
+     *
+     * @returns true if the layer is a group layer
+     */
+    bool isGroupLayer() const noexcept {
+      return m_data->kind == compiled::GROUP_LAYER;
+    }
+
+    /**
+     * @brief Get the name of the layer.
+     *
+     * @returns the name of the layer
+     */
+    const char *getName() const noexcept;
+
+    /**
+     * @brief Get the opacity of the layer.
+     *
+     * @returns the opacity of the layer (0.0 is transparent, 1.0 is opaque)
+     */
+    double getOpacity() const noexcept {
+      return m_data->opacity;
+    }
+
+    /**
+     * @brief Tell whether the layer is visible.
+     *
+     * @returns true if the layer is visible
+     */
+    bool isVisible() const noexcept {
+      return m_data->visible != 0;
+    }
+
+    /**
+     * @brief Get the offset of the layer.
+     *
+     * @returns the offset of the layer, in pixels
+     */
+    const Vector2f& getOffset() const noexcept {
+      return m_data->offset;
+    }
+
+    /**
+     * @brief Tell whether the layer is inside a group.
+     *
+     * @returns true if the layer is inside a group
+     */
+    bool hasParent() const noexcept {
+      return m_data->parent != compiled::None;
+    }
+
+    /**
+     * @brief Get the index of the group of the layer.
+     *
+     * @returns the index of the group in the compiled map
+     */
+    std::size_t getParentIndex() const noexcept {
+      return m_data->parent - 1;
+    }
+
+    /**
+     * @brief Get the number of layers inside a group layer.
+     *
+     * The layers inside the group, nested groups included, follow the group
+     * in the compiled map.
+     *
+     * @returns the number of layers inside the group
+     */
+    std::size_t getDescendantCount() const noexcept {
+      return isGroupLayer() ? m_data->content.count : 0;
+    }
+
+    /**
+     * @brief Get a raw cell of a tile layer.
+     *
+     * @param x the x coordinate of the cell
+     * @param y the y coordinate of the cell
+     * @returns the global id of the cell with the flip flags
+     * @sa Cell::fromRawGID()
+     */
+    unsigned getRawGID(unsigned x, unsigned y) const noexcept;
+
+    /**
+     * @brief Get a cell of a tile layer.
+     *
+     * @param x the x coordinate of the cell
+     * @param y the y coordinate of the cell
+     * @returns the cell
+     */
+    Cell getCell(unsigned x, unsigned y) const noexcept {
+      return Cell::fromRawGID(getRawGID(x, y));
+    }
+
+    /**
+     * @brief Get the number of objects of an object layer.
+     *
+     * @returns the number of objects
+     */
+    std::size_t getObjectCount() const noexcept {
+      return isObjectLayer() ? m_data->content.count : 0;
+    }
+
+    /**
+     * @brief Get an object of an object layer.
+     *
+     * @param index the index of the object in the layer
+     * @returns the object
+     */
+    CompiledObject getObject(std::size_t index) const noexcept {
+      return CompiledObject(getMap(), m_data->content.first + index);
+    }
+
+    /**
+     * @brief Get the color used to display the objects of an object layer.
+     *
+     * @return the color to display the objects
+     */
+    const char *getColor() const noexcept;
+
+    /**
+     * @brief Get the draw order of an object layer.
+     *
+     * @returns the draw order
+     */
+    DrawOrder getDrawOrder() const noexcept;
+
+    /**
+     * @brief Tell whether an image layer has an image.
+     *
+     * @returns true if the layer has an image
+     */
+    bool hasImage() const noexcept {
+      return m_data->image != compiled::None;
+    }
+
+    /**
+     * @brief Get the image of an image layer.
+     *
+     * @returns the image
+     */
+    CompiledImage getImage() const noexcept;
+
+  private:
+    const compiled::Layer *m_data;
+  };
+
+  /**
+   * @brief A compiled map is a read-only map in a binary format.
+   *
+   * A compiled map is produced from a parsed map by compile(). The compiled
+   * data can be saved in a file and then used directly from memory, without
+   * any parsing or decoding: opening a compiled map only checks its header
+   * and the bounds of its sections, so that opening is cheap whatever the
+   * size of the map. The references between the sections are checked on
+   * demand by validate(), which must be called before using a compiled map
+   * from an untrusted source.
+   * The structure and the names of the functions follow the structure of a
+   * Map, and a full Map can be rebuilt with toMap().
+   *
+   * The view itself only needs the standard library and Boost.Range, so it
+   * can be used without the parser, for example with the data generated by
+   * `tmx2cpp`.
+   *
+   * @sa Map::openCompiled(), Map::saveCompiled()
+   */
+  class CompiledMap : public CompiledComponent {
+  public:
+    /**
+     * @name Properties
+     * @{
+     */
+    /**
+     * @brief Get the raw header of the compiled map.
+     *
+     * @returns the header
+     */
+    const compiled::Header& getHeader() const noexcept {
+      return *m_header;
+    }
+
+    /**
+     * @brief Get the version of the TMX format.
+     *
+     * @returns the version of the TMX format (generally "1.0")
+     */
+    const char *getVersion() const noexcept {
+      return getString(m_header->mapVersion);
+    }
+
+    /**
+     * @brief Get the orientation of the map.
+     *
+     * @returns the orientation of the map
+     */
+    Orientation getOrientation() const noexcept;
+
+    /**
+     * @brief Get the width of the map.
+     *
+     * @returns the width of the map (in number of tiles)
+     */
+    unsigned getWidth() const noexcept {
+      return m_header->width;
+    }
+
+    /**
+     * @brief Get the height of the map.
+     *
+     * @returns the height of the map (in number of tiles)
+     */
+    unsigned getHeight() const noexcept {
+      return m_header->height;
+    }
+
+    /**
+     * @brief Get the width of tiles.
+     *
+     * @returns the width of tiles (in pixels)
+     */
+    unsigned getTileWidth() const noexcept {
+      return m_header->tilewidth;
+    }
+
+    /**
+     * @brief Get the height of tiles.
+     *
+     * @returns the height of tiles (in pixels)
+     */
+    unsigned getTileHeight() const noexcept {
+      return m_header->tileheight;
+    }
+
+    /**
+     * @brief Get the background color.
+     *
+     * @returns the background color
+     */
+    const char *getBackgroundColor() const noexcept {
+      return getString(m_header->backgroundColor);
+    }
+
+    /**
+     * @brief Get the render order.
+     *
+     * @returns the render order
+     */
+    RenderOrder getRenderOrder() const noexcept;
+
+    /**
+     * @brief Get the next object id.
+     *
+     * @returns the next object id.
+     */
+    unsigned getNextObjectId() const noexcept {
+      return m_header->nextObjectId;
+    }
+
+    /**
+     * @brief Get the size of the side of a chunk.
+     *
+     * @returns the size of the side of a chunk, in tiles
+     */
+    unsigned getChunkSize() const noexcept {
+      return m_header->chunkSize;
+    }
+    /** @} */
+
+    /**
+     * @name Tilesets and layers
+     * @{
+     */
+    /**
+     * @brief Get the number of tilesets.
+     *
+     * @returns the number of tilesets
+     */
+    std::size_t getTileSetCount() const noexcept {
+      return getCount(compiled::TILESETS);
+    }
+
+    /**
+     * @brief Get a tileset.
+     *
+     * @param index the index of the tileset
+     * @returns the tileset
+     */
+    CompiledTileSet getTileSet(std::size_t index) const noexcept {
+      return CompiledTileSet(*this, getSection<compiled::TileSet>(compiled::TILESETS)[index]);
+    }
+
+    /**
+     * @brief Get the index of the tileset corresponding to a global id.
+     *
+     * @param gid a global id
+     * @returns the index of the tileset, or getTileSetCount() if there is none
+     */
+    std::size_t getTileSetIndexFromGID(unsigned gid) const noexcept;
+
+    /**
+     * @brief Get the number of layers.
+     *
+     * @returns the number of layers, group layers and the layers inside them included
+     */
+    std::size_t getLayerCount() const noexcept {
+      return getCount(compiled::LAYERS);
+    }
+
+    /**
+     * @brief Get a layer.
+     *
+     * @param index the index of the layer
+     * @returns the layer
+     */
+    CompiledLayer getLayer(std::size_t index) const noexcept {
+      return CompiledLayer(*this, getSection<compiled::Layer>(compiled::LAYERS)[index]);
+    }
+    /** @} */
+
+    /**
+     * @name Raw access
+     * @{
+     */
+    /**
+     * @brief Get the beginning of a section.
+     *
+     * @param id the identifier of the section
+     * @returns a pointer to the first element of the section
+     */
+    template<typename T>
+    const T *getSection(compiled::SectionId id) const noexcept {
+      return reinterpret_cast<const T *>(m_data + m_header->sections[id].offset);
+    }
+
+    /**
+     * @brief Get the number of elements in a section.
+     *
+     * @param id the identifier of the section
+     * @returns the number of elements
+     */
+    std::size_t getCount(compiled::SectionId id) const noexcept {
+      return m_header->sections[id].count;
+    }
+
+    /**
+     * @brief Get an interned string.
+     *
+     * @param index the index of the string
+     * @returns the string, or an empty string if the index is invalid
+     */
+    const char *getString(uint32_t index) const noexcept {
+      if (index >= getCount(compiled::STRING_OFFSETS)) {
+        return "";
+      }
+
+      return getSection<char>(compiled::STRING_DATA) + getSection<uint32_t>(compiled::STRING_OFFSETS)[index];
+    }
+
+    /**
+     * @brief Get the compiled data.
+     *
+     * @returns the beginning of the compiled data
+     */
+    const char *getData() const noexcept {
+      return m_data;
+    }
+
+    /**
+     * @brief Get the size of the compiled data.
+     *
+     * @returns the size of the compiled data
+     */
+    std::size_t getSize() const noexcept {
+      return m_header->size;
+    }
+    /** @} */
+
+    /**
+     * @name Conversion
+     * @{
+     */
+    /**
+     * @brief Rebuild a full map from the compiled map.
+     *
+     * @returns a map equivalent to the map that was compiled
+     */
+    std::unique_ptr<Map> toMap() const;
+
+    /**
+     * @brief Compile a map.
+     *
+     * @param map the map
+     * @param chunkSize the size of the side of a chunk, in tiles
+     * @returns the compiled data
+     */
+    static std::vector<char> compile(const Map& map, unsigned chunkSize = compiled::DefaultChunkSize);
+
+    /**
+     * @brief Use compiled data in memory.
+     *
+     * The data is not copied, it must be aligned on 8 bytes and stay valid
+     * as long as the compiled map exists, which can be ensured by giving an
+     * owner of the memory. Only the header and the bounds of the sections
+     * are checked, the ranges and indices inside the sections are checked by
+     * validate().
+     *
+     * @param data the compiled data
+     * @param size the size of the compiled data
+     * @param owner an optional owner of the data, destroyed with the compiled map
+     * @returns the compiled map, or nullptr if the data is not a valid compiled map
+     */
+    static std::unique_ptr<CompiledMap> fromMemory(const void *data, std::size_t size, std::shared_ptr<const void> owner = nullptr);
+
+    /**
+     * @brief Check all the references inside the compiled data.
+     *
+     * The ranges, the optional indices, the string offsets, the cells of
+     * the chunks, the object references and the nesting of the group layers
+     * are checked, so that following them never reads outside the data.
+     * The whole data is read, so the check is done only when asked, for
+     * example for a file that may be corrupted.
+     *
+     * @returns true if the compiled map is valid
+     */
+    bool validate() const;
+    /** @} */
+
+  private:
+    CompiledMap(const char *data, std::shared_ptr<const void> owner);
+
+  private:
+    const char *m_data;
+    const compiled::Header *m_header;
+    std::shared_ptr<const void> m_owner;
+  };
+
+}
+
+#endif // TMX_COMPILED_MAP_H
@@ -23,6 +23,9 @@ namespace tmx {
 
   /**
    * @brief A base class for classes that have properties.
+   *
+   * A component may have defaults: another component that gives the
+   * properties this component does not define, without copying them.
    */
   class Component {
   public:
@@ -30,6 +33,8 @@ namespace tmx {
     /**
      * @brief Tell if the object has a given property.
      *
+     * The property may come from the defaults.
+     *
      * @param key the property key
      * @returns true if the object has the given property
      */
@@ -38,6 +43,9 @@ namespace tmx {
     /**
      * @brief Get a property value.
      *
+     * The value comes from the defaults if the component does not define
+     * the property.
+     *
      * @param key the property key
      * @param def a default value if the property does not exist
      * @returns the value of the given property
@@ -52,8 +60,64 @@ namespace tmx {
      */
     bool addProperty(const std::string& key, const std::string& value);
 
+    /**
+     * @brief Set a property, replacing its previous value if any.
+     *
+     * @param key the property key
+     * @param value the property value
+     * @returns true if the property has been added or its value changed
+     */
+    bool setProperty(const std::string& key, const std::string& value);
+
+    /**
+     * @brief Remove a property.
+     *
+     * @param key the property key
+     * @returns true if the property existed
+     */
+    bool removeProperty(const std::string& key);
+
+    /**
+     * @brief Get all the properties.
+     *
+     * The properties of the defaults are not included.
+     *
+     * @returns the properties, sorted by key
+     */
+    const std::map<std::string, std::string>& getProperties() const noexcept {
+      return m_prop;
+    }
+
+    /**
+     * @brief Get all the properties, including the defaults.
+     *
+     * @returns a copy of the properties and the defaults they do not override, sorted by key
+     */
+    std::map<std::string, std::string> getAllProperties() const;
+
+    /**
+     * @brief Get the defaults of the component.
+     *
+     * @returns the component that gives the missing properties, or null
+     */
+    const Component *getDefaults() const noexcept {
+      return m_defaults;
+    }
+
+    /**
+     * @brief Set the defaults of the component.
+     *
+     * The defaults must outlive the component.
+     *
+     * @param defaults the component that gives the missing properties, or null
+     */
+    void setDefaults(const Component *defaults) noexcept {
+      m_defaults = defaults;
+    }
+
   private:
     std::map<std::string, std::string> m_prop;
+    const Component *m_defaults = nullptr;
   };
 
 
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_COMPRESSION_DICTIONARY_H
+#define TMX_COMPRESSION_DICTIONARY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "FileSystem.h"
+
+namespace tmx {
+
+  /**
+   * @brief A preset dictionary for the zlib compression of tile layers.
+   *
+   * Maps that share their structure compress better when the compressor
+   * starts with a dictionary of the data they have in common. A map refers
+   * to its dictionary with the `compressiondictionary` property, the path
+   * of the dictionary relative to the TMX file. The parser uses it to
+   * decode the zlib layers and the writer uses it to encode them.
+   *
+   * The gzip format has no preset dictionary, so gzip layers never use a
+   * dictionary.
+   */
+  class CompressionDictionary {
+  public:
+    /**
+     * @brief The maximum size of a dictionary.
+     *
+     * It is the size of the zlib window: the compressor can not refer to
+     * the bytes before.
+     */
+    static constexpr std::size_t MaxSize = 32768;
+
+    /**
+     * @brief The default size of a trained dictionary.
+     *
+     * The decoder copies the whole dictionary in its window for each layer,
+     * so a large dictionary slows down the decoding of small layers more
+     * than it reduces their size.
+     */
+    static constexpr std::size_t DefaultSize = 8192;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param data the content of the dictionary
+     */
+    explicit CompressionDictionary(std::vector<uint8_t> data);
+
+    /**
+     * @brief Get the content of the dictionary.
+     *
+     * @returns the content of the dictionary
+     */
+    const uint8_t *getData() const noexcept {
+      return m_data.data();
+    }
+
+    /**
+     * @brief Get the size of the dictionary.
+     *
+     * @returns the size of the dictionary
+     */
+    std::size_t getSize() const noexcept {
+      return m_data.size();
+    }
+
+    /**
+     * @brief Get the identifier of the dictionary.
+     *
+     * The identifier is the Adler-32 checksum that zlib records in the
+     * streams compressed with the dictionary.
+     *
+     * @returns the identifier of the dictionary
+     */
+    uint32_t getId() const noexcept {
+      return m_id;
+    }
+
+    /**
+     * @brief Save the dictionary in a file.
+     *
+     * @param filename the name of the file
+     * @returns true if the dictionary has been saved
+     */
+    bool save(const boost::filesystem::path& filename) const;
+
+    /**
+     * @brief Get the name of the map property that refers to a dictionary.
+     *
+     * @returns the name of the property
+     */
+    static const char *getPropertyName() noexcept {
+      return "compressiondictionary";
+    }
+
+    /**
+     * @brief Load a dictionary.
+     *
+     * A dictionary is loaded once for the whole process: the following
+     * calls with the same path return the same dictionary, as long as the
+     * content of the file does not change.
+     *
+     * @param filename the name of the file of the dictionary
+     * @param filesystem the file system of the file
+     * @returns the dictionary or null if the file can not be read
+     */
+    static std::shared_ptr<const CompressionDictionary> load(const boost::filesystem::path& filename, FileSystem& filesystem = FileSystem::getDefault());
+
+    /**
+     * @brief Train a dictionary on some samples.
+     *
+     * The samples are the uncompressed data of the tile layers of a corpus
+     * of maps. The dictionary gathers the sequences of cells that appear
+     * in the largest number of samples, the most common at the end where
+     * zlib encodes them with the shortest distances.
+     *
+     * @param samples the uncompressed data of the tile layers
+     * @param size the maximum size of the dictionary
+     * @returns the dictionary
+     */
+    static std::shared_ptr<const CompressionDictionary> train(const std::vector<std::vector<uint8_t>>& samples, std::size_t size = DefaultSize);
+
+  private:
+    std::vector<uint8_t> m_data;
+    uint32_t m_id;
+  };
+
+}
+
+#endif // TMX_COMPRESSION_DICTIONARY_H
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_CONCURRENT_TILE_EDITOR_H
+#define TMX_CONCURRENT_TILE_EDITOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Cell.h"
+#include "CompiledMap.h"
+#include "Geometry.h"
+#include "Map.h"
+#include "MapEditor.h"
+#include "TileLayer.h"
+
+namespace tmx {
+
+  /**
+   * @brief An edit of a cell.
+   */
+  struct CellEdit {
+    unsigned x; /**< the x coordinate of the cell */
+    unsigned y; /**< the y coordinate of the cell */
+    Cell cell;  /**< the new cell */
+  };
+
+  /**
+   * @brief A concurrent tile editor lets many threads edit a tile layer.
+   *
+   * The layer is partitioned in chunks, and each chunk has its own lock:
+   * writers on different chunks never wait for each other, and there is no
+   * global lock. A batch of edits is grouped by chunk so that each chunk is
+   * locked once per batch. Within a chunk, the edits are applied in the
+   * order of the batch.
+   *
+   * The dirty chunks are recorded in an atomic bitmap, and can be
+   * transferred to a dirty set at any time.
+   *
+   * The layer must not be used by other means while it is edited.
+   */
+  class ConcurrentTileEditor {
+  public:
+    /**
+     * @brief ConcurrentTileEditor constructor.
+     *
+     * @param map the edited map
+     * @param layer the index of the tile layer in Map::getAllLayers()
+     * @param chunkSize the size of a chunk (in number of tiles)
+     */
+    ConcurrentTileEditor(Map& map, unsigned layer, unsigned chunkSize = compiled::DefaultChunkSize);
+
+    ConcurrentTileEditor(const ConcurrentTileEditor&) = delete;
+    ConcurrentTileEditor& operator=(const ConcurrentTileEditor&) = delete;
+
+    /**
+     * @brief Tell whether the editor has a tile layer.
+     *
+     * @returns true if the layer is a tile layer with a cell for each tile of the map
+     */
+    bool isValid() const noexcept {
+      return m_layer != nullptr;
+    }
+
+    /**
+     * @brief Get the size of a chunk.
+     *
+     * @returns the size of a chunk (in number of tiles)
+     */
+    unsigned getChunkSize() const noexcept {
+      return m_chunkSize;
+    }
+
+    /**
+     * @brief Get a cell.
+     *
+     * @param x the x coordinate of the cell
+     * @param y the y coordinate of the cell
+     * @returns the cell, or an empty cell if there is no such cell
+     */
+    Cell getCell(unsigned x, unsigned y) const;
+
+    /**
+     * @brief Set a cell.
+     *
+     * @param x the x coordinate of the cell
+     * @param y the y coordinate of the cell
+     * @param cell the new cell
+     * @returns true if the cell changed
+     */
+    bool setCell(unsigned x, unsigned y, Cell cell);
+
+    /**
+     * @brief Apply a batch of edits.
+     *
+     * The edits outside the map are ignored.
+     *
+     * @param edits the edits
+     * @returns the number of cells that changed
+     */
+    std::size_t apply(const std::vector<CellEdit>& edits);
+
+    /**
+     * @brief Take the dirty chunks.
+     *
+     * @returns the coordinates of the chunks that changed since the last call
+     */
+    std::vector<Vector2u> takeDirtyChunks();
+
+    /**
+     * @brief Move the dirty chunks to a dirty set.
+     *
+     * The dirty set must have the same geometry as the editor.
+     *
+     * @param dirty the dirty set
+     */
+    void takeDirtyChunks(DirtySet& dirty);
+
+  private:
+    std::size_t getChunkIndex(unsigned x, unsigned y) const noexcept {
+      return (y / m_chunkSize) * m_chunkColumns + (x / m_chunkSize);
+    }
+
+    bool setCellLocked(unsigned x, unsigned y, Cell cell);
+    void markChunk(std::size_t chunk);
+
+  private:
+    TileLayer *m_layer;
+    unsigned m_index;
+    unsigned m_width;
+    unsigned m_height;
+    unsigned m_chunkSize;
+    unsigned m_chunkColumns;
+    unsigned m_chunkRows;
+
+    std::unique_ptr<std::mutex[]> m_locks;
+    std::unique_ptr<std::atomic<uint64_t>[]> m_dirty;
+    std::size_t m_dirtyWords;
+  };
+
+}
+
+#endif // TMX_CONCURRENT_TILE_EDITOR_H
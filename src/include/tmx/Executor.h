@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_EXECUTOR_H
+#define TMX_EXECUTOR_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+namespace tmx {
+
+  /**
+   * @brief Some counters about the activity of an executor.
+   */
+  struct ExecutorStatistics {
+    uint64_t tasksRun;                    /**< the number of tasks that have been run */
+    std::chrono::nanoseconds stealTime;   /**< the time spent looking for tasks in other queues */
+    std::chrono::nanoseconds idleTime;    /**< the time spent waiting for tasks */
+  };
+
+  /**
+   * @brief An executor runs tasks on behalf of the library.
+   *
+   * Every parallel or asynchronous operation of the library is submitted to
+   * an executor, either explicitly given or the default executor. The
+   * default executor can be replaced, so that the library can be integrated
+   * in an existing job system and never creates threads by itself.
+   *
+   * @sa WorkStealingExecutor
+   */
+  class Executor {
+  public:
+    /**
+     * @brief Executor destructor.
+     */
+    virtual ~Executor();
+
+    /**
+     * @brief Submit a task for execution.
+     *
+     * The task may be run on any thread, at any time after the call.
+     *
+     * @param task the task to run
+     */
+    virtual void execute(std::function<void()> task) = 0;
+
+    /**
+     * @brief Get the statistics of the executor.
+     *
+     * By default, all the counters are zero.
+     *
+     * @returns the statistics of the executor
+     */
+    virtual ExecutorStatistics getStatistics() const;
+
+    /**
+     * @name Default executor
+     * @{
+     */
+    /**
+     * @brief Get the default executor.
+     *
+     * If no default executor has been set, a work-stealing executor with as
+     * many threads as hardware threads is created at the first call.
+     *
+     * @returns the default executor
+     */
+    static Executor& getDefault();
+
+    /**
+     * @brief Set the default executor.
+     *
+     * The executor must outlive every use of the library.
+     *
+     * @param executor the new default executor, or nullptr to restore the
+     * library executor
+     */
+    static void setDefault(Executor *executor);
+    /** @} */
+  };
+
+}
+
+#endif // TMX_EXECUTOR_H
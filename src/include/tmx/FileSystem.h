@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_FILE_SYSTEM_H
+#define TMX_FILE_SYSTEM_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+namespace tmx {
+
+  /**
+   * @brief A file is an opened file of a file system.
+   */
+  class File {
+  public:
+    /**
+     * @brief File destructor.
+     */
+    virtual ~File();
+
+    /**
+     * @brief Get the size of the file.
+     *
+     * @returns the size of the file (in bytes)
+     */
+    virtual std::size_t getSize() const = 0;
+
+    /**
+     * @brief Read a part of the file.
+     *
+     * @param offset the offset of the first byte to read
+     * @param buffer the buffer where the bytes are copied
+     * @param size the number of bytes to read
+     * @returns the number of bytes actually read
+     */
+    virtual std::size_t read(std::size_t offset, void *buffer, std::size_t size) = 0;
+
+    /**
+     * @brief Map the whole file in memory.
+     *
+     * The memory is valid as long as the file is not destroyed.
+     *
+     * @returns the content of the file, or nullptr in case of error
+     */
+    virtual const char *map() = 0;
+  };
+
+  /**
+   * @brief A file system gives access to the files needed by the library.
+   *
+   * Every file read by the library (TMX files, TSX files) is opened through
+   * a file system, either explicitly given or the default file system.
+   *
+   * @sa NativeFileSystem, AssetPack
+   */
+  class FileSystem {
+  public:
+    /**
+     * @brief FileSystem destructor.
+     */
+    virtual ~FileSystem();
+
+    /**
+     * @brief Open a file.
+     *
+     * @param path the path of the file
+     * @returns the opened file, or nullptr if the file is not a regular file
+     */
+    virtual std::unique_ptr<File> open(const boost::filesystem::path& path) = 0;
+
+    /**
+     * @brief List the regular files of a directory.
+     *
+     * The default implementation can not list any directory.
+     *
+     * @param directory the path of the directory
+     * @param files the names of the files, relative to the directory, in no particular order
+     * @returns true if the directory has been listed
+     */
+    virtual bool list(const boost::filesystem::path& directory, std::vector<boost::filesystem::path>& files);
+
+    /**
+     * @name Default file system
+     * @{
+     */
+    /**
+     * @brief Get the default file system.
+     *
+     * If no default file system has been set, it is the native file system.
+     *
+     * @returns the default file system
+     */
+    static FileSystem& getDefault();
+
+    /**
+     * @brief Set the default file system.
+     *
+     * The file system must outlive every use of the library.
+     *
+     * @param filesystem the new default file system, or nullptr to restore
+     * the native file system
+     */
+    static void setDefault(FileSystem *filesystem);
+    /** @} */
+  };
+
+  /**
+   * @brief The file system of the operating system.
+   */
+  class NativeFileSystem : public FileSystem {
+  public:
+    virtual std::unique_ptr<File> open(const boost::filesystem::path& path) override;
+    virtual bool list(const boost::filesystem::path& directory, std::vector<boost::filesystem::path>& files) override;
+  };
+
+}
+
+#endif // TMX_FILE_SYSTEM_H
@@ -52,6 +52,14 @@ namespace tmx {
     int y; /**< the y coordinate */
   };
 
+  /**
+   * @brief A vector of floats.
+   */
+  struct Vector2f {
+    float x; /**< the x coordinate */
+    float y; /**< the y coordinate */
+  };
+
 }
 
 
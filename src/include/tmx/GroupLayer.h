@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_GROUP_LAYER_H
+#define TMX_GROUP_LAYER_H
+
+#include <memory>
+#include <vector>
+
+#include <boost/range/adaptor/transformed.hpp>
+
+#include "Adaptor.h"
+#include "Layer.h"
+
+namespace tmx {
+
+  /**
+   * @brief A group layer is a layer that contains other layers.
+   *
+   * The opacity, the visibility and the offset of a group apply to all the
+   * layers of the group, groups included.
+   *
+   * @sa Map::getFlattenedLayers
+   */
+  class GroupLayer : public Layer {
+  public:
+    /**
+     * @brief GroupLayer constructor.
+     */
+    GroupLayer(const std::string& name, double opacity, bool visible)
+      : Layer(name, opacity, visible)
+    {
+    }
+
+    virtual void accept(const Map& map, LayerVisitor& visitor) const override;
+
+    /**
+     * @brief A layer range.
+     */
+    typedef boost::transformed_range<Adaptor, const boost::iterator_range<std::vector<std::unique_ptr<Layer>>::const_iterator>> const_layer_range;
+
+    /**
+     * @brief Add a layer to the group.
+     *
+     * @param layer the layer
+     */
+    void addLayer(std::unique_ptr<Layer> layer) {
+      m_layers.emplace_back(std::move(layer));
+    }
+
+    /**
+     * @brief Get the number of layers of the group.
+     *
+     * @returns the number of layers
+     */
+    std::size_t getLayerCount() const noexcept {
+      return m_layers.size();
+    }
+
+    /**
+     * @brief Get a layer of the group.
+     *
+     * @param index the index of the layer
+     * @returns the layer, or nullptr if the index is out of range
+     */
+    const Layer *getLayer(std::size_t index) const noexcept {
+      return index < m_layers.size() ? m_layers[index].get() : nullptr;
+    }
+
+    /**
+     * @brief Get a layer of the group.
+     *
+     * @param index the index of the layer
+     * @returns the layer, or nullptr if the index is out of range
+     */
+    Layer *getLayer(std::size_t index) noexcept {
+      return index < m_layers.size() ? m_layers[index].get() : nullptr;
+    }
+
+    /**
+     * @brief Get the layers of the group.
+     *
+     * @returns a layer range
+     */
+    const_layer_range getLayers() const noexcept {
+      return boost::make_iterator_range(m_layers) | boost::adaptors::transformed(Adaptor());
+    }
+
+  private:
+    std::vector<std::unique_ptr<Layer>> m_layers;
+  };
+
+}
+
+#endif // TMX_GROUP_LAYER_H
@@ -16,7 +16,10 @@
 #ifndef TMX_IMAGE_H
 #define TMX_IMAGE_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include <boost/filesystem.hpp>
 
@@ -26,6 +29,9 @@ namespace tmx {
 
   /**
    * @brief An image is an image file on the system.
+   *
+   * The image file may also be embedded in the map. Then, the image has
+   * no source and its data is the content of the file.
    */
   class Image {
   public:
@@ -101,6 +107,44 @@ namespace tmx {
       return { m_width, m_height };
     }
 
+    /**
+     * @brief Set the embedded data of the image.
+     *
+     * @param data the content of the image file, in the format of the image
+     */
+    void setData(std::vector<uint8_t> data) {
+      m_data = std::move(data);
+    }
+
+    /**
+     * @brief Tell whether the image is embedded in the map.
+     *
+     * @returns true if the image has embedded data
+     */
+    bool hasData() const noexcept {
+      return !m_data.empty();
+    }
+
+    /**
+     * @brief Get the embedded data of the image.
+     *
+     * The data is owned by the image, it is not copied.
+     *
+     * @returns the content of the image file
+     */
+    const uint8_t *getData() const noexcept {
+      return m_data.data();
+    }
+
+    /**
+     * @brief Get the size of the embedded data of the image.
+     *
+     * @returns the size of the data, in bytes
+     */
+    std::size_t getDataSize() const noexcept {
+      return m_data.size();
+    }
+
   private:
     const std::string m_format;
     const boost::filesystem::path m_source;
@@ -108,6 +152,8 @@ namespace tmx {
 
     const unsigned m_width;
     const unsigned m_height;
+
+    std::vector<uint8_t> m_data;
   };
 
 }
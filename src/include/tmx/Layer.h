@@ -17,6 +17,7 @@
 #define TMX_LAYER_BASE_H
 
 #include "Component.h"
+#include "Geometry.h"
 
 namespace tmx {
   class LayerVisitor;
@@ -25,7 +26,8 @@ namespace tmx {
   /**
    * @brief A layer is a layer in the whole map.
    *
-   * There are three kinds of layers: image layers, tile layers and object layers.
+   * There are four kinds of layers: image layers, tile layers, object layers
+   * and group layers.
    */
   class Layer : public Component {
   public:
@@ -33,7 +35,7 @@ namespace tmx {
      * @brief Layer constructor.
      */
     Layer(const std::string& name, double opacity, bool visible)
-      : m_name(name), m_opacity(opacity), m_visible(visible)
+      : m_name(name), m_opacity(opacity), m_visible(visible), m_offset{ 0.0f, 0.0f }
     {
     }
 
@@ -67,6 +69,15 @@ namespace tmx {
       return m_opacity;
     }
 
+    /**
+     * @brief Set the opacity of the layer.
+     *
+     * @param opacity the opacity of the layer (0.0 is transparent, 1.0 is opaque)
+     */
+    void setOpacity(double opacity) noexcept {
+      m_opacity = opacity;
+    }
+
     /**
      * @brief Tell whether the layer is visible.
      *
@@ -76,10 +87,41 @@ namespace tmx {
       return m_visible;
     }
 
+    /**
+     * @brief Show or hide the layer.
+     *
+     * @param visible true if the layer is visible
+     */
+    void setVisible(bool visible) noexcept {
+      m_visible = visible;
+    }
+
+    /**
+     * @brief Set the offset of the layer.
+     *
+     * @param x the x coordinate of the offset, in pixels
+     * @param y the y coordinate of the offset, in pixels
+     */
+    void setOffset(float x, float y) noexcept {
+      m_offset = { x, y };
+    }
+
+    /**
+     * @brief Get the offset of the layer.
+     *
+     * The offset is relative to the group of the layer, if any.
+     *
+     * @returns the offset of the layer, in pixels
+     */
+    const Vector2f& getOffset() const noexcept {
+      return m_offset;
+    }
+
   private:
     const std::string m_name;
     double m_opacity;
     bool m_visible;
+    Vector2f m_offset;
 
   };
 
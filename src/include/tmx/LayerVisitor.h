@@ -21,6 +21,7 @@ namespace tmx {
   class TileLayer;
   class ObjectLayer;
   class ImageLayer;
+  class GroupLayer;
 
   /**
    * @brief A layer visitor is a visitor for layers in the visitor pattern.
@@ -52,6 +53,15 @@ namespace tmx {
      * @param layer the image layer
      */
     virtual void visitImageLayer(const Map& map, const ImageLayer& layer);
+
+    /**
+     * @brief Visit a group layer.
+     *
+     * By default, the layers of the group are visited.
+     *
+     * @param layer the group layer
+     */
+    virtual void visitGroupLayer(const Map& map, const GroupLayer& layer);
   };
 
 }
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_LOAD_PROGRESS_H
+#define TMX_LOAD_PROGRESS_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace tmx {
+
+  /**
+   * @brief The progress of a map loading.
+   *
+   * A load progress is shared between the thread that loads a map and the
+   * threads that want to observe the loading. All the functions are
+   * thread-safe. The loading can be cancelled at any time, it is then
+   * stopped before the next tileset or the next layer.
+   */
+  class LoadProgress {
+  public:
+    /**
+     * @brief LoadProgress constructor.
+     */
+    LoadProgress()
+      : m_bytes(0), m_tilesets(0), m_tilesetCount(0), m_layers(0), m_layerCount(0), m_cancelled(false)
+    {
+    }
+
+    /**
+     * @name Progress
+     * @{
+     */
+    /**
+     * @brief Get the number of bytes read from files (TMX and TSX).
+     *
+     * @returns the number of bytes read
+     */
+    std::size_t getBytesRead() const noexcept {
+      return m_bytes.load();
+    }
+
+    /**
+     * @brief Get the number of tilesets that have been decoded.
+     *
+     * @returns the number of decoded tilesets
+     */
+    unsigned getTileSetsDecoded() const noexcept {
+      return m_tilesets.load();
+    }
+
+    /**
+     * @brief Get the number of tilesets in the map.
+     *
+     * @returns the number of tilesets, or 0 if the map is not read yet
+     */
+    unsigned getTileSetCount() const noexcept {
+      return m_tilesetCount.load();
+    }
+
+    /**
+     * @brief Get the number of layers that have been decoded.
+     *
+     * @returns the number of decoded layers
+     */
+    unsigned getLayersDecoded() const noexcept {
+      return m_layers.load();
+    }
+
+    /**
+     * @brief Get the number of layers in the map.
+     *
+     * @returns the number of layers, or 0 if the map is not read yet
+     */
+    unsigned getLayerCount() const noexcept {
+      return m_layerCount.load();
+    }
+    /** @} */
+
+    /**
+     * @name Cancellation
+     * @{
+     */
+    /**
+     * @brief Cancel the loading.
+     *
+     * The loading stops before the next tileset or layer and the result of
+     * the loading is a null map.
+     */
+    void cancel() noexcept {
+      m_cancelled.store(true);
+    }
+
+    /**
+     * @brief Tell whether the loading has been cancelled.
+     *
+     * @returns true if the loading has been cancelled
+     */
+    bool isCancelled() const noexcept {
+      return m_cancelled.load();
+    }
+    /** @} */
+
+    /**
+     * @name Reporting
+     * @{
+     */
+    /**
+     * @brief Report that some bytes have been read.
+     *
+     * @param bytes the number of bytes
+     */
+    void addBytesRead(std::size_t bytes) noexcept {
+      m_bytes.fetch_add(bytes);
+    }
+
+    /**
+     * @brief Report the number of tilesets and layers in the map.
+     *
+     * @param tilesets the number of tilesets
+     * @param layers the number of layers
+     */
+    void setCounts(unsigned tilesets, unsigned layers) noexcept {
+      m_tilesetCount.store(tilesets);
+      m_layerCount.store(layers);
+    }
+
+    /**
+     * @brief Report that a tileset has been decoded.
+     */
+    void addTileSetDecoded() noexcept {
+      m_tilesets.fetch_add(1);
+    }
+
+    /**
+     * @brief Report that a layer has been decoded.
+     */
+    void addLayerDecoded() noexcept {
+      m_layers.fetch_add(1);
+    }
+    /** @} */
+
+  private:
+    std::atomic<std::size_t> m_bytes;
+    std::atomic<unsigned> m_tilesets;
+    std::atomic<unsigned> m_tilesetCount;
+    std::atomic<unsigned> m_layers;
+    std::atomic<unsigned> m_layerCount;
+    std::atomic<bool> m_cancelled;
+  };
+
+}
+
+#endif // TMX_LOAD_PROGRESS_H
@@ -18,6 +18,7 @@
 
 #include <cstddef>
 
+#include <future>
 #include <memory>
 #include <string>
 #include <vector>
@@ -25,9 +26,15 @@
 #include <boost/filesystem.hpp>
 #include <boost/range/iterator_range.hpp>
 
+#include "CompiledMap.h"
 #include "Component.h"
+#include "Executor.h"
+#include "FileSystem.h"
+#include "Geometry.h"
 #include "Layer.h"
 #include "LayerVisitor.h"
+#include "LoadProgress.h"
+#include "ParseVisitor.h"
 #include "TileSet.h"
 
 /**
@@ -35,6 +42,8 @@
  */
 namespace tmx {
 
+  class CompressionDictionary;
+
   /**
    * @brief the orientation of the map.
    */
@@ -72,6 +81,33 @@ namespace tmx {
     LEFT_UP,    /**< Left up order */
   };
 
+  /**
+   * @brief The encoding of the cells of the tile layers in a TMX file.
+   */
+  enum class LayerEncoding {
+    XML,          /**< One XML element for each cell */
+    CSV,          /**< Comma-separated values */
+    BASE64,       /**< Base64 of the raw global ids */
+    BASE64_ZLIB,  /**< Base64 of the raw global ids compressed with zlib, and the dictionary of the map if any */
+    BASE64_GZIP,  /**< Base64 of the raw global ids compressed with gzip */
+  };
+
+  class GroupLayer;
+
+  /**
+   * @brief A layer of a map, with the effect of its groups.
+   *
+   * @sa Map::getFlattenedLayers
+   */
+  struct FlattenedLayer {
+    const Layer *layer;         /**< the layer, never a group */
+    const GroupLayer *group;    /**< the innermost group of the layer, or nullptr */
+    unsigned depth;             /**< the number of groups of the layer */
+    double opacity;             /**< the opacity of the layer multiplied by the opacity of its groups */
+    bool visible;               /**< true if the layer and all its groups are visible */
+    Vector2f offset;            /**< the offset of the layer plus the offsets of its groups, in pixels */
+  };
+
   /**
    * @brief A map is a set of tilesets and a set of different layers.
    *
@@ -210,6 +246,44 @@ namespace tmx {
       return m_nextObjectId;
     }
 
+    /**
+     * @brief Set the next object id.
+     *
+     * @param id the new next object id
+     */
+    void setNextObjectId(unsigned id) noexcept {
+      m_nextObjectId = id;
+    }
+
+    /**
+     * @brief Allocate an id for a new object.
+     *
+     * @returns the next object id, that is incremented
+     */
+    unsigned allocateObjectId() noexcept {
+      return m_nextObjectId++;
+    }
+
+    /**
+     * @brief Get the compression dictionary of the map.
+     *
+     * @returns the dictionary of the zlib layers, or null
+     */
+    std::shared_ptr<const CompressionDictionary> getCompressionDictionary() const noexcept {
+      return m_dictionary;
+    }
+
+    /**
+     * @brief Set the compression dictionary of the map.
+     *
+     * The `compressiondictionary` property of the map refers to the source
+     * of the dictionary, or is removed if the dictionary is null.
+     *
+     * @param source the path of the dictionary, relative to the TMX file
+     * @param dictionary the dictionary of the zlib layers, or null
+     */
+    void setCompressionDictionary(const boost::filesystem::path& source, std::shared_ptr<const CompressionDictionary> dictionary);
+
     /** @} */
 
     /**
@@ -234,6 +308,17 @@ namespace tmx {
       m_tilesets.emplace_back(std::move(tileset));
     }
 
+    /**
+     * @brief Remove all the tilesets from the map.
+     *
+     * @returns the tilesets, in their order in the map
+     */
+    std::vector<std::unique_ptr<TileSet>> releaseTileSets() {
+      std::vector<std::unique_ptr<TileSet>> tilesets;
+      tilesets.swap(m_tilesets);
+      return tilesets;
+    }
+
     /**
      * @brief Get the tilesets.
      *
@@ -270,6 +355,46 @@ namespace tmx {
       m_layers.emplace_back(std::move(layer));
     }
 
+    /**
+     * @brief Remove all the layers from the map.
+     *
+     * @returns the layers, in their order in the map
+     */
+    std::vector<std::unique_ptr<Layer>> releaseLayers() {
+      std::vector<std::unique_ptr<Layer>> layers;
+      layers.swap(m_layers);
+      return layers;
+    }
+
+    /**
+     * @brief Get the number of layers.
+     *
+     * @returns the number of layers
+     */
+    std::size_t getLayerCount() const noexcept {
+      return m_layers.size();
+    }
+
+    /**
+     * @brief Get a layer.
+     *
+     * @param index the index of the layer
+     * @returns the layer, or nullptr if the index is out of range
+     */
+    Layer *getLayer(std::size_t index) noexcept {
+      return index < m_layers.size() ? m_layers[index].get() : nullptr;
+    }
+
+    /**
+     * @brief Get a layer.
+     *
+     * @param index the index of the layer
+     * @returns the layer, or nullptr if the index is out of range
+     */
+    const Layer *getLayer(std::size_t index) const noexcept {
+      return index < m_layers.size() ? m_layers[index].get() : nullptr;
+    }
+
     /**
      * @brief Get the layers.
      *
@@ -279,6 +404,40 @@ namespace tmx {
       return boost::make_iterator_range(m_layers) | boost::adaptors::transformed(Adaptor());
     }
 
+    /**
+     * @brief Get all the layers, the layers of the groups included.
+     *
+     * The layers are in depth-first order, a group before its layers, like
+     * the layers of a compiled map. The index of a layer in this order
+     * designates the layer in the editors, the instances and the patches
+     * of the map. Without groups, it is the index of the layer in the map.
+     *
+     * @returns all the layers
+     */
+    std::vector<Layer *> getAllLayers();
+
+    /**
+     * @brief Get all the layers, the layers of the groups included.
+     *
+     * @returns all the layers, in depth-first order
+     * @sa getAllLayers()
+     */
+    std::vector<const Layer *> getAllLayers() const;
+
+    /**
+     * @brief Get the flattened layers.
+     *
+     * The flattened layers are all the layers of the map that are not
+     * groups, in the order of drawing, with the opacity, the visibility
+     * and the offset that result from their groups. They are composed at
+     * each call from the current state of the layers, so that a change in
+     * a group is reflected in its layers. A renderer can keep the result
+     * as long as the layers of the map are not modified.
+     *
+     * @returns the flattened layers
+     */
+    std::vector<FlattenedLayer> getFlattenedLayers() const;
+
     /**
      * @brief Visit the layers with a visitor.
      *
@@ -298,10 +457,136 @@ namespace tmx {
     /**
      * @brief Parse a TMX file.
      *
+     * The files with the `.json` or `.tmj` extension are parsed as Tiled
+     * JSON maps, with their `.tsj` (or `.tsx`) tilesets. They give the same
+     * map as the equivalent TMX file.
+     *
      * @param filename the name of the TMX file
      * @returns a map
      */
     static std::unique_ptr<Map> parseFile(const boost::filesystem::path& filename);
+
+    /**
+     * @brief Parse a TMX file from a file system.
+     *
+     * The TMX file and the TSX files it references are opened with the file
+     * system.
+     *
+     * @param filename the name of the TMX file in the file system
+     * @param filesystem the file system
+     * @returns a map
+     */
+    static std::unique_ptr<Map> parseFile(const boost::filesystem::path& filename, FileSystem& filesystem);
+
+    /**
+     * @brief Open a compiled map file.
+     *
+     * The file is mapped in memory and used in place, without any decoding.
+     * Only the header and the bounds of the sections are checked, see
+     * CompiledMap::validate().
+     *
+     * @param filename the filename of the compiled map
+     * @returns a view on the compiled map or nullptr if the file is not valid
+     */
+    static std::unique_ptr<CompiledMap> openCompiled(const boost::filesystem::path& filename);
+
+    /**
+     * @brief Open a compiled map file with a specific file system.
+     *
+     * @param filename the filename of the compiled map
+     * @param filesystem the file system used to open the file
+     * @returns a view on the compiled map or nullptr if the file is not valid
+     */
+    static std::unique_ptr<CompiledMap> openCompiled(const boost::filesystem::path& filename, FileSystem& filesystem);
+
+    /**
+     * @brief Save the map in the compiled format.
+     *
+     * @param filename the filename of the compiled map
+     * @returns true if the map has been saved
+     */
+    bool saveCompiled(const boost::filesystem::path& filename) const;
+
+    /**
+     * @brief Save the map in a TMX file.
+     *
+     * The tilesets are embedded in the TMX file. The sources of the images
+     * are written relative to the directory of the TMX file. The tile
+     * layers are encoded in parallel on the default executor.
+     *
+     * @param filename the name of the TMX file
+     * @param encoding the encoding of the tile layers
+     * @returns true if the map has been saved
+     * @sa Executor::getDefault()
+     */
+    bool saveFile(const boost::filesystem::path& filename, LayerEncoding encoding = LayerEncoding::BASE64_ZLIB) const;
+
+    /**
+     * @brief Save the map in a TMX file.
+     *
+     * @param filename the name of the TMX file
+     * @param encoding the encoding of the tile layers
+     * @param executor the executor that encodes the tile layers
+     * @returns true if the map has been saved
+     */
+    bool saveFile(const boost::filesystem::path& filename, LayerEncoding encoding, Executor& executor) const;
+
+    /**
+     * @brief Save the map in memory in the TMX format.
+     *
+     * @param encoding the encoding of the tile layers
+     * @param base the directory the sources of the images are relative to, or empty to keep the sources as they are
+     * @returns the content of the TMX file
+     */
+    std::string saveMemory(LayerEncoding encoding = LayerEncoding::BASE64_ZLIB, const boost::filesystem::path& base = boost::filesystem::path()) const;
+
+    /**
+     * @brief Save the map in memory in the TMX format.
+     *
+     * @param encoding the encoding of the tile layers
+     * @param base the directory the sources of the images are relative to, or empty to keep the sources as they are
+     * @param executor the executor that encodes the tile layers
+     * @returns the content of the TMX file
+     */
+    std::string saveMemory(LayerEncoding encoding, const boost::filesystem::path& base, Executor& executor) const;
+
+    /**
+     * @brief Parse a TMX file and visit its elements while they are decoded.
+     *
+     * Each tileset, layer and object is given to the visitor as soon as it
+     * is decoded. The visitor decides whether the element is kept in the
+     * map or discarded.
+     *
+     * @param filename the name of the TMX file
+     * @param visitor the visitor
+     * @returns a map
+     */
+    static std::unique_ptr<Map> parseFile(const boost::filesystem::path& filename, ParseVisitor& visitor);
+
+    /**
+     * @brief Parse a TMX file asynchronously.
+     *
+     * The parsing is submitted to the executor and the function returns
+     * immediately. If the loading is cancelled, the resulting map is null.
+     *
+     * @param filename the name of the TMX file
+     * @param executor the executor that runs the parsing
+     * @param progress an optional progress to observe or cancel the loading
+     * @returns the future map
+     */
+    static std::future<std::unique_ptr<Map>> parseFileAsync(const boost::filesystem::path& filename,
+        Executor& executor, std::shared_ptr<LoadProgress> progress = nullptr);
+
+    /**
+     * @brief Parse a TMX file asynchronously on the default executor.
+     *
+     * @param filename the name of the TMX file
+     * @param progress an optional progress to observe or cancel the loading
+     * @returns the future map
+     * @sa Executor::getDefault()
+     */
+    static std::future<std::unique_ptr<Map>> parseFileAsync(const boost::filesystem::path& filename,
+        std::shared_ptr<LoadProgress> progress = nullptr);
     /** @} */
 
   private:
@@ -323,10 +608,12 @@ namespace tmx {
     const StaggerAxis m_axis;
     const StaggerIndex m_index;
 
-    const unsigned m_nextObjectId;
+    unsigned m_nextObjectId;
 
     std::vector<std::unique_ptr<TileSet>> m_tilesets;
     std::vector<std::unique_ptr<Layer>> m_layers;
+
+    std::shared_ptr<const CompressionDictionary> m_dictionary;
   };
 
 }
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_MAP_DIFF_H
+#define TMX_MAP_DIFF_H
+
+#include <cstddef>
+#include <vector>
+
+#include "FileSystem.h"
+#include "Map.h"
+
+namespace tmx {
+
+  /**
+   * @brief Compute a patch from a map to another map.
+   *
+   * The patch covers what can change in a map after its creation: the
+   * cells of the tile layers (as runs of changed cells), the objects that
+   * were added, removed or modified, and the properties of the map, of
+   * the layers and of the objects. Both maps must have the same structure:
+   * same size, same tilesets and same layers in the same order, groups
+   * included. The layers of the groups are compared like the other layers,
+   * and the properties of the groups are part of the patch. A modified
+   * object keeps its place in its layer, a new object is inserted at its
+   * place in the modified map. An instance of a template refers to the
+   * path of its template file, and only carries the properties and the
+   * points that it does not share with its template. The next object id
+   * of the modified map is part of the patch, so that the ids of the new
+   * objects are not allocated again.
+   *
+   * The patch is a compact binary format with variable-length integers.
+   *
+   * @param from the original map
+   * @param to the modified map
+   * @returns the patch, or an empty vector if the structures of the maps differ
+   */
+  std::vector<char> diff(const Map& from, const Map& to);
+
+  /**
+   * @brief Apply a patch to a map.
+   *
+   * The patch is completely decoded and checked before the map is
+   * modified: an invalid patch leaves the map untouched. The templates of
+   * the objects of the patch are loaded with ObjectTemplate::load.
+   *
+   * @param map the map to modify, with the structure of the original map of the patch
+   * @param data the patch data
+   * @param size the size of the patch data
+   * @param filesystem the file system of the templates
+   * @returns true if the patch has been applied
+   */
+  bool apply(Map& map, const char *data, std::size_t size, FileSystem& filesystem = FileSystem::getDefault());
+
+  /**
+   * @brief Apply a patch to a map.
+   *
+   * @param map the map to modify, with the structure of the original map of the patch
+   * @param patch the patch
+   * @param filesystem the file system of the templates
+   * @returns true if the patch has been applied
+   */
+  inline bool apply(Map& map, const std::vector<char>& patch, FileSystem& filesystem = FileSystem::getDefault()) {
+    return apply(map, patch.data(), patch.size(), filesystem);
+  }
+
+}
+
+#endif // TMX_MAP_DIFF_H
@@ -0,0 +1,377 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_MAP_EDITOR_H
+#define TMX_MAP_EDITOR_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Cell.h"
+#include "CompiledMap.h"
+#include "Geometry.h"
+#include "Map.h"
+#include "Object.h"
+
+namespace tmx {
+
+  /**
+   * @brief A set of changes made to a map.
+   *
+   * Tile changes are recorded by chunk, with one bit per chunk of each tile
+   * layer. Object changes are recorded by layer and object id: an object is
+   * dirty if it has been added, removed, replaced, or if one of its
+   * properties changed. Property changes of the map and of the layers are
+   * recorded by key.
+   */
+  class DirtySet {
+  public:
+    /**
+     * @brief DirtySet constructor.
+     *
+     * @param width the width of the map (in number of tiles)
+     * @param height the height of the map (in number of tiles)
+     * @param chunkSize the size of a chunk (in number of tiles)
+     */
+    DirtySet(unsigned width, unsigned height, unsigned chunkSize = compiled::DefaultChunkSize);
+
+    /**
+     * @brief Get the size of a chunk.
+     *
+     * @returns the size of a chunk (in number of tiles)
+     */
+    unsigned getChunkSize() const noexcept {
+      return m_chunkSize;
+    }
+
+    /**
+     * @brief Get the number of chunks of a layer.
+     *
+     * @returns the number of chunks in each direction
+     */
+    Vector2u getChunkCount() const noexcept {
+      return { m_chunkColumns, m_chunkRows };
+    }
+
+    /**
+     * @brief Get the rectangle of a chunk in the map.
+     *
+     * @param chunk the coordinates of the chunk
+     * @returns the rectangle of the chunk, clipped to the map (in tiles)
+     */
+    Rect getChunkRect(Vector2u chunk) const noexcept;
+
+    /**
+     * @brief Tell whether there is no change.
+     *
+     * @returns true if nothing is dirty
+     */
+    bool isEmpty() const noexcept;
+
+    /**
+     * @brief Forget all the changes.
+     */
+    void clear();
+
+    /**
+     * @brief Add the changes of another set.
+     *
+     * The other set must have the same geometry.
+     *
+     * @param other the other set
+     */
+    void merge(const DirtySet& other);
+
+    /**
+     * @brief Mark the chunk of a cell as dirty.
+     *
+     * @param layer the index of the layer
+     * @param x the x coordinate of the cell
+     * @param y the y coordinate of the cell
+     */
+    void markCell(unsigned layer, unsigned x, unsigned y);
+
+    /**
+     * @brief Mark a chunk as dirty.
+     *
+     * @param layer the index of the layer
+     * @param chunk the coordinates of the chunk
+     */
+    void markChunk(unsigned layer, Vector2u chunk);
+
+    /**
+     * @brief Mark an object as dirty.
+     *
+     * @param layer the index of the layer
+     * @param id the id of the object
+     */
+    void markObject(unsigned layer, unsigned id);
+
+    /**
+     * @brief Mark a property of the map as dirty.
+     *
+     * @param key the property key
+     */
+    void markProperty(const std::string& key);
+
+    /**
+     * @brief Mark a property of a layer as dirty.
+     *
+     * @param layer the index of the layer
+     * @param key the property key
+     */
+    void markLayerProperty(unsigned layer, const std::string& key);
+
+    /**
+     * @brief Tell whether a chunk is dirty.
+     *
+     * @param layer the index of the layer
+     * @param chunk the coordinates of the chunk
+     * @returns true if a cell of the chunk changed
+     */
+    bool isChunkDirty(unsigned layer, Vector2u chunk) const noexcept;
+
+    /**
+     * @brief Get the layers that have dirty chunks.
+     *
+     * @returns the indices of the layers, in increasing order
+     */
+    std::vector<unsigned> getDirtyLayers() const;
+
+    /**
+     * @brief Get the dirty chunks of a layer.
+     *
+     * @param layer the index of the layer
+     * @returns the coordinates of the dirty chunks, in row-major order
+     */
+    std::vector<Vector2u> getDirtyChunks(unsigned layer) const;
+
+    /**
+     * @brief Get the dirty objects.
+     *
+     * @returns the pairs of layer index and object id
+     */
+    const std::set<std::pair<unsigned, unsigned>>& getDirtyObjects() const noexcept {
+      return m_objects;
+    }
+
+    /**
+     * @brief Get the dirty properties of the map.
+     *
+     * @returns the property keys
+     */
+    const std::set<std::string>& getDirtyProperties() const noexcept {
+      return m_properties;
+    }
+
+    /**
+     * @brief Get the dirty properties of the layers.
+     *
+     * @returns the pairs of layer index and property key
+     */
+    const std::set<std::pair<unsigned, std::string>>& getDirtyLayerProperties() const noexcept {
+      return m_layerProperties;
+    }
+
+  private:
+    unsigned m_width;
+    unsigned m_height;
+    unsigned m_chunkSize;
+    unsigned m_chunkColumns;
+    unsigned m_chunkRows;
+
+    std::map<unsigned, std::vector<uint64_t>> m_chunks;
+    std::set<std::pair<unsigned, unsigned>> m_objects;
+    std::set<std::string> m_properties;
+    std::set<std::pair<unsigned, std::string>> m_layerProperties;
+  };
+
+  /**
+   * @brief A map editor modifies a map and records the changes.
+   *
+   * The editor only records real changes: setting a cell or a property to
+   * its current value does not make anything dirty. The consumers of the
+   * changes (renderers, network synchronization, caches) take the dirty
+   * set and handle the deltas only.
+   *
+   * Layers are designated by their index in Map::getAllLayers(), so the
+   * layers of the groups can be edited. The layers of the map must not be
+   * added or removed while the map is edited.
+   */
+  class MapEditor {
+  public:
+    /**
+     * @brief MapEditor constructor.
+     *
+     * @param map the edited map
+     * @param chunkSize the size of a dirty chunk (in number of tiles)
+     */
+    explicit MapEditor(Map& map, unsigned chunkSize = compiled::DefaultChunkSize);
+
+    /**
+     * @brief Get the edited map.
+     *
+     * @returns the map
+     */
+    Map& getMap() noexcept {
+      return m_map;
+    }
+
+    /**
+     * @brief Get a cell of a tile layer.
+     *
+     * @param layer the index of the layer
+     * @param x the x coordinate of the cell
+     * @param y the y coordinate of the cell
+     * @returns the cell, or an empty cell if there is no such cell
+     */
+    Cell getCell(unsigned layer, unsigned x, unsigned y) const noexcept;
+
+    /**
+     * @brief Set a cell of a tile layer.
+     *
+     * @param layer the index of the layer
+     * @param x the x coordinate of the cell
+     * @param y the y coordinate of the cell
+     * @param cell the new cell
+     * @returns true if the cell exists, false otherwise
+     */
+    bool setCell(unsigned layer, unsigned x, unsigned y, Cell cell);
+
+    /**
+     * @brief Allocate an id for a new object.
+     *
+     * @returns the id
+     */
+    unsigned allocateObjectId() noexcept {
+      return m_map.allocateObjectId();
+    }
+
+    /**
+     * @brief Add an object to an object layer.
+     *
+     * @param layer the index of the layer
+     * @param obj the object
+     * @returns true if the object has been added
+     */
+    bool addObject(unsigned layer, std::unique_ptr<Object> obj);
+
+    /**
+     * @brief Remove an object from an object layer.
+     *
+     * @param layer the index of the layer
+     * @param id the id of the object
+     * @returns the removed object, or nullptr if there is no such object
+     */
+    std::unique_ptr<Object> removeObject(unsigned layer, unsigned id);
+
+    /**
+     * @brief Replace an object of an object layer by an object with the same id.
+     *
+     * This is the way to move or resize an object.
+     *
+     * @param layer the index of the layer
+     * @param obj the new object
+     * @returns the replaced object, or nullptr if there is no such object
+     */
+    std::unique_ptr<Object> replaceObject(unsigned layer, std::unique_ptr<Object> obj);
+
+    /**
+     * @brief Set a property of the map.
+     *
+     * @param key the property key
+     * @param value the property value
+     * @returns true if the property changed
+     */
+    bool setProperty(const std::string& key, const std::string& value);
+
+    /**
+     * @brief Remove a property of the map.
+     *
+     * @param key the property key
+     * @returns true if the property existed
+     */
+    bool removeProperty(const std::string& key);
+
+    /**
+     * @brief Set a property of a layer.
+     *
+     * @param layer the index of the layer
+     * @param key the property key
+     * @param value the property value
+     * @returns true if the property changed
+     */
+    bool setLayerProperty(unsigned layer, const std::string& key, const std::string& value);
+
+    /**
+     * @brief Remove a property of a layer.
+     *
+     * @param layer the index of the layer
+     * @param key the property key
+     * @returns true if the property existed
+     */
+    bool removeLayerProperty(unsigned layer, const std::string& key);
+
+    /**
+     * @brief Set a property of an object.
+     *
+     * @param layer the index of the layer
+     * @param id the id of the object
+     * @param key the property key
+     * @param value the property value
+     * @returns true if the property changed
+     */
+    bool setObjectProperty(unsigned layer, unsigned id, const std::string& key, const std::string& value);
+
+    /**
+     * @brief Remove a property of an object.
+     *
+     * @param layer the index of the layer
+     * @param id the id of the object
+     * @param key the property key
+     * @returns true if the property existed
+     */
+    bool removeObjectProperty(unsigned layer, unsigned id, const std::string& key);
+
+    /**
+     * @brief Get the changes since the last call to takeDirtySet().
+     *
+     * @returns the dirty set
+     */
+    const DirtySet& getDirtySet() const noexcept {
+      return m_dirty;
+    }
+
+    /**
+     * @brief Take the changes and start a new dirty set.
+     *
+     * @returns the changes since the last call
+     */
+    DirtySet takeDirtySet();
+
+  private:
+    Map& m_map;
+    std::vector<Layer *> m_layers;
+    DirtySet m_dirty;
+  };
+
+}
+
+#endif // TMX_MAP_EDITOR_H
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_MAP_HANDLE_H
+#define TMX_MAP_HANDLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Map.h"
+
+namespace tmx {
+
+  /**
+   * @brief A handle on the current version of a map, shared between threads.
+   *
+   * A handle publishes immutable snapshots of a map. Readers acquire the
+   * current snapshot without taking a lock and without blocking, even while
+   * a writer publishes a new map. A snapshot stays valid until it is
+   * released, whatever the number of maps published in the meantime.
+   *
+   * The reclamation of the old maps uses hazard pointers: each reader
+   * announces the map it uses in a record, and a retired map is deleted
+   * only when no record points to it. Records are reused, so there are as
+   * many records as the maximum number of simultaneous snapshots.
+   *
+   * Writers are serialized between themselves, but never wait for readers.
+   */
+  class MapHandle {
+  private:
+    struct Record;
+
+  public:
+    /**
+     * @brief A snapshot of a map.
+     *
+     * The map of a snapshot never changes. A snapshot must be released
+     * (i.e. destroyed) before its handle is destroyed.
+     */
+    class Snapshot {
+    public:
+      /**
+       * @brief Snapshot constructor.
+       *
+       * The snapshot is empty.
+       */
+      Snapshot() noexcept
+      : m_record(nullptr), m_map(nullptr)
+      {
+      }
+
+      /**
+       * @brief Snapshot destructor.
+       *
+       * The map is released.
+       */
+      ~Snapshot();
+
+      Snapshot(const Snapshot&) = delete;
+      Snapshot& operator=(const Snapshot&) = delete;
+
+      /**
+       * @brief Snapshot move constructor.
+       */
+      Snapshot(Snapshot&& other) noexcept
+      : m_record(other.m_record), m_map(other.m_map)
+      {
+        other.m_record = nullptr;
+        other.m_map = nullptr;
+      }
+
+      /**
+       * @brief Snapshot move assignment.
+       */
+      Snapshot& operator=(Snapshot&& other) noexcept;
+
+      /**
+       * @brief Get the map of the snapshot.
+       *
+       * @returns the map, or nullptr if no map has been published
+       */
+      const Map *get() const noexcept {
+        return m_map;
+      }
+
+      /**
+       * @brief Access the map of the snapshot.
+       */
+      const Map *operator->() const noexcept {
+        return m_map;
+      }
+
+      /**
+       * @brief Access the map of the snapshot.
+       */
+      const Map& operator*() const noexcept {
+        return *m_map;
+      }
+
+      /**
+       * @brief Tell whether the snapshot has a map.
+       */
+      explicit operator bool() const noexcept {
+        return m_map != nullptr;
+      }
+
+      /**
+       * @brief Release the map before the destruction of the snapshot.
+       */
+      void release() noexcept;
+
+    private:
+      friend class MapHandle;
+
+      Snapshot(Record *record, const Map *map) noexcept
+      : m_record(record), m_map(map)
+      {
+      }
+
+      Record *m_record;
+      const Map *m_map;
+    };
+
+    /**
+     * @brief MapHandle constructor.
+     *
+     * @param map the initial map, may be nullptr
+     */
+    explicit MapHandle(std::unique_ptr<const Map> map = nullptr);
+
+    /**
+     * @brief MapHandle destructor.
+     *
+     * All the snapshots must have been released.
+     */
+    ~MapHandle();
+
+    MapHandle(const MapHandle&) = delete;
+    MapHandle& operator=(const MapHandle&) = delete;
+
+    /**
+     * @brief Acquire a snapshot of the current map.
+     *
+     * This function is lock-free and may be called from any thread.
+     *
+     * @returns a snapshot of the current map
+     */
+    Snapshot acquire() const;
+
+    /**
+     * @brief Publish a new map.
+     *
+     * The new map is visible to the next snapshots. The previous map is
+     * retired and deleted when the last snapshot on it is released and a
+     * reclamation happens.
+     *
+     * @param map the new map, may be nullptr
+     */
+    void publish(std::unique_ptr<const Map> map);
+
+    /**
+     * @brief Delete the retired maps that are not used anymore.
+     *
+     * This function is called at each publication.
+     *
+     * @returns the number of deleted maps
+     */
+    std::size_t reclaim();
+
+    /**
+     * @brief Get the number of retired maps that are not deleted yet.
+     *
+     * @returns the number of retired maps
+     */
+    std::size_t getRetiredCount() const;
+
+    /**
+     * @brief Get the number of publications since the creation of the handle.
+     *
+     * @returns the version of the current map
+     */
+    uint64_t getVersion() const noexcept {
+      return m_version.load(std::memory_order_acquire);
+    }
+
+  private:
+    Record *acquireRecord() const;
+    std::size_t reclaimLocked();
+
+  private:
+    std::atomic<const Map *> m_current;
+    std::atomic<uint64_t> m_version;
+    mutable std::atomic<Record *> m_records;
+
+    mutable std::mutex m_writeMutex;
+    std::vector<const Map *> m_retired;
+  };
+
+}
+
+#endif // TMX_MAP_HANDLE_H
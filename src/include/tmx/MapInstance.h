@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_MAP_INSTANCE_H
+#define TMX_MAP_INSTANCE_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Cell.h"
+#include "CompiledMap.h"
+#include "Map.h"
+#include "Object.h"
+#include "ObjectLayer.h"
+#include "TileLayer.h"
+
+namespace tmx {
+
+  /**
+   * @brief The memory used by a map instance.
+   */
+  struct InstanceStatistics {
+    std::size_t copiedChunks;     /**< the number of chunks copied from the template */
+    std::size_t totalChunks;      /**< the number of chunks of all the tile layers */
+    std::size_t changedObjects;   /**< the number of objects added, removed or modified */
+    std::size_t changedProperties;/**< the number of properties of the map and the layers that changed */
+    std::size_t overheadBytes;    /**< an estimation of the memory used by the instance, in bytes */
+  };
+
+  /**
+   * @brief A map instance is a copy-on-write copy of a template map.
+   *
+   * An instance shares everything with its template: tilesets, cells,
+   * objects and properties. When a cell is written, the chunk of the cell
+   * is copied in the instance, and then modified. When an object is
+   * written, the object is copied in the instance. So, the memory used by
+   * an instance is proportional to its changes, not to the size of the map.
+   *
+   * The template is never modified and can be shared by instances in
+   * different threads. An instance must not be used by several threads
+   * at the same time.
+   *
+   * Layers are designated by their index in Map::getAllLayers() of the
+   * template, the layers of the groups included.
+   */
+  class MapInstance {
+  public:
+    /**
+     * @brief Create an instance of a template map.
+     *
+     * @param map the template map
+     * @param chunkSize the size of a copied chunk (in number of tiles)
+     * @returns a new instance, or nullptr if the template is nullptr
+     */
+    static std::unique_ptr<MapInstance> instantiate(std::shared_ptr<const Map> map, unsigned chunkSize = compiled::DefaultChunkSize);
+
+    MapInstance(const MapInstance&) = delete;
+    MapInstance& operator=(const MapInstance&) = delete;
+
+    /**
+     * @brief Get the template of the instance.
+     *
+     * @returns the template map
+     */
+    const Map& getTemplate() const noexcept {
+      return *m_template;
+    }
+
+    /**
+     * @name Cells
+     * @{
+     */
+    /**
+     * @brief Get a cell of a tile layer.
+     *
+     * @param layer the index of the layer
+     * @param x the x coordinate of the cell
+     * @param y the y coordinate of the cell
+     * @returns the cell, or an empty cell if there is no such cell
+     */
+    Cell getCell(unsigned layer, unsigned x, unsigned y) const noexcept;
+
+    /**
+     * @brief Set a cell of a tile layer.
+     *
+     * The chunk of the cell is copied from the template on the first write.
+     *
+     * @param layer the index of the layer
+     * @param x the x coordinate of the cell
+     * @param y the y coordinate of the cell
+     * @param cell the new cell
+     * @returns true if the cell exists, false otherwise
+     */
+    bool setCell(unsigned layer, unsigned x, unsigned y, Cell cell);
+    /** @} */
+
+    /**
+     * @name Objects
+     * @{
+     */
+    /**
+     * @brief Get an object of an object layer.
+     *
+     * @param layer the index of the layer
+     * @param id the id of the object
+     * @returns the object, or nullptr if there is no such object
+     */
+    const Object *getObject(unsigned layer, unsigned id) const noexcept;
+
+    /**
+     * @brief Get the objects of an object layer.
+     *
+     * The objects of the template come first, in their order, then the
+     * objects added to the instance, by increasing id.
+     *
+     * @param layer the index of the layer
+     * @returns the objects
+     */
+    std::vector<const Object *> getObjects(unsigned layer) const;
+
+    /**
+     * @brief Allocate an id for a new object.
+     *
+     * @returns the id
+     */
+    unsigned allocateObjectId() noexcept {
+      return m_nextObjectId++;
+    }
+
+    /**
+     * @brief Add an object to an object layer.
+     *
+     * @param layer the index of the layer
+     * @param obj the object
+     * @returns true if the object has been added
+     */
+    bool addObject(unsigned layer, std::unique_ptr<Object> obj);
+
+    /**
+     * @brief Remove an object from an object layer.
+     *
+     * @param layer the index of the layer
+     * @param id the id of the object
+     * @returns true if the object has been removed
+     */
+    bool removeObject(unsigned layer, unsigned id);
+
+    /**
+     * @brief Replace an object by an object with the same id.
+     *
+     * @param layer the index of the layer
+     * @param obj the new object
+     * @returns true if the object has been replaced
+     */
+    bool replaceObject(unsigned layer, std::unique_ptr<Object> obj);
+
+    /**
+     * @brief Set a property of an object.
+     *
+     * The object is copied from the template on the first write.
+     *
+     * @param layer the index of the layer
+     * @param id the id of the object
+     * @param key the property key
+     * @param value the property value
+     * @returns true if the property changed
+     */
+    bool setObjectProperty(unsigned layer, unsigned id, const std::string& key, const std::string& value);
+    /** @} */
+
+    /**
+     * @name Properties
+     * @{
+     */
+    /**
+     * @brief Get a property of the map.
+     *
+     * @param key the property key
+     * @param def a default value if the property does not exist
+     * @returns the value of the property
+     */
+    const std::string& getProperty(const std::string& key, const std::string& def) const noexcept;
+
+    /**
+     * @brief Set a property of the map.
+     *
+     * @param key the property key
+     * @param value the property value
+     */
+    void setProperty(const std::string& key, const std::string& value);
+
+    /**
+     * @brief Remove a property of the map.
+     *
+     * @param key the property key
+     */
+    void removeProperty(const std::string& key);
+
+    /**
+     * @brief Get a property of a layer.
+     *
+     * @param layer the index of the layer
+     * @param key the property key
+     * @param def a default value if the property does not exist
+     * @returns the value of the property
+     */
+    const std::string& getLayerProperty(unsigned layer, const std::string& key, const std::string& def) const noexcept;
+
+    /**
+     * @brief Set a property of a layer.
+     *
+     * @param layer the index of the layer
+     * @param key the property key
+     * @param value the property value
+     */
+    void setLayerProperty(unsigned layer, const std::string& key, const std::string& value);
+
+    /**
+     * @brief Remove a property of a layer.
+     *
+     * @param layer the index of the layer
+     * @param key the property key
+     */
+    void removeLayerProperty(unsigned layer, const std::string& key);
+    /** @} */
+
+    /**
+     * @brief Build a full map from the instance.
+     *
+     * The map is a deep copy of the template with the changes of the
+     * instance, it only shares the immutable compression dictionary and
+     * object templates with the template. It can be saved, or
+     * given to diff() with the template to get a patch of the instance.
+     *
+     * @returns a map equivalent to the instance
+     */
+    std::unique_ptr<Map> toMap() const;
+
+    /**
+     * @brief Get the memory used by the instance.
+     *
+     * @returns the statistics of the instance
+     */
+    InstanceStatistics getStatistics() const;
+
+  private:
+    // a property of the instance, the flag is false if the property is removed
+    typedef std::map<std::string, std::pair<bool, std::string>> PropertyOverrides;
+
+    struct LayerState {
+      const Layer *layer;
+      const TileLayer *tiles;
+      const ObjectLayer *objects;
+      std::vector<std::unique_ptr<std::vector<Cell>>> chunks;  // empty until the first write
+      std::map<unsigned, std::unique_ptr<Object>> overrides;   // nullptr if the object is removed
+      PropertyOverrides properties;
+    };
+
+    MapInstance(std::shared_ptr<const Map> map, unsigned chunkSize);
+
+    LayerState *getObjectLayer(unsigned layer) noexcept;
+    std::unique_ptr<Layer> copyLayer(std::size_t& index) const;
+
+    static const std::string& getOverriddenProperty(const PropertyOverrides& overrides, const Component& component,
+        const std::string& key, const std::string& def) noexcept;
+
+  private:
+    std::shared_ptr<const Map> m_template;
+    unsigned m_chunkSize;
+    unsigned m_chunkColumns;
+    unsigned m_chunkRows;
+    unsigned m_nextObjectId;
+    std::vector<LayerState> m_layers;
+    PropertyOverrides m_properties;
+  };
+
+}
+
+#endif // TMX_MAP_INSTANCE_H
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_MAP_REGION_H
+#define TMX_MAP_REGION_H
+
+#include <cstddef>
+
+#include "Geometry.h"
+#include "Map.h"
+
+namespace tmx {
+
+  /**
+   * @brief A map region is a partial map that contains only a rectangle of tiles.
+   *
+   * A region has the same attributes as the map it comes from, but only
+   * some of its layers. The tile layers contain the cells of the rectangle
+   * only, in row-major order, starting at the top left corner of the
+   * rectangle. The object layers contain the objects that intersect the
+   * rectangle, with their coordinates in the map. A region has no tileset,
+   * the tilesets are the ones of the full map.
+   *
+   * @sa RegionLoader
+   */
+  class MapRegion : public Map {
+  public:
+    /**
+     * @brief MapRegion constructor.
+     */
+    MapRegion(const std::string version, Orientation orientation, unsigned width, unsigned height,
+        unsigned tilewidth, unsigned tileheight, const std::string& bgcolor, RenderOrder renderOrder,
+        unsigned hexSideLength, StaggerAxis axis, StaggerIndex index, unsigned nextObjectId, const Rect& rect)
+      : Map(version, orientation, width, height, tilewidth, tileheight, bgcolor, renderOrder, hexSideLength, axis, index, nextObjectId)
+      , m_rect(rect)
+      , m_bytesRead(0)
+    {
+    }
+
+    /**
+     * @brief Get the rectangle of the region.
+     *
+     * @returns the rectangle of the region, in tiles
+     */
+    const Rect& getRect() const noexcept {
+      return m_rect;
+    }
+
+    /**
+     * @brief Get the number of bytes read to load the region.
+     *
+     * @returns the number of bytes read
+     */
+    std::size_t getBytesRead() const noexcept {
+      return m_bytesRead;
+    }
+
+    /**
+     * @brief Set the number of bytes read to load the region.
+     *
+     * @param bytes the number of bytes read
+     */
+    void setBytesRead(std::size_t bytes) noexcept {
+      m_bytesRead = bytes;
+    }
+
+  private:
+    const Rect m_rect;
+    std::size_t m_bytesRead;
+  };
+
+}
+
+#endif // TMX_MAP_REGION_H
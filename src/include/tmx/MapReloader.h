@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_MAP_RELOADER_H
+#define TMX_MAP_RELOADER_H
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "FileSystem.h"
+#include "Map.h"
+
+namespace tmx {
+
+  /**
+   * @brief The report of a reload.
+   */
+  struct ReloadReport {
+    bool reloaded;                             /**< true if the file has been parsed, false if the previous map is kept */
+    std::vector<std::string> changedTileSets;  /**< the names of the tilesets that have been decoded */
+    std::vector<std::string> changedLayers;    /**< the names of the layers that have been decoded */
+    unsigned reusedTileSets;                   /**< the number of tilesets taken from the previous map */
+    unsigned reusedLayers;                     /**< the number of layers taken from the previous map */
+    unsigned removedTileSets;                  /**< the number of tilesets of the previous map that are gone */
+    unsigned removedLayers;                    /**< the number of layers of the previous map that are gone */
+    std::chrono::nanoseconds duration;         /**< the duration of the reload */
+  };
+
+  /**
+   * @brief A map reloader reloads a map when its files change.
+   *
+   * The reloader hashes the XML subtree of each tileset and each layer (and
+   * the TSX file of external tilesets). When the map is reloaded, only the
+   * tilesets and layers whose hash changed are decoded, the others are
+   * moved from the previous map to the new map. So, a pointer to an
+   * unchanged tileset or layer stays valid after a reload, while the
+   * pointer to the map itself changes.
+   *
+   * The reload can be triggered by an explicit call, or by a change in one
+   * of the files of the map, watched with inotify on Linux.
+   *
+   * The map must not be used while it is reloaded.
+   */
+  class MapReloader {
+  public:
+    /**
+     * @brief MapReloader constructor.
+     *
+     * The map is not loaded until the first call to reload().
+     *
+     * @param filename the filename of the TMX file
+     * @param filesystem the file system used to open the files
+     */
+    explicit MapReloader(const boost::filesystem::path& filename, FileSystem& filesystem = FileSystem::getDefault());
+
+    /**
+     * @brief MapReloader destructor.
+     */
+    ~MapReloader();
+
+    MapReloader(const MapReloader&) = delete;
+    MapReloader& operator=(const MapReloader&) = delete;
+
+    /**
+     * @brief Get the current map.
+     *
+     * @returns the current map, or nullptr if the map has never been loaded
+     */
+    const Map *getMap() const noexcept {
+      return m_map.get();
+    }
+
+    /**
+     * @brief Reload the map.
+     *
+     * If the file can not be parsed, the previous map is kept.
+     *
+     * @returns a report of the changes
+     */
+    ReloadReport reload();
+
+    /**
+     * @brief Start watching the files of the map.
+     *
+     * The directories of the TMX file and the TSX files are watched, so
+     * that files replaced by a rename are seen too. The watched files are
+     * updated at each reload.
+     *
+     * @returns true if the files are watched, false if it is not supported
+     */
+    bool watch();
+
+    /**
+     * @brief Tell whether a file of the map changed since the last call.
+     *
+     * This function does not block.
+     *
+     * @returns true if a file of the map changed
+     */
+    bool hasChanged();
+
+    /**
+     * @brief Wait for a change in a file of the map.
+     *
+     * @param timeout the maximum duration of the wait
+     * @returns true if a file of the map changed
+     */
+    bool waitForChange(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Reload the map if one of its files changed.
+     *
+     * @param report the report of the reload, if any
+     * @returns true if the map has been reloaded
+     */
+    bool reloadIfChanged(ReloadReport& report);
+
+  private:
+    void updateWatches();
+    bool readEvents();
+
+  private:
+    const boost::filesystem::path m_filename;
+    FileSystem& m_filesystem;
+    std::unique_ptr<Map> m_map;
+    std::vector<uint64_t> m_tilesetHashes;
+    std::vector<uint64_t> m_layerHashes;
+
+    int m_notify;
+    std::set<boost::filesystem::path> m_files;
+    std::map<int, boost::filesystem::path> m_watches;
+  };
+
+}
+
+#endif // TMX_MAP_RELOADER_H
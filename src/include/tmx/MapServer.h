@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_MAP_SERVER_H
+#define TMX_MAP_SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+#include "CompiledMap.h"
+#include "Executor.h"
+
+namespace tmx {
+
+  /**
+   * @brief A map server shares compiled maps with other processes.
+   *
+   * The server listens on a Unix domain socket. A client sends the name of
+   * a map, relative to the root directory of the server, and receives a
+   * file descriptor to a sealed, read-only, in-memory file (memfd) that
+   * contains the compiled map. Each map is parsed and compiled only once,
+   * then all the clients map the same memory. A map that could not be
+   * loaded is tried again at the next request.
+   *
+   * The server is only available on Linux.
+   *
+   * @sa MapClient, CompiledMap
+   */
+  class MapServer {
+  public:
+    /**
+     * @brief MapServer constructor.
+     *
+     * @param root the directory of the maps
+     * @param executor the executor that serves the clients
+     */
+    explicit MapServer(const boost::filesystem::path& root, Executor& executor = Executor::getDefault());
+
+    /**
+     * @brief MapServer destructor.
+     */
+    ~MapServer();
+
+    MapServer(const MapServer&) = delete;
+    MapServer& operator=(const MapServer&) = delete;
+
+    /**
+     * @brief Start listening on a socket.
+     *
+     * An existing socket file is replaced.
+     *
+     * @param socket the path of the socket
+     * @returns true if the server listens on the socket
+     */
+    bool listen(const boost::filesystem::path& socket);
+
+    /**
+     * @brief Serve the clients until stop() is called.
+     *
+     * Each connection is served by a task of the executor. When the
+     * function returns, all the tasks are finished.
+     */
+    void run();
+
+    /**
+     * @brief Stop the server.
+     *
+     * This function can be called from another thread or from a signal
+     * handler.
+     */
+    void stop();
+
+    /**
+     * @brief Load a map before any client asks for it.
+     *
+     * @param name the name of the map, relative to the root directory
+     * @returns true if the map is available
+     */
+    bool preload(const std::string& name);
+
+    /**
+     * @brief Get the number of maps loaded by the server.
+     *
+     * @returns the number of maps
+     */
+    std::size_t getMapCount() const;
+
+  private:
+    struct Entry {
+      Entry();
+      ~Entry();
+
+      std::mutex mutex;
+      int fd;
+      std::size_t size;
+    };
+
+    // returns false if the map could not be loaded
+    bool load(const std::string& name, int& fd, std::size_t& size);
+    void serve(int client);
+
+  private:
+    const boost::filesystem::path m_root;
+    Executor& m_executor;
+    int m_socket;
+    boost::filesystem::path m_socketPath;
+    std::atomic<bool> m_stopped;
+    std::atomic<std::size_t> m_mapCount;
+
+    std::mutex m_mutex;
+    std::condition_variable m_idle;
+    std::map<std::string, std::unique_ptr<Entry>> m_entries;
+    std::set<int> m_clients;
+  };
+
+  /**
+   * @brief A map client gets compiled maps from a map server.
+   *
+   * @sa MapServer
+   */
+  class MapClient {
+  public:
+    /**
+     * @brief Attach to a map of a map server.
+     *
+     * The returned compiled map is a view on the memory shared with the
+     * server and the other clients. The memory stays mapped as long as the
+     * compiled map exists, even if the server stops.
+     *
+     * @param socket the path of the socket of the server
+     * @param name the name of the map, relative to the root directory of the server
+     * @returns the compiled map or nullptr if the map is not available
+     */
+    static std::unique_ptr<CompiledMap> attach(const boost::filesystem::path& socket, const std::string& name);
+  };
+
+}
+
+#endif // TMX_MAP_SERVER_H
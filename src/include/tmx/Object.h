@@ -16,6 +16,7 @@
 #ifndef TMX_OBJECT_H
 #define TMX_OBJECT_H
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -24,11 +25,17 @@
 
 namespace tmx {
 
+  class ObjectTemplate;
+
   /**
    * @brief An object is a geometrical object.
    *
    * There four kinds of geometrical objects: rectangles, ellipses, polylines
    * and polygons.
+   *
+   * An object may be an instance of a template. It shares the name, the
+   * type and the properties of the object of the template, unless it
+   * defines its own.
    */
   class Object : public Component {
   public:
@@ -83,7 +90,7 @@ namespace tmx {
      * @return the name of the object
      */
     const std::string& getName() const noexcept {
-      return m_name;
+      return (m_name.empty() && m_base != nullptr) ? m_base->getName() : m_name;
     }
 
     /**
@@ -92,7 +99,7 @@ namespace tmx {
      * @return the type of the object.
      */
     const std::string& getType() const noexcept {
-      return m_type;
+      return (m_type.empty() && m_base != nullptr) ? m_base->getType() : m_type;
     }
 
     /**
@@ -197,6 +204,26 @@ namespace tmx {
       return m_kind == TILE;
     }
 
+    /**
+     * @brief Get the template of the object.
+     *
+     * @returns the template of the object or null if the object is not an
+     * instance of a template
+     */
+    const std::shared_ptr<const ObjectTemplate>& getTemplate() const noexcept {
+      return m_template;
+    }
+
+    /**
+     * @brief Make the object an instance of a template.
+     *
+     * The object uses the name, the type and the properties of the object
+     * of the template as defaults.
+     *
+     * @param objectTemplate the template
+     */
+    void setTemplate(std::shared_ptr<const ObjectTemplate> objectTemplate);
+
   private:
     const Kind m_kind;
     const unsigned m_id;
@@ -205,6 +232,8 @@ namespace tmx {
     const Vector2u m_origin;
     const double m_rotation;
     const bool m_visible;
+    std::shared_ptr<const ObjectTemplate> m_template;
+    const Object *m_base = nullptr;
   };
 
   /**
@@ -359,7 +388,29 @@ namespace tmx {
      * @param points the points
      */
     void setPoints(std::vector<Vector2i> points) {
-      m_points = std::move(points);
+      m_points = std::make_shared<const std::vector<Vector2i>>(std::move(points));
+    }
+
+    /**
+     * @brief Share the points of another chain.
+     *
+     * The points are never modified, so the instances of a template use
+     * the points of the template instead of a copy.
+     *
+     * @param other the other chain
+     */
+    void sharePoints(const Chain& other) {
+      m_points = other.m_points;
+    }
+
+    /**
+     * @brief Tell whether this chain shares its points with another chain.
+     *
+     * @param other the other chain
+     * @returns true if the chains share their points
+     */
+    bool sharesPoints(const Chain& other) const noexcept {
+      return m_points != nullptr && m_points == other.m_points;
     }
 
     /**
@@ -373,7 +424,7 @@ namespace tmx {
      * @returns the begin iterator
      */
     const_iterator begin() const noexcept {
-      return m_points.cbegin();
+      return getPoints().cbegin();
     }
 
     /**
@@ -382,11 +433,14 @@ namespace tmx {
      * @returns the end iterator
      */
     const_iterator end() const noexcept {
-      return m_points.cend();
+      return getPoints().cend();
     }
 
   private:
-    std::vector<Vector2i> m_points;
+    const std::vector<Vector2i>& getPoints() const noexcept;
+
+  private:
+    std::shared_ptr<const std::vector<Vector2i>> m_points;
   };
 
   /**
@@ -412,7 +466,7 @@ namespace tmx {
      * @brief Polygon constructor.
      */
     Polygon(unsigned id, const std::string& name, const std::string& type, const Vector2u& origin, double rotation, bool visible)
-      : Chain(POLYLINE, id, name, type, origin, rotation, visible)
+      : Chain(POLYGON, id, name, type, origin, rotation, visible)
     {
     }
   };
@@ -16,6 +16,7 @@
 #ifndef TMX_OBJECT_LAYER_H
 #define TMX_OBJECT_LAYER_H
 
+#include <algorithm>
 #include <vector>
 
 #include <boost/iterator/transform_iterator.hpp>
@@ -56,10 +57,19 @@ namespace tmx {
      *
      * @return the color to display the objects
      */
-    const std::string& getColor() noexcept {
+    const std::string& getColor() const noexcept {
       return m_color;
     }
 
+    /**
+     * @brief Get the order in which the objects should be drawn.
+     *
+     * @return the draw order
+     */
+    DrawOrder getDrawOrder() const noexcept {
+      return m_order;
+    }
+
     /**
      * @brief Add an object.
      *
@@ -69,6 +79,53 @@ namespace tmx {
       m_objects.emplace_back(std::move(obj));
     }
 
+    /**
+     * @brief Insert an object at a place in the draw order.
+     *
+     * @param index the index of the object in the layer, the object is
+     * added at the end if the index is past the end
+     * @param obj the object
+     */
+    void insertObject(std::size_t index, std::unique_ptr<Object> obj) {
+      m_objects.emplace(m_objects.begin() + std::min(index, m_objects.size()), std::move(obj));
+    }
+
+    /**
+     * @brief Get an object by its id.
+     *
+     * @param id the id of the object
+     * @returns the object, or nullptr if there is no such object
+     */
+    Object *getObject(unsigned id) noexcept;
+
+    /**
+     * @brief Get an object by its id.
+     *
+     * @param id the id of the object
+     * @returns the object, or nullptr if there is no such object
+     */
+    const Object *getObject(unsigned id) const noexcept {
+      return const_cast<ObjectLayer *>(this)->getObject(id);
+    }
+
+    /**
+     * @brief Remove an object.
+     *
+     * @param id the id of the object
+     * @returns the removed object, or nullptr if there is no such object
+     */
+    std::unique_ptr<Object> removeObject(unsigned id);
+
+    /**
+     * @brief Replace the object that has the same id as a new object.
+     *
+     * The new object takes the place of the previous one in the draw order.
+     *
+     * @param obj the new object
+     * @returns the replaced object, or nullptr if there is no such object
+     */
+    std::unique_ptr<Object> replaceObject(std::unique_ptr<Object> obj);
+
     /**
      * @brief An object iterator.
      */
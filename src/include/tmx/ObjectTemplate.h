@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_OBJECT_TEMPLATE_H
+#define TMX_OBJECT_TEMPLATE_H
+
+#include <memory>
+
+#include <boost/filesystem.hpp>
+
+#include "FileSystem.h"
+#include "Object.h"
+
+namespace tmx {
+
+  /**
+   * @brief An object template is an object shared by several maps.
+   *
+   * A template is defined in a TX file (or a TJ file in the JSON format).
+   * The objects that refer to a template are its instances: they share the
+   * geometry and the properties of the object of the template, unless they
+   * override them.
+   *
+   * The object of a tile template refers to a tile of an external tileset
+   * of the template. The instances refer to the same tile in the map.
+   */
+  class ObjectTemplate {
+  public:
+    /**
+     * @brief Constructor.
+     *
+     * @param source the path of the template file
+     * @param object the object of the template
+     * @param tileset the path of the tileset of the template, if any
+     * @param firstGID the first global id of the tileset in the template
+     */
+    ObjectTemplate(const boost::filesystem::path& source, std::unique_ptr<Object> object, const boost::filesystem::path& tileset, unsigned firstGID)
+      : m_source(source), m_object(std::move(object)), m_tileset(tileset), m_firstGID(firstGID)
+    {
+    }
+
+    /**
+     * @brief Get the path of the template file.
+     *
+     * @returns the path of the template file
+     */
+    const boost::filesystem::path& getSource() const noexcept {
+      return m_source;
+    }
+
+    /**
+     * @brief Get the object of the template.
+     *
+     * @returns the object of the template
+     */
+    const Object& getObject() const noexcept {
+      return *m_object;
+    }
+
+    /**
+     * @brief Tell whether the template has a tileset.
+     *
+     * @returns true if the template has a tileset
+     */
+    bool hasTileSet() const noexcept {
+      return !m_tileset.empty();
+    }
+
+    /**
+     * @brief Get the path of the tileset of the template.
+     *
+     * @returns the path of the tileset
+     */
+    const boost::filesystem::path& getTileSetSource() const noexcept {
+      return m_tileset;
+    }
+
+    /**
+     * @brief Get the first global id of the tileset in the template.
+     *
+     * @returns the first global id of the tileset
+     */
+    unsigned getFirstGID() const noexcept {
+      return m_firstGID;
+    }
+
+    /**
+     * @brief Load a template.
+     *
+     * A template is parsed once for the whole process: the following calls
+     * with the same path return the same template, so all the instances
+     * in all the maps share it. The file is read at each call and the
+     * template is parsed again if the content of the file changed.
+     *
+     * @param filename the name of the template file
+     * @param filesystem the file system of the file
+     * @returns the template or null if the file can not be parsed
+     */
+    static std::shared_ptr<const ObjectTemplate> load(const boost::filesystem::path& filename, FileSystem& filesystem = FileSystem::getDefault());
+
+  private:
+    const boost::filesystem::path m_source;
+    const std::unique_ptr<Object> m_object;
+    const boost::filesystem::path m_tileset;
+    const unsigned m_firstGID;
+  };
+
+}
+
+#endif // TMX_OBJECT_TEMPLATE_H
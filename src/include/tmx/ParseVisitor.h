@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_PARSE_VISITOR_H
+#define TMX_PARSE_VISITOR_H
+
+namespace tmx {
+  class Map;
+  class TileSet;
+  class TileLayer;
+  class ObjectLayer;
+  class ImageLayer;
+  class GroupLayer;
+  class Object;
+
+  /**
+   * @brief The fate of an element after it has been visited during the parsing.
+   */
+  enum class ParseAction {
+    KEEP,     /**< The element is added to the map */
+    DISCARD,  /**< The element is destroyed */
+  };
+
+  /**
+   * @brief A parse visitor is a visitor for the elements of a map while it is parsed.
+   *
+   * Each element is visited as soon as it has been decoded, before being
+   * added to the map. The map given to the visitor is the map under
+   * construction, it only contains the elements that have been kept so far.
+   */
+  class ParseVisitor {
+  public:
+    /**
+     * @brief ParseVisitor destructor.
+     */
+    virtual ~ParseVisitor();
+
+    /**
+     * @brief Visit a tileset.
+     *
+     * @param map the map under construction
+     * @param tileset the tileset
+     * @returns the fate of the tileset
+     */
+    virtual ParseAction visitTileSet(const Map& map, const TileSet& tileset);
+
+    /**
+     * @brief Visit a tile layer.
+     *
+     * @param map the map under construction
+     * @param layer the tile layer
+     * @returns the fate of the layer
+     */
+    virtual ParseAction visitTileLayer(const Map& map, const TileLayer& layer);
+
+    /**
+     * @brief Visit an object layer.
+     *
+     * The objects of the layer have already been visited.
+     *
+     * @param map the map under construction
+     * @param layer the object layer
+     * @returns the fate of the layer
+     */
+    virtual ParseAction visitObjectLayer(const Map& map, const ObjectLayer& layer);
+
+    /**
+     * @brief Visit an image layer.
+     *
+     * @param map the map under construction
+     * @param layer the image layer
+     * @returns the fate of the layer
+     */
+    virtual ParseAction visitImageLayer(const Map& map, const ImageLayer& layer);
+
+    /**
+     * @brief Visit a group layer.
+     *
+     * The layers of the group have already been visited, with the same
+     * calls as the layers of the map, and the group only contains the
+     * layers that have been kept.
+     *
+     * @param map the map under construction
+     * @param layer the group layer
+     * @returns the fate of the layer
+     */
+    virtual ParseAction visitGroupLayer(const Map& map, const GroupLayer& layer);
+
+    /**
+     * @brief Visit an object.
+     *
+     * Only the objects of the object layers of the map are visited, the
+     * collision shapes of the tiles are always kept.
+     *
+     * @param map the map under construction
+     * @param layer the object layer under construction
+     * @param object the object
+     * @returns the fate of the object
+     */
+    virtual ParseAction visitObject(const Map& map, const ObjectLayer& layer, const Object& object);
+  };
+
+}
+
+
+#endif // TMX_PARSE_VISITOR_H
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_REGION_LOADER_H
+#define TMX_REGION_LOADER_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "CompiledMap.h"
+#include "FileSystem.h"
+#include "MapRegion.h"
+
+namespace tmx {
+
+  /**
+   * @brief A region loader reads regions of a compiled map file.
+   *
+   * The loader reads the header and the list of layers of the compiled map
+   * when it is opened. Then, each region is read with the chunk index of the
+   * compiled map: only the chunks that intersect the region are read, and
+   * the rest of the file is never touched. Strings are cached by the loader
+   * so they are read only once.
+   *
+   * A region loader must not be used by several threads at the same time.
+   *
+   * @sa CompiledMap, MapRegion
+   */
+  class RegionLoader {
+  public:
+    /**
+     * @brief Get the header of the compiled map.
+     *
+     * @returns the header of the compiled map
+     */
+    const compiled::Header& getHeader() const noexcept {
+      return m_header;
+    }
+
+    /**
+     * @brief Get the total number of bytes read since the opening.
+     *
+     * @returns the number of bytes read
+     */
+    std::size_t getBytesRead() const noexcept {
+      return m_bytesRead;
+    }
+
+    /**
+     * @brief Load a region of the map.
+     *
+     * The rectangle is clipped to the bounds of the map. The objects are
+     * selected with their axis-aligned bounds, in pixels, computed as if the
+     * map was orthogonal.
+     *
+     * @param layers the names of the tile layers and object layers to load, or all of them if empty
+     * @param rect the rectangle to load, in tiles
+     * @returns the region or nullptr if the file could not be read
+     */
+    std::unique_ptr<MapRegion> loadRegion(const std::vector<std::string>& layers, const Rect& rect);
+
+    /**
+     * @brief Open a compiled map file for loading regions.
+     *
+     * @param filename the filename of the compiled map
+     * @param filesystem the file system used to open the file
+     * @returns a region loader or nullptr if the file is not a valid compiled map
+     */
+    static std::unique_ptr<RegionLoader> open(const boost::filesystem::path& filename, FileSystem& filesystem = FileSystem::getDefault());
+
+  private:
+    RegionLoader(std::unique_ptr<File> file);
+
+    bool readBytes(uint64_t offset, void *buffer, std::size_t size);
+
+    template<typename T>
+    bool readElements(compiled::SectionId id, uint64_t index, std::size_t count, T *elements) {
+      const compiled::Section& section = m_header.sections[id];
+
+      if (index > section.count || count > section.count - index) {
+        return false;
+      }
+
+      return readBytes(section.offset + index * sizeof(T), elements, count * sizeof(T));
+    }
+
+    bool readString(uint32_t index, std::string& str);
+    bool readProperties(const compiled::Range& range, Component& component);
+    bool readTileLayer(const compiled::Layer& data, const Rect& rect, MapRegion& region);
+    bool readObjectLayer(const compiled::Layer& data, const Rect& rect, MapRegion& region);
+    std::unique_ptr<Object> readObject(uint32_t index);
+
+  private:
+    std::unique_ptr<File> m_file;
+    compiled::Header m_header;
+    std::vector<compiled::Layer> m_layers;
+    std::unordered_map<uint32_t, std::string> m_strings;
+    std::size_t m_bytesRead;
+  };
+
+}
+
+#endif // TMX_REGION_LOADER_H
@@ -17,12 +17,22 @@
 #define TMX_TILE_H
 
 #include <array>
+#include <vector>
 
 #include "Component.h"
 #include "Image.h"
+#include "ObjectLayer.h"
 
 namespace tmx {
 
+  /**
+   * @brief A frame of the animation of a tile.
+   */
+  struct Frame {
+    unsigned tileId;    /**< the local id of the tile to show, in the same tileset */
+    unsigned duration;  /**< the duration of the frame, in milliseconds */
+  };
+
   /**
    * @brief A tile is a rectangular part of a tileset.
    */
@@ -126,12 +136,75 @@ namespace tmx {
       return m_image.get();
     }
 
+    /**
+     * @brief Set the animation of this tile.
+     *
+     * @param frames the frames of the animation
+     */
+    void setAnimation(std::vector<Frame> frames) {
+      m_animation = std::move(frames);
+    }
+
+    /**
+     * @brief Tell whether the tile is animated.
+     *
+     * @returns true if the tile has an animation
+     */
+    bool hasAnimation() const noexcept {
+      return !m_animation.empty();
+    }
+
+    /**
+     * @brief Get the frames of the animation of this tile.
+     *
+     * @returns the frames, empty if the tile is not animated
+     *
+     * @sa AnimationClock
+     */
+    const std::vector<Frame>& getAnimation() const noexcept {
+      return m_animation;
+    }
+
+    /**
+     * @brief Set the objects of this tile.
+     *
+     * The objects of a tile are generally its collision shapes, in the
+     * coordinates of the tile.
+     *
+     * @param objects the objects of this tile
+     */
+    void setObjects(std::unique_ptr<ObjectLayer> objects) {
+      m_objects = std::move(objects);
+    }
+
+    /**
+     * @brief Tell whether the tile has objects.
+     *
+     * @returns true if the tile has objects
+     */
+    bool hasObjects() const noexcept {
+      return m_objects.get() != nullptr;
+    }
+
+    /**
+     * @brief Get the objects of this tile.
+     *
+     * @returns the objects of this tile, or nullptr
+     *
+     * @sa TileColliders
+     */
+    const ObjectLayer *getObjects() const noexcept {
+      return m_objects.get();
+    }
+
   private:
     const unsigned m_id;
     const std::array<unsigned, 4> m_terrain;
     const unsigned m_probability;
 
     std::unique_ptr<Image> m_image;
+    std::vector<Frame> m_animation;
+    std::unique_ptr<ObjectLayer> m_objects;
   };
 
 }
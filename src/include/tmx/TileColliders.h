@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_TILE_COLLIDERS_H
+#define TMX_TILE_COLLIDERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <boost/range/iterator_range.hpp>
+
+#include "Geometry.h"
+#include "Map.h"
+
+namespace tmx {
+
+  /**
+   * @brief An axis-aligned bounding box.
+   */
+  struct ColliderBox {
+    Vector2f min; /**< the top left corner */
+    Vector2f max; /**< the bottom right corner */
+  };
+
+  /**
+   * @brief A kind of collision shape.
+   */
+  enum class ColliderKind : uint32_t {
+    BOX,      /**< An axis-aligned box, the bounds of the shape */
+    ELLIPSE,  /**< An axis-aligned ellipse inscribed in the bounds of the shape */
+    CONVEX,   /**< A convex polygon */
+    CHAIN,    /**< An open line */
+  };
+
+  /**
+   * @brief A collision shape of a tile.
+   */
+  struct ColliderShape {
+    ColliderKind kind;  /**< the kind of the shape */
+    unsigned object;    /**< the id of the object of the shape */
+    ColliderBox bounds; /**< the bounds of the shape */
+    uint32_t first;     /**< convex and chain: index of the first point */
+    uint32_t count;     /**< convex and chain: number of points */
+  };
+
+  /**
+   * @brief The collision shapes of a tile.
+   */
+  struct TileCollider {
+    ColliderBox bounds; /**< the bounds of all the shapes */
+    uint32_t first;     /**< index of the first shape */
+    uint32_t count;     /**< number of shapes */
+  };
+
+  /**
+   * @brief The collision shapes of all the tiles of a map, by global id.
+   *
+   * The shapes come from the objects of the tiles. They are converted
+   * once, in flat arrays, so that getting the shapes of a tile is a lookup
+   * in a table, without allocation:
+   *
+   * - a rectangle is a box, and a rotated rectangle is a convex polygon
+   * - an ellipse is an ellipse, and a rotated ellipse is approximated by a
+   *   convex polygon
+   * - a polygon is decomposed in convex polygons
+   * - a polyline is a chain
+   *
+   * The coordinates are in pixels, relative to the top left corner of the
+   * tile, and do not take the flip flags of the cells into account. The
+   * points of a convex polygon are in the order of the polygon in Tiled.
+   *
+   * @sa Tile::getObjects
+   */
+  class TileColliders {
+  public:
+    /**
+     * @brief The number of points of a rotated ellipse.
+     */
+    static constexpr std::size_t EllipseSegments = 16;
+
+    /**
+     * @brief Constructor.
+     *
+     * @param map the map with the tiles
+     */
+    explicit TileColliders(const Map& map);
+
+    /**
+     * @brief Get the number of tiles with collision shapes.
+     *
+     * @returns the number of tiles with collision shapes
+     */
+    std::size_t getColliderCount() const noexcept {
+      return m_colliders.size();
+    }
+
+    /**
+     * @brief Get the collision shapes of a tile.
+     *
+     * @param gid the global id of the tile, without the flip flags
+     * @returns the collision shapes of the tile, or nullptr if the tile has none
+     */
+    const TileCollider *getCollider(unsigned gid) const noexcept {
+      if (gid >= m_index.size() || m_index[gid] == 0) {
+        return nullptr;
+      }
+
+      return &m_colliders[m_index[gid] - 1];
+    }
+
+    /**
+     * @brief Get the shapes of a collider.
+     *
+     * @param collider the collider
+     * @returns a range of shapes
+     */
+    boost::iterator_range<const ColliderShape *> getShapes(const TileCollider& collider) const noexcept {
+      const ColliderShape *first = m_shapes.data() + collider.first;
+      return boost::make_iterator_range(first, first + collider.count);
+    }
+
+    /**
+     * @brief Get the points of a shape.
+     *
+     * @param shape the shape
+     * @returns a range of points, empty for a box or an ellipse
+     */
+    boost::iterator_range<const Vector2f *> getPoints(const ColliderShape& shape) const noexcept {
+      const Vector2f *first = m_points.data() + shape.first;
+      return boost::make_iterator_range(first, first + shape.count);
+    }
+
+  private:
+    void addObject(const Object& object);
+    void addShape(ColliderKind kind, const Object& object, ColliderBox bounds, const std::vector<Vector2f>& points);
+
+  private:
+    std::vector<uint32_t> m_index;  // index of the collider plus one, by global id
+    std::vector<TileCollider> m_colliders;
+    std::vector<ColliderShape> m_shapes;
+    std::vector<Vector2f> m_points;
+  };
+
+}
+
+#endif // TMX_TILE_COLLIDERS_H
@@ -47,6 +47,35 @@ namespace tmx {
       m_cells.emplace_back(cell);
     }
 
+    /**
+     * @brief Get the number of cells of the layer.
+     *
+     * @returns the number of cells
+     */
+    std::size_t getCellCount() const noexcept {
+      return m_cells.size();
+    }
+
+    /**
+     * @brief Get a cell of the layer.
+     *
+     * @param index the index of the cell, in row-major order
+     * @returns the cell
+     */
+    const Cell& getCell(std::size_t index) const noexcept {
+      return m_cells[index];
+    }
+
+    /**
+     * @brief Replace a cell of the layer.
+     *
+     * @param index the index of the cell, in row-major order
+     * @param cell the new cell
+     */
+    void setCell(std::size_t index, Cell cell) noexcept {
+      m_cells[index] = cell;
+    }
+
     /**
      * @brief A cell iterator.
      */
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_WORK_STEALING_EXECUTOR_H
+#define TMX_WORK_STEALING_EXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Executor.h"
+
+namespace tmx {
+
+  /**
+   * @brief An executor with a pool of threads that steal work from each other.
+   *
+   * Each thread has its own queue of tasks. A task submitted from a thread
+   * of the pool goes to the queue of this thread, other tasks are
+   * distributed among the queues. When its queue is empty, a thread steals
+   * the oldest task of another queue.
+   */
+  class WorkStealingExecutor : public Executor {
+  public:
+    /**
+     * @brief WorkStealingExecutor constructor.
+     *
+     * @param threads the number of threads, or 0 for the number of hardware threads
+     */
+    explicit WorkStealingExecutor(unsigned threads = 0);
+
+    /**
+     * @brief WorkStealingExecutor destructor.
+     *
+     * The pending tasks are run before the threads are stopped.
+     */
+    virtual ~WorkStealingExecutor();
+
+    WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+    WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+    virtual void execute(std::function<void()> task) override;
+
+    virtual ExecutorStatistics getStatistics() const override;
+
+    /**
+     * @brief Get the number of threads of the pool.
+     *
+     * @returns the number of threads
+     */
+    unsigned getThreadCount() const noexcept {
+      return static_cast<unsigned>(m_threads.size());
+    }
+
+  private:
+    struct Queue {
+      std::mutex mutex;
+      std::deque<std::function<void()>> tasks;
+    };
+
+    void run(std::size_t index);
+    bool popLocal(std::size_t index, std::function<void()>& task);
+    bool steal(std::size_t index, std::function<void()>& task);
+
+  private:
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::atomic<std::size_t> m_next;
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_sleepCondition;
+    std::atomic<std::size_t> m_pending;
+    bool m_stop;
+
+    std::atomic<uint64_t> m_tasksRun;
+    std::atomic<int64_t> m_stealTime;
+    std::atomic<int64_t> m_idleTime;
+  };
+
+}
+
+#endif // TMX_WORK_STEALING_EXECUTOR_H
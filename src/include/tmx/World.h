@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_WORLD_H
+#define TMX_WORLD_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "Executor.h"
+#include "FileSystem.h"
+#include "Geometry.h"
+#include "Map.h"
+
+namespace tmx {
+
+  class LoadProgress;
+  class TileSetCache;
+
+  /**
+   * @brief A map of a world, with its place in the world.
+   */
+  struct WorldMap {
+    boost::filesystem::path fileName;  /**< the path of the map file */
+    int x;                             /**< the x coordinate of the top left corner, in pixels */
+    int y;                             /**< the y coordinate of the top left corner, in pixels */
+    unsigned width;                    /**< the width of the map, in pixels */
+    unsigned height;                   /**< the height of the map, in pixels */
+  };
+
+  /**
+   * @brief The statistics of a world.
+   */
+  struct WorldStatistics {
+    uint64_t hits;              /**< the number of requests of a resident or loading map */
+    uint64_t misses;            /**< the number of requests that started a load */
+    uint64_t evictions;         /**< the number of evicted maps */
+    uint64_t prefetches;        /**< the number of loads started by a prefetch */
+    std::size_t residentMaps;   /**< the number of loaded maps */
+    std::size_t loadingMaps;    /**< the number of maps being loaded */
+  };
+
+  /**
+   * @brief A world is a set of maps laid out in a large space.
+   *
+   * A world is defined in a world file of Tiled. The world keeps a spatial
+   * index of the bounds of its maps, so that the map under a point is found
+   * in logarithmic time.
+   *
+   * The maps are loaded on demand, asynchronously on an executor. A moving
+   * focus (e.g. the position of the player) prefetches the maps around it
+   * before they are needed, and evicts the maps that are far away. A map
+   * that is still used outside the world stays alive until it is released,
+   * even if it has been evicted.
+   *
+   * All the functions of the world can be called from several threads.
+   */
+  class World {
+  public:
+    /**
+     * @brief A future map.
+     *
+     * The map is nullptr if it could not be loaded.
+     */
+    typedef std::shared_future<std::shared_ptr<const Map>> future_map;
+
+    /**
+     * @brief The index returned when no map is found.
+     */
+    static constexpr std::size_t NoMap = static_cast<std::size_t>(-1);
+
+    /**
+     * @brief The default prefetch distance, in pixels.
+     */
+    static constexpr unsigned DefaultPrefetchDistance = 512;
+
+    /**
+     * @brief World destructor.
+     *
+     * The destructor cancels the loads in progress and waits for them.
+     */
+    ~World();
+
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    /**
+     * @name Maps
+     * @{
+     */
+    /**
+     * @brief Get the maps of the world.
+     *
+     * @returns the maps, in the order of the world file
+     */
+    const std::vector<WorldMap>& getMaps() const noexcept {
+      return m_maps;
+    }
+
+    /**
+     * @brief Find the map that covers a point.
+     *
+     * If several maps cover the point, the first one in the world file is
+     * returned.
+     *
+     * @param x the x coordinate of the point, in pixels
+     * @param y the y coordinate of the point, in pixels
+     * @returns the index of the map or NoMap
+     */
+    std::size_t findMapAt(int x, int y) const;
+
+    /**
+     * @brief Find the maps that intersect a rectangle.
+     *
+     * @param x the x coordinate of the top left corner, in pixels
+     * @param y the y coordinate of the top left corner, in pixels
+     * @param width the width of the rectangle, in pixels
+     * @param height the height of the rectangle, in pixels
+     * @returns the indices of the maps, sorted
+     */
+    std::vector<std::size_t> findMaps(int x, int y, unsigned width, unsigned height) const;
+    /** @} */
+
+    /**
+     * @name Loading
+     * @{
+     */
+    /**
+     * @brief Request a map.
+     *
+     * The map is loaded if it is not resident.
+     *
+     * @param index the index of the map
+     * @returns the future map
+     */
+    future_map requestMap(std::size_t index);
+
+    /**
+     * @brief Get the map that covers a point.
+     *
+     * This function blocks while the map is loaded.
+     *
+     * @param x the x coordinate of the point, in pixels
+     * @param y the y coordinate of the point, in pixels
+     * @returns the map or nullptr if no map covers the point
+     */
+    std::shared_ptr<const Map> getMapAt(int x, int y);
+
+    /**
+     * @brief Get the map that covers a point if it is loaded.
+     *
+     * This function never blocks. It requests the map if it is not
+     * resident.
+     *
+     * @param x the x coordinate of the point, in pixels
+     * @param y the y coordinate of the point, in pixels
+     * @returns the map or nullptr if the map is not loaded yet
+     */
+    std::shared_ptr<const Map> tryGetMapAt(int x, int y);
+
+    /**
+     * @brief Move the focus of the world.
+     *
+     * The maps closer to the focus than the prefetch distance are loaded,
+     * the maps farther than the eviction distance are evicted, and their
+     * loads are cancelled.
+     *
+     * @param focus the focus, in pixels
+     */
+    void updateFocus(const Vector2i& focus);
+
+    /**
+     * @brief Set the distances of the prefetch and of the eviction.
+     *
+     * The eviction distance is at least the prefetch distance. A larger
+     * eviction distance avoids to reload a map when the focus goes back
+     * and forth along a border.
+     *
+     * @param prefetch the prefetch distance, in pixels
+     * @param eviction the eviction distance, in pixels
+     */
+    void setDistances(unsigned prefetch, unsigned eviction);
+
+    /**
+     * @brief Get the statistics of the world.
+     *
+     * @returns the statistics
+     */
+    WorldStatistics getStatistics() const;
+    /** @} */
+
+    /**
+     * @brief Parse a world file.
+     *
+     * The maps listed in the file and the maps that match its patterns are
+     * part of the world. The patterns are matched against the files of the
+     * directory of the world file, listed by the file system.
+     *
+     * @param filename the filename of the world file
+     * @param executor the executor that loads the maps
+     * @param filesystem the file system used to open the files
+     * @returns a world or nullptr if the file is not a valid world file
+     */
+    static std::unique_ptr<World> parseFile(const boost::filesystem::path& filename,
+        Executor& executor = Executor::getDefault(), FileSystem& filesystem = FileSystem::getDefault());
+
+  private:
+    struct Box {
+      int x0, y0, x1, y1;
+    };
+
+    struct Node {
+      Box box;
+      uint32_t first;
+      uint32_t count;
+    };
+
+    struct Entry {
+      future_map map;
+      std::shared_ptr<LoadProgress> progress;
+    };
+
+    World(std::vector<WorldMap> maps, Executor& executor, FileSystem& filesystem);
+
+    void buildIndex();
+    template<typename Function>
+    void query(const Box& box, Function function) const;
+
+    future_map request(std::size_t index, bool prefetch);
+    std::shared_ptr<const Map> load(std::size_t index, LoadProgress& progress);
+
+  private:
+    std::vector<WorldMap> m_maps;
+    std::vector<Box> m_boxes;
+    std::vector<Node> m_nodes;      // the leaves first, the root last
+    std::size_t m_leaves;
+    std::vector<uint32_t> m_order;  // the maps, in the order of the leaves
+
+    Executor& m_executor;
+    FileSystem& m_filesystem;
+    std::unique_ptr<TileSetCache> m_tilesets;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_done;
+    unsigned m_prefetchDistance;
+    unsigned m_evictionDistance;
+    std::unordered_map<std::size_t, Entry> m_entries;
+    std::size_t m_loading;
+    WorldStatistics m_stats;
+  };
+
+}
+
+#endif // TMX_WORLD_H
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/AnimationClock.h>
+
+#include <algorithm>
+#include <numeric>
+
+#include <tmx/Cell.h>
+#include <tmx/Tile.h>
+#include <tmx/TileSet.h>
+
+namespace tmx {
+
+  AnimationClock::AnimationClock(const Map& map) {
+    uint32_t maxGID = 0;
+
+    for (auto tileset : map.getTileSets()) {
+      for (auto tile : *tileset) {
+        if (!tile->hasAnimation()) {
+          continue;
+        }
+
+        Animation animation;
+        animation.gid = tileset->getFirstGID() + tile->getId();
+        animation.period = 0;
+        animation.first = m_frameEnds.size();
+        animation.count = tile->getAnimation().size();
+
+        for (auto& frame : tile->getAnimation()) {
+          animation.period += frame.duration;
+          m_frameEnds.push_back(animation.period);
+          m_frameGIDs.push_back(tileset->getFirstGID() + frame.tileId);
+        }
+
+        maxGID = std::max(maxGID, animation.gid);
+        m_animations.push_back(animation);
+      }
+    }
+
+    if (m_animations.empty()) {
+      return;
+    }
+
+    // the tiles that are not animated are their own frame
+    m_table.resize(maxGID + 1);
+    std::iota(m_table.begin(), m_table.end(), 0);
+
+    update(std::chrono::milliseconds::zero());
+  }
+
+  void AnimationClock::update(std::chrono::milliseconds time) {
+    auto now = time.count();
+
+    for (auto& animation : m_animations) {
+      uint32_t index = 0;
+
+      if (animation.period > 0) {
+        auto elapsed = now % animation.period;
+
+        if (elapsed < 0) {
+          elapsed += animation.period;
+        }
+
+        // the first frame that ends after the elapsed time
+        auto first = m_frameEnds.begin() + animation.first;
+        auto last = first + animation.count;
+        index = std::upper_bound(first, last, static_cast<uint32_t>(elapsed)) - first;
+
+        // frames with a null duration at the end of the period
+        if (index == animation.count) {
+          index = 0;
+        }
+      }
+
+      m_table[animation.gid] = m_frameGIDs[animation.first + index];
+    }
+  }
+
+  // written without branch in the loop so that the compiler can vectorize it
+  void AnimationClock::remap(const uint32_t *raw, uint32_t *out, std::size_t count) const noexcept {
+    const uint32_t FlipMask = Cell::HFLIP_FLAG | Cell::VFLIP_FLAG | Cell::DFLIP_FLAG;
+
+    const uint32_t *table = m_table.data();
+    const uint32_t size = m_table.size();
+
+    for (std::size_t i = 0; i < count; ++i) {
+      uint32_t gid = raw[i] & ~FlipMask;
+      uint32_t frame = gid < size ? table[gid] : gid;
+      out[i] = frame | (raw[i] & FlipMask);
+    }
+  }
+
+}
@@ -0,0 +1,372 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/AssetPack.h>
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace fs = boost::filesystem;
+namespace ipc = boost::interprocess;
+
+/*
+ * Format of a pack (all integers are little-endian):
+ *
+ * - magic: "TMXPACK\0"
+ * - version: uint32 (1)
+ * - count: uint32
+ * - count entries:
+ *   - offset: uint64 (from the beginning of the pack)
+ *   - size: uint64
+ *   - path length: uint32
+ *   - path: bytes, not null-terminated
+ * - the content of the files, each aligned on 8 bytes
+ */
+
+namespace tmx {
+
+  namespace {
+
+    const char PackMagic[8] = { 'T', 'M', 'X', 'P', 'A', 'C', 'K', '\0' };
+    const uint32_t PackVersion = 1;
+    const std::size_t PackAlignment = 8;
+
+    // the paths of a pack are relative to its root, an absolute path or a path outside the root is invalid
+    bool normalizePath(const fs::path& path, std::string& normalized) {
+      if (path.has_root_path()) {
+        return false;
+      }
+
+      std::vector<std::string> elements;
+
+      for (auto& element : path) {
+        std::string name = element.generic_string();
+
+        if (name == "." || name.empty()) {
+          continue;
+        }
+
+        if (name == "..") {
+          if (elements.empty()) {
+            return false;
+          }
+
+          elements.pop_back();
+          continue;
+        }
+
+        elements.push_back(name);
+      }
+
+      normalized.clear();
+
+      for (auto& name : elements) {
+        if (!normalized.empty()) {
+          normalized += '/';
+        }
+
+        normalized += name;
+      }
+
+      return true;
+    }
+
+    class PackReader {
+    public:
+      PackReader(const char *data, std::size_t size)
+        : m_data(data), m_size(size), m_offset(0), m_ok(true)
+      {
+      }
+
+      bool isOk() const {
+        return m_ok;
+      }
+
+      const char *readBytes(std::size_t size) {
+        if (!m_ok || m_size - m_offset < size) {
+          m_ok = false;
+          return nullptr;
+        }
+
+        const char *bytes = m_data + m_offset;
+        m_offset += size;
+        return bytes;
+      }
+
+      uint64_t readInteger(std::size_t size) {
+        const char *bytes = readBytes(size);
+
+        if (bytes == nullptr) {
+          return 0;
+        }
+
+        uint64_t value = 0;
+
+        for (std::size_t i = 0; i < size; ++i) {
+          value |= static_cast<uint64_t>(static_cast<uint8_t>(bytes[i])) << (8 * i);
+        }
+
+        return value;
+      }
+
+    private:
+      const char *m_data;
+      std::size_t m_size;
+      std::size_t m_offset;
+      bool m_ok;
+    };
+
+    void writeInteger(std::ostream& out, uint64_t value, std::size_t size) {
+      for (std::size_t i = 0; i < size; ++i) {
+        out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+      }
+    }
+
+    std::size_t align(std::size_t offset) {
+      return (offset + PackAlignment - 1) / PackAlignment * PackAlignment;
+    }
+
+    class PackFile : public File {
+    public:
+      PackFile(const char *data, std::size_t size)
+        : m_data(data), m_size(size)
+      {
+      }
+
+      virtual std::size_t getSize() const override {
+        return m_size;
+      }
+
+      virtual std::size_t read(std::size_t offset, void *buffer, std::size_t size) override {
+        if (offset >= m_size) {
+          return 0;
+        }
+
+        size = std::min(size, m_size - offset);
+        std::memcpy(buffer, m_data + offset, size);
+        return size;
+      }
+
+      virtual const char *map() override {
+        return m_data;
+      }
+
+    private:
+      const char *m_data;
+      const std::size_t m_size;
+    };
+
+  }
+
+  struct AssetPack::Mapping {
+    ipc::file_mapping file;
+    ipc::mapped_region region;
+  };
+
+  AssetPack::AssetPack(std::unique_ptr<Mapping> mapping)
+    : m_mapping(std::move(mapping))
+  {
+  }
+
+  AssetPack::~AssetPack() {
+  }
+
+  std::unique_ptr<File> AssetPack::open(const fs::path& path) {
+    std::string name;
+
+    if (!normalizePath(path, name)) {
+      return nullptr;
+    }
+
+    auto it = m_index.find(name);
+
+    if (it == m_index.end()) {
+      return nullptr;
+    }
+
+    const char *base = static_cast<const char *>(m_mapping->region.get_address());
+    return std::unique_ptr<File>(new PackFile(base + it->second.offset, it->second.size));
+  }
+
+  bool AssetPack::list(const fs::path& directory, std::vector<fs::path>& files) {
+    std::string prefix;
+
+    if (!normalizePath(directory, prefix)) {
+      return false;
+    }
+
+    if (!prefix.empty()) {
+      prefix += '/';
+    }
+
+    // the pack only has files, a directory exists if it has files
+    bool found = prefix.empty();
+
+    for (auto& entry : m_index) {
+      const std::string& name = entry.first;
+
+      if (name.compare(0, prefix.size(), prefix) != 0) {
+        continue;
+      }
+
+      found = true;
+
+      if (name.find('/', prefix.size()) == std::string::npos) {
+        files.push_back(name.substr(prefix.size()));
+      }
+    }
+
+    return found;
+  }
+
+  std::unique_ptr<AssetPack> AssetPack::openPack(const fs::path& filename) {
+    std::unique_ptr<Mapping> mapping(new Mapping);
+
+    try {
+      ipc::file_mapping file(filename.string().c_str(), ipc::read_only);
+      ipc::mapped_region region(file, ipc::read_only);
+      mapping->file.swap(file);
+      mapping->region.swap(region);
+    } catch (ipc::interprocess_exception& ex) {
+      std::clog << "Error! Unable to map the asset pack: " << filename << '\n';
+      return nullptr;
+    }
+
+    const char *data = static_cast<const char *>(mapping->region.get_address());
+    const std::size_t size = mapping->region.get_size();
+
+    PackReader reader(data, size);
+    const char *magic = reader.readBytes(sizeof PackMagic);
+
+    if (magic == nullptr || std::memcmp(magic, PackMagic, sizeof PackMagic) != 0) {
+      std::clog << "Error! Not an asset pack: " << filename << '\n';
+      return nullptr;
+    }
+
+    uint32_t version = reader.readInteger(4);
+
+    if (version != PackVersion) {
+      std::clog << "Error! Unsupported asset pack version: " << version << '\n';
+      return nullptr;
+    }
+
+    uint32_t count = reader.readInteger(4);
+
+    std::unique_ptr<AssetPack> pack(new AssetPack(std::move(mapping)));
+    pack->m_index.reserve(count);
+
+    for (uint32_t i = 0; i < count && reader.isOk(); ++i) {
+      Entry entry;
+      entry.offset = reader.readInteger(8);
+      entry.size = reader.readInteger(8);
+      std::size_t length = reader.readInteger(4);
+      const char *path = reader.readBytes(length);
+
+      if (path == nullptr || entry.offset > size || entry.size > size - entry.offset) {
+        reader.readBytes(size); // invalidate the reader
+        break;
+      }
+
+      pack->m_index.emplace(std::string(path, length), entry);
+    }
+
+    if (!reader.isOk()) {
+      std::clog << "Error! Corrupted asset pack: " << filename << '\n';
+      return nullptr;
+    }
+
+    return pack;
+  }
+
+  bool AssetPack::createPack(const fs::path& filename, const fs::path& root, const std::vector<fs::path>& files) {
+    std::vector<std::string> names;
+    std::vector<uintmax_t> sizes;
+
+    for (auto& file : files) {
+      std::string name;
+
+      if (!normalizePath(file, name)) {
+        std::clog << "Error! The path of a file of an asset pack must be relative to its root: " << file << '\n';
+        return false;
+      }
+
+      boost::system::error_code ec;
+      uintmax_t size = fs::file_size(root / file, ec);
+
+      if (ec) {
+        std::clog << "Error! Unable to add a file to the asset pack: " << (root / file) << '\n';
+        return false;
+      }
+
+      names.push_back(name);
+      sizes.push_back(size);
+    }
+
+    std::size_t offset = sizeof PackMagic + 4 + 4;
+
+    for (auto& name : names) {
+      offset += 8 + 8 + 4 + name.size();
+    }
+
+    std::ofstream out(filename.string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+    if (!out) {
+      std::clog << "Error! Unable to create the asset pack: " << filename << '\n';
+      return false;
+    }
+
+    out.write(PackMagic, sizeof PackMagic);
+    writeInteger(out, PackVersion, 4);
+    writeInteger(out, names.size(), 4);
+
+    std::vector<std::size_t> offsets;
+
+    for (std::size_t i = 0; i < names.size(); ++i) {
+      offset = align(offset);
+      offsets.push_back(offset);
+
+      writeInteger(out, offset, 8);
+      writeInteger(out, sizes[i], 8);
+      writeInteger(out, names[i].size(), 4);
+      out.write(names[i].data(), names[i].size());
+
+      offset += sizes[i];
+    }
+
+    for (std::size_t i = 0; i < names.size(); ++i) {
+      while (static_cast<std::size_t>(out.tellp()) < offsets[i]) {
+        out.put('\0');
+      }
+
+      if (sizes[i] > 0) {
+        std::ifstream in((root / files[i]).string().c_str(), std::ios::in | std::ios::binary);
+        out << in.rdbuf();
+      }
+
+      if (static_cast<std::size_t>(out.tellp()) != offsets[i] + sizes[i]) {
+        std::clog << "Error! Unable to copy a file in the asset pack: " << (root / files[i]) << '\n';
+        return false;
+      }
+    }
+
+    return static_cast<bool>(out);
+  }
+
+}
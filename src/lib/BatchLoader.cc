@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/BatchLoader.h>
+
+#include <algorithm>
+#include <future>
+
+#include <tinyxml2.h>
+
+#include <tmx/LoadProgress.h>
+
+#include "Parser.h"
+#include "TileSetCache.h"
+
+namespace fs = boost::filesystem;
+
+namespace tmx {
+
+  namespace {
+
+    bool matchPattern(const char *pattern, const char *name) {
+      for (;;) {
+        switch (*pattern) {
+          case '\0':
+            return *name == '\0';
+
+          case '*':
+            // try every possible length for the star
+            do {
+              if (matchPattern(pattern + 1, name)) {
+                return true;
+              }
+            } while (*name++ != '\0');
+            return false;
+
+          case '?':
+            if (*name == '\0') {
+              return false;
+            }
+            break;
+
+          default:
+            if (*pattern != *name) {
+              return false;
+            }
+            break;
+        }
+
+        ++pattern;
+        ++name;
+      }
+    }
+
+    double perSecond(double quantity, std::chrono::nanoseconds duration) {
+      if (duration.count() == 0) {
+        return 0.0;
+      }
+
+      return quantity / std::chrono::duration<double>(duration).count();
+    }
+
+  }
+
+  double BatchStatistics::getMegabytesPerSecond() const noexcept {
+    return perSecond(bytes / (1024.0 * 1024.0), duration);
+  }
+
+  double BatchStatistics::getMapsPerSecond() const noexcept {
+    return perSecond(maps, duration);
+  }
+
+  BatchLoader::BatchLoader(Executor& executor)
+    : m_executor(executor), m_filesystem(nullptr)
+  {
+    m_stats.maps = m_stats.failures = 0;
+    m_stats.bytes = 0;
+    m_stats.duration = std::chrono::nanoseconds::zero();
+  }
+
+  void BatchLoader::addFile(const fs::path& filename) {
+    m_files.push_back(filename);
+  }
+
+  std::size_t BatchLoader::addFiles(const fs::path& directory, const std::string& pattern) {
+    std::vector<fs::path> files;
+    boost::system::error_code ec;
+
+    for (fs::directory_iterator it(directory, ec), end; it != end; it.increment(ec)) {
+      if (ec) {
+        break;
+      }
+
+      const fs::path& path = it->path();
+
+      if (fs::is_regular_file(it->status()) && matchPattern(pattern.c_str(), path.filename().string().c_str())) {
+        files.push_back(path);
+      }
+    }
+
+    std::sort(files.begin(), files.end());
+    m_files.insert(m_files.end(), files.begin(), files.end());
+    return files.size();
+  }
+
+  std::vector<std::unique_ptr<Map>> BatchLoader::load() {
+    typedef std::packaged_task<std::unique_ptr<Map>()> Task;
+
+    auto start = std::chrono::steady_clock::now();
+
+    TileSetCache tilesets;
+    LoadProgress progress;
+    std::vector<std::future<std::unique_ptr<Map>>> futures;
+
+    for (auto& file : m_files) {
+      auto task = std::make_shared<Task>([this,&file,&tilesets,&progress]() {
+        // the document of the thread is reused from one map to the next
+        static thread_local tinyxml2::XMLDocument doc;
+
+        ParseContext context;
+        context.progress = &progress;
+        context.tilesets = &tilesets;
+        context.document = &doc;
+        context.filesystem = m_filesystem;
+        return parseMapFile(file, context);
+      });
+
+      futures.push_back(task->get_future());
+      m_executor.execute([task]() { (*task)(); });
+    }
+
+    std::vector<std::unique_ptr<Map>> maps;
+    maps.reserve(futures.size());
+
+    m_stats.maps = m_stats.failures = 0;
+
+    for (auto& future : futures) {
+      maps.push_back(future.get());
+
+      if (maps.back()) {
+        m_stats.maps++;
+      } else {
+        m_stats.failures++;
+      }
+    }
+
+    m_stats.bytes = progress.getBytesRead();
+    m_stats.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+    return maps;
+  }
+
+}
@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/ChunkPager.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "MapCompiler.h"
+
+namespace fs = boost::filesystem;
+
+namespace tmx {
+
+  namespace {
+
+    template<typename T>
+    bool readElements(File& file, const compiled::Header& header, compiled::SectionId id, uint64_t index, std::size_t count, T *elements) {
+      const compiled::Section& section = header.sections[id];
+
+      if (index > section.count || count > section.count - index) {
+        return false;
+      }
+
+      std::size_t size = count * sizeof(T);
+      return file.read(section.offset + index * sizeof(T), elements, size) == size;
+    }
+
+  }
+
+  ChunkPager::ChunkPager(std::unique_ptr<File> file, std::size_t budget, Executor& executor)
+  : m_file(std::move(file))
+  , m_chunksPerRow(0)
+  , m_chunksPerColumn(0)
+  , m_executor(executor)
+  , m_budget(budget)
+  , m_loading(0)
+  {
+    std::memset(&m_header, 0, sizeof m_header);
+    std::memset(&m_stats, 0, sizeof m_stats);
+  }
+
+  ChunkPager::~ChunkPager() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_loading == 0; });
+  }
+
+  std::size_t ChunkPager::getBudget() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_budget;
+  }
+
+  void ChunkPager::setBudget(std::size_t budget) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_budget = budget;
+    evict();
+  }
+
+  ChunkPager::future_chunk ChunkPager::requestChunk(unsigned layer, unsigned cx, unsigned cy) {
+    return request(layer, cx, cy, Request::QUERY);
+  }
+
+  std::shared_ptr<const TileChunk> ChunkPager::getChunkAt(unsigned layer, unsigned x, unsigned y) {
+    return request(layer, x / m_header.chunkSize, y / m_header.chunkSize, Request::QUERY).get();
+  }
+
+  Cell ChunkPager::getCell(unsigned layer, unsigned x, unsigned y) {
+    auto chunk = getChunkAt(layer, x, y);
+
+    if (!chunk) {
+      return Cell(0);
+    }
+
+    return chunk->getCell(x, y);
+  }
+
+  bool ChunkPager::tryGetCell(unsigned layer, unsigned x, unsigned y, Cell& cell) {
+    auto future = request(layer, x / m_header.chunkSize, y / m_header.chunkSize, Request::QUERY);
+
+    if (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      return false;
+    }
+
+    auto chunk = future.get();
+
+    if (!chunk) {
+      return false;
+    }
+
+    cell = chunk->getCell(x, y);
+    return true;
+  }
+
+  void ChunkPager::prefetch(unsigned layer, const Vector2u& position, const Vector2i& direction, unsigned distance) {
+    int cx = position.x / m_header.chunkSize;
+    int cy = position.y / m_header.chunkSize;
+    int sx = (direction.x > 0) - (direction.x < 0);
+    int sy = (direction.y > 0) - (direction.y < 0);
+
+    auto fetch = [this, layer](int x, int y) {
+      if (x >= 0 && y >= 0) {
+        request(layer, x, y, Request::PREFETCH);
+      }
+    };
+
+    fetch(cx, cy);
+
+    for (int i = 1; i <= static_cast<int>(distance); ++i) {
+      fetch(cx + i * sx, cy + i * sy);
+
+      // a diagonal movement also enters the neighbours of the diagonal
+      if (sx != 0 && sy != 0) {
+        fetch(cx + i * sx, cy + (i - 1) * sy);
+        fetch(cx + (i - 1) * sx, cy + i * sy);
+      }
+    }
+  }
+
+  PagerStatistics ChunkPager::getStatistics() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+  }
+
+  ChunkPager::future_chunk ChunkPager::request(unsigned layer, unsigned cx, unsigned cy, Request kind) {
+    if (layer >= m_layers.size() || m_layers[layer].kind != compiled::TILE_LAYER || cx >= m_chunksPerRow || cy >= m_chunksPerColumn) {
+      std::promise<std::shared_ptr<const TileChunk>> promise;
+      promise.set_value(nullptr);
+      return promise.get_future().share();
+    }
+
+    uint64_t key = (static_cast<uint64_t>(layer) * m_chunksPerColumn + cy) * m_chunksPerRow + cx;
+    auto promise = std::make_shared<std::promise<std::shared_ptr<const TileChunk>>>();
+    future_chunk chunk;
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto it = m_entries.find(key);
+
+      if (it != m_entries.end()) {
+        Entry& entry = it->second;
+        m_lru.splice(m_lru.begin(), m_lru, entry.position);
+
+        if (kind == Request::QUERY) {
+          m_stats.hits++;
+        }
+
+        return entry.chunk;
+      }
+
+      if (kind == Request::QUERY) {
+        m_stats.misses++;
+      } else {
+        m_stats.prefetches++;
+      }
+
+      Entry entry;
+      entry.chunk = promise->get_future().share();
+      entry.size = 0;
+      entry.position = m_lru.insert(m_lru.begin(), key);
+      m_entries.emplace(key, entry);
+      m_loading++;
+
+      // the entry may be evicted as soon as the lock is released
+      chunk = entry.chunk;
+    }
+
+    m_executor.execute([this, promise, key, layer, cx, cy]() {
+      auto chunk = load(layer, cx, cy);
+      promise->set_value(chunk);
+      loaded(key, chunk);
+    });
+
+    return chunk;
+  }
+
+  std::shared_ptr<const TileChunk> ChunkPager::load(unsigned layer, unsigned cx, unsigned cy) {
+    unsigned size = m_header.chunkSize;
+
+    Rect rect;
+    rect.x = cx * size;
+    rect.y = cy * size;
+    rect.width = std::min(size, m_header.width - rect.x);
+    rect.height = std::min(size, m_header.height - rect.y);
+
+    std::vector<uint32_t> cells(rect.width * rect.height);
+    compiled::Chunk chunk;
+
+    {
+      std::lock_guard<std::mutex> lock(m_fileMutex);
+
+      if (!readElements(*m_file, m_header, compiled::CHUNKS, m_layers[layer].chunks.first + cy * m_chunksPerRow + cx, 1, &chunk)
+          || !readElements(*m_file, m_header, compiled::CELLS, chunk.cells, cells.size(), cells.data())) {
+        std::clog << "Error! Unable to read the chunk (" << cx << ", " << cy << ") of layer " << layer << '\n';
+        return nullptr;
+      }
+    }
+
+    return std::make_shared<TileChunk>(rect, std::move(cells));
+  }
+
+  void ChunkPager::loaded(uint64_t key, const std::shared_ptr<const TileChunk>& chunk) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+
+    if (it != m_entries.end()) {
+      if (chunk) {
+        it->second.size = chunk->getMemorySize();
+        m_stats.residentBytes += it->second.size;
+        m_stats.residentChunks++;
+        evict();
+      } else {
+        // forget the failure so that the chunk can be requested again
+        m_lru.erase(it->second.position);
+        m_entries.erase(it);
+      }
+    }
+
+    m_loading--;
+    m_done.notify_all();
+  }
+
+  void ChunkPager::evict() {
+    auto it = m_lru.end();
+
+    while (m_stats.residentBytes > m_budget && it != m_lru.begin()) {
+      --it;
+
+      auto entry = m_entries.find(*it);
+      std::size_t size = entry->second.size;
+
+      if (size == 0) {
+        // still loading
+        continue;
+      }
+
+      m_stats.residentBytes -= size;
+      m_stats.residentChunks--;
+      m_stats.evictions++;
+      m_entries.erase(entry);
+      it = m_lru.erase(it);
+    }
+  }
+
+  std::unique_ptr<ChunkPager> ChunkPager::open(const fs::path& filename, std::size_t budget, Executor& executor, FileSystem& filesystem) {
+    std::unique_ptr<File> file = filesystem.open(filename);
+
+    if (!file) {
+      std::clog << "Error! Unknown compiled map: " << filename << '\n';
+      return nullptr;
+    }
+
+    std::unique_ptr<ChunkPager> pager(new ChunkPager(std::move(file), budget, executor));
+    compiled::Header& header = pager->m_header;
+
+    if (pager->m_file->read(0, &header, sizeof header) != sizeof header || !isValidHeader(header)) {
+      std::clog << "Error! Invalid compiled map: " << filename << '\n';
+      return nullptr;
+    }
+
+    pager->m_layers.resize(header.sections[compiled::LAYERS].count);
+
+    if (!readElements(*pager->m_file, header, compiled::LAYERS, 0, pager->m_layers.size(), pager->m_layers.data())) {
+      std::clog << "Error! Invalid compiled map: " << filename << '\n';
+      return nullptr;
+    }
+
+    pager->m_chunksPerRow = (header.width + header.chunkSize - 1) / header.chunkSize;
+    pager->m_chunksPerColumn = (header.height + header.chunkSize - 1) / header.chunkSize;
+    return pager;
+  }
+
+}
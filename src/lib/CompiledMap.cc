@@ -0,0 +1,555 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/CompiledMap.h>
+
+#include <algorithm>
+#include <cassert>
+
+#include "MapCompiler.h"
+
+namespace tmx {
+
+  /*
+   * CompiledImage
+   */
+
+  const char *CompiledImage::getFormat() const noexcept {
+    return m_map->getString(m_data->format);
+  }
+
+  const char *CompiledImage::getSource() const noexcept {
+    return m_map->getString(m_data->source);
+  }
+
+  const char *CompiledImage::getTransparent() const noexcept {
+    return m_map->getString(m_data->trans);
+  }
+
+  const uint8_t *CompiledImage::getData() const noexcept {
+    return m_map->getSection<uint8_t>(compiled::IMAGE_DATA) + m_data->data.first;
+  }
+
+  /*
+   * CompiledComponent
+   */
+
+  const char *CompiledComponent::getProperty(const char *key, const char *def) const noexcept {
+    const compiled::Property *property = findProperty(key);
+
+    if (property == nullptr) {
+      return def;
+    }
+
+    return m_map->getString(property->value);
+  }
+
+  boost::iterator_range<const compiled::Property *> CompiledComponent::getProperties() const noexcept {
+    const compiled::Property *first = m_map->getSection<compiled::Property>(compiled::PROPERTIES) + m_properties.first;
+    return boost::make_iterator_range(first, first + m_properties.count);
+  }
+
+  const compiled::Property *CompiledComponent::findProperty(const char *key) const noexcept {
+    for (auto& property : getProperties()) {
+      if (std::strcmp(m_map->getString(property.key), key) == 0) {
+        return &property;
+      }
+    }
+
+    return nullptr;
+  }
+
+  /*
+   * CompiledTerrain, CompiledTile, CompiledTileSet
+   */
+
+  const char *CompiledTerrain::getName() const noexcept {
+    return getMap().getString(m_data->name);
+  }
+
+  CompiledImage CompiledTile::getImage() const noexcept {
+    assert(hasImage());
+    return CompiledImage(getMap(), getMap().getSection<compiled::Image>(compiled::IMAGES)[m_data->image - 1]);
+  }
+
+  boost::iterator_range<const compiled::Frame *> CompiledTile::getAnimation() const noexcept {
+    const compiled::Frame *first = getMap().getSection<compiled::Frame>(compiled::FRAMES) + m_data->frames.first;
+    return boost::make_iterator_range(first, first + m_data->frames.count);
+  }
+
+  CompiledLayer CompiledTile::getObjects() const noexcept {
+    assert(hasObjects());
+    return CompiledLayer(getMap(), getMap().getSection<compiled::Layer>(compiled::TILE_LAYERS)[m_data->objects - 1]);
+  }
+
+  const char *CompiledTileSet::getName() const noexcept {
+    return getMap().getString(m_data->name);
+  }
+
+  CompiledImage CompiledTileSet::getImage() const noexcept {
+    assert(hasImage());
+    return CompiledImage(getMap(), getMap().getSection<compiled::Image>(compiled::IMAGES)[m_data->image - 1]);
+  }
+
+  CompiledTerrain CompiledTileSet::getTerrain(std::size_t index) const noexcept {
+    assert(index < m_data->terrains.count);
+    return CompiledTerrain(getMap(), getMap().getSection<compiled::Terrain>(compiled::TERRAINS)[m_data->terrains.first + index]);
+  }
+
+  CompiledTile CompiledTileSet::getTileInfo(std::size_t index) const noexcept {
+    assert(index < m_data->tiles.count);
+    return CompiledTile(getMap(), getMap().getSection<compiled::Tile>(compiled::TILES)[m_data->tiles.first + index]);
+  }
+
+  std::size_t CompiledTileSet::findTileInfo(unsigned id) const noexcept {
+    const compiled::Tile *tiles = getMap().getSection<compiled::Tile>(compiled::TILES) + m_data->tiles.first;
+
+    for (std::size_t i = 0; i < m_data->tiles.count; ++i) {
+      if (tiles[i].id == id) {
+        return i;
+      }
+    }
+
+    return m_data->tiles.count;
+  }
+
+  /*
+   * CompiledObject
+   */
+
+  CompiledObject::CompiledObject(const CompiledMap& map, std::size_t index)
+    : CompiledComponent(map, map.getSection<compiled::Range>(compiled::OBJECT_PROPERTIES)[index])
+    , m_index(index)
+  {
+  }
+
+  unsigned CompiledObject::getKind() const noexcept {
+    return getMap().getSection<uint8_t>(compiled::OBJECT_KINDS)[m_index];
+  }
+
+  unsigned CompiledObject::getId() const noexcept {
+    return getMap().getSection<uint32_t>(compiled::OBJECT_IDS)[m_index];
+  }
+
+  const char *CompiledObject::getName() const noexcept {
+    return getMap().getString(getMap().getSection<uint32_t>(compiled::OBJECT_NAMES)[m_index]);
+  }
+
+  const char *CompiledObject::getType() const noexcept {
+    return getMap().getString(getMap().getSection<uint32_t>(compiled::OBJECT_TYPES)[m_index]);
+  }
+
+  Vector2u CompiledObject::getOrigin() const noexcept {
+    return getMap().getSection<Vector2u>(compiled::OBJECT_ORIGINS)[m_index];
+  }
+
+  double CompiledObject::getRotation() const noexcept {
+    return getMap().getSection<double>(compiled::OBJECT_ROTATIONS)[m_index];
+  }
+
+  bool CompiledObject::isVisible() const noexcept {
+    return getMap().getSection<uint8_t>(compiled::OBJECT_VISIBLE)[m_index] != 0;
+  }
+
+  Size CompiledObject::getSize() const noexcept {
+    return getMap().getSection<Size>(compiled::OBJECT_SIZES)[m_index];
+  }
+
+  Cell CompiledObject::getCell() const noexcept {
+    return Cell::fromRawGID(getMap().getSection<uint32_t>(compiled::OBJECT_GIDS)[m_index]);
+  }
+
+  boost::iterator_range<const Vector2i *> CompiledObject::getPoints() const noexcept {
+    compiled::Range range = getMap().getSection<compiled::Range>(compiled::OBJECT_POINTS)[m_index];
+    const Vector2i *first = getMap().getSection<Vector2i>(compiled::POINTS) + range.first;
+    return boost::make_iterator_range(first, first + range.count);
+  }
+
+  /*
+   * CompiledLayer
+   */
+
+  const char *CompiledLayer::getName() const noexcept {
+    return getMap().getString(m_data->name);
+  }
+
+  unsigned CompiledLayer::getRawGID(unsigned x, unsigned y) const noexcept {
+    const CompiledMap& map = getMap();
+    assert(isTileLayer());
+    assert(x < map.getWidth() && y < map.getHeight());
+
+    unsigned size = map.getChunkSize();
+    unsigned chunksPerRow = (map.getWidth() + size - 1) / size;
+    unsigned cx = x / size;
+    unsigned cy = y / size;
+    unsigned chunkWidth = std::min(size, map.getWidth() - cx * size);
+
+    const compiled::Chunk& chunk = map.getSection<compiled::Chunk>(compiled::CHUNKS)[m_data->chunks.first + cy * chunksPerRow + cx];
+    return map.getSection<uint32_t>(compiled::CELLS)[chunk.cells + (y - cy * size) * chunkWidth + (x - cx * size)];
+  }
+
+  const char *CompiledLayer::getColor() const noexcept {
+    return getMap().getString(m_data->color);
+  }
+
+  DrawOrder CompiledLayer::getDrawOrder() const noexcept {
+    return static_cast<DrawOrder>(m_data->drawOrder);
+  }
+
+  CompiledImage CompiledLayer::getImage() const noexcept {
+    assert(hasImage());
+    return CompiledImage(getMap(), getMap().getSection<compiled::Image>(compiled::IMAGES)[m_data->image - 1]);
+  }
+
+  namespace {
+
+    // checks all the references inside a compiled map whose sections are inside the data
+    class Validator {
+    public:
+      Validator(const char *data)
+      : m_data(data)
+      , m_header(*reinterpret_cast<const compiled::Header *>(data))
+      {
+      }
+
+      bool isValid() const {
+        return areStringsValid() && areObjectsValid() && areImagesValid() && areTileSetsValid() && areLayersValid()
+            && isRangeValid(m_header.properties, compiled::PROPERTIES);
+      }
+
+    private:
+      template<typename T>
+      const T *getSection(compiled::SectionId id) const {
+        return reinterpret_cast<const T *>(m_data + m_header.sections[id].offset);
+      }
+
+      uint64_t getCount(compiled::SectionId id) const {
+        return m_header.sections[id].count;
+      }
+
+      bool isRangeValid(const compiled::Range& range, compiled::SectionId id) const {
+        return range.first <= getCount(id) && range.count <= getCount(id) - range.first;
+      }
+
+      // checks an index plus one, or None
+      bool isOptionalValid(uint32_t index, compiled::SectionId id) const {
+        return index <= getCount(id);
+      }
+
+      bool areStringsValid() const {
+        // the last byte of the string data is a null byte, checked before
+        auto offsets = getSection<uint32_t>(compiled::STRING_OFFSETS);
+
+        for (uint64_t i = 0; i < getCount(compiled::STRING_OFFSETS); ++i) {
+          if (offsets[i] >= getCount(compiled::STRING_DATA)) {
+            return false;
+          }
+        }
+
+        return true;
+      }
+
+      bool areObjectsValid() const {
+        static const compiled::SectionId ObjectSections[] = {
+          compiled::OBJECT_VISIBLE, compiled::OBJECT_IDS, compiled::OBJECT_NAMES, compiled::OBJECT_TYPES,
+          compiled::OBJECT_ORIGINS, compiled::OBJECT_ROTATIONS, compiled::OBJECT_SIZES, compiled::OBJECT_GIDS,
+          compiled::OBJECT_POINTS, compiled::OBJECT_PROPERTIES, compiled::OBJECT_BOUNDS,
+        };
+
+        uint64_t count = getCount(compiled::OBJECT_KINDS);
+
+        for (auto id : ObjectSections) {
+          if (getCount(id) != count) {
+            return false;
+          }
+        }
+
+        auto points = getSection<compiled::Range>(compiled::OBJECT_POINTS);
+        auto properties = getSection<compiled::Range>(compiled::OBJECT_PROPERTIES);
+
+        for (uint64_t i = 0; i < count; ++i) {
+          if (!isRangeValid(points[i], compiled::POINTS) || !isRangeValid(properties[i], compiled::PROPERTIES)) {
+            return false;
+          }
+        }
+
+        auto refs = getSection<uint32_t>(compiled::OBJECT_REFS);
+
+        for (uint64_t i = 0; i < getCount(compiled::OBJECT_REFS); ++i) {
+          if (refs[i] >= count) {
+            return false;
+          }
+        }
+
+        return true;
+      }
+
+      bool areImagesValid() const {
+        auto images = getSection<compiled::Image>(compiled::IMAGES);
+
+        for (uint64_t i = 0; i < getCount(compiled::IMAGES); ++i) {
+          if (!isRangeValid(images[i].data, compiled::IMAGE_DATA)) {
+            return false;
+          }
+        }
+
+        return true;
+      }
+
+      bool areTileSetsValid() const {
+        auto terrains = getSection<compiled::Terrain>(compiled::TERRAINS);
+
+        for (uint64_t i = 0; i < getCount(compiled::TERRAINS); ++i) {
+          if (!isRangeValid(terrains[i].properties, compiled::PROPERTIES)) {
+            return false;
+          }
+        }
+
+        auto tiles = getSection<compiled::Tile>(compiled::TILES);
+
+        for (uint64_t i = 0; i < getCount(compiled::TILES); ++i) {
+          const compiled::Tile& tile = tiles[i];
+
+          if (!isOptionalValid(tile.image, compiled::IMAGES) || !isRangeValid(tile.properties, compiled::PROPERTIES)
+              || !isRangeValid(tile.frames, compiled::FRAMES) || !isOptionalValid(tile.objects, compiled::TILE_LAYERS)) {
+            return false;
+          }
+        }
+
+        auto tileLayers = getSection<compiled::Layer>(compiled::TILE_LAYERS);
+
+        for (uint64_t i = 0; i < getCount(compiled::TILE_LAYERS); ++i) {
+          const compiled::Layer& layer = tileLayers[i];
+
+          if (layer.kind != compiled::OBJECT_LAYER || layer.parent != compiled::None || layer.chunks.count != 0
+              || !isRangeValid(layer.properties, compiled::PROPERTIES) || !isRangeValid(layer.content, compiled::OBJECT_KINDS)) {
+            return false;
+          }
+        }
+
+        auto tilesets = getSection<compiled::TileSet>(compiled::TILESETS);
+
+        for (uint64_t i = 0; i < getCount(compiled::TILESETS); ++i) {
+          const compiled::TileSet& tileset = tilesets[i];
+
+          if (!isOptionalValid(tileset.image, compiled::IMAGES) || !isRangeValid(tileset.terrains, compiled::TERRAINS)
+              || !isRangeValid(tileset.tiles, compiled::TILES) || !isRangeValid(tileset.properties, compiled::PROPERTIES)) {
+            return false;
+          }
+        }
+
+        return true;
+      }
+
+      bool areLayersValid() const {
+        uint64_t size = m_header.chunkSize;
+        uint64_t chunksPerRow = (m_header.width + size - 1) / size;
+        uint64_t chunksPerColumn = (m_header.height + size - 1) / size;
+
+        auto layers = getSection<compiled::Layer>(compiled::LAYERS);
+        auto chunks = getSection<compiled::Chunk>(compiled::CHUNKS);
+
+        for (uint64_t i = 0; i < getCount(compiled::LAYERS); ++i) {
+          const compiled::Layer& layer = layers[i];
+
+          if (!isRangeValid(layer.properties, compiled::PROPERTIES)) {
+            return false;
+          }
+
+          // the group of a layer comes before the layer and contains it
+          if (layer.parent != compiled::None) {
+            if (layer.parent > i) {
+              return false;
+            }
+
+            const compiled::Layer& group = layers[layer.parent - 1];
+
+            uint64_t end = static_cast<uint64_t>(group.content.first) + group.content.count;
+
+            if (group.kind != compiled::GROUP_LAYER || i >= end) {
+              return false;
+            }
+
+            // a nested group ends inside its group
+            if (layer.kind == compiled::GROUP_LAYER && static_cast<uint64_t>(layer.content.first) + layer.content.count > end) {
+              return false;
+            }
+          }
+
+          switch (layer.kind) {
+            case compiled::TILE_LAYER:
+              if (layer.chunks.count != chunksPerRow * chunksPerColumn || !isRangeValid(layer.chunks, compiled::CHUNKS)) {
+                return false;
+              }
+
+              for (uint64_t cy = 0; cy < chunksPerColumn; ++cy) {
+                for (uint64_t cx = 0; cx < chunksPerRow; ++cx) {
+                  uint64_t chunkWidth = std::min(size, m_header.width - cx * size);
+                  uint64_t chunkHeight = std::min(size, m_header.height - cy * size);
+                  const compiled::Chunk& chunk = chunks[layer.chunks.first + cy * chunksPerRow + cx];
+
+                  if (chunk.cells > getCount(compiled::CELLS) || chunkWidth * chunkHeight > getCount(compiled::CELLS) - chunk.cells) {
+                    return false;
+                  }
+                }
+              }
+              break;
+
+            case compiled::OBJECT_LAYER:
+              if (!isRangeValid(layer.content, compiled::OBJECT_KINDS) || !isRangeValid(layer.chunks, compiled::CHUNKS)) {
+                return false;
+              }
+
+              for (uint32_t j = 0; j < layer.chunks.count; ++j) {
+                if (!isRangeValid(chunks[layer.chunks.first + j].objects, compiled::OBJECT_REFS)) {
+                  return false;
+                }
+              }
+              break;
+
+            case compiled::IMAGE_LAYER:
+              if (!isOptionalValid(layer.image, compiled::IMAGES)) {
+                return false;
+              }
+              break;
+
+            case compiled::GROUP_LAYER:
+              if (layer.content.first != i + 1 || !isRangeValid(layer.content, compiled::LAYERS)) {
+                return false;
+              }
+              break;
+
+            default:
+              return false;
+          }
+        }
+
+        return true;
+      }
+
+    private:
+      const char *m_data;
+      const compiled::Header& m_header;
+    };
+
+  }
+
+  bool isValidHeader(const compiled::Header& header) {
+    return std::memcmp(header.magic, compiled::Magic, sizeof compiled::Magic) == 0
+        && header.byteOrder == compiled::ByteOrderMark
+        && header.version == compiled::Version
+        && header.chunkSize > 0;
+  }
+
+  /*
+   * CompiledMap
+   */
+
+  CompiledMap::CompiledMap(const char *data, std::shared_ptr<const void> owner)
+    : CompiledComponent(*this, reinterpret_cast<const compiled::Header *>(data)->properties)
+    , m_data(data)
+    , m_header(reinterpret_cast<const compiled::Header *>(data))
+    , m_owner(std::move(owner))
+  {
+  }
+
+  Orientation CompiledMap::getOrientation() const noexcept {
+    return static_cast<Orientation>(m_header->orientation);
+  }
+
+  RenderOrder CompiledMap::getRenderOrder() const noexcept {
+    return static_cast<RenderOrder>(m_header->renderOrder);
+  }
+
+  std::size_t CompiledMap::getTileSetIndexFromGID(unsigned gid) const noexcept {
+    const compiled::TileSet *tilesets = getSection<compiled::TileSet>(compiled::TILESETS);
+    std::size_t count = getTileSetCount();
+
+    for (std::size_t i = count; i > 0; --i) {
+      if (tilesets[i - 1].firstgid <= gid) {
+        return i - 1;
+      }
+    }
+
+    return count;
+  }
+
+  std::unique_ptr<CompiledMap> CompiledMap::fromMemory(const void *data, std::size_t size, std::shared_ptr<const void> owner) {
+    static const std::size_t ElementSizes[compiled::SECTION_COUNT] = {
+      sizeof(uint32_t),             // STRING_OFFSETS
+      sizeof(char),                 // STRING_DATA
+      sizeof(compiled::Property),   // PROPERTIES
+      sizeof(compiled::Image),      // IMAGES
+      sizeof(compiled::Terrain),    // TERRAINS
+      sizeof(compiled::Tile),       // TILES
+      sizeof(compiled::TileSet),    // TILESETS
+      sizeof(compiled::Layer),      // LAYERS
+      sizeof(compiled::Chunk),      // CHUNKS
+      sizeof(uint32_t),             // CELLS
+      sizeof(uint8_t),              // OBJECT_KINDS
+      sizeof(uint8_t),              // OBJECT_VISIBLE
+      sizeof(uint32_t),             // OBJECT_IDS
+      sizeof(uint32_t),             // OBJECT_NAMES
+      sizeof(uint32_t),             // OBJECT_TYPES
+      sizeof(Vector2u),             // OBJECT_ORIGINS
+      sizeof(double),               // OBJECT_ROTATIONS
+      sizeof(Size),                 // OBJECT_SIZES
+      sizeof(uint32_t),             // OBJECT_GIDS
+      sizeof(compiled::Range),      // OBJECT_POINTS
+      sizeof(compiled::Range),      // OBJECT_PROPERTIES
+      sizeof(Vector2i),             // POINTS
+      sizeof(compiled::Bounds),     // OBJECT_BOUNDS
+      sizeof(uint32_t),             // OBJECT_REFS
+      sizeof(compiled::Frame),      // FRAMES
+      sizeof(compiled::Layer),      // TILE_LAYERS
+      sizeof(uint8_t),              // IMAGE_DATA
+    };
+
+    const char *bytes = static_cast<const char *>(data);
+
+    if (data == nullptr || reinterpret_cast<uintptr_t>(data) % 8 != 0 || size < sizeof(compiled::Header)) {
+      return nullptr;
+    }
+
+    auto header = reinterpret_cast<const compiled::Header *>(bytes);
+
+    if (!isValidHeader(*header) || header->size > size) {
+      return nullptr;
+    }
+
+    const compiled::Section& strings = header->sections[compiled::STRING_DATA];
+
+    if (strings.count == 0 || strings.offset + strings.count > header->size || bytes[strings.offset + strings.count - 1] != '\0') {
+      return nullptr;
+    }
+
+    for (unsigned i = 0; i < compiled::SECTION_COUNT; ++i) {
+      const compiled::Section& section = header->sections[i];
+
+      if (section.offset % 8 != 0 || section.offset > header->size
+          || section.count > (header->size - section.offset) / ElementSizes[i]) {
+        return nullptr;
+      }
+    }
+
+    return std::unique_ptr<CompiledMap>(new CompiledMap(bytes, std::move(owner)));
+  }
+
+  bool CompiledMap::validate() const {
+    Validator validator(m_data);
+    return validator.isValid();
+  }
+
+}
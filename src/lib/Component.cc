@@ -18,7 +18,11 @@
 namespace tmx {
 
   bool Component::hasProperty(const std::string& key) const noexcept {
-    return m_prop.count(key) > 0;
+    if (m_prop.count(key) > 0) {
+      return true;
+    }
+
+    return m_defaults != nullptr && m_defaults->hasProperty(key);
   }
 
   const std::string& Component::getProperty(const std::string& key, const std::string& def) const noexcept {
@@ -28,9 +32,27 @@ namespace tmx {
       return it->second;
     }
 
+    if (m_defaults != nullptr) {
+      return m_defaults->getProperty(key, def);
+    }
+
     return def;
   }
 
+  std::map<std::string, std::string> Component::getAllProperties() const {
+    if (m_defaults == nullptr) {
+      return m_prop;
+    }
+
+    std::map<std::string, std::string> properties = m_defaults->getAllProperties();
+
+    for (auto& property : m_prop) {
+      properties[property.first] = property.second;
+    }
+
+    return properties;
+  }
+
   bool Component::addProperty(const std::string& key, const std::string& value) {
 #if __cplusplus >= 201103L
     auto ret = m_prop.emplace(key, value);
@@ -40,4 +62,24 @@ namespace tmx {
     return ret.second;
   }
 
+  bool Component::setProperty(const std::string& key, const std::string& value) {
+    auto it = m_prop.find(key);
+
+    if (it == m_prop.end()) {
+      m_prop.emplace(key, value);
+      return true;
+    }
+
+    if (it->second == value) {
+      return false;
+    }
+
+    it->second = value;
+    return true;
+  }
+
+  bool Component::removeProperty(const std::string& key) {
+    return m_prop.erase(key) > 0;
+  }
+
 }
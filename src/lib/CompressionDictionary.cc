@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/CompressionDictionary.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+#include <zlib.h>
+
+namespace fs = boost::filesystem;
+
+namespace tmx {
+
+  namespace {
+
+    // the length of the sequences of the training, 8 cells
+    const std::size_t SequenceLength = 32;
+
+    // the sequences start on a cell
+    const std::size_t SequenceStep = 4;
+
+    uint64_t hashSequence(const uint8_t *data) {
+      uint64_t hash = UINT64_C(14695981039346656037);
+
+      for (std::size_t i = 0; i < SequenceLength; ++i) {
+        hash = (hash ^ data[i]) * UINT64_C(1099511628211);
+      }
+
+      return hash;
+    }
+
+    struct Sequence {
+      unsigned samples;
+      std::size_t last;
+      std::size_t sample;
+      std::size_t offset;
+    };
+
+    std::mutex cacheMutex;
+    std::map<std::pair<FileSystem *, fs::path>, std::shared_ptr<const CompressionDictionary>> cache;
+
+  }
+
+  constexpr std::size_t CompressionDictionary::MaxSize;
+  constexpr std::size_t CompressionDictionary::DefaultSize;
+
+  CompressionDictionary::CompressionDictionary(std::vector<uint8_t> data)
+  : m_data(std::move(data))
+  {
+    m_id = adler32(adler32(0L, Z_NULL, 0), m_data.data(), m_data.size());
+  }
+
+  bool CompressionDictionary::save(const fs::path& filename) const {
+    std::ofstream out(filename.string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(m_data.data()), m_data.size());
+
+    if (!out) {
+      std::clog << "Error! Unable to write the compression dictionary: " << filename << '\n';
+      return false;
+    }
+
+    return true;
+  }
+
+  std::shared_ptr<const CompressionDictionary> CompressionDictionary::load(const fs::path& filename, FileSystem& filesystem) {
+    auto key = std::make_pair(&filesystem, filename.lexically_normal());
+
+    // the file is read each time, the cached dictionary is kept only if the file did not change
+    auto file = filesystem.open(filename);
+
+    if (!file) {
+      std::clog << "Error! Unknown compression dictionary: " << filename << '\n';
+
+      std::lock_guard<std::mutex> lock(cacheMutex);
+      cache.erase(key);
+      return nullptr;
+    }
+
+    std::vector<uint8_t> data(file->getSize());
+
+    if (data.empty() || file->read(0, data.data(), data.size()) != data.size()) {
+      std::clog << "Error! Unable to read the compression dictionary: " << filename << '\n';
+
+      std::lock_guard<std::mutex> lock(cacheMutex);
+      cache.erase(key);
+      return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto it = cache.find(key);
+
+    if (it != cache.end() && it->second->getSize() == data.size()
+        && std::equal(data.begin(), data.end(), it->second->getData())) {
+      return it->second;
+    }
+
+    auto dictionary = std::make_shared<const CompressionDictionary>(std::move(data));
+    cache[key] = dictionary;
+    return dictionary;
+  }
+
+  std::shared_ptr<const CompressionDictionary> CompressionDictionary::train(const std::vector<std::vector<uint8_t>>& samples, std::size_t size) {
+    size = std::min(size, MaxSize);
+
+    // count the number of samples where each sequence appears
+    std::unordered_map<uint64_t, Sequence> sequences;
+
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+      const std::vector<uint8_t>& sample = samples[i];
+
+      for (std::size_t offset = 0; offset + SequenceLength <= sample.size(); offset += SequenceStep) {
+        auto inserted = sequences.emplace(hashSequence(sample.data() + offset), Sequence{ 0, 0, i, offset });
+        Sequence& sequence = inserted.first->second;
+
+        if (inserted.second || sequence.last != i) {
+          sequence.samples++;
+          sequence.last = i;
+        }
+      }
+    }
+
+    std::vector<const Sequence *> common;
+
+    for (auto& item : sequences) {
+      if (item.second.samples >= 2) {
+        common.push_back(&item.second);
+      }
+    }
+
+    std::sort(common.begin(), common.end(), [](const Sequence *lhs, const Sequence *rhs) {
+      return std::make_tuple(rhs->samples, lhs->sample, lhs->offset) < std::make_tuple(lhs->samples, rhs->sample, rhs->offset);
+    });
+
+    // take the most common sequences first, skip those already in the dictionary
+    std::string content;
+    std::vector<const Sequence *> chosen;
+
+    for (auto sequence : common) {
+      if (content.size() + SequenceLength > size) {
+        break;
+      }
+
+      const char *data = reinterpret_cast<const char *>(samples[sequence->sample].data() + sequence->offset);
+
+      if (content.find(data, 0, SequenceLength) != std::string::npos) {
+        continue;
+      }
+
+      content.append(data, SequenceLength);
+      chosen.push_back(sequence);
+    }
+
+    if (chosen.empty()) {
+      std::clog << "Error! The samples have nothing in common\n";
+      return nullptr;
+    }
+
+    // the most common sequences at the end, closer to the data
+    std::vector<uint8_t> data;
+    data.reserve(content.size());
+
+    for (auto it = chosen.rbegin(); it != chosen.rend(); ++it) {
+      const uint8_t *sequence = samples[(*it)->sample].data() + (*it)->offset;
+      data.insert(data.end(), sequence, sequence + SequenceLength);
+    }
+
+    return std::make_shared<const CompressionDictionary>(std::move(data));
+  }
+
+}
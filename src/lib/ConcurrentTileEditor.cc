@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/ConcurrentTileEditor.h>
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+namespace tmx {
+
+  ConcurrentTileEditor::ConcurrentTileEditor(Map& map, unsigned layer, unsigned chunkSize)
+  : m_layer(nullptr)
+  , m_index(layer)
+  , m_width(map.getWidth())
+  , m_height(map.getHeight())
+  , m_chunkSize(chunkSize > 0 ? chunkSize : compiled::DefaultChunkSize)
+  , m_chunkColumns((m_width + m_chunkSize - 1) / m_chunkSize)
+  , m_chunkRows((m_height + m_chunkSize - 1) / m_chunkSize)
+  , m_dirtyWords(0)
+  {
+    auto layers = map.getAllLayers();
+
+    if (layer < layers.size()) {
+      m_layer = dynamic_cast<TileLayer *>(layers[layer]);
+    }
+
+    if (m_layer == nullptr) {
+      std::clog << "Error! Not a tile layer: " << layer << '\n';
+      return;
+    }
+
+    if (m_layer->getCellCount() != static_cast<std::size_t>(m_width) * m_height) {
+      std::clog << "Error! The tile layer does not cover the map: " << layer << '\n';
+      m_layer = nullptr;
+      return;
+    }
+
+    std::size_t chunks = static_cast<std::size_t>(m_chunkColumns) * m_chunkRows;
+    m_locks.reset(new std::mutex[chunks]);
+    m_dirtyWords = (chunks + 63) / 64;
+    m_dirty.reset(new std::atomic<uint64_t>[m_dirtyWords]);
+
+    for (std::size_t i = 0; i < m_dirtyWords; ++i) {
+      m_dirty[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  Cell ConcurrentTileEditor::getCell(unsigned x, unsigned y) const {
+    if (m_layer == nullptr || x >= m_width || y >= m_height) {
+      return Cell(0);
+    }
+
+    std::lock_guard<std::mutex> lock(m_locks[getChunkIndex(x, y)]);
+    return m_layer->getCell(static_cast<std::size_t>(y) * m_width + x);
+  }
+
+  bool ConcurrentTileEditor::setCell(unsigned x, unsigned y, Cell cell) {
+    if (m_layer == nullptr || x >= m_width || y >= m_height) {
+      return false;
+    }
+
+    std::size_t chunk = getChunkIndex(x, y);
+    bool changed;
+
+    {
+      std::lock_guard<std::mutex> lock(m_locks[chunk]);
+      changed = setCellLocked(x, y, cell);
+    }
+
+    if (changed) {
+      markChunk(chunk);
+    }
+
+    return changed;
+  }
+
+  std::size_t ConcurrentTileEditor::apply(const std::vector<CellEdit>& edits) {
+    if (m_layer == nullptr) {
+      return 0;
+    }
+
+    // group the edits by chunk, keeping the order of the batch in a chunk
+    std::vector<std::pair<std::size_t, std::size_t>> order;
+    order.reserve(edits.size());
+
+    for (std::size_t i = 0; i < edits.size(); ++i) {
+      const CellEdit& edit = edits[i];
+
+      if (edit.x < m_width && edit.y < m_height) {
+        order.emplace_back(getChunkIndex(edit.x, edit.y), i);
+      }
+    }
+
+    std::sort(order.begin(), order.end());
+
+    std::size_t changed = 0;
+    std::size_t i = 0;
+
+    while (i < order.size()) {
+      std::size_t chunk = order[i].first;
+      std::size_t changedInChunk = 0;
+
+      {
+        std::lock_guard<std::mutex> lock(m_locks[chunk]);
+
+        for (; i < order.size() && order[i].first == chunk; ++i) {
+          const CellEdit& edit = edits[order[i].second];
+
+          if (setCellLocked(edit.x, edit.y, edit.cell)) {
+            changedInChunk++;
+          }
+        }
+      }
+
+      if (changedInChunk > 0) {
+        markChunk(chunk);
+        changed += changedInChunk;
+      }
+    }
+
+    return changed;
+  }
+
+  std::vector<Vector2u> ConcurrentTileEditor::takeDirtyChunks() {
+    std::vector<Vector2u> chunks;
+
+    for (std::size_t word = 0; word < m_dirtyWords; ++word) {
+      uint64_t value = m_dirty[word].exchange(0, std::memory_order_acq_rel);
+
+      for (unsigned bit = 0; value != 0; ++bit, value >>= 1) {
+        if ((value & 1) != 0) {
+          std::size_t index = word * 64 + bit;
+          chunks.push_back({ static_cast<unsigned>(index % m_chunkColumns), static_cast<unsigned>(index / m_chunkColumns) });
+        }
+      }
+    }
+
+    return chunks;
+  }
+
+  void ConcurrentTileEditor::takeDirtyChunks(DirtySet& dirty) {
+    for (auto chunk : takeDirtyChunks()) {
+      dirty.markChunk(m_index, chunk);
+    }
+  }
+
+  bool ConcurrentTileEditor::setCellLocked(unsigned x, unsigned y, Cell cell) {
+    std::size_t index = static_cast<std::size_t>(y) * m_width + x;
+
+    if (m_layer->getCell(index).getRawGID() == cell.getRawGID()) {
+      return false;
+    }
+
+    m_layer->setCell(index, cell);
+    return true;
+  }
+
+  void ConcurrentTileEditor::markChunk(std::size_t chunk) {
+    uint64_t bit = UINT64_C(1) << (chunk % 64);
+    std::atomic<uint64_t>& word = m_dirty[chunk / 64];
+
+    // avoid the read-modify-write when the chunk is already dirty
+    if ((word.load(std::memory_order_relaxed) & bit) == 0) {
+      word.fetch_or(bit, std::memory_order_release);
+    }
+  }
+
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/Executor.h>
+
+#include <atomic>
+
+#include <tmx/WorkStealingExecutor.h>
+
+namespace tmx {
+
+  namespace {
+
+    std::atomic<Executor *> defaultExecutor(nullptr);
+
+  }
+
+  Executor::~Executor() {
+  }
+
+  ExecutorStatistics Executor::getStatistics() const {
+    ExecutorStatistics stats;
+    stats.tasksRun = 0;
+    stats.stealTime = std::chrono::nanoseconds::zero();
+    stats.idleTime = std::chrono::nanoseconds::zero();
+    return stats;
+  }
+
+  Executor& Executor::getDefault() {
+    Executor *executor = defaultExecutor.load();
+
+    if (executor != nullptr) {
+      return *executor;
+    }
+
+    static WorkStealingExecutor libraryExecutor;
+    return libraryExecutor;
+  }
+
+  void Executor::setDefault(Executor *executor) {
+    defaultExecutor.store(executor);
+  }
+
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/FileSystem.h>
+
+#include <atomic>
+#include <fstream>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace fs = boost::filesystem;
+namespace ipc = boost::interprocess;
+
+namespace tmx {
+
+  namespace {
+
+    std::atomic<FileSystem *> defaultFileSystem(nullptr);
+
+    class NativeFile : public File {
+    public:
+      NativeFile(const fs::path& path, std::size_t size)
+        : m_path(path), m_size(size)
+      {
+      }
+
+      virtual std::size_t getSize() const override {
+        return m_size;
+      }
+
+      virtual std::size_t read(std::size_t offset, void *buffer, std::size_t size) override {
+        if (!m_stream.is_open()) {
+          m_stream.open(m_path.string().c_str(), std::ios::in | std::ios::binary);
+        }
+
+        if (!m_stream || offset >= m_size) {
+          return 0;
+        }
+
+        m_stream.seekg(offset);
+        m_stream.read(static_cast<char *>(buffer), size);
+        std::size_t count = m_stream.gcount();
+        m_stream.clear();
+        return count;
+      }
+
+      virtual const char *map() override {
+        if (m_size == 0) {
+          return "";
+        }
+
+        if (m_region.get_address() == nullptr) {
+          try {
+            ipc::file_mapping mapping(m_path.string().c_str(), ipc::read_only);
+            ipc::mapped_region region(mapping, ipc::read_only);
+            m_region.swap(region);
+          } catch (ipc::interprocess_exception& ex) {
+            return nullptr;
+          }
+        }
+
+        return static_cast<const char *>(m_region.get_address());
+      }
+
+    private:
+      const fs::path m_path;
+      const std::size_t m_size;
+      std::ifstream m_stream;
+      ipc::mapped_region m_region;
+    };
+
+  }
+
+  File::~File() {
+  }
+
+  FileSystem::~FileSystem() {
+  }
+
+  bool FileSystem::list(const fs::path& directory, std::vector<fs::path>& files) {
+    return false;
+  }
+
+  FileSystem& FileSystem::getDefault() {
+    FileSystem *filesystem = defaultFileSystem.load();
+
+    if (filesystem != nullptr) {
+      return *filesystem;
+    }
+
+    static NativeFileSystem nativeFileSystem;
+    return nativeFileSystem;
+  }
+
+  void FileSystem::setDefault(FileSystem *filesystem) {
+    defaultFileSystem.store(filesystem);
+  }
+
+  std::unique_ptr<File> NativeFileSystem::open(const fs::path& path) {
+    boost::system::error_code ec;
+
+    if (!fs::is_regular_file(path, ec)) {
+      return nullptr;
+    }
+
+    uintmax_t size = fs::file_size(path, ec);
+
+    if (ec) {
+      return nullptr;
+    }
+
+    return std::unique_ptr<File>(new NativeFile(path, size));
+  }
+
+  bool NativeFileSystem::list(const fs::path& directory, std::vector<fs::path>& files) {
+    boost::system::error_code ec;
+    fs::directory_iterator it(directory.empty() ? fs::path(".") : directory, ec);
+
+    if (ec) {
+      return false;
+    }
+
+    for (fs::directory_iterator end; it != end; it.increment(ec)) {
+      if (ec) {
+        return false;
+      }
+
+      if (fs::is_regular_file(it->status())) {
+        files.push_back(it->path().filename());
+      }
+    }
+
+    return true;
+  }
+
+}
@@ -0,0 +1,486 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include "Json.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+namespace tmx {
+
+  namespace json {
+
+    namespace {
+
+      // deep enough for any map, shallow enough for the stack
+      const unsigned MaxDepth = 256;
+
+      char *encodeUtf8(char *out, uint32_t code) {
+        if (code < 0x80) {
+          *out++ = static_cast<char>(code);
+        } else if (code < 0x800) {
+          *out++ = static_cast<char>(0xC0 | (code >> 6));
+          *out++ = static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+          *out++ = static_cast<char>(0xE0 | (code >> 12));
+          *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+          *out++ = static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+          *out++ = static_cast<char>(0xF0 | (code >> 18));
+          *out++ = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+          *out++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+          *out++ = static_cast<char>(0x80 | (code & 0x3F));
+        }
+
+        return out;
+      }
+
+      bool parseHex(const char *text, uint32_t& code) {
+        code = 0;
+
+        for (int i = 0; i < 4; ++i) {
+          char c = text[i];
+          code <<= 4;
+
+          if (c >= '0' && c <= '9') {
+            code |= c - '0';
+          } else if (c >= 'a' && c <= 'f') {
+            code |= c - 'a' + 10;
+          } else if (c >= 'A' && c <= 'F') {
+            code |= c - 'A' + 10;
+          } else {
+            return false;
+          }
+        }
+
+        return true;
+      }
+
+    }
+
+    const Value *Value::find(const char *key) const noexcept {
+      if (m_type != Type::OBJECT) {
+        return nullptr;
+      }
+
+      for (auto& member : *this) {
+        if (std::strcmp(member.m_key, key) == 0) {
+          return &member;
+        }
+      }
+
+      return nullptr;
+    }
+
+    std::string Value::getString(const char *key, const std::string& def) const {
+      const Value *value = find(key);
+
+      if (value == nullptr || value->m_type != Type::STRING) {
+        return def;
+      }
+
+      return std::string(value->m_string, value->m_size);
+    }
+
+    double Value::getNumber(const char *key, double def) const noexcept {
+      const Value *value = find(key);
+
+      if (value == nullptr || value->m_type != Type::NUMBER) {
+        return def;
+      }
+
+      return value->m_number;
+    }
+
+    unsigned Value::getUInt(const char *key, unsigned def) const noexcept {
+      const Value *value = find(key);
+
+      if (value == nullptr || value->m_type != Type::NUMBER || value->m_number < 0) {
+        return def;
+      }
+
+      return static_cast<unsigned>(value->m_number);
+    }
+
+    int Value::getInt(const char *key, int def) const noexcept {
+      const Value *value = find(key);
+
+      if (value == nullptr || value->m_type != Type::NUMBER) {
+        return def;
+      }
+
+      return static_cast<int>(value->m_number);
+    }
+
+    bool Value::getBool(const char *key, bool def) const noexcept {
+      const Value *value = find(key);
+
+      if (value == nullptr || value->m_type != Type::BOOLEAN) {
+        return def;
+      }
+
+      return value->m_bool;
+    }
+
+    Document::Document()
+    : m_text(nullptr)
+    , m_current(nullptr)
+    , m_error(nullptr)
+    {
+      std::memset(&m_root, 0, sizeof m_root);
+    }
+
+    Document::~Document() {
+    }
+
+    bool Document::parse(char *text) {
+      m_text = m_current = m_error = text;
+      m_stack.clear();
+      m_blocks.clear();
+      std::memset(&m_root, 0, sizeof m_root);
+
+      skipSpaces();
+
+      if (!parseValue(m_root, 0)) {
+        return false;
+      }
+
+      skipSpaces();
+
+      if (*m_current != '\0') {
+        return fail();
+      }
+
+      return true;
+    }
+
+    bool Document::fail() {
+      m_error = m_current;
+      return false;
+    }
+
+    void Document::skipSpaces() {
+      while (*m_current == ' ' || *m_current == '\n' || *m_current == '\r' || *m_current == '\t') {
+        ++m_current;
+      }
+    }
+
+    bool Document::parseValue(Value& value, unsigned depth) {
+      value.m_key = nullptr;
+      value.m_size = 0;
+      value.m_bool = false;
+
+      switch (*m_current) {
+        case '{':
+          return parseObject(value, depth + 1);
+
+        case '[':
+          return parseArray(value, depth + 1);
+
+        case '"':
+          value.m_type = Type::STRING;
+          return parseString(value.m_string, value.m_size);
+
+        case 't':
+          if (std::strncmp(m_current, "true", 4) != 0) {
+            return fail();
+          }
+
+          m_current += 4;
+          value.m_type = Type::BOOLEAN;
+          value.m_bool = true;
+          return true;
+
+        case 'f':
+          if (std::strncmp(m_current, "false", 5) != 0) {
+            return fail();
+          }
+
+          m_current += 5;
+          value.m_type = Type::BOOLEAN;
+          return true;
+
+        case 'n':
+          if (std::strncmp(m_current, "null", 4) != 0) {
+            return fail();
+          }
+
+          m_current += 4;
+          value.m_type = Type::NIL;
+          value.m_elements = nullptr;
+          return true;
+
+        default:
+          return parseNumber(value);
+      }
+    }
+
+    bool Document::parseString(const char *& string, uint32_t& size) {
+      assert(*m_current == '"');
+      ++m_current;
+
+      // the unescaped string is never longer, it is written over the text
+      char *out = m_current;
+      string = out;
+
+      for (;;) {
+        char c = *m_current;
+
+        if (c == '"') {
+          break;
+        }
+
+        if (c == '\0' || static_cast<unsigned char>(c) < 0x20) {
+          return fail();
+        }
+
+        if (c != '\\') {
+          *out++ = c;
+          ++m_current;
+          continue;
+        }
+
+        ++m_current;
+
+        switch (*m_current++) {
+          case '"':
+            *out++ = '"';
+            break;
+          case '\\':
+            *out++ = '\\';
+            break;
+          case '/':
+            *out++ = '/';
+            break;
+          case 'b':
+            *out++ = '\b';
+            break;
+          case 'f':
+            *out++ = '\f';
+            break;
+          case 'n':
+            *out++ = '\n';
+            break;
+          case 'r':
+            *out++ = '\r';
+            break;
+          case 't':
+            *out++ = '\t';
+            break;
+          case 'u': {
+            uint32_t code;
+
+            if (!parseHex(m_current, code)) {
+              return fail();
+            }
+
+            m_current += 4;
+
+            // a surrogate pair
+            if (code >= 0xD800 && code <= 0xDBFF) {
+              uint32_t low;
+
+              if (m_current[0] != '\\' || m_current[1] != 'u' || !parseHex(m_current + 2, low) || low < 0xDC00 || low > 0xDFFF) {
+                return fail();
+              }
+
+              m_current += 6;
+              code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            }
+
+            out = encodeUtf8(out, code);
+            break;
+          }
+          default:
+            --m_current;
+            return fail();
+        }
+      }
+
+      size = out - string;
+      *out = '\0';
+      ++m_current;
+      return true;
+    }
+
+    bool Document::parseNumber(Value& value) {
+      char *start = m_current;
+      bool negative = false;
+
+      if (*m_current == '-') {
+        negative = true;
+        ++m_current;
+      }
+
+      if (*m_current < '0' || *m_current > '9') {
+        return fail();
+      }
+
+      // the integers are the most common numbers, decode them directly
+      uint64_t integer = 0;
+      int digits = 0;
+
+      while (*m_current >= '0' && *m_current <= '9') {
+        integer = integer * 10 + (*m_current - '0');
+        ++m_current;
+        ++digits;
+      }
+
+      value.m_type = Type::NUMBER;
+
+      if (*m_current != '.' && *m_current != 'e' && *m_current != 'E' && digits <= 15) {
+        value.m_number = negative ? -static_cast<double>(integer) : static_cast<double>(integer);
+        return true;
+      }
+
+      char *end = nullptr;
+      value.m_number = std::strtod(start, &end);
+
+      if (end == start) {
+        m_current = start;
+        return fail();
+      }
+
+      m_current = end;
+      return true;
+    }
+
+    const Value *Document::store(std::size_t first) {
+      std::size_t count = m_stack.size() - first;
+
+      if (count == 0) {
+        return nullptr;
+      }
+
+      std::unique_ptr<Value[]> block(new Value[count]);
+      std::memcpy(block.get(), m_stack.data() + first, count * sizeof(Value));
+      m_stack.resize(first);
+
+      const Value *elements = block.get();
+      m_blocks.push_back(std::move(block));
+      return elements;
+    }
+
+    bool Document::parseArray(Value& value, unsigned depth) {
+      assert(*m_current == '[');
+
+      if (depth > MaxDepth) {
+        return fail();
+      }
+
+      ++m_current;
+      skipSpaces();
+
+      std::size_t first = m_stack.size();
+
+      if (*m_current != ']') {
+        for (;;) {
+          Value element;
+
+          if (!parseValue(element, depth)) {
+            return false;
+          }
+
+          m_stack.push_back(element);
+          skipSpaces();
+
+          if (*m_current == ']') {
+            break;
+          }
+
+          if (*m_current != ',') {
+            return fail();
+          }
+
+          ++m_current;
+          skipSpaces();
+        }
+      }
+
+      ++m_current;
+      value.m_type = Type::ARRAY;
+      value.m_size = m_stack.size() - first;
+      value.m_elements = store(first);
+      return true;
+    }
+
+    bool Document::parseObject(Value& value, unsigned depth) {
+      assert(*m_current == '{');
+
+      if (depth > MaxDepth) {
+        return fail();
+      }
+
+      ++m_current;
+      skipSpaces();
+
+      std::size_t first = m_stack.size();
+
+      if (*m_current != '}') {
+        for (;;) {
+          if (*m_current != '"') {
+            return fail();
+          }
+
+          const char *key;
+          uint32_t size;
+
+          if (!parseString(key, size)) {
+            return false;
+          }
+
+          skipSpaces();
+
+          if (*m_current != ':') {
+            return fail();
+          }
+
+          ++m_current;
+          skipSpaces();
+
+          Value member;
+
+          if (!parseValue(member, depth)) {
+            return false;
+          }
+
+          member.m_key = key;
+          m_stack.push_back(member);
+          skipSpaces();
+
+          if (*m_current == '}') {
+            break;
+          }
+
+          if (*m_current != ',') {
+            return fail();
+          }
+
+          ++m_current;
+          skipSpaces();
+        }
+      }
+
+      ++m_current;
+      value.m_type = Type::OBJECT;
+      value.m_size = m_stack.size() - first;
+      value.m_elements = store(first);
+      return true;
+    }
+
+  }
+
+}
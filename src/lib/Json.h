@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_JSON_H
+#define TMX_JSON_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tmx {
+
+  /*
+   * A small in-situ JSON parser. The strings are unescaped and terminated
+   * in the buffer of the text, so the values point into the buffer and the
+   * buffer must outlive the document. The elements of an array and the
+   * members of an object are stored contiguously.
+   */
+  namespace json {
+
+    enum class Type : uint8_t {
+      NIL,
+      BOOLEAN,
+      NUMBER,
+      STRING,
+      ARRAY,
+      OBJECT,
+    };
+
+    class Value {
+    public:
+      Type getType() const noexcept {
+        return m_type;
+      }
+
+      bool is(Type type) const noexcept {
+        return m_type == type;
+      }
+
+      // the key of a member of an object, null otherwise
+      const char *getKey() const noexcept {
+        return m_key;
+      }
+
+      bool getBool() const noexcept {
+        return m_type == Type::BOOLEAN && m_bool;
+      }
+
+      double getNumber() const noexcept {
+        return m_type == Type::NUMBER ? m_number : 0.0;
+      }
+
+      const char *getString() const noexcept {
+        return m_type == Type::STRING ? m_string : "";
+      }
+
+      // the length of a string, the number of elements of an array or of members of an object
+      std::size_t getSize() const noexcept {
+        return m_size;
+      }
+
+      const Value *begin() const noexcept {
+        return (m_type == Type::ARRAY || m_type == Type::OBJECT) ? m_elements : nullptr;
+      }
+
+      const Value *end() const noexcept {
+        return (m_type == Type::ARRAY || m_type == Type::OBJECT) ? m_elements + m_size : nullptr;
+      }
+
+      // returns null if the value is not an object or has no such member
+      const Value *find(const char *key) const noexcept;
+
+      // the accessors of the members, with a default value if the member is missing or has another type
+      bool hasMember(const char *key) const noexcept {
+        return find(key) != nullptr;
+      }
+
+      std::string getString(const char *key, const std::string& def = std::string()) const;
+      double getNumber(const char *key, double def = 0.0) const noexcept;
+      unsigned getUInt(const char *key, unsigned def = 0) const noexcept;
+      int getInt(const char *key, int def = 0) const noexcept;
+      bool getBool(const char *key, bool def = false) const noexcept;
+
+    private:
+      friend class Document;
+
+      const char *m_key;
+
+      union {
+        double m_number;
+        const char *m_string;
+        const Value *m_elements;
+      };
+
+      uint32_t m_size;
+      Type m_type;
+      bool m_bool;
+    };
+
+    class Document {
+    public:
+      Document();
+      ~Document();
+
+      Document(const Document&) = delete;
+      Document& operator=(const Document&) = delete;
+
+      // parses a null-terminated text, that is modified
+      bool parse(char *text);
+
+      const Value& getRoot() const noexcept {
+        return m_root;
+      }
+
+      // the offset of the error in the text
+      std::size_t getErrorOffset() const noexcept {
+        return m_error - m_text;
+      }
+
+    private:
+      bool parseValue(Value& value, unsigned depth);
+      bool parseString(const char *& string, uint32_t& size);
+      bool parseNumber(Value& value);
+      bool parseArray(Value& value, unsigned depth);
+      bool parseObject(Value& value, unsigned depth);
+      const Value *store(std::size_t first);
+      void skipSpaces();
+      bool fail();
+
+    private:
+      char *m_text;
+      char *m_current;
+      char *m_error;
+      Value m_root;
+      std::vector<Value> m_stack;
+      std::vector<std::unique_ptr<Value[]>> m_blocks;
+    };
+
+  }
+
+}
+
+#endif // TMX_JSON_H
@@ -0,0 +1,1148 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <tmx/CompressionDictionary.h>
+#include <tmx/FileSystem.h>
+#include <tmx/GroupLayer.h>
+#include <tmx/Image.h>
+#include <tmx/ImageLayer.h>
+#include <tmx/Layer.h>
+#include <tmx/LoadProgress.h>
+#include <tmx/Map.h>
+#include <tmx/Object.h>
+#include <tmx/ObjectLayer.h>
+#include <tmx/ObjectTemplate.h>
+#include <tmx/ParseVisitor.h>
+#include <tmx/Terrain.h>
+#include <tmx/Tile.h>
+#include <tmx/TileLayer.h>
+#include <tmx/TileSet.h>
+
+#include "Json.h"
+#include "Parser.h"
+#include "TileSetCache.h"
+
+#define INVALID static_cast<unsigned>(-1)
+
+namespace fs = boost::filesystem;
+
+namespace tmx {
+
+  namespace {
+
+    template<typename T, typename... Args>
+    std::unique_ptr<T> makeUnique(Args&&... args) {
+      return std::unique_ptr<T>(new T(std::forward<Args>(args)...));
+    }
+
+    // the text of a file, null-terminated for the in-situ parser
+    bool loadText(File& file, std::vector<char>& text) {
+      const std::size_t size = file.getSize();
+      text.resize(size + 1);
+
+      const char *data = file.map();
+
+      if (data != nullptr) {
+        std::memcpy(text.data(), data, size);
+      } else if (file.read(0, text.data(), size) != size) {
+        return false;
+      }
+
+      text[size] = '\0';
+      return true;
+    }
+
+    // the values of the properties are strings in the TMX format
+    std::string toString(const json::Value& value) {
+      switch (value.getType()) {
+        case json::Type::STRING:
+          return std::string(value.getString(), value.getSize());
+
+        case json::Type::BOOLEAN:
+          return value.getBool() ? "true" : "false";
+
+        case json::Type::NUMBER: {
+          char buffer[32];
+          std::snprintf(buffer, sizeof buffer, "%.17g", value.getNumber());
+
+          // the shortest representation, like the text of the TMX file
+          for (int precision = 1; precision <= 17; ++precision) {
+            char shorter[32];
+            std::snprintf(shorter, sizeof shorter, "%.*g", precision, value.getNumber());
+
+            if (std::strtod(shorter, nullptr) == value.getNumber()) {
+              return shorter;
+            }
+          }
+
+          return buffer;
+        }
+
+        default:
+          break;
+      }
+
+      return std::string();
+    }
+
+    std::string getColor(const json::Value& value, const char *key) {
+      std::string color = value.getString(key);
+
+      // the TMX format has no '#' in the transparent color of images
+      if (!color.empty() && color[0] == '#') {
+        color.erase(0, 1);
+      }
+
+      return color;
+    }
+
+    // FNV-1a on the parsed values, stable between runs
+    uint64_t hashBytes(const void *data, std::size_t size, uint64_t hash) {
+      auto bytes = static_cast<const unsigned char *>(data);
+
+      for (std::size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= UINT64_C(1099511628211);
+      }
+
+      return hash;
+    }
+
+    uint64_t hashValue(const json::Value& value, uint64_t hash = UINT64_C(14695981039346656037)) {
+      json::Type type = value.getType();
+      hash = hashBytes(&type, sizeof type, hash);
+
+      if (value.getKey() != nullptr) {
+        hash = hashBytes(value.getKey(), std::strlen(value.getKey()) + 1, hash);
+      }
+
+      switch (type) {
+        case json::Type::BOOLEAN: {
+          bool content = value.getBool();
+          return hashBytes(&content, sizeof content, hash);
+        }
+
+        case json::Type::NUMBER: {
+          double content = value.getNumber();
+          return hashBytes(&content, sizeof content, hash);
+        }
+
+        case json::Type::STRING:
+          return hashBytes(value.getString(), value.getSize() + 1, hash);
+
+        case json::Type::ARRAY:
+        case json::Type::OBJECT:
+          for (auto& element : value) {
+            hash = hashValue(element, hash);
+          }
+
+          return hashBytes("]", 1, hash);
+
+        default:
+          break;
+      }
+
+      return hash;
+    }
+
+    template<typename T>
+    std::unique_ptr<T> takeReusable(std::vector<std::pair<uint64_t, std::unique_ptr<T>>>& elements, uint64_t hash) {
+      for (auto& element : elements) {
+        if (element.first == hash && element.second) {
+          return std::move(element.second);
+        }
+      }
+
+      return nullptr;
+    }
+
+    bool hasExtension(const fs::path& filename, const char *extension) {
+      return boost::algorithm::iequals(filename.extension().string(), extension);
+    }
+
+    class JsonParser {
+    public:
+      JsonParser(const fs::path& filename, const ParseContext& context)
+      : mapPath(filename), currentPath(filename.parent_path()), context(context), currentMap(nullptr), parsingTemplate(false)
+      {
+      }
+
+      FileSystem& getFileSystem() const {
+        return context.filesystem ? *context.filesystem : FileSystem::getDefault();
+      }
+
+      bool isCancelled() const {
+        return context.progress != nullptr && context.progress->isCancelled();
+      }
+
+      template<typename... Elements>
+      bool mustKeep(ParseAction (ParseVisitor::*visit)(const Map&, const Elements&...), const Elements&... elements) {
+        if (context.visitor == nullptr) {
+          return true;
+        }
+
+        assert(currentMap);
+        return (context.visitor->*visit)(*currentMap, elements...) == ParseAction::KEEP;
+      }
+
+      bool loadDocument(const fs::path& filename, std::vector<char>& text, json::Document& doc) {
+        auto file = getFileSystem().open(filename);
+
+        if (!file || !loadText(*file, text)) {
+          std::clog << "Error! Unknown JSON file: " << filename << '\n';
+          return false;
+        }
+
+        if (!doc.parse(text.data())) {
+          std::clog << "Error! Unable to parse the JSON file: " << filename << " (offset " << doc.getErrorOffset() << ")\n";
+          return false;
+        }
+
+        if (!doc.getRoot().is(json::Type::OBJECT)) {
+          std::clog << "Error! The JSON file is not an object: " << filename << '\n';
+          return false;
+        }
+
+        if (context.progress) {
+          context.progress->addBytesRead(file->getSize());
+        }
+
+        if (context.reuse) {
+          context.reuse->files.push_back(filename);
+        }
+
+        return true;
+      }
+
+      /*
+       * Fragment parsers
+       */
+
+      // the properties are an array of {name, type, value} since Tiled 1.2, an object before
+      void parseComponent(const json::Value& value, Component *component, const json::Value *properties = nullptr) {
+        if (properties == nullptr) {
+          properties = value.find("properties");
+        }
+
+        if (properties == nullptr) {
+          return;
+        }
+
+        if (properties->is(json::Type::OBJECT)) {
+          for (auto& property : *properties) {
+            component->addProperty(property.getKey(), toString(property));
+          }
+
+          return;
+        }
+
+        for (auto& property : *properties) {
+          std::string name = property.getString("name");
+          assert(!name.empty());
+          const json::Value *content = property.find("value");
+          component->addProperty(name, content ? toString(*content) : std::string());
+        }
+      }
+
+      std::unique_ptr<Image> parseImage(const json::Value& value, const char *imageKey, const char *widthKey, const char *heightKey) {
+        std::string source = value.getString(imageKey);
+
+        if (source.empty()) {
+          return nullptr;
+        }
+
+        std::string trans = getColor(value, "transparentcolor");
+        unsigned width = value.getUInt(widthKey);
+        unsigned height = value.getUInt(heightKey);
+
+        return makeUnique<Image>(std::string(), currentPath / source, trans, width, height);
+      }
+
+      void parseLayerOffset(const json::Value& value, Layer *layer) {
+        double x = value.getNumber("offsetx");
+        double y = value.getNumber("offsety");
+        layer->setOffset(static_cast<float>(x), static_cast<float>(y));
+      }
+
+      std::unique_ptr<ImageLayer> parseImageLayer(const json::Value& value) {
+        std::string name = value.getString("name");
+        double opacity = value.getNumber("opacity", 1.0);
+        bool visible = value.getBool("visible", true);
+
+        auto imageLayer = makeUnique<ImageLayer>(name, opacity, visible);
+        parseComponent(value, imageLayer.get());
+        parseLayerOffset(value, imageLayer.get());
+
+        auto image = parseImage(value, "image", "imagewidth", "imageheight");
+
+        if (image) {
+          imageLayer->setImage(std::move(image));
+        }
+
+        return imageLayer;
+      }
+
+      std::vector<Vector2i> parsePoints(const json::Value& points) {
+        std::vector<Vector2i> ret;
+
+        for (auto& point : points) {
+          ret.push_back({ point.getInt("x"), point.getInt("y") });
+        }
+
+        return ret;
+      }
+
+      // a template is loaded once by map, all its instances see the same file
+      std::shared_ptr<const ObjectTemplate> loadTemplate(const fs::path& templatePath) {
+        fs::path key = templatePath.lexically_normal();
+        auto it = templates.find(key);
+
+        if (it != templates.end()) {
+          return it->second;
+        }
+
+        if (context.reuse) {
+          context.reuse->files.push_back(templatePath);
+        }
+
+        auto objectTemplate = ObjectTemplate::load(templatePath, getFileSystem());
+        templates.emplace(key, objectTemplate);
+        return objectTemplate;
+      }
+
+      std::unique_ptr<Object> parseTemplateInstance(const json::Value& value) {
+        fs::path templatePath = currentPath / value.getString("template");
+
+        if (parsingTemplate) {
+          std::clog << "Error! A template can not refer to another template: " << templatePath << '\n';
+          return nullptr;
+        }
+
+        auto objectTemplate = loadTemplate(templatePath);
+
+        if (!objectTemplate) {
+          return nullptr;
+        }
+
+        TemplateInstance instance;
+        instance.id = value.getUInt("id");
+        instance.origin.x = value.getUInt("x");
+        instance.origin.y = value.getUInt("y");
+        instance.name = value.getString("name");
+        instance.type = value.getString("type", value.getString("class"));
+
+        if ((instance.hasRotation = value.hasMember("rotation"))) {
+          instance.rotation = value.getNumber("rotation");
+        }
+
+        if ((instance.hasVisible = value.hasMember("visible"))) {
+          instance.visible = value.getBool("visible");
+        }
+
+        if ((instance.hasWidth = value.hasMember("width"))) {
+          instance.width = value.getUInt("width");
+        }
+
+        if ((instance.hasHeight = value.hasMember("height"))) {
+          instance.height = value.getUInt("height");
+        }
+
+        if ((instance.hasGID = value.hasMember("gid"))) {
+          instance.gid = value.getUInt("gid");
+        }
+
+        const json::Value *points = value.find("polygon");
+
+        if (points == nullptr) {
+          points = value.find("polyline");
+        }
+
+        if ((instance.hasPoints = (points != nullptr))) {
+          instance.points = parsePoints(*points);
+        }
+
+        auto object = instantiateTemplate(std::move(objectTemplate), instance, tilesetSources);
+        parseComponent(value, object.get());
+        return object;
+      }
+
+      std::unique_ptr<Object> parseObject(const json::Value& value) {
+        if (value.hasMember("template")) {
+          auto object = parseTemplateInstance(value);
+
+          if (object) {
+            return object;
+          }
+        }
+
+        unsigned id = value.getUInt("id");
+        std::string name = value.getString("name");
+        std::string type = value.getString("type", value.getString("class"));
+        unsigned x = value.getUInt("x");
+        unsigned y = value.getUInt("y");
+        double rotation = value.getNumber("rotation");
+        bool visible = value.getBool("visible", true);
+
+        Vector2u origin{x, y};
+
+        std::unique_ptr<Object> object;
+
+        if (const json::Value *points = value.find("polygon")) {
+          auto polygon = makeUnique<Polygon>(id, name, type, origin, rotation, visible);
+          polygon->setPoints(parsePoints(*points));
+          object = std::move(polygon);
+        } else if (const json::Value *points = value.find("polyline")) {
+          auto polyline = makeUnique<Polyline>(id, name, type, origin, rotation, visible);
+          polyline->setPoints(parsePoints(*points));
+          object = std::move(polyline);
+        } else if (value.hasMember("gid")) {
+          unsigned gid = value.getUInt("gid");
+
+          bool hflip, vflip, dflip;
+          std::tie(hflip, vflip, dflip, gid) = decodeGID(gid);
+
+          object = makeUnique<TileObject>(id, name, type, origin, rotation, visible, gid, hflip, vflip, dflip);
+        } else {
+          unsigned width = value.getUInt("width");
+          unsigned height = value.getUInt("height");
+
+          if (value.getBool("ellipse")) {
+            object = makeUnique<Ellipse>(id, name, type, origin, rotation, visible, width, height);
+          } else {
+            object = makeUnique<Rectangle>(id, name, type, origin, rotation, visible, width, height);
+          }
+        }
+
+        parseComponent(value, object.get());
+        return object;
+      }
+
+      // the objects of the tiles are not visited, the visitor only sees the objects of the map
+      std::unique_ptr<ObjectLayer> parseObjectGroup(const json::Value& value, bool visit) {
+        std::string name = value.getString("name");
+        double opacity = value.getNumber("opacity", 1.0);
+        bool visible = value.getBool("visible", true);
+
+        std::string color = value.getString("color");
+
+        DrawOrder order = DrawOrder::TOP_DOWN;
+
+        if (value.hasMember("draworder")) {
+          std::string draworder = value.getString("draworder");
+
+          if (draworder == "topdown") {
+            order = DrawOrder::TOP_DOWN;
+          } else if (draworder == "index") {
+            order = DrawOrder::INDEX;
+          } else {
+            std::clog << "Error! Wrong draw order string: '" << draworder << "'\n";
+          }
+        }
+
+        auto objectLayerPtr = makeUnique<ObjectLayer>(name, opacity, visible, color, order);
+        auto objectLayer = objectLayerPtr.get();
+
+        parseComponent(value, objectLayer);
+        parseLayerOffset(value, objectLayer);
+
+        if (const json::Value *objects = value.find("objects")) {
+          for (auto& element : *objects) {
+            auto object = parseObject(element);
+
+            if (!visit || mustKeep(&ParseVisitor::visitObject, *objectLayer, *object)) {
+              objectLayer->addObject(std::move(object));
+            }
+          }
+        }
+
+        return objectLayerPtr;
+      }
+
+      std::unique_ptr<GroupLayer> parseGroup(const json::Value& value) {
+        std::string name = value.getString("name");
+        double opacity = value.getNumber("opacity", 1.0);
+        bool visible = value.getBool("visible", true);
+
+        auto groupPtr = makeUnique<GroupLayer>(name, opacity, visible);
+        auto group = groupPtr.get();
+
+        parseComponent(value, group);
+        parseLayerOffset(value, group);
+
+        if (const json::Value *layers = value.find("layers")) {
+          for (auto& element : *layers) {
+            std::string type = element.getString("type");
+
+            if (type == "tilelayer") {
+              auto layer = parseLayer(element);
+
+              if (mustKeep(&ParseVisitor::visitTileLayer, *layer)) {
+                group->addLayer(std::move(layer));
+              }
+            } else if (type == "objectgroup") {
+              auto layer = parseObjectGroup(element, true);
+
+              if (mustKeep(&ParseVisitor::visitObjectLayer, *layer)) {
+                group->addLayer(std::move(layer));
+              }
+            } else if (type == "imagelayer") {
+              auto layer = parseImageLayer(element);
+
+              if (mustKeep(&ParseVisitor::visitImageLayer, *layer)) {
+                group->addLayer(std::move(layer));
+              }
+            } else if (type == "group") {
+              auto layer = parseGroup(element);
+
+              if (mustKeep(&ParseVisitor::visitGroupLayer, *layer)) {
+                group->addLayer(std::move(layer));
+              }
+            }
+          }
+        }
+
+        return groupPtr;
+      }
+
+      std::unique_ptr<TileLayer> parseLayer(const json::Value& value) {
+        std::string name = value.getString("name");
+        double opacity = value.getNumber("opacity", 1.0);
+        bool visible = value.getBool("visible", true);
+
+        auto tileLayerPtr = makeUnique<TileLayer>(name, opacity, visible);
+        auto tileLayer = tileLayerPtr.get();
+
+        parseComponent(value, tileLayer);
+        parseLayerOffset(value, tileLayer);
+
+        if (value.hasMember("chunks")) {
+          std::clog << "Error! Infinite maps are not supported, in layer: '" << name << "'\n";
+          return tileLayerPtr;
+        }
+
+        const json::Value *data = value.find("data");
+
+        if (data == nullptr) {
+          return tileLayerPtr;
+        }
+
+        if (data->is(json::Type::ARRAY)) {
+          for (auto& item : *data) {
+            unsigned gid = static_cast<unsigned>(static_cast<uint64_t>(item.getNumber()));
+
+            bool hflip, vflip, dflip;
+            std::tie(hflip, vflip, dflip, gid) = decodeGID(gid);
+
+            tileLayer->addCell({ gid, hflip, vflip, dflip });
+          }
+
+          return tileLayerPtr;
+        }
+
+        if (value.getString("encoding") != "base64") {
+          std::clog << "Error! Wrong encoding of the layer data: '" << value.getString("encoding") << "'\n";
+          return tileLayerPtr;
+        }
+
+        std::vector<uint8_t> buffer = decodeBase64(std::string(data->getString(), data->getSize()));
+        std::string compression = value.getString("compression");
+
+        if (compression == "zlib" || compression == "gzip") {
+          buffer = decodeCompressed(buffer, dictionary.get());
+        } else if (!compression.empty()) {
+          std::clog << "Error! Wrong compression of the layer data: '" << compression << "'\n";
+          return tileLayerPtr;
+        }
+
+        const std::size_t sz = buffer.size();
+        assert(sz % 4 == 0);
+
+        for (std::size_t i = 0; i + 4 <= sz; i += 4) {
+          unsigned gid = buffer[i] | (buffer[i + 1] << 8) | (buffer[i + 2] << 16) | (buffer[i + 3] << 24);
+
+          bool hflip, vflip, dflip;
+          std::tie(hflip, vflip, dflip, gid) = decodeGID(gid);
+
+          tileLayer->addCell({ gid, hflip, vflip, dflip });
+        }
+
+        return tileLayerPtr;
+      }
+
+      std::unique_ptr<Tile> parseTile(unsigned id, const json::Value *value, const json::Value *properties) {
+        std::array<unsigned, 4> terrain = { { INVALID, INVALID, INVALID, INVALID } };
+        unsigned probability = 100;
+
+        if (value != nullptr) {
+          if (const json::Value *items = value->find("terrain")) {
+            unsigned t = 0;
+
+            for (auto& item : *items) {
+              if (t == terrain.size()) {
+                break;
+              }
+
+              double index = item.getNumber();
+              terrain[t++] = index >= 0 ? static_cast<unsigned>(index) : INVALID;
+            }
+          }
+
+          probability = value->getUInt("probability", 100);
+        }
+
+        auto tile = makeUnique<Tile>(id, terrain, probability);
+
+        if (value != nullptr) {
+          parseComponent(*value, tile.get());
+
+          auto image = parseImage(*value, "image", "imagewidth", "imageheight");
+
+          if (image) {
+            tile->setImage(std::move(image));
+          }
+
+          if (const json::Value *animation = value->find("animation")) {
+            std::vector<Frame> frames;
+
+            for (auto& frame : *animation) {
+              frames.push_back({ frame.getUInt("tileid"), frame.getUInt("duration") });
+            }
+
+            tile->setAnimation(std::move(frames));
+          }
+
+          if (const json::Value *objects = value->find("objectgroup")) {
+            tile->setObjects(parseObjectGroup(*objects, false));
+          }
+        }
+
+        if (properties != nullptr) {
+          parseComponent(*properties, tile.get(), properties);
+        }
+
+        return tile;
+      }
+
+      std::unique_ptr<Terrain> parseTerrain(const json::Value& value) {
+        std::string name = value.getString("name");
+        unsigned tile = value.getUInt("tile");
+
+        auto terrain = makeUnique<Terrain>(name, tile);
+        parseComponent(value, terrain.get());
+
+        return terrain;
+      }
+
+      std::unique_ptr<TileSet> parseTileSetFromValue(unsigned firstgid, const json::Value& value) {
+        std::string name = value.getString("name");
+        unsigned tilewidth = value.getUInt("tilewidth");
+        unsigned tileheight = value.getUInt("tileheight");
+        unsigned spacing = value.getUInt("spacing");
+        unsigned margin = value.getUInt("margin");
+        unsigned tilecount = value.getUInt("tilecount");
+
+        auto tilesetPtr = makeUnique<TileSet>(firstgid, name, tilewidth, tileheight, spacing, margin, tilecount);
+        auto tileset = tilesetPtr.get();
+
+        parseComponent(value, tileset);
+
+        if (const json::Value *offset = value.find("tileoffset")) {
+          tileset->setOffset(offset->getInt("x"), offset->getInt("y"));
+        }
+
+        auto image = parseImage(value, "image", "imagewidth", "imageheight");
+
+        if (image) {
+          tileset->setImage(std::move(image));
+        }
+
+        if (const json::Value *terrains = value.find("terrains")) {
+          for (auto& terrain : *terrains) {
+            tileset->addTerrain(parseTerrain(terrain));
+          }
+        }
+
+        const json::Value *tiles = value.find("tiles");
+
+        // an array of tiles with their id since Tiled 1.2
+        if (tiles != nullptr && tiles->is(json::Type::ARRAY)) {
+          for (auto& tile : *tiles) {
+            tileset->addTile(parseTile(tile.getUInt("id"), &tile, nullptr));
+          }
+
+          return tilesetPtr;
+        }
+
+        // an object indexed by the id of the tiles before, with the properties apart
+        std::map<unsigned, std::pair<const json::Value *, const json::Value *>> indexed;
+
+        if (tiles != nullptr) {
+          for (auto& tile : *tiles) {
+            indexed[std::strtoul(tile.getKey(), nullptr, 10)].first = &tile;
+          }
+        }
+
+        if (const json::Value *properties = value.find("tileproperties")) {
+          for (auto& tile : *properties) {
+            indexed[std::strtoul(tile.getKey(), nullptr, 10)].second = &tile;
+          }
+        }
+
+        for (auto& tile : indexed) {
+          tileset->addTile(parseTile(tile.first, tile.second.first, tile.second.second));
+        }
+
+        return tilesetPtr;
+      }
+
+      std::unique_ptr<TileSet> parseTileSetFromFile(unsigned firstgid, const fs::path& tilesetPath) {
+        std::vector<char> text;
+        json::Document doc;
+
+        if (!loadDocument(tilesetPath, text, doc)) {
+          std::clog << "Error! Unable to load a JSON tileset: " << tilesetPath << '\n';
+          return nullptr;
+        }
+
+        if (doc.getRoot().hasMember("firstgid")) {
+          std::clog << "Warning! Member 'firstgid' present in a JSON tileset: " << tilesetPath << '\n';
+        }
+
+        fs::path savedPath = currentPath;
+        currentPath = tilesetPath.parent_path();
+
+        auto tileset = parseTileSetFromValue(firstgid, doc.getRoot());
+
+        currentPath = savedPath;
+        return tileset;
+      }
+
+      std::unique_ptr<TileSet> parseTileSet(const json::Value& value) {
+        unsigned firstgid = value.getUInt("firstgid");
+        std::string source = value.getString("source");
+
+        if (source.empty()) {
+          return parseTileSetFromValue(firstgid, value);
+        }
+
+        return loadTileSetFile(currentPath / source, firstgid, context);
+      }
+
+      // the hash of an external tileset includes the content of its file
+      uint64_t hashTileSet(const json::Value& value) {
+        uint64_t hash = hashValue(value);
+        std::string source = value.getString("source");
+
+        if (!source.empty()) {
+          fs::path tilesetPath = currentPath / source;
+          context.reuse->files.push_back(tilesetPath);
+          hash = hashFile(tilesetPath, hash);
+        }
+
+        return hash;
+      }
+
+      uint64_t hashFile(const fs::path& path, uint64_t hash) {
+        auto file = getFileSystem().open(path);
+        std::vector<char> text;
+
+        if (file && loadText(*file, text)) {
+          hash = hashBytes(text.data(), text.size(), hash);
+        }
+
+        return hash;
+      }
+
+      // the hash of a layer includes the content of the templates of its objects
+      uint64_t hashTemplates(const json::Value& value, uint64_t hash) {
+        for (auto& element : value) {
+          const char *key = element.getKey();
+
+          if (key != nullptr && std::strcmp(key, "template") == 0 && element.is(json::Type::STRING)) {
+            fs::path templatePath = currentPath / element.getString();
+            fs::path normalized = templatePath.lexically_normal();
+            auto it = templateHashes.find(normalized);
+
+            if (it == templateHashes.end()) {
+              context.reuse->files.push_back(templatePath);
+              it = templateHashes.emplace(normalized, hashFile(templatePath, UINT64_C(14695981039346656037))).first;
+            }
+
+            hash = hashBytes(&it->second, sizeof it->second, hash);
+          }
+
+          hash = hashTemplates(element, hash);
+        }
+
+        return hash;
+      }
+
+      template<typename T>
+      std::unique_ptr<T> reuseLayer(const json::Value& value, uint64_t& hash) {
+        if (context.reuse == nullptr) {
+          return nullptr;
+        }
+
+        // the type of the layer is in the hash, so the kind of layer is the same
+        hash = hashTemplates(value, hashValue(value));
+
+        // the same data decodes differently with another dictionary
+        if (dictionary) {
+          hash ^= dictionary->getId();
+        }
+
+        std::unique_ptr<Layer> layer = takeReusable(context.reuse->layers, hash);
+        return std::unique_ptr<T>(static_cast<T *>(layer.release()));
+      }
+
+      void addLayer(Map *map, std::unique_ptr<Layer> layer, uint64_t hash, bool decoded) {
+        if (context.reuse) {
+          context.reuse->layerHashes.push_back(hash);
+
+          if (decoded) {
+            context.reuse->decodedLayers.push_back(layer->getName());
+          }
+        }
+
+        map->addLayer(std::move(layer));
+      }
+
+      std::unique_ptr<Map> parseMap(const json::Value& value) {
+        std::string version = "1.0";
+
+        if (const json::Value *item = value.find("version")) {
+          version = toString(*item);
+
+          // the version is a number before Tiled 1.2
+          if (item->is(json::Type::NUMBER) && version.find('.') == std::string::npos) {
+            version += ".0";
+          }
+        }
+
+        Orientation orientation = Orientation::UNKNOWN;
+        std::string orientationString = value.getString("orientation");
+
+        if (orientationString == "orthogonal") {
+          orientation = Orientation::ORTHOGONAL;
+        } else if (orientationString == "isometric") {
+          orientation = Orientation::ISOMETRIC;
+        } else if (orientationString == "staggered") {
+          orientation = Orientation::STAGGERED;
+        } else if (orientationString == "hexagonal") {
+          orientation = Orientation::HEXAGONAL;
+        } else {
+          std::clog << "Error! Wrong orientation string: '" << orientationString << "'\n";
+        }
+
+        unsigned width = value.getUInt("width");
+        unsigned height = value.getUInt("height");
+        unsigned tilewidth = value.getUInt("tilewidth");
+        unsigned tileheight = value.getUInt("tileheight");
+        std::string bgcolor = value.getString("backgroundcolor", "#FFFFFF");
+
+        RenderOrder renderOrder = RenderOrder::RIGHT_DOWN; // default value
+
+        if (value.hasMember("renderorder")) {
+          std::string order = value.getString("renderorder");
+
+          if (order == "right-down") {
+            renderOrder = RenderOrder::RIGHT_DOWN;
+          } else if (order == "right-up") {
+            renderOrder = RenderOrder::RIGHT_UP;
+          } else if (order == "left-down") {
+            renderOrder = RenderOrder::LEFT_DOWN;
+          } else if (order == "left-up") {
+            renderOrder = RenderOrder::LEFT_UP;
+          } else {
+            std::clog << "Error! Wrong render order string: '" << order << "'\n";
+          }
+        }
+
+        unsigned hexSideLength = value.getUInt("hexsidelength");
+
+        StaggerAxis axis = StaggerAxis::Y;
+
+        if (value.hasMember("staggeraxis")) {
+          std::string staggerAxis = value.getString("staggeraxis");
+
+          if (staggerAxis == "x") {
+            axis = StaggerAxis::X;
+          } else if (staggerAxis == "y") {
+            axis = StaggerAxis::Y;
+          } else {
+            std::clog << "Error! Wrong stagger axis string: '" << staggerAxis << "'\n";
+          }
+        }
+
+        StaggerIndex index = StaggerIndex::ODD;
+
+        if (value.hasMember("staggerindex")) {
+          std::string staggerIndex = value.getString("staggerindex");
+
+          if (staggerIndex == "odd") {
+            index = StaggerIndex::ODD;
+          } else if (staggerIndex == "even") {
+            index = StaggerIndex::EVEN;
+          } else {
+            std::clog << "Error! Wrong stagger index string: '" << staggerIndex << "'\n";
+          }
+        }
+
+        unsigned nextObjectId = value.getUInt("nextobjectid");
+
+        auto mapPtr = makeUnique<Map>(version, orientation, width, height, tilewidth, tileheight, bgcolor, renderOrder,
+            hexSideLength, axis, index, nextObjectId);
+        auto map = mapPtr.get();
+        parseComponent(value, map);
+
+        currentMap = map;
+
+        if (map->hasProperty(CompressionDictionary::getPropertyName())) {
+          fs::path source = map->getProperty(CompressionDictionary::getPropertyName(), "");
+          fs::path dictionaryPath = currentPath / source;
+          dictionary = CompressionDictionary::load(dictionaryPath, getFileSystem());
+
+          if (dictionary) {
+            map->setCompressionDictionary(source, dictionary);
+          }
+
+          if (context.reuse) {
+            context.reuse->files.push_back(dictionaryPath);
+          }
+        }
+
+        const json::Value *tilesets = value.find("tilesets");
+        const json::Value *layers = value.find("layers");
+
+        if (context.progress) {
+          unsigned layerCount = 0;
+
+          if (layers != nullptr) {
+            for (auto& layer : *layers) {
+              std::string type = layer.getString("type");
+
+              if (type == "tilelayer" || type == "objectgroup" || type == "imagelayer" || type == "group") {
+                layerCount++;
+              }
+            }
+          }
+
+          context.progress->setCounts(tilesets ? tilesets->getSize() : 0, layerCount);
+        }
+
+        if (tilesets != nullptr) {
+          for (auto& element : *tilesets) {
+            if (isCancelled()) {
+              break;
+            }
+
+            std::string source = element.getString("source");
+
+            if (!source.empty()) {
+              tilesetSources[(currentPath / source).lexically_normal()] = element.getUInt("firstgid");
+            }
+
+            std::unique_ptr<TileSet> tileset;
+            uint64_t hash = 0;
+            bool decoded = false;
+
+            if (context.reuse) {
+              hash = hashTileSet(element);
+              tileset = takeReusable(context.reuse->tilesets, hash);
+            }
+
+            if (!tileset) {
+              tileset = parseTileSet(element);
+              decoded = true;
+            }
+
+            if (tileset && mustKeep(&ParseVisitor::visitTileSet, *tileset)) {
+              if (context.reuse) {
+                context.reuse->tilesetHashes.push_back(hash);
+
+                if (decoded) {
+                  context.reuse->decodedTileSets.push_back(tileset->getName());
+                }
+              }
+
+              map->addTileSet(std::move(tileset));
+            }
+
+            if (context.progress) {
+              context.progress->addTileSetDecoded();
+            }
+          }
+        }
+
+        if (layers != nullptr) {
+          for (auto& element : *layers) {
+            if (isCancelled()) {
+              break;
+            }
+
+            std::string type = element.getString("type");
+            uint64_t hash = 0;
+
+            if (type == "tilelayer") {
+              auto layer = reuseLayer<TileLayer>(element, hash);
+              bool decoded = !layer;
+
+              if (decoded) {
+                layer = parseLayer(element);
+              }
+
+              if (mustKeep(&ParseVisitor::visitTileLayer, *layer)) {
+                addLayer(map, std::move(layer), hash, decoded);
+              }
+            } else if (type == "objectgroup") {
+              auto layer = reuseLayer<ObjectLayer>(element, hash);
+              bool decoded = !layer;
+
+              if (decoded) {
+                layer = parseObjectGroup(element, true);
+              }
+
+              if (mustKeep(&ParseVisitor::visitObjectLayer, *layer)) {
+                addLayer(map, std::move(layer), hash, decoded);
+              }
+            } else if (type == "imagelayer") {
+              auto layer = reuseLayer<ImageLayer>(element, hash);
+              bool decoded = !layer;
+
+              if (decoded) {
+                layer = parseImageLayer(element);
+              }
+
+              if (mustKeep(&ParseVisitor::visitImageLayer, *layer)) {
+                addLayer(map, std::move(layer), hash, decoded);
+              }
+            } else if (type == "group") {
+              auto layer = reuseLayer<GroupLayer>(element, hash);
+              bool decoded = !layer;
+
+              if (decoded) {
+                layer = parseGroup(element);
+              }
+
+              if (mustKeep(&ParseVisitor::visitGroupLayer, *layer)) {
+                addLayer(map, std::move(layer), hash, decoded);
+              }
+            } else {
+              continue;
+            }
+
+            if (context.progress) {
+              context.progress->addLayerDecoded();
+            }
+          }
+        }
+
+        if (isCancelled()) {
+          return nullptr;
+        }
+
+        return mapPtr;
+      }
+
+      std::unique_ptr<Map> parse() {
+        std::vector<char> text;
+        json::Document doc;
+
+        if (!loadDocument(mapPath, text, doc)) {
+          std::clog << "Error! Unable to load the JSON map: " << mapPath << '\n';
+          return nullptr;
+        }
+
+        return parseMap(doc.getRoot());
+      }
+
+      std::shared_ptr<const ObjectTemplate> parseTemplate() {
+        std::vector<char> text;
+        json::Document doc;
+
+        if (!loadDocument(mapPath, text, doc)) {
+          std::clog << "Error! Unable to load the JSON template: " << mapPath << '\n';
+          return nullptr;
+        }
+
+        const json::Value& root = doc.getRoot();
+        const json::Value *value = root.find("object");
+
+        if (value == nullptr || !value->is(json::Type::OBJECT)) {
+          std::clog << "Error! No object in the template: " << mapPath << '\n';
+          return nullptr;
+        }
+
+        parsingTemplate = true;
+
+        unsigned firstgid = 0;
+        fs::path tilesetPath;
+
+        if (const json::Value *tileset = root.find("tileset")) {
+          firstgid = tileset->getUInt("firstgid");
+          tilesetPath = (currentPath / tileset->getString("source")).lexically_normal();
+        }
+
+        return std::make_shared<const ObjectTemplate>(mapPath, parseObject(*value), tilesetPath, firstgid);
+      }
+
+      fs::path mapPath;
+      fs::path currentPath;
+      const ParseContext& context;
+      const Map *currentMap;
+      std::shared_ptr<const CompressionDictionary> dictionary;
+      TileSetSources tilesetSources;
+      std::map<fs::path, std::shared_ptr<const ObjectTemplate>> templates;
+      std::map<fs::path, uint64_t> templateHashes;
+      bool parsingTemplate;
+    };
+
+  }
+
+  bool isJsonFile(const fs::path& filename) {
+    return hasExtension(filename, ".json") || hasExtension(filename, ".tmj") || hasExtension(filename, ".tsj") || hasExtension(filename, ".tj");
+  }
+
+  std::unique_ptr<Map> parseJsonMapFile(const fs::path& filename, const ParseContext& context) {
+    JsonParser parser(filename, context);
+    return parser.parse();
+  }
+
+  std::shared_ptr<const ObjectTemplate> parseJsonTemplateFile(const fs::path& filename, FileSystem& filesystem) {
+    ParseContext context;
+    context.filesystem = &filesystem;
+
+    JsonParser parser(filename, context);
+    return parser.parseTemplate();
+  }
+
+  std::unique_ptr<TileSet> parseJsonTileSetFile(const fs::path& filename, unsigned firstgid, const ParseContext& context) {
+    // there is no map under construction, the tileset is visited as a whole by the parser of the map
+    ParseContext tilesetContext = context;
+    tilesetContext.visitor = nullptr;
+
+    JsonParser parser(filename, tilesetContext);
+    return parser.parseTileSetFromFile(firstgid, filename);
+  }
+
+}
@@ -15,6 +15,8 @@
  */
 #include <tmx/LayerVisitor.h>
 
+#include <tmx/GroupLayer.h>
+
 namespace tmx {
 
   LayerVisitor::~LayerVisitor() {
@@ -32,4 +34,10 @@ namespace tmx {
     // do nothing by default
   }
 
+  void LayerVisitor::visitGroupLayer(const Map& map, const GroupLayer& layer) {
+    for (auto child : layer.getLayers()) {
+      child->accept(map, *this);
+    }
+  }
+
 }
@@ -15,6 +15,7 @@
  */
 #include <tmx/Layer.h>
 #include <tmx/LayerVisitor.h>
+#include <tmx/GroupLayer.h>
 #include <tmx/ImageLayer.h>
 #include <tmx/ObjectLayer.h>
 #include <tmx/TileLayer.h>
@@ -24,6 +25,10 @@ namespace tmx {
   Layer::~Layer() {
   }
 
+  void GroupLayer::accept(const Map& map, LayerVisitor& visitor) const {
+    visitor.visitGroupLayer(map, *this);
+  }
+
   void ImageLayer::accept(const Map& map, LayerVisitor& visitor) const {
     visitor.visitImageLayer(map, *this);
   }
@@ -32,6 +37,39 @@ namespace tmx {
     visitor.visitObjectLayer(map, *this);
   }
 
+  Object *ObjectLayer::getObject(unsigned id) noexcept {
+    for (auto& obj : m_objects) {
+      if (obj->getId() == id) {
+        return obj.get();
+      }
+    }
+
+    return nullptr;
+  }
+
+  std::unique_ptr<Object> ObjectLayer::removeObject(unsigned id) {
+    for (auto it = m_objects.begin(); it != m_objects.end(); ++it) {
+      if ((*it)->getId() == id) {
+        std::unique_ptr<Object> obj = std::move(*it);
+        m_objects.erase(it);
+        return obj;
+      }
+    }
+
+    return nullptr;
+  }
+
+  std::unique_ptr<Object> ObjectLayer::replaceObject(std::unique_ptr<Object> obj) {
+    for (auto& current : m_objects) {
+      if (current->getId() == obj->getId()) {
+        current.swap(obj);
+        return obj;
+      }
+    }
+
+    return nullptr;
+  }
+
   void TileLayer::accept(const Map& map, LayerVisitor& visitor) const {
     visitor.visitTileLayer(map, *this);
   }
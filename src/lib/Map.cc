@@ -17,8 +17,99 @@
 
 #include <boost/range/adaptor/reversed.hpp>
 
+#include <tmx/CompressionDictionary.h>
+#include <tmx/GroupLayer.h>
+
 namespace tmx {
 
+  namespace {
+
+    void flattenLayer(std::vector<FlattenedLayer>& flattened, const Layer& layer, const FlattenedLayer& parent) {
+      FlattenedLayer current;
+      current.layer = &layer;
+      current.group = parent.group;
+      current.depth = parent.depth;
+      current.opacity = parent.opacity * layer.getOpacity();
+      current.visible = parent.visible && layer.isVisible();
+      current.offset.x = parent.offset.x + layer.getOffset().x;
+      current.offset.y = parent.offset.y + layer.getOffset().y;
+
+      auto group = dynamic_cast<const GroupLayer *>(&layer);
+
+      if (group == nullptr) {
+        flattened.push_back(current);
+        return;
+      }
+
+      current.group = group;
+      current.depth++;
+
+      for (auto child : group->getLayers()) {
+        flattenLayer(flattened, *child, current);
+      }
+    }
+
+    // depth first, a group before its layers
+    void collectLayers(Layer& layer, std::vector<Layer *>& layers) {
+      layers.push_back(&layer);
+
+      if (auto group = dynamic_cast<GroupLayer *>(&layer)) {
+        for (std::size_t i = 0; i < group->getLayerCount(); ++i) {
+          collectLayers(*group->getLayer(i), layers);
+        }
+      }
+    }
+
+    void collectLayers(const Layer& layer, std::vector<const Layer *>& layers) {
+      layers.push_back(&layer);
+
+      if (auto group = dynamic_cast<const GroupLayer *>(&layer)) {
+        for (auto child : group->getLayers()) {
+          collectLayers(*child, layers);
+        }
+      }
+    }
+
+  }
+
+  std::vector<FlattenedLayer> Map::getFlattenedLayers() const {
+    std::vector<FlattenedLayer> flattened;
+
+    FlattenedLayer root;
+    root.layer = nullptr;
+    root.group = nullptr;
+    root.depth = 0;
+    root.opacity = 1.0;
+    root.visible = true;
+    root.offset = { 0.0f, 0.0f };
+
+    for (auto& layer : m_layers) {
+      flattenLayer(flattened, *layer, root);
+    }
+
+    return flattened;
+  }
+
+  std::vector<Layer *> Map::getAllLayers() {
+    std::vector<Layer *> layers;
+
+    for (auto& layer : m_layers) {
+      collectLayers(*layer, layers);
+    }
+
+    return layers;
+  }
+
+  std::vector<const Layer *> Map::getAllLayers() const {
+    std::vector<const Layer *> layers;
+
+    for (auto& layer : m_layers) {
+      collectLayers(static_cast<const Layer&>(*layer), layers);
+    }
+
+    return layers;
+  }
+
   const TileSet *Map::getTileSetFromGID(unsigned gid) const noexcept {
     for (auto tileset : getTileSets() | boost::adaptors::reversed) {
       if (tileset->getFirstGID() <= gid) {
@@ -29,4 +120,14 @@ namespace tmx {
     return nullptr;
   }
 
+  void Map::setCompressionDictionary(const boost::filesystem::path& source, std::shared_ptr<const CompressionDictionary> dictionary) {
+    if (dictionary) {
+      setProperty(CompressionDictionary::getPropertyName(), source.generic_string());
+    } else {
+      removeProperty(CompressionDictionary::getPropertyName());
+    }
+
+    m_dictionary = std::move(dictionary);
+  }
+
 }
\ No newline at end of file
@@ -0,0 +1,846 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include "MapCompiler.h"
+
+#include <tmx/CompiledMap.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+#include <tmx/GroupLayer.h>
+#include <tmx/Image.h>
+#include <tmx/ImageLayer.h>
+#include <tmx/Map.h>
+#include <tmx/ObjectLayer.h>
+#include <tmx/TileLayer.h>
+
+namespace fs = boost::filesystem;
+
+namespace tmx {
+
+  namespace {
+
+    template<typename T, typename... Args>
+    inline std::unique_ptr<T> makeUnique(Args&&... args) {
+      return std::unique_ptr<T>(new T(std::forward<Args>(args)...));
+    }
+
+    class Compiler : public LayerVisitor {
+    public:
+      Compiler(const Map& map, unsigned chunkSize)
+      : m_map(map)
+      , m_chunkSize(chunkSize)
+      , m_chunksPerRow((map.getWidth() + chunkSize - 1) / chunkSize)
+      , m_chunksPerColumn((map.getHeight() + chunkSize - 1) / chunkSize)
+      {
+        // the empty string is always the first string
+        intern("");
+      }
+
+      uint32_t intern(const std::string& str) {
+        auto it = m_strings.find(str);
+
+        if (it != m_strings.end()) {
+          return it->second;
+        }
+
+        uint32_t index = m_stringOffsets.size();
+        m_stringOffsets.push_back(m_stringData.size());
+        m_stringData.insert(m_stringData.end(), str.begin(), str.end());
+        m_stringData.push_back('\0');
+        m_strings.emplace(str, index);
+        return index;
+      }
+
+      compiled::Range addProperties(const Component& component) {
+        // the defaults of the instances of a template are flattened
+        if (component.getDefaults() != nullptr) {
+          return addProperties(component.getAllProperties());
+        }
+
+        return addProperties(component.getProperties());
+      }
+
+      compiled::Range addProperties(const std::map<std::string, std::string>& properties) {
+        compiled::Range range;
+        range.first = m_properties.size();
+        range.count = 0;
+
+        for (auto& property : properties) {
+          compiled::Property data;
+          data.key = intern(property.first);
+          data.value = intern(property.second);
+          m_properties.push_back(data);
+          range.count++;
+        }
+
+        return range;
+      }
+
+      uint32_t addImage(const Image *image) {
+        if (image == nullptr) {
+          return compiled::None;
+        }
+
+        compiled::Image data;
+        data.format = intern(image->getFormat());
+        data.source = intern(image->getSource().string());
+        data.trans = intern(image->getTransparent());
+        data.width = image->getWidth();
+        data.height = image->getHeight();
+        data.data.first = m_imageData.size();
+        data.data.count = image->getDataSize();
+        m_imageData.insert(m_imageData.end(), image->getData(), image->getData() + image->getDataSize());
+        m_images.push_back(data);
+        return m_images.size(); // index plus one
+      }
+
+      void addTileSet(const TileSet& tileset) {
+        compiled::TileSet data;
+        data.firstgid = tileset.getFirstGID();
+        data.name = intern(tileset.getName());
+        data.tilewidth = tileset.getTileWidth();
+        data.tileheight = tileset.getTileHeight();
+        data.spacing = tileset.getSpacing();
+        data.margin = tileset.getMargin();
+        data.tilecount = tileset.getTileCount();
+        data.offsetX = tileset.getOffsetX();
+        data.offsetY = tileset.getOffsetY();
+        data.image = addImage(tileset.getImage());
+
+        data.terrains.first = m_terrains.size();
+
+        for (auto terrain : tileset.getTerrains()) {
+          compiled::Terrain terrainData;
+          terrainData.name = intern(terrain->getName());
+          terrainData.tile = terrain->getTile();
+          terrainData.properties = addProperties(*terrain);
+          m_terrains.push_back(terrainData);
+        }
+
+        data.terrains.count = m_terrains.size() - data.terrains.first;
+
+        data.tiles.first = m_tiles.size();
+
+        for (auto tile : tileset) {
+          compiled::Tile tileData;
+          tileData.id = tile->getId();
+
+          for (unsigned i = 0; i < 4; ++i) {
+            tileData.terrain[i] = tile->getTerrain()[i];
+          }
+
+          tileData.probability = tile->getProbability();
+          tileData.image = addImage(tile->getImage());
+          tileData.properties = addProperties(*tile);
+
+          tileData.frames.first = m_frames.size();
+
+          for (auto& frame : tile->getAnimation()) {
+            compiled::Frame frameData;
+            frameData.tileId = frame.tileId;
+            frameData.duration = frame.duration;
+            m_frames.push_back(frameData);
+          }
+
+          tileData.frames.count = m_frames.size() - tileData.frames.first;
+          tileData.objects = compiled::None;
+
+          if (tile->hasObjects()) {
+            m_tileLayers.push_back(makeObjectLayer(*tile->getObjects()));
+            tileData.objects = m_tileLayers.size(); // index plus one
+          }
+          m_tiles.push_back(tileData);
+        }
+
+        data.tiles.count = m_tiles.size() - data.tiles.first;
+
+        data.properties = addProperties(tileset);
+        m_tilesets.push_back(data);
+      }
+
+      compiled::Layer makeLayer(const Layer& layer, compiled::LayerKind kind) {
+        compiled::Layer data;
+        std::memset(&data, 0, sizeof data);
+        data.kind = kind;
+        data.name = intern(layer.getName());
+        data.opacity = layer.getOpacity();
+        data.visible = layer.isVisible() ? 1 : 0;
+        data.properties = addProperties(layer);
+        data.offset = layer.getOffset();
+        data.parent = m_parent;
+        return data;
+      }
+
+      virtual void visitTileLayer(const Map& map, const TileLayer& layer) override {
+        compiled::Layer data = makeLayer(layer, compiled::TILE_LAYER);
+        data.chunks.first = m_chunks.size();
+        data.chunks.count = m_chunksPerRow * m_chunksPerColumn;
+
+        unsigned width = map.getWidth();
+        unsigned height = map.getHeight();
+
+        std::vector<uint32_t> cells;
+        cells.reserve(width * height);
+
+        for (auto cell : layer) {
+          cells.push_back(cell.getRawGID());
+        }
+
+        cells.resize(width * height, 0);
+
+        for (unsigned cy = 0; cy < m_chunksPerColumn; ++cy) {
+          for (unsigned cx = 0; cx < m_chunksPerRow; ++cx) {
+            compiled::Chunk chunk;
+            chunk.cells = m_cells.size();
+            chunk.objects.first = chunk.objects.count = 0;
+            m_chunks.push_back(chunk);
+
+            unsigned xmax = std::min(width, (cx + 1) * m_chunkSize);
+            unsigned ymax = std::min(height, (cy + 1) * m_chunkSize);
+
+            for (unsigned y = cy * m_chunkSize; y < ymax; ++y) {
+              auto row = cells.begin() + y * width;
+              m_cells.insert(m_cells.end(), row + cx * m_chunkSize, row + xmax);
+            }
+          }
+        }
+
+        m_layers.push_back(data);
+      }
+
+      compiled::Layer makeObjectLayer(const ObjectLayer& layer) {
+        compiled::Layer data = makeLayer(layer, compiled::OBJECT_LAYER);
+        data.color = intern(layer.getColor());
+        data.drawOrder = static_cast<uint32_t>(layer.getDrawOrder());
+        data.content.first = m_objectKinds.size();
+
+        for (auto object : layer) {
+          addObject(*object);
+        }
+
+        data.content.count = m_objectKinds.size() - data.content.first;
+        return data;
+      }
+
+      virtual void visitObjectLayer(const Map& map, const ObjectLayer& layer) override {
+        compiled::Layer data = makeObjectLayer(layer);
+        std::vector<std::vector<uint32_t>> refs(m_chunksPerRow * m_chunksPerColumn);
+
+        for (uint32_t index = data.content.first; index < data.content.first + data.content.count && !refs.empty(); ++index) {
+          // register the object in all the chunks it intersects
+          const compiled::Bounds& bounds = m_objectBounds[index];
+          unsigned cxmin = toChunk(bounds.left, map.getTileWidth(), m_chunksPerRow);
+          unsigned cxmax = toChunk(bounds.right, map.getTileWidth(), m_chunksPerRow);
+          unsigned cymin = toChunk(bounds.top, map.getTileHeight(), m_chunksPerColumn);
+          unsigned cymax = toChunk(bounds.bottom, map.getTileHeight(), m_chunksPerColumn);
+
+          for (unsigned cy = cymin; cy <= cymax; ++cy) {
+            for (unsigned cx = cxmin; cx <= cxmax; ++cx) {
+              refs[cy * m_chunksPerRow + cx].push_back(index);
+            }
+          }
+        }
+
+        data.chunks.first = m_chunks.size();
+        data.chunks.count = refs.size();
+
+        for (auto& chunkRefs : refs) {
+          compiled::Chunk chunk;
+          chunk.cells = 0;
+          chunk.objects.first = m_objectRefs.size();
+          chunk.objects.count = chunkRefs.size();
+          m_chunks.push_back(chunk);
+          m_objectRefs.insert(m_objectRefs.end(), chunkRefs.begin(), chunkRefs.end());
+        }
+
+        m_layers.push_back(data);
+      }
+
+      virtual void visitImageLayer(const Map& map, const ImageLayer& layer) override {
+        compiled::Layer data = makeLayer(layer, compiled::IMAGE_LAYER);
+        data.image = addImage(layer.getImage());
+        m_layers.push_back(data);
+      }
+
+      virtual void visitGroupLayer(const Map& map, const GroupLayer& layer) override {
+        uint32_t index = m_layers.size();
+        m_layers.push_back(makeLayer(layer, compiled::GROUP_LAYER));
+
+        uint32_t parent = m_parent;
+        m_parent = index + 1;
+
+        for (auto child : layer.getLayers()) {
+          child->accept(map, *this);
+        }
+
+        m_parent = parent;
+
+        // the layers inside the group follow the group
+        m_layers[index].content.first = index + 1;
+        m_layers[index].content.count = m_layers.size() - index - 1;
+      }
+
+      void addObject(const Object& object) {
+        m_objectKinds.push_back(object.getKind());
+        m_objectVisible.push_back(object.isVisible() ? 1 : 0);
+        m_objectIds.push_back(object.getId());
+        m_objectNames.push_back(intern(object.getName()));
+        m_objectTypes.push_back(intern(object.getType()));
+        m_objectOrigins.push_back(object.getOrigin());
+        m_objectRotations.push_back(object.getRotation());
+
+        Size size = { 0, 0 };
+        uint32_t gid = 0;
+        compiled::Range points = { static_cast<uint32_t>(m_points.size()), 0 };
+
+        int x = object.getOrigin().x;
+        int y = object.getOrigin().y;
+        compiled::Bounds bounds = { x, y, x, y };
+
+        if (object.isRectangle() || object.isEllipse()) {
+          auto boxed = static_cast<const Boxed *>(&object);
+          size.width = boxed->getWidth();
+          size.height = boxed->getHeight();
+          bounds.right += size.width;
+          bounds.bottom += size.height;
+        } else if (object.isTile()) {
+          auto tile = static_cast<const TileObject *>(&object);
+          gid = Cell(tile->getGID(), tile->isHorizontallyFlipped(), tile->isVerticallyFlipped(), tile->isDiagonallyFlipped()).getRawGID();
+
+          // the origin of a tile object is its bottom left corner
+          auto tileset = m_map.getTileSetFromGID(tile->getGID());
+          bounds.right += tileset ? tileset->getTileWidth() : m_map.getTileWidth();
+          bounds.top -= tileset ? tileset->getTileHeight() : m_map.getTileHeight();
+        } else if (object.isChain()) {
+          auto chain = static_cast<const Chain *>(&object);
+          m_points.insert(m_points.end(), chain->begin(), chain->end());
+          points.count = m_points.size() - points.first;
+
+          for (auto point : *chain) {
+            bounds.left = std::min(bounds.left, x + point.x);
+            bounds.top = std::min(bounds.top, y + point.y);
+            bounds.right = std::max(bounds.right, x + point.x);
+            bounds.bottom = std::max(bounds.bottom, y + point.y);
+          }
+        }
+
+        if (object.getRotation() != 0.0) {
+          // the object rotates around its origin, take the farthest corner
+          int dx = std::max(x - bounds.left, bounds.right - x);
+          int dy = std::max(y - bounds.top, bounds.bottom - y);
+          int radius = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(dx) * dx + static_cast<double>(dy) * dy)));
+          bounds = { x - radius, y - radius, x + radius, y + radius };
+        }
+
+        m_objectBounds.push_back(bounds);
+
+        m_objectSizes.push_back(size);
+        m_objectGids.push_back(gid);
+        m_objectPoints.push_back(points);
+        m_objectProperties.push_back(addProperties(object));
+      }
+
+      std::vector<char> compile() {
+        const Map& map = m_map;
+
+        compiled::Header header;
+        std::memset(&header, 0, sizeof header);
+
+        std::memcpy(header.magic, compiled::Magic, sizeof compiled::Magic);
+        header.version = compiled::Version;
+        header.byteOrder = compiled::ByteOrderMark;
+
+        header.mapVersion = intern(map.getVersion());
+        header.orientation = static_cast<uint32_t>(map.getOrientation());
+        header.width = map.getWidth();
+        header.height = map.getHeight();
+        header.tilewidth = map.getTileWidth();
+        header.tileheight = map.getTileHeight();
+        header.backgroundColor = intern(map.getBackgroundColor());
+        header.renderOrder = static_cast<uint32_t>(map.getRenderOrder());
+        header.hexSideLength = map.getHexSideLength();
+        header.staggerAxis = static_cast<uint32_t>(map.getStaggerAxis());
+        header.staggerIndex = static_cast<uint32_t>(map.getStaggerIndex());
+        header.nextObjectId = map.getNextObjectId();
+        header.properties = addProperties(map);
+        header.chunkSize = m_chunkSize;
+
+        for (auto tileset : map.getTileSets()) {
+          addTileSet(*tileset);
+        }
+
+        map.visitLayers(*this);
+
+        std::vector<char> out(sizeof header);
+        place(out, header, compiled::STRING_OFFSETS, m_stringOffsets);
+        place(out, header, compiled::STRING_DATA, m_stringData);
+        place(out, header, compiled::PROPERTIES, m_properties);
+        place(out, header, compiled::IMAGES, m_images);
+        place(out, header, compiled::TERRAINS, m_terrains);
+        place(out, header, compiled::TILES, m_tiles);
+        place(out, header, compiled::TILESETS, m_tilesets);
+        place(out, header, compiled::LAYERS, m_layers);
+        place(out, header, compiled::CHUNKS, m_chunks);
+        place(out, header, compiled::CELLS, m_cells);
+        place(out, header, compiled::OBJECT_KINDS, m_objectKinds);
+        place(out, header, compiled::OBJECT_VISIBLE, m_objectVisible);
+        place(out, header, compiled::OBJECT_IDS, m_objectIds);
+        place(out, header, compiled::OBJECT_NAMES, m_objectNames);
+        place(out, header, compiled::OBJECT_TYPES, m_objectTypes);
+        place(out, header, compiled::OBJECT_ORIGINS, m_objectOrigins);
+        place(out, header, compiled::OBJECT_ROTATIONS, m_objectRotations);
+        place(out, header, compiled::OBJECT_SIZES, m_objectSizes);
+        place(out, header, compiled::OBJECT_GIDS, m_objectGids);
+        place(out, header, compiled::OBJECT_POINTS, m_objectPoints);
+        place(out, header, compiled::OBJECT_PROPERTIES, m_objectProperties);
+        place(out, header, compiled::POINTS, m_points);
+        place(out, header, compiled::OBJECT_BOUNDS, m_objectBounds);
+        place(out, header, compiled::OBJECT_REFS, m_objectRefs);
+        place(out, header, compiled::FRAMES, m_frames);
+        place(out, header, compiled::TILE_LAYERS, m_tileLayers);
+        place(out, header, compiled::IMAGE_DATA, m_imageData);
+
+        out.resize(align(out.size()));
+        header.size = out.size();
+        std::memcpy(out.data(), &header, sizeof header);
+        return out;
+      }
+
+    private:
+      unsigned toChunk(int coord, unsigned tileSize, unsigned count) const {
+        if (coord < 0 || tileSize == 0 || count == 0) {
+          return 0;
+        }
+
+        return std::min(static_cast<unsigned>(coord) / tileSize / m_chunkSize, count - 1);
+      }
+
+      static std::size_t align(std::size_t offset) {
+        return (offset + 7) / 8 * 8;
+      }
+
+      template<typename T>
+      static void place(std::vector<char>& out, compiled::Header& header, compiled::SectionId id, const std::vector<T>& elements) {
+        std::size_t offset = align(out.size());
+        header.sections[id].offset = offset;
+        header.sections[id].count = elements.size();
+
+        out.resize(offset + elements.size() * sizeof(T));
+
+        if (!elements.empty()) {
+          std::memcpy(out.data() + offset, elements.data(), elements.size() * sizeof(T));
+        }
+      }
+
+    private:
+      const Map& m_map;
+      unsigned m_chunkSize;
+      unsigned m_chunksPerRow;
+      unsigned m_chunksPerColumn;
+      uint32_t m_parent = compiled::None;
+
+      std::unordered_map<std::string, uint32_t> m_strings;
+      std::vector<uint32_t> m_stringOffsets;
+      std::vector<char> m_stringData;
+
+      std::vector<compiled::Property> m_properties;
+      std::vector<compiled::Image> m_images;
+      std::vector<uint8_t> m_imageData;
+      std::vector<compiled::Terrain> m_terrains;
+      std::vector<compiled::Tile> m_tiles;
+      std::vector<compiled::Frame> m_frames;
+      std::vector<compiled::Layer> m_tileLayers;
+      std::vector<compiled::TileSet> m_tilesets;
+      std::vector<compiled::Layer> m_layers;
+      std::vector<compiled::Chunk> m_chunks;
+      std::vector<uint32_t> m_cells;
+
+      std::vector<uint8_t> m_objectKinds;
+      std::vector<uint8_t> m_objectVisible;
+      std::vector<uint32_t> m_objectIds;
+      std::vector<uint32_t> m_objectNames;
+      std::vector<uint32_t> m_objectTypes;
+      std::vector<Vector2u> m_objectOrigins;
+      std::vector<double> m_objectRotations;
+      std::vector<Size> m_objectSizes;
+      std::vector<uint32_t> m_objectGids;
+      std::vector<compiled::Range> m_objectPoints;
+      std::vector<compiled::Range> m_objectProperties;
+      std::vector<Vector2i> m_points;
+      std::vector<compiled::Bounds> m_objectBounds;
+      std::vector<uint32_t> m_objectRefs;
+    };
+
+    void copyProperties(const CompiledMap& map, const CompiledComponent& compiled, Component& component) {
+      for (auto& property : compiled.getProperties()) {
+        component.addProperty(map.getString(property.key), map.getString(property.value));
+      }
+    }
+
+    std::unique_ptr<Image> makeImage(const CompiledImage& image) {
+      auto result = makeUnique<Image>(image.getFormat(), image.getSource(), image.getTransparent(), image.getWidth(), image.getHeight());
+
+      if (image.hasData()) {
+        result->setData(std::vector<uint8_t>(image.getData(), image.getData() + image.getDataSize()));
+      }
+
+      return result;
+    }
+
+    void copyLayer(const CompiledMap& map, const CompiledLayer& compiledLayer, Layer& layer) {
+      layer.setOffset(compiledLayer.getOffset().x, compiledLayer.getOffset().y);
+      copyProperties(map, compiledLayer, layer);
+    }
+
+    std::unique_ptr<ObjectLayer> rebuildObjectLayer(const CompiledMap& map, const CompiledLayer& compiledLayer) {
+      auto layer = makeUnique<ObjectLayer>(compiledLayer.getName(), compiledLayer.getOpacity(), compiledLayer.isVisible(),
+          compiledLayer.getColor(), compiledLayer.getDrawOrder());
+
+      for (std::size_t j = 0; j < compiledLayer.getObjectCount(); ++j) {
+        CompiledObject compiledObject = compiledLayer.getObject(j);
+        auto points = compiledObject.getPoints();
+        auto object = makeObject(compiledObject.getKind(), compiledObject.getId(), compiledObject.getName(), compiledObject.getType(),
+            compiledObject.getOrigin(), compiledObject.getRotation(), compiledObject.isVisible(), compiledObject.getSize(),
+            compiledObject.getCell().getRawGID(), std::vector<Vector2i>(points.begin(), points.end()));
+
+        if (!object) {
+          std::clog << "Error! Unknown kind of compiled object: " << compiledObject.getKind() << '\n';
+          continue;
+        }
+
+        copyProperties(map, compiledObject, *object);
+        layer->addObject(std::move(object));
+      }
+
+      return layer;
+    }
+
+    // rebuilds the layer at index and the layers inside it, index is moved after them
+    std::unique_ptr<Layer> rebuildLayer(const CompiledMap& map, std::size_t& index) {
+      CompiledLayer compiledLayer = map.getLayer(index++);
+      std::unique_ptr<Layer> result;
+
+      if (compiledLayer.isTileLayer()) {
+        auto layer = makeUnique<TileLayer>(compiledLayer.getName(), compiledLayer.getOpacity(), compiledLayer.isVisible());
+
+        for (unsigned y = 0; y < map.getHeight(); ++y) {
+          for (unsigned x = 0; x < map.getWidth(); ++x) {
+            layer->addCell(compiledLayer.getCell(x, y));
+          }
+        }
+
+        result = std::move(layer);
+      } else if (compiledLayer.isObjectLayer()) {
+        result = rebuildObjectLayer(map, compiledLayer);
+      } else if (compiledLayer.isImageLayer()) {
+        auto layer = makeUnique<ImageLayer>(compiledLayer.getName(), compiledLayer.getOpacity(), compiledLayer.isVisible());
+
+        if (compiledLayer.hasImage()) {
+          layer->setImage(makeImage(compiledLayer.getImage()));
+        }
+
+        result = std::move(layer);
+      } else if (compiledLayer.isGroupLayer()) {
+        auto layer = makeUnique<GroupLayer>(compiledLayer.getName(), compiledLayer.getOpacity(), compiledLayer.isVisible());
+        std::size_t end = index + compiledLayer.getDescendantCount();
+
+        while (index < end) {
+          auto child = rebuildLayer(map, index);
+
+          if (child) {
+            layer->addLayer(std::move(child));
+          }
+        }
+
+        result = std::move(layer);
+      } else {
+        std::clog << "Error! Unknown kind of compiled layer: " << compiledLayer.getData().kind << '\n';
+        return nullptr;
+      }
+
+      copyLayer(map, compiledLayer, *result);
+      return result;
+    }
+
+  }
+
+  std::unique_ptr<Object> makeObject(unsigned kind, unsigned id, const std::string& name, const std::string& type,
+      const Vector2u& origin, double rotation, bool visible, const Size& size, unsigned raw, std::vector<Vector2i> points) {
+    switch (kind) {
+      case Object::RECTANGLE:
+        return makeUnique<Rectangle>(id, name, type, origin, rotation, visible, size.width, size.height);
+
+      case Object::ELLIPSE:
+        return makeUnique<Ellipse>(id, name, type, origin, rotation, visible, size.width, size.height);
+
+      case Object::POLYLINE:
+      case Object::POLYGON: {
+        std::unique_ptr<Chain> chain;
+
+        if (kind == Object::POLYLINE) {
+          chain = makeUnique<Polyline>(id, name, type, origin, rotation, visible);
+        } else {
+          chain = makeUnique<Polygon>(id, name, type, origin, rotation, visible);
+        }
+
+        chain->setPoints(std::move(points));
+        return std::move(chain);
+      }
+
+      case Object::TILE: {
+        Cell cell = Cell::fromRawGID(raw);
+        return makeUnique<TileObject>(id, name, type, origin, rotation, visible, cell.getGID(),
+            cell.isHorizontallyFlipped(), cell.isVerticallyFlipped(), cell.isDiagonallyFlipped());
+      }
+
+      default:
+        break;
+    }
+
+    return nullptr;
+  }
+
+  std::unique_ptr<Object> cloneObject(const Object& object) {
+    Size size = { 0, 0 };
+    unsigned raw = 0;
+    std::vector<Vector2i> points;
+
+    if (object.isRectangle() || object.isEllipse()) {
+      auto boxed = static_cast<const Boxed *>(&object);
+      size.width = boxed->getWidth();
+      size.height = boxed->getHeight();
+    } else if (object.isTile()) {
+      auto tile = static_cast<const TileObject *>(&object);
+      raw = Cell(tile->getGID(), tile->isHorizontallyFlipped(), tile->isVerticallyFlipped(), tile->isDiagonallyFlipped()).getRawGID();
+    }
+
+    auto clone = makeObject(object.getKind(), object.getId(), object.getName(), object.getType(),
+        object.getOrigin(), object.getRotation(), object.isVisible(), size, raw, std::move(points));
+
+    if (clone) {
+      // the points are immutable, the clone shares them
+      if (object.isChain()) {
+        static_cast<Chain *>(clone.get())->sharePoints(*static_cast<const Chain *>(&object));
+      }
+
+      clone->setTemplate(object.getTemplate());
+
+      for (auto& property : object.getProperties()) {
+        clone->addProperty(property.first, property.second);
+      }
+    }
+
+    return clone;
+  }
+
+  std::unique_ptr<Image> copyImage(const Image *image) {
+    if (image == nullptr) {
+      return nullptr;
+    }
+
+    auto copy = makeUnique<Image>(image->getFormat(), image->getSource(), image->getTransparent(), image->getWidth(), image->getHeight());
+
+    if (image->hasData()) {
+      copy->setData(std::vector<uint8_t>(image->getData(), image->getData() + image->getDataSize()));
+    }
+
+    return copy;
+  }
+
+  std::unique_ptr<TileSet> copyTileSet(const TileSet& tileset, unsigned firstgid) {
+    auto copy = makeUnique<TileSet>(firstgid, tileset.getName(), tileset.getTileWidth(), tileset.getTileHeight(),
+        tileset.getSpacing(), tileset.getMargin(), tileset.getTileCount());
+    copy->setOffset(tileset.getOffsetX(), tileset.getOffsetY());
+    copy->setImage(copyImage(tileset.getImage()));
+
+    for (auto& property : tileset.getProperties()) {
+      copy->addProperty(property.first, property.second);
+    }
+
+    for (auto terrain : tileset.getTerrains()) {
+      auto terrainCopy = makeUnique<Terrain>(terrain->getName(), terrain->getTile());
+
+      for (auto& property : terrain->getProperties()) {
+        terrainCopy->addProperty(property.first, property.second);
+      }
+
+      copy->addTerrain(std::move(terrainCopy));
+    }
+
+    for (auto tile : tileset) {
+      auto tileCopy = makeUnique<Tile>(tile->getId(), tile->getTerrain(), tile->getProbability());
+      tileCopy->setImage(copyImage(tile->getImage()));
+
+      for (auto& property : tile->getProperties()) {
+        tileCopy->addProperty(property.first, property.second);
+      }
+
+      if (tile->hasAnimation()) {
+        tileCopy->setAnimation(tile->getAnimation());
+      }
+
+      if (tile->hasObjects()) {
+        const ObjectLayer& objects = *tile->getObjects();
+        auto objectsCopy = makeUnique<ObjectLayer>(objects.getName(), objects.getOpacity(), objects.isVisible(), objects.getColor(), objects.getDrawOrder());
+        objectsCopy->setOffset(objects.getOffset().x, objects.getOffset().y);
+
+        for (auto& property : objects.getProperties()) {
+          objectsCopy->addProperty(property.first, property.second);
+        }
+
+        for (auto object : objects) {
+          objectsCopy->addObject(cloneObject(*object));
+        }
+
+        tileCopy->setObjects(std::move(objectsCopy));
+      }
+
+      copy->addTile(std::move(tileCopy));
+    }
+
+    return copy;
+  }
+
+  std::vector<char> CompiledMap::compile(const Map& map, unsigned chunkSize) {
+    assert(chunkSize > 0);
+    Compiler compiler(map, chunkSize);
+    return compiler.compile();
+  }
+
+  std::unique_ptr<Map> CompiledMap::toMap() const {
+    auto map = makeUnique<Map>(getVersion(), getOrientation(), getWidth(), getHeight(), getTileWidth(), getTileHeight(),
+        getBackgroundColor(), getRenderOrder(), m_header->hexSideLength,
+        static_cast<StaggerAxis>(m_header->staggerAxis), static_cast<StaggerIndex>(m_header->staggerIndex), getNextObjectId());
+
+    copyProperties(*this, *this, *map);
+
+    for (std::size_t i = 0; i < getTileSetCount(); ++i) {
+      CompiledTileSet compiledTileSet = getTileSet(i);
+      const compiled::TileSet& data = compiledTileSet.getData();
+
+      auto tileset = makeUnique<TileSet>(data.firstgid, compiledTileSet.getName(), data.tilewidth, data.tileheight,
+          data.spacing, data.margin, data.tilecount);
+      tileset->setOffset(data.offsetX, data.offsetY);
+      copyProperties(*this, compiledTileSet, *tileset);
+
+      if (compiledTileSet.hasImage()) {
+        tileset->setImage(makeImage(compiledTileSet.getImage()));
+      }
+
+      for (std::size_t j = 0; j < compiledTileSet.getTerrainCount(); ++j) {
+        CompiledTerrain compiledTerrain = compiledTileSet.getTerrain(j);
+        auto terrain = makeUnique<Terrain>(compiledTerrain.getName(), compiledTerrain.getTile());
+        copyProperties(*this, compiledTerrain, *terrain);
+        tileset->addTerrain(std::move(terrain));
+      }
+
+      for (std::size_t j = 0; j < compiledTileSet.getTileInfoCount(); ++j) {
+        CompiledTile compiledTile = compiledTileSet.getTileInfo(j);
+        std::array<unsigned, 4> terrain = { { compiledTile.getTerrain(0), compiledTile.getTerrain(1), compiledTile.getTerrain(2), compiledTile.getTerrain(3) } };
+        auto tile = makeUnique<Tile>(compiledTile.getId(), terrain, compiledTile.getProbability());
+        copyProperties(*this, compiledTile, *tile);
+
+        if (compiledTile.hasImage()) {
+          tile->setImage(makeImage(compiledTile.getImage()));
+        }
+
+        if (compiledTile.hasAnimation()) {
+          std::vector<Frame> frames;
+
+          for (auto& frame : compiledTile.getAnimation()) {
+            frames.push_back({ frame.tileId, frame.duration });
+          }
+
+          tile->setAnimation(std::move(frames));
+        }
+
+        if (compiledTile.hasObjects()) {
+          CompiledLayer compiledObjects = compiledTile.getObjects();
+          auto objects = rebuildObjectLayer(*this, compiledObjects);
+          copyLayer(*this, compiledObjects, *objects);
+          tile->setObjects(std::move(objects));
+        }
+
+        tileset->addTile(std::move(tile));
+      }
+
+      map->addTileSet(std::move(tileset));
+    }
+
+    std::size_t index = 0;
+
+    while (index < getLayerCount()) {
+      auto layer = rebuildLayer(*this, index);
+
+      if (layer) {
+        map->addLayer(std::move(layer));
+      }
+    }
+
+    return map;
+  }
+
+  bool Map::saveCompiled(const fs::path& filename) const {
+    std::vector<char> data = CompiledMap::compile(*this);
+
+    std::ofstream out(filename.string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    out.write(data.data(), data.size());
+
+    if (!out) {
+      std::clog << "Error! Unable to write the compiled map: " << filename << '\n';
+      return false;
+    }
+
+    return true;
+  }
+
+  std::unique_ptr<CompiledMap> Map::openCompiled(const fs::path& filename) {
+    return openCompiled(filename, FileSystem::getDefault());
+  }
+
+  std::unique_ptr<CompiledMap> Map::openCompiled(const fs::path& filename, FileSystem& filesystem) {
+    std::shared_ptr<File> file(filesystem.open(filename));
+
+    if (!file) {
+      std::clog << "Error! Unknown compiled map: " << filename << '\n';
+      return nullptr;
+    }
+
+    const char *data = file->map();
+
+    if (data == nullptr) {
+      std::clog << "Error! Unable to map the compiled map: " << filename << '\n';
+      return nullptr;
+    }
+
+    auto map = CompiledMap::fromMemory(data, file->getSize(), file);
+
+    if (!map) {
+      std::clog << "Error! Invalid compiled map: " << filename << '\n';
+      return nullptr;
+    }
+
+    return map;
+  }
+
+}
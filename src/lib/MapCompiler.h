@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_MAP_COMPILER_H
+#define TMX_MAP_COMPILER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <tmx/CompiledMap.h>
+#include <tmx/Geometry.h>
+
+namespace tmx {
+  class Image;
+  class Object;
+  class TileSet;
+
+  // checks the magic, the byte order, the version and the chunk size of a compiled map
+  bool isValidHeader(const compiled::Header& header);
+
+  // creates an object from the fields of a compiled object, returns nullptr if the kind is unknown
+  std::unique_ptr<Object> makeObject(unsigned kind, unsigned id, const std::string& name, const std::string& type,
+      const Vector2u& origin, double rotation, bool visible, const Size& size, unsigned raw, std::vector<Vector2i> points);
+
+  // creates a copy of an object, with its properties
+  std::unique_ptr<Object> cloneObject(const Object& object);
+
+  // creates a copy of an image, with its data, returns nullptr if there is no image
+  std::unique_ptr<Image> copyImage(const Image *image);
+
+  // creates a copy of a tileset with another first global id
+  std::unique_ptr<TileSet> copyTileSet(const TileSet& tileset, unsigned firstgid);
+
+}
+
+#endif // TMX_MAP_COMPILER_H
@@ -0,0 +1,877 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/MapDiff.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+#include <tmx/GroupLayer.h>
+#include <tmx/ImageLayer.h>
+#include <tmx/Object.h>
+#include <tmx/ObjectLayer.h>
+#include <tmx/ObjectTemplate.h>
+#include <tmx/TileLayer.h>
+#include <tmx/TileSet.h>
+
+#include "MapCompiler.h"
+
+namespace tmx {
+
+  namespace {
+
+    const char PatchMagic[4] = { 'T', 'M', 'X', 'P' };
+    const uint8_t PatchVersion = 4;
+
+    // the number of cells compared at once before looking for the changed cells
+    const std::size_t BlockSize = 64;
+
+    // unchanged cells between two runs that are merged with the runs, as a run header costs about as much
+    const std::size_t MergeGap = 2;
+
+    enum PropertyOp : uint8_t {
+      PROPERTY_REMOVE = 0,
+      PROPERTY_SET = 1,
+    };
+
+    enum LayerKind {
+      UNKNOWN_LAYER,
+      TILE_LAYER,
+      OBJECT_LAYER,
+      IMAGE_LAYER,
+      GROUP_LAYER,
+    };
+
+    LayerKind getLayerKind(const Layer& layer) {
+      if (dynamic_cast<const TileLayer *>(&layer) != nullptr) {
+        return TILE_LAYER;
+      }
+
+      if (dynamic_cast<const ObjectLayer *>(&layer) != nullptr) {
+        return OBJECT_LAYER;
+      }
+
+      if (dynamic_cast<const ImageLayer *>(&layer) != nullptr) {
+        return IMAGE_LAYER;
+      }
+
+      if (dynamic_cast<const GroupLayer *>(&layer) != nullptr) {
+        return GROUP_LAYER;
+      }
+
+      return UNKNOWN_LAYER;
+    }
+
+    /*
+     * encoding
+     */
+
+    class PatchWriter {
+    public:
+      explicit PatchWriter(std::vector<char>& data)
+      : m_data(data)
+      {
+      }
+
+      void writeBytes(const char *bytes, std::size_t size) {
+        m_data.insert(m_data.end(), bytes, bytes + size);
+      }
+
+      void writeByte(uint8_t value) {
+        m_data.push_back(static_cast<char>(value));
+      }
+
+      void writeVarint(uint64_t value) {
+        while (value >= 0x80) {
+          writeByte(static_cast<uint8_t>(value | 0x80));
+          value >>= 7;
+        }
+
+        writeByte(static_cast<uint8_t>(value));
+      }
+
+      void writeSigned(int64_t value) {
+        writeVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+      }
+
+      void writeDouble(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+
+        for (int i = 0; i < 8; ++i) {
+          writeByte(static_cast<uint8_t>(bits >> (8 * i)));
+        }
+      }
+
+      void writeString(const std::string& value) {
+        writeVarint(value.size());
+        writeBytes(value.data(), value.size());
+      }
+
+    private:
+      std::vector<char>& m_data;
+    };
+
+    class PatchReader {
+    public:
+      PatchReader(const char *data, std::size_t size)
+      : m_current(data), m_end(data + size), m_ok(true)
+      {
+      }
+
+      bool isOk() const {
+        return m_ok;
+      }
+
+      bool isAtEnd() const {
+        return m_current == m_end;
+      }
+
+      bool readBytes(char *bytes, std::size_t size) {
+        if (!m_ok || static_cast<std::size_t>(m_end - m_current) < size) {
+          m_ok = false;
+          return false;
+        }
+
+        std::memcpy(bytes, m_current, size);
+        m_current += size;
+        return true;
+      }
+
+      uint8_t readByte() {
+        char byte = 0;
+        readBytes(&byte, 1);
+        return static_cast<uint8_t>(byte);
+      }
+
+      uint64_t readVarint() {
+        uint64_t value = 0;
+
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+          uint8_t byte = readByte();
+
+          if (!m_ok) {
+            return 0;
+          }
+
+          value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+          if ((byte & 0x80) == 0) {
+            return value;
+          }
+        }
+
+        m_ok = false;
+        return 0;
+      }
+
+      unsigned readUnsigned() {
+        uint64_t value = readVarint();
+
+        if (value > UINT32_MAX) {
+          m_ok = false;
+          return 0;
+        }
+
+        return static_cast<unsigned>(value);
+      }
+
+      int64_t readSigned() {
+        uint64_t value = readVarint();
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+      }
+
+      double readDouble() {
+        uint64_t bits = 0;
+
+        for (int i = 0; i < 8; ++i) {
+          bits |= static_cast<uint64_t>(readByte()) << (8 * i);
+        }
+
+        double value;
+        std::memcpy(&value, &bits, sizeof value);
+        return value;
+      }
+
+      std::string readString() {
+        uint64_t size = readVarint();
+
+        if (!m_ok || size > static_cast<uint64_t>(m_end - m_current)) {
+          m_ok = false;
+          return std::string();
+        }
+
+        std::string value(m_current, static_cast<std::size_t>(size));
+        m_current += size;
+        return value;
+      }
+
+      // the number of elements of a list, each element taking at least one byte
+      std::size_t readCount() {
+        uint64_t count = readVarint();
+
+        if (!m_ok || count > static_cast<uint64_t>(m_end - m_current)) {
+          m_ok = false;
+          return 0;
+        }
+
+        return static_cast<std::size_t>(count);
+      }
+
+    private:
+      const char *m_current;
+      const char *m_end;
+      bool m_ok;
+    };
+
+    std::size_t writePropertyChanges(PatchWriter& writer, const Component& from, const Component& to) {
+      std::vector<std::pair<const std::string *, const std::string *>> changes;
+
+      auto& before = from.getProperties();
+      auto& after = to.getProperties();
+      auto it = before.begin();
+      auto jt = after.begin();
+
+      while (it != before.end() || jt != after.end()) {
+        if (jt == after.end() || (it != before.end() && it->first < jt->first)) {
+          changes.emplace_back(&it->first, nullptr);
+          ++it;
+        } else if (it == before.end() || jt->first < it->first) {
+          changes.emplace_back(&jt->first, &jt->second);
+          ++jt;
+        } else {
+          if (it->second != jt->second) {
+            changes.emplace_back(&jt->first, &jt->second);
+          }
+
+          ++it;
+          ++jt;
+        }
+      }
+
+      writer.writeVarint(changes.size());
+
+      for (auto& change : changes) {
+        writer.writeByte(change.second ? PROPERTY_SET : PROPERTY_REMOVE);
+        writer.writeString(*change.first);
+
+        if (change.second) {
+          writer.writeString(*change.second);
+        }
+      }
+
+      return changes.size();
+    }
+
+    void writeObject(PatchWriter& writer, const Object& object) {
+      writer.writeVarint(object.getKind());
+      writer.writeVarint(object.getId());
+      writer.writeString(object.getName());
+      writer.writeString(object.getType());
+      writer.writeVarint(object.getOrigin().x);
+      writer.writeVarint(object.getOrigin().y);
+      writer.writeDouble(object.getRotation());
+      writer.writeByte(object.isVisible() ? 1 : 0);
+
+      // an instance is rebuilt from its template, that gives the properties and the points it does not override
+      auto& objectTemplate = object.getTemplate();
+      writer.writeString(objectTemplate ? objectTemplate->getSource().string() : std::string());
+
+      if (object.isRectangle() || object.isEllipse()) {
+        auto boxed = static_cast<const Boxed *>(&object);
+        writer.writeVarint(boxed->getWidth());
+        writer.writeVarint(boxed->getHeight());
+      } else if (object.isTile()) {
+        auto tile = static_cast<const TileObject *>(&object);
+        writer.writeVarint(Cell(tile->getGID(), tile->isHorizontallyFlipped(), tile->isVerticallyFlipped(), tile->isDiagonallyFlipped()).getRawGID());
+      } else if (object.isChain()) {
+        auto chain = static_cast<const Chain *>(&object);
+        auto base = objectTemplate ? &objectTemplate->getObject() : nullptr;
+        bool shared = base != nullptr && base->isChain() && chain->sharesPoints(*static_cast<const Chain *>(base));
+        writer.writeByte(shared ? 1 : 0);
+
+        if (!shared) {
+          writer.writeVarint(std::distance(chain->begin(), chain->end()));
+
+          for (auto point : *chain) {
+            writer.writeSigned(point.x);
+            writer.writeSigned(point.y);
+          }
+        }
+      }
+
+      auto& properties = object.getProperties();
+      writer.writeVarint(properties.size());
+
+      for (auto& property : properties) {
+        writer.writeString(property.first);
+        writer.writeString(property.second);
+      }
+    }
+
+    // written without early exit so that the compiler can vectorize it
+    bool isSameBlock(const Cell *lhs, const Cell *rhs, std::size_t count) {
+      unsigned difference = 0;
+
+      for (std::size_t i = 0; i < count; ++i) {
+        difference |= (lhs[i].getGID() ^ rhs[i].getGID())
+            | static_cast<unsigned>(lhs[i].isHorizontallyFlipped() != rhs[i].isHorizontallyFlipped())
+            | static_cast<unsigned>(lhs[i].isVerticallyFlipped() != rhs[i].isVerticallyFlipped())
+            | static_cast<unsigned>(lhs[i].isDiagonallyFlipped() != rhs[i].isDiagonallyFlipped());
+      }
+
+      return difference == 0;
+    }
+
+    std::size_t writeCellRuns(PatchWriter& writer, const TileLayer& from, const TileLayer& to) {
+      struct Run {
+        std::size_t first;
+        std::size_t last;
+      };
+
+      std::vector<Run> runs;
+      std::size_t count = to.getCellCount();
+      const Cell *lhs = count > 0 ? &from.getCell(0) : nullptr;
+      const Cell *rhs = count > 0 ? &to.getCell(0) : nullptr;
+
+      for (std::size_t block = 0; block < count; block += BlockSize) {
+        std::size_t size = std::min(BlockSize, count - block);
+
+        if (isSameBlock(lhs + block, rhs + block, size)) {
+          continue;
+        }
+
+        for (std::size_t i = block; i < block + size; ++i) {
+          if (lhs[i].getRawGID() == rhs[i].getRawGID()) {
+            continue;
+          }
+
+          if (!runs.empty() && i - runs.back().last <= MergeGap + 1) {
+            runs.back().last = i;
+          } else {
+            runs.push_back({ i, i });
+          }
+        }
+      }
+
+      writer.writeVarint(runs.size());
+      std::size_t position = 0;
+
+      for (auto& run : runs) {
+        // the start is relative to the end of the previous run
+        writer.writeVarint(run.first - position);
+        writer.writeVarint(run.last - run.first + 1);
+
+        for (std::size_t i = run.first; i <= run.last; ++i) {
+          writer.writeVarint(rhs[i].getRawGID());
+        }
+
+        position = run.last + 1;
+      }
+
+      return runs.size();
+    }
+
+    // ObjectLayer::getObject() is a linear search
+    std::unordered_map<unsigned, const Object *> indexObjects(const ObjectLayer& layer) {
+      std::unordered_map<unsigned, const Object *> objects;
+
+      for (auto object : layer) {
+        objects.emplace(object->getId(), object);
+      }
+
+      return objects;
+    }
+
+    std::size_t writeObjectChanges(PatchWriter& writer, const ObjectLayer& from, const ObjectLayer& to) {
+      auto fromObjects = indexObjects(from);
+      auto toObjects = indexObjects(to);
+
+      std::vector<unsigned> removed;
+
+      for (auto object : from) {
+        if (toObjects.count(object->getId()) == 0) {
+          removed.push_back(object->getId());
+        }
+      }
+
+      writer.writeVarint(removed.size());
+
+      for (auto id : removed) {
+        writer.writeVarint(id);
+      }
+
+      std::vector<char> changes;
+      PatchWriter changesWriter(changes);
+      std::size_t changed = 0;
+
+      std::vector<char> before;
+      std::vector<char> after;
+
+      std::size_t index = 0;
+
+      for (auto object : to) {
+        std::size_t position = index++;
+        auto it = fromObjects.find(object->getId());
+        const Object *previous = it != fromObjects.end() ? it->second : nullptr;
+
+        after.clear();
+        PatchWriter afterWriter(after);
+        writeObject(afterWriter, *object);
+
+        if (previous != nullptr) {
+          before.clear();
+          PatchWriter beforeWriter(before);
+          writeObject(beforeWriter, *previous);
+
+          if (before == after) {
+            continue;
+          }
+        }
+
+        // a new object is inserted at its place in the draw order
+        changesWriter.writeVarint(position);
+        changesWriter.writeBytes(after.data(), after.size());
+        changed++;
+      }
+
+      writer.writeVarint(changed);
+      writer.writeBytes(changes.data(), changes.size());
+      return removed.size() + changed;
+    }
+
+    bool isSameStructure(const Map& from, const Map& to) {
+      if (from.getWidth() != to.getWidth() || from.getHeight() != to.getHeight()
+          || from.getOrientation() != to.getOrientation()
+          || from.getTileWidth() != to.getTileWidth() || from.getTileHeight() != to.getTileHeight()) {
+        return false;
+      }
+
+      auto fromTileSets = from.getTileSets();
+      auto toTileSets = to.getTileSets();
+
+      if (fromTileSets.size() != toTileSets.size()) {
+        return false;
+      }
+
+      for (auto it = fromTileSets.begin(), jt = toTileSets.begin(); it != fromTileSets.end(); ++it, ++jt) {
+        if ((*it)->getFirstGID() != (*jt)->getFirstGID() || (*it)->getName() != (*jt)->getName()) {
+          return false;
+        }
+      }
+
+      if (from.getLayerCount() != to.getLayerCount()) {
+        return false;
+      }
+
+      auto fromLayers = from.getAllLayers();
+      auto toLayers = to.getAllLayers();
+
+      if (fromLayers.size() != toLayers.size()) {
+        return false;
+      }
+
+      for (std::size_t i = 0; i < fromLayers.size(); ++i) {
+        const Layer& lhs = *fromLayers[i];
+        const Layer& rhs = *toLayers[i];
+        LayerKind kind = getLayerKind(lhs);
+
+        if (kind == UNKNOWN_LAYER || kind != getLayerKind(rhs) || lhs.getName() != rhs.getName()
+            || lhs.getOpacity() != rhs.getOpacity() || lhs.isVisible() != rhs.isVisible()
+            || lhs.getOffset().x != rhs.getOffset().x || lhs.getOffset().y != rhs.getOffset().y) {
+          return false;
+        }
+
+        if (kind == TILE_LAYER && static_cast<const TileLayer&>(lhs).getCellCount() != static_cast<const TileLayer&>(rhs).getCellCount()) {
+          return false;
+        }
+
+        if (kind == GROUP_LAYER && static_cast<const GroupLayer&>(lhs).getLayerCount() != static_cast<const GroupLayer&>(rhs).getLayerCount()) {
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    /*
+     * decoding
+     */
+
+    struct PropertyChange {
+      bool set;
+      std::string key;
+      std::string value;
+    };
+
+    struct CellRun {
+      std::size_t first;
+      std::vector<unsigned> cells;
+    };
+
+    struct ObjectChange {
+      std::size_t index;
+      std::unique_ptr<Object> object;
+    };
+
+    struct LayerPatch {
+      std::size_t index;
+      std::vector<PropertyChange> properties;
+      std::vector<CellRun> runs;
+      std::vector<unsigned> removed;
+      std::vector<ObjectChange> objects;
+    };
+
+    bool readPropertyChanges(PatchReader& reader, std::vector<PropertyChange>& changes) {
+      std::size_t count = reader.readCount();
+
+      for (std::size_t i = 0; i < count && reader.isOk(); ++i) {
+        PropertyChange change;
+        uint8_t op = reader.readByte();
+
+        if (op != PROPERTY_REMOVE && op != PROPERTY_SET) {
+          return false;
+        }
+
+        change.set = (op == PROPERTY_SET);
+        change.key = reader.readString();
+
+        if (change.set) {
+          change.value = reader.readString();
+        }
+
+        changes.push_back(std::move(change));
+      }
+
+      return reader.isOk();
+    }
+
+    std::unique_ptr<Object> readObject(PatchReader& reader, FileSystem& filesystem) {
+      unsigned kind = reader.readUnsigned();
+      unsigned id = reader.readUnsigned();
+      std::string name = reader.readString();
+      std::string type = reader.readString();
+      Vector2u origin;
+      origin.x = reader.readUnsigned();
+      origin.y = reader.readUnsigned();
+      double rotation = reader.readDouble();
+      bool visible = reader.readByte() != 0;
+      std::string source = reader.readString();
+
+      if (!reader.isOk()) {
+        return nullptr;
+      }
+
+      std::shared_ptr<const ObjectTemplate> objectTemplate;
+
+      if (!source.empty()) {
+        objectTemplate = ObjectTemplate::load(source, filesystem);
+
+        if (!objectTemplate) {
+          return nullptr;
+        }
+      }
+
+      Size size = { 0, 0 };
+      unsigned raw = 0;
+      std::vector<Vector2i> points;
+      bool shared = false;
+
+      switch (kind) {
+        case Object::RECTANGLE:
+        case Object::ELLIPSE:
+          size.width = reader.readUnsigned();
+          size.height = reader.readUnsigned();
+          break;
+
+        case Object::TILE:
+          raw = reader.readUnsigned();
+          break;
+
+        case Object::POLYLINE:
+        case Object::POLYGON: {
+          shared = reader.readByte() != 0;
+
+          if (shared) {
+            if (!objectTemplate || !objectTemplate->getObject().isChain()) {
+              return nullptr;
+            }
+
+            break;
+          }
+
+          std::size_t count = reader.readCount();
+
+          for (std::size_t i = 0; i < count && reader.isOk(); ++i) {
+            Vector2i point;
+            point.x = static_cast<int>(reader.readSigned());
+            point.y = static_cast<int>(reader.readSigned());
+            points.push_back(point);
+          }
+
+          break;
+        }
+
+        default:
+          return nullptr;
+      }
+
+      if (!reader.isOk()) {
+        return nullptr;
+      }
+
+      auto object = makeObject(kind, id, name, type, origin, rotation, visible, size, raw, std::move(points));
+
+      if (shared) {
+        static_cast<Chain *>(object.get())->sharePoints(static_cast<const Chain&>(objectTemplate->getObject()));
+      }
+
+      object->setTemplate(std::move(objectTemplate));
+      std::size_t count = reader.readCount();
+
+      for (std::size_t i = 0; i < count && reader.isOk(); ++i) {
+        std::string key = reader.readString();
+        std::string value = reader.readString();
+        object->addProperty(key, value);
+      }
+
+      if (!reader.isOk()) {
+        return nullptr;
+      }
+
+      return object;
+    }
+
+    bool readLayerPatch(PatchReader& reader, const std::vector<const Layer *>& layers, FileSystem& filesystem, LayerPatch& patch) {
+      patch.index = reader.readUnsigned();
+      unsigned kind = reader.readByte();
+
+      if (!reader.isOk() || patch.index >= layers.size()) {
+        return false;
+      }
+
+      const Layer *layer = layers[patch.index];
+
+      if (kind != getLayerKind(*layer) || !readPropertyChanges(reader, patch.properties)) {
+        return false;
+      }
+
+      if (kind == TILE_LAYER) {
+        std::size_t cellCount = static_cast<const TileLayer *>(layer)->getCellCount();
+        std::size_t count = reader.readCount();
+        std::size_t position = 0;
+
+        for (std::size_t i = 0; i < count && reader.isOk(); ++i) {
+          CellRun run;
+          run.first = position + reader.readVarint();
+          std::size_t size = reader.readCount();
+
+          if (!reader.isOk() || run.first > cellCount || size > cellCount - run.first) {
+            return false;
+          }
+
+          run.cells.reserve(size);
+
+          for (std::size_t j = 0; j < size; ++j) {
+            run.cells.push_back(reader.readUnsigned());
+          }
+
+          position = run.first + size;
+          patch.runs.push_back(std::move(run));
+        }
+      } else if (kind == OBJECT_LAYER) {
+        std::size_t count = reader.readCount();
+
+        for (std::size_t i = 0; i < count && reader.isOk(); ++i) {
+          patch.removed.push_back(reader.readUnsigned());
+        }
+
+        count = reader.readCount();
+
+        for (std::size_t i = 0; i < count && reader.isOk(); ++i) {
+          ObjectChange change;
+          change.index = reader.readVarint();
+          change.object = readObject(reader, filesystem);
+
+          if (!change.object) {
+            return false;
+          }
+
+          patch.objects.push_back(std::move(change));
+        }
+      }
+
+      return reader.isOk();
+    }
+
+    void applyPropertyChanges(Component& component, const std::vector<PropertyChange>& changes) {
+      for (auto& change : changes) {
+        if (change.set) {
+          component.setProperty(change.key, change.value);
+        } else {
+          component.removeProperty(change.key);
+        }
+      }
+    }
+
+  }
+
+  std::vector<char> diff(const Map& from, const Map& to) {
+    std::vector<char> patch;
+
+    if (!isSameStructure(from, to)) {
+      std::clog << "Error! The maps do not have the same structure, they can not be compared\n";
+      return patch;
+    }
+
+    PatchWriter writer(patch);
+    writer.writeBytes(PatchMagic, sizeof PatchMagic);
+    writer.writeByte(PatchVersion);
+    writer.writeVarint(to.getWidth());
+    writer.writeVarint(to.getHeight());
+    writer.writeVarint(to.getNextObjectId());
+    auto fromLayers = from.getAllLayers();
+    auto toLayers = to.getAllLayers();
+
+    writer.writeVarint(toLayers.size());
+    writePropertyChanges(writer, from, to);
+
+    std::vector<char> layers;
+    PatchWriter layersWriter(layers);
+    std::size_t changed = 0;
+    std::vector<char> layer;
+
+    for (std::size_t i = 0; i < toLayers.size(); ++i) {
+      const Layer& lhs = *fromLayers[i];
+      const Layer& rhs = *toLayers[i];
+      LayerKind kind = getLayerKind(rhs);
+
+      layer.clear();
+      PatchWriter layerWriter(layer);
+      layerWriter.writeVarint(i);
+      layerWriter.writeByte(kind);
+      std::size_t changes = writePropertyChanges(layerWriter, lhs, rhs);
+
+      switch (kind) {
+        case TILE_LAYER:
+          changes += writeCellRuns(layerWriter, static_cast<const TileLayer&>(lhs), static_cast<const TileLayer&>(rhs));
+          break;
+
+        case OBJECT_LAYER:
+          changes += writeObjectChanges(layerWriter, static_cast<const ObjectLayer&>(lhs), static_cast<const ObjectLayer&>(rhs));
+          break;
+
+        default:
+          break;
+      }
+
+      if (changes > 0) {
+        layersWriter.writeBytes(layer.data(), layer.size());
+        changed++;
+      }
+    }
+
+    writer.writeVarint(changed);
+    writer.writeBytes(layers.data(), layers.size());
+    return patch;
+  }
+
+  bool apply(Map& map, const char *data, std::size_t size, FileSystem& filesystem) {
+    PatchReader reader(data, size);
+
+    char magic[sizeof PatchMagic];
+
+    if (!reader.readBytes(magic, sizeof magic) || std::memcmp(magic, PatchMagic, sizeof PatchMagic) != 0 || reader.readByte() != PatchVersion) {
+      std::clog << "Error! Not a map patch\n";
+      return false;
+    }
+
+    unsigned width = reader.readUnsigned();
+    unsigned height = reader.readUnsigned();
+    unsigned nextObjectId = reader.readUnsigned();
+    std::size_t layerCount = reader.readVarint();
+    auto mapLayers = map.getAllLayers();
+    std::vector<const Layer *> constLayers(mapLayers.begin(), mapLayers.end());
+
+    if (!reader.isOk() || width != map.getWidth() || height != map.getHeight() || layerCount != mapLayers.size()) {
+      std::clog << "Error! The patch does not match the structure of the map\n";
+      return false;
+    }
+
+    std::vector<PropertyChange> properties;
+    std::vector<LayerPatch> layers;
+
+    bool ok = readPropertyChanges(reader, properties);
+    std::size_t count = reader.readCount();
+
+    for (std::size_t i = 0; i < count && ok; ++i) {
+      LayerPatch layer;
+      ok = readLayerPatch(reader, constLayers, filesystem, layer);
+      layers.push_back(std::move(layer));
+    }
+
+    if (!ok || !reader.isOk() || !reader.isAtEnd()) {
+      std::clog << "Error! Invalid map patch\n";
+      return false;
+    }
+
+    // the ids allocated for the new objects must not be allocated again
+    if (nextObjectId > map.getNextObjectId()) {
+      map.setNextObjectId(nextObjectId);
+    }
+
+    applyPropertyChanges(map, properties);
+
+    for (auto& patch : layers) {
+      Layer *layer = mapLayers[patch.index];
+      applyPropertyChanges(*layer, patch.properties);
+
+      if (!patch.runs.empty()) {
+        TileLayer *tileLayer = static_cast<TileLayer *>(layer);
+
+        for (auto& run : patch.runs) {
+          for (std::size_t i = 0; i < run.cells.size(); ++i) {
+            tileLayer->setCell(run.first + i, Cell::fromRawGID(run.cells[i]));
+          }
+        }
+      }
+
+      if (!patch.removed.empty() || !patch.objects.empty()) {
+        ObjectLayer *objectLayer = static_cast<ObjectLayer *>(layer);
+
+        for (auto id : patch.removed) {
+          objectLayer->removeObject(id);
+        }
+
+        // the objects are in the draw order of the modified map, so the places of the new objects are right
+        for (auto& change : patch.objects) {
+          if (objectLayer->getObject(change.object->getId()) != nullptr) {
+            objectLayer->replaceObject(std::move(change.object));
+          } else {
+            objectLayer->insertObject(change.index, std::move(change.object));
+          }
+        }
+      }
+    }
+
+    return true;
+  }
+
+}
@@ -0,0 +1,344 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/MapEditor.h>
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+#include <tmx/ObjectLayer.h>
+#include <tmx/TileLayer.h>
+
+namespace tmx {
+
+  namespace {
+
+    Layer *getLayer(const std::vector<Layer *>& layers, unsigned layer) {
+      return layer < layers.size() ? layers[layer] : nullptr;
+    }
+
+    TileLayer *getTileLayer(const std::vector<Layer *>& layers, unsigned layer) {
+      return dynamic_cast<TileLayer *>(getLayer(layers, layer));
+    }
+
+    ObjectLayer *getObjectLayer(const std::vector<Layer *>& layers, unsigned layer) {
+      return dynamic_cast<ObjectLayer *>(getLayer(layers, layer));
+    }
+
+  }
+
+  /*
+   * DirtySet
+   */
+
+  DirtySet::DirtySet(unsigned width, unsigned height, unsigned chunkSize)
+  : m_width(width)
+  , m_height(height)
+  , m_chunkSize(chunkSize > 0 ? chunkSize : compiled::DefaultChunkSize)
+  , m_chunkColumns((width + m_chunkSize - 1) / m_chunkSize)
+  , m_chunkRows((height + m_chunkSize - 1) / m_chunkSize)
+  {
+  }
+
+  Rect DirtySet::getChunkRect(Vector2u chunk) const noexcept {
+    Rect rect;
+    rect.x = chunk.x * m_chunkSize;
+    rect.y = chunk.y * m_chunkSize;
+    rect.width = std::min(m_chunkSize, m_width - rect.x);
+    rect.height = std::min(m_chunkSize, m_height - rect.y);
+    return rect;
+  }
+
+  bool DirtySet::isEmpty() const noexcept {
+    return m_chunks.empty() && m_objects.empty() && m_properties.empty() && m_layerProperties.empty();
+  }
+
+  void DirtySet::clear() {
+    m_chunks.clear();
+    m_objects.clear();
+    m_properties.clear();
+    m_layerProperties.clear();
+  }
+
+  void DirtySet::merge(const DirtySet& other) {
+    assert(m_width == other.m_width && m_height == other.m_height && m_chunkSize == other.m_chunkSize);
+
+    for (auto& chunks : other.m_chunks) {
+      auto& bits = m_chunks[chunks.first];
+
+      if (bits.empty()) {
+        bits = chunks.second;
+        continue;
+      }
+
+      for (std::size_t i = 0; i < bits.size(); ++i) {
+        bits[i] |= chunks.second[i];
+      }
+    }
+
+    m_objects.insert(other.m_objects.begin(), other.m_objects.end());
+    m_properties.insert(other.m_properties.begin(), other.m_properties.end());
+    m_layerProperties.insert(other.m_layerProperties.begin(), other.m_layerProperties.end());
+  }
+
+  void DirtySet::markCell(unsigned layer, unsigned x, unsigned y) {
+    assert(x < m_width && y < m_height);
+    markChunk(layer, { x / m_chunkSize, y / m_chunkSize });
+  }
+
+  void DirtySet::markChunk(unsigned layer, Vector2u chunk) {
+    assert(chunk.x < m_chunkColumns && chunk.y < m_chunkRows);
+    auto& bits = m_chunks[layer];
+
+    if (bits.empty()) {
+      bits.resize((m_chunkColumns * m_chunkRows + 63) / 64, 0);
+    }
+
+    std::size_t index = chunk.y * m_chunkColumns + chunk.x;
+    bits[index / 64] |= UINT64_C(1) << (index % 64);
+  }
+
+  void DirtySet::markObject(unsigned layer, unsigned id) {
+    m_objects.emplace(layer, id);
+  }
+
+  void DirtySet::markProperty(const std::string& key) {
+    m_properties.insert(key);
+  }
+
+  void DirtySet::markLayerProperty(unsigned layer, const std::string& key) {
+    m_layerProperties.emplace(layer, key);
+  }
+
+  bool DirtySet::isChunkDirty(unsigned layer, Vector2u chunk) const noexcept {
+    auto it = m_chunks.find(layer);
+
+    if (it == m_chunks.end() || chunk.x >= m_chunkColumns || chunk.y >= m_chunkRows) {
+      return false;
+    }
+
+    std::size_t index = chunk.y * m_chunkColumns + chunk.x;
+    return (it->second[index / 64] & (UINT64_C(1) << (index % 64))) != 0;
+  }
+
+  std::vector<unsigned> DirtySet::getDirtyLayers() const {
+    std::vector<unsigned> layers;
+
+    for (auto& chunks : m_chunks) {
+      layers.push_back(chunks.first);
+    }
+
+    return layers;
+  }
+
+  std::vector<Vector2u> DirtySet::getDirtyChunks(unsigned layer) const {
+    std::vector<Vector2u> chunks;
+    auto it = m_chunks.find(layer);
+
+    if (it == m_chunks.end()) {
+      return chunks;
+    }
+
+    const std::vector<uint64_t>& bits = it->second;
+
+    for (std::size_t word = 0; word < bits.size(); ++word) {
+      uint64_t value = bits[word];
+
+      while (value != 0) {
+        unsigned bit = 0;
+
+        while ((value & (UINT64_C(1) << bit)) == 0) {
+          ++bit;
+        }
+
+        value &= ~(UINT64_C(1) << bit);
+        unsigned index = word * 64 + bit;
+        chunks.push_back({ index % m_chunkColumns, index / m_chunkColumns });
+      }
+    }
+
+    return chunks;
+  }
+
+  /*
+   * MapEditor
+   */
+
+  MapEditor::MapEditor(Map& map, unsigned chunkSize)
+  : m_map(map)
+  , m_layers(map.getAllLayers())
+  , m_dirty(map.getWidth(), map.getHeight(), chunkSize)
+  {
+  }
+
+  Cell MapEditor::getCell(unsigned layer, unsigned x, unsigned y) const noexcept {
+    TileLayer *tileLayer = getTileLayer(m_layers, layer);
+
+    if (tileLayer == nullptr || x >= m_map.getWidth() || y >= m_map.getHeight()) {
+      return Cell(0);
+    }
+
+    std::size_t index = static_cast<std::size_t>(y) * m_map.getWidth() + x;
+
+    if (index >= tileLayer->getCellCount()) {
+      return Cell(0);
+    }
+
+    return tileLayer->getCell(index);
+  }
+
+  bool MapEditor::setCell(unsigned layer, unsigned x, unsigned y, Cell cell) {
+    TileLayer *tileLayer = getTileLayer(m_layers, layer);
+
+    if (tileLayer == nullptr || x >= m_map.getWidth() || y >= m_map.getHeight()) {
+      return false;
+    }
+
+    std::size_t index = static_cast<std::size_t>(y) * m_map.getWidth() + x;
+
+    if (index >= tileLayer->getCellCount()) {
+      return false;
+    }
+
+    if (tileLayer->getCell(index).getRawGID() != cell.getRawGID()) {
+      tileLayer->setCell(index, cell);
+      m_dirty.markCell(layer, x, y);
+    }
+
+    return true;
+  }
+
+  bool MapEditor::addObject(unsigned layer, std::unique_ptr<Object> obj) {
+    ObjectLayer *objectLayer = getObjectLayer(m_layers, layer);
+
+    if (objectLayer == nullptr || !obj) {
+      return false;
+    }
+
+    if (objectLayer->getObject(obj->getId()) != nullptr) {
+      std::clog << "Error! An object with this id already exists: " << obj->getId() << '\n';
+      return false;
+    }
+
+    m_dirty.markObject(layer, obj->getId());
+    objectLayer->addObject(std::move(obj));
+    return true;
+  }
+
+  std::unique_ptr<Object> MapEditor::removeObject(unsigned layer, unsigned id) {
+    ObjectLayer *objectLayer = getObjectLayer(m_layers, layer);
+
+    if (objectLayer == nullptr) {
+      return nullptr;
+    }
+
+    std::unique_ptr<Object> obj = objectLayer->removeObject(id);
+
+    if (obj) {
+      m_dirty.markObject(layer, id);
+    }
+
+    return obj;
+  }
+
+  std::unique_ptr<Object> MapEditor::replaceObject(unsigned layer, std::unique_ptr<Object> obj) {
+    ObjectLayer *objectLayer = getObjectLayer(m_layers, layer);
+
+    if (objectLayer == nullptr || !obj) {
+      return nullptr;
+    }
+
+    unsigned id = obj->getId();
+    std::unique_ptr<Object> previous = objectLayer->replaceObject(std::move(obj));
+
+    if (previous) {
+      m_dirty.markObject(layer, id);
+    }
+
+    return previous;
+  }
+
+  bool MapEditor::setProperty(const std::string& key, const std::string& value) {
+    if (!m_map.setProperty(key, value)) {
+      return false;
+    }
+
+    m_dirty.markProperty(key);
+    return true;
+  }
+
+  bool MapEditor::removeProperty(const std::string& key) {
+    if (!m_map.removeProperty(key)) {
+      return false;
+    }
+
+    m_dirty.markProperty(key);
+    return true;
+  }
+
+  bool MapEditor::setLayerProperty(unsigned layer, const std::string& key, const std::string& value) {
+    Layer *mapLayer = getLayer(m_layers, layer);
+
+    if (mapLayer == nullptr || !mapLayer->setProperty(key, value)) {
+      return false;
+    }
+
+    m_dirty.markLayerProperty(layer, key);
+    return true;
+  }
+
+  bool MapEditor::removeLayerProperty(unsigned layer, const std::string& key) {
+    Layer *mapLayer = getLayer(m_layers, layer);
+
+    if (mapLayer == nullptr || !mapLayer->removeProperty(key)) {
+      return false;
+    }
+
+    m_dirty.markLayerProperty(layer, key);
+    return true;
+  }
+
+  bool MapEditor::setObjectProperty(unsigned layer, unsigned id, const std::string& key, const std::string& value) {
+    ObjectLayer *objectLayer = getObjectLayer(m_layers, layer);
+    Object *obj = objectLayer ? objectLayer->getObject(id) : nullptr;
+
+    if (obj == nullptr || !obj->setProperty(key, value)) {
+      return false;
+    }
+
+    m_dirty.markObject(layer, id);
+    return true;
+  }
+
+  bool MapEditor::removeObjectProperty(unsigned layer, unsigned id, const std::string& key) {
+    ObjectLayer *objectLayer = getObjectLayer(m_layers, layer);
+    Object *obj = objectLayer ? objectLayer->getObject(id) : nullptr;
+
+    if (obj == nullptr || !obj->removeProperty(key)) {
+      return false;
+    }
+
+    m_dirty.markObject(layer, id);
+    return true;
+  }
+
+  DirtySet MapEditor::takeDirtySet() {
+    DirtySet dirty(m_map.getWidth(), m_map.getHeight(), m_dirty.getChunkSize());
+    std::swap(dirty, m_dirty);
+    return dirty;
+  }
+
+}
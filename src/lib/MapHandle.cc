@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/MapHandle.h>
+
+#include <algorithm>
+
+namespace tmx {
+
+  struct MapHandle::Record {
+    std::atomic<bool> active;
+    std::atomic<const Map *> hazard;
+    Record *next;
+  };
+
+  MapHandle::Snapshot::~Snapshot() {
+    release();
+  }
+
+  MapHandle::Snapshot& MapHandle::Snapshot::operator=(Snapshot&& other) noexcept {
+    if (this != &other) {
+      release();
+      m_record = other.m_record;
+      m_map = other.m_map;
+      other.m_record = nullptr;
+      other.m_map = nullptr;
+    }
+
+    return *this;
+  }
+
+  void MapHandle::Snapshot::release() noexcept {
+    if (m_record == nullptr) {
+      return;
+    }
+
+    m_record->hazard.store(nullptr, std::memory_order_release);
+    m_record->active.store(false, std::memory_order_release);
+    m_record = nullptr;
+    m_map = nullptr;
+  }
+
+  MapHandle::MapHandle(std::unique_ptr<const Map> map)
+  : m_current(map.release())
+  , m_version(0)
+  , m_records(nullptr)
+  {
+  }
+
+  MapHandle::~MapHandle() {
+    delete m_current.load(std::memory_order_relaxed);
+
+    for (auto map : m_retired) {
+      delete map;
+    }
+
+    Record *record = m_records.load(std::memory_order_relaxed);
+
+    while (record != nullptr) {
+      Record *next = record->next;
+      delete record;
+      record = next;
+    }
+  }
+
+  MapHandle::Record *MapHandle::acquireRecord() const {
+    for (Record *record = m_records.load(std::memory_order_acquire); record != nullptr; record = record->next) {
+      if (record->active.load(std::memory_order_relaxed)) {
+        continue;
+      }
+
+      bool expected = false;
+
+      if (record->active.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+        return record;
+      }
+    }
+
+    // all the records are in use, add a new one at the head of the list
+    Record *record = new Record;
+    record->active.store(true, std::memory_order_relaxed);
+    record->hazard.store(nullptr, std::memory_order_relaxed);
+    record->next = m_records.load(std::memory_order_relaxed);
+
+    while (!m_records.compare_exchange_weak(record->next, record, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      // record->next has been updated, try again
+    }
+
+    return record;
+  }
+
+  MapHandle::Snapshot MapHandle::acquire() const {
+    Record *record = acquireRecord();
+    const Map *map = m_current.load(std::memory_order_seq_cst);
+
+    // announce the map, then check it has not been retired in the meantime
+    for (;;) {
+      record->hazard.store(map, std::memory_order_seq_cst);
+      const Map *current = m_current.load(std::memory_order_seq_cst);
+
+      if (current == map) {
+        break;
+      }
+
+      map = current;
+    }
+
+    return Snapshot(record, map);
+  }
+
+  void MapHandle::publish(std::unique_ptr<const Map> map) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    const Map *previous = m_current.exchange(map.release(), std::memory_order_seq_cst);
+    m_version.fetch_add(1, std::memory_order_release);
+
+    if (previous != nullptr) {
+      m_retired.push_back(previous);
+    }
+
+    reclaimLocked();
+  }
+
+  std::size_t MapHandle::reclaim() {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    return reclaimLocked();
+  }
+
+  std::size_t MapHandle::reclaimLocked() {
+    if (m_retired.empty()) {
+      return 0;
+    }
+
+    std::vector<const Map *> hazards;
+
+    // a record added after this load announces a map that is not retired
+    for (Record *record = m_records.load(std::memory_order_seq_cst); record != nullptr; record = record->next) {
+      const Map *hazard = record->hazard.load(std::memory_order_seq_cst);
+
+      if (hazard != nullptr) {
+        hazards.push_back(hazard);
+      }
+    }
+
+    std::sort(hazards.begin(), hazards.end());
+
+    auto it = std::partition(m_retired.begin(), m_retired.end(), [&hazards](const Map *map) {
+      return std::binary_search(hazards.begin(), hazards.end(), map);
+    });
+
+    std::size_t count = std::distance(it, m_retired.end());
+
+    for (auto jt = it; jt != m_retired.end(); ++jt) {
+      delete *jt;
+    }
+
+    m_retired.erase(it, m_retired.end());
+    return count;
+  }
+
+  std::size_t MapHandle::getRetiredCount() const {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    return m_retired.size();
+  }
+
+}
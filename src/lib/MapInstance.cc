@@ -0,0 +1,445 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/MapInstance.h>
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+#include <tmx/CompressionDictionary.h>
+#include <tmx/GroupLayer.h>
+#include <tmx/ImageLayer.h>
+
+#include "MapCompiler.h"
+
+namespace tmx {
+
+  namespace {
+
+    // an estimation of the overhead of a node in a std::map
+    const std::size_t MapNodeOverhead = 4 * sizeof(void *);
+
+    std::size_t getStringSize(const std::string& str) {
+      return str.capacity() > 15 ? str.capacity() + 1 : 0;
+    }
+
+    std::size_t getObjectSize(const Object& object) {
+      std::size_t size = sizeof(Object) + 2 * sizeof(unsigned) + getStringSize(object.getName()) + getStringSize(object.getType());
+
+      if (object.isChain()) {
+        auto chain = static_cast<const Chain *>(&object);
+        size += sizeof(std::vector<Vector2i>) + std::distance(chain->begin(), chain->end()) * sizeof(Vector2i);
+      }
+
+      for (auto& property : object.getProperties()) {
+        size += MapNodeOverhead + 2 * sizeof(std::string) + getStringSize(property.first) + getStringSize(property.second);
+      }
+
+      return size;
+    }
+
+    void copyProperties(const Component& from, Component& to) {
+      for (auto& property : from.getProperties()) {
+        to.addProperty(property.first, property.second);
+      }
+    }
+
+    // the flag of an override is false if the property is removed
+    void overrideProperties(const std::map<std::string, std::pair<bool, std::string>>& overrides, Component& component) {
+      for (auto& property : overrides) {
+        if (property.second.first) {
+          component.setProperty(property.first, property.second.second);
+        } else {
+          component.removeProperty(property.first);
+        }
+      }
+    }
+
+  }
+
+  std::unique_ptr<MapInstance> MapInstance::instantiate(std::shared_ptr<const Map> map, unsigned chunkSize) {
+    if (!map) {
+      return nullptr;
+    }
+
+    return std::unique_ptr<MapInstance>(new MapInstance(std::move(map), chunkSize));
+  }
+
+  MapInstance::MapInstance(std::shared_ptr<const Map> map, unsigned chunkSize)
+  : m_template(std::move(map))
+  , m_chunkSize(chunkSize > 0 ? chunkSize : compiled::DefaultChunkSize)
+  , m_chunkColumns((m_template->getWidth() + m_chunkSize - 1) / m_chunkSize)
+  , m_chunkRows((m_template->getHeight() + m_chunkSize - 1) / m_chunkSize)
+  , m_nextObjectId(m_template->getNextObjectId())
+  {
+    std::size_t cellCount = static_cast<std::size_t>(m_template->getWidth()) * m_template->getHeight();
+    auto layers = m_template->getAllLayers();
+    m_layers.resize(layers.size());
+
+    for (std::size_t i = 0; i < m_layers.size(); ++i) {
+      LayerState& state = m_layers[i];
+      state.layer = layers[i];
+      state.tiles = dynamic_cast<const TileLayer *>(state.layer);
+      state.objects = dynamic_cast<const ObjectLayer *>(state.layer);
+
+      if (state.tiles != nullptr && state.tiles->getCellCount() != cellCount) {
+        std::clog << "Error! The tile layer does not cover the map: " << state.layer->getName() << '\n';
+        state.tiles = nullptr;
+      }
+    }
+  }
+
+  Cell MapInstance::getCell(unsigned layer, unsigned x, unsigned y) const noexcept {
+    if (layer >= m_layers.size() || m_layers[layer].tiles == nullptr || x >= m_template->getWidth() || y >= m_template->getHeight()) {
+      return Cell(0);
+    }
+
+    const LayerState& state = m_layers[layer];
+
+    if (!state.chunks.empty()) {
+      auto& chunk = state.chunks[(y / m_chunkSize) * m_chunkColumns + (x / m_chunkSize)];
+
+      if (chunk) {
+        unsigned width = std::min(m_chunkSize, m_template->getWidth() - (x / m_chunkSize) * m_chunkSize);
+        return (*chunk)[(y % m_chunkSize) * width + (x % m_chunkSize)];
+      }
+    }
+
+    return state.tiles->getCell(static_cast<std::size_t>(y) * m_template->getWidth() + x);
+  }
+
+  bool MapInstance::setCell(unsigned layer, unsigned x, unsigned y, Cell cell) {
+    if (layer >= m_layers.size() || m_layers[layer].tiles == nullptr || x >= m_template->getWidth() || y >= m_template->getHeight()) {
+      return false;
+    }
+
+    LayerState& state = m_layers[layer];
+
+    if (state.chunks.empty()) {
+      state.chunks.resize(static_cast<std::size_t>(m_chunkColumns) * m_chunkRows);
+    }
+
+    unsigned left = (x / m_chunkSize) * m_chunkSize;
+    unsigned top = (y / m_chunkSize) * m_chunkSize;
+    unsigned width = std::min(m_chunkSize, m_template->getWidth() - left);
+    auto& chunk = state.chunks[(y / m_chunkSize) * m_chunkColumns + (x / m_chunkSize)];
+
+    if (!chunk) {
+      if (getCell(layer, x, y).getRawGID() == cell.getRawGID()) {
+        return true;
+      }
+
+      // copy the chunk from the template
+      unsigned height = std::min(m_chunkSize, m_template->getHeight() - top);
+      chunk.reset(new std::vector<Cell>);
+      chunk->reserve(static_cast<std::size_t>(width) * height);
+
+      for (unsigned j = 0; j < height; ++j) {
+        std::size_t row = static_cast<std::size_t>(top + j) * m_template->getWidth() + left;
+
+        for (unsigned i = 0; i < width; ++i) {
+          chunk->push_back(state.tiles->getCell(row + i));
+        }
+      }
+    }
+
+    (*chunk)[(y - top) * width + (x - left)] = cell;
+    return true;
+  }
+
+  const Object *MapInstance::getObject(unsigned layer, unsigned id) const noexcept {
+    if (layer >= m_layers.size() || m_layers[layer].objects == nullptr) {
+      return nullptr;
+    }
+
+    const LayerState& state = m_layers[layer];
+    auto it = state.overrides.find(id);
+
+    if (it != state.overrides.end()) {
+      return it->second.get();
+    }
+
+    return state.objects->getObject(id);
+  }
+
+  std::vector<const Object *> MapInstance::getObjects(unsigned layer) const {
+    std::vector<const Object *> objects;
+
+    if (layer >= m_layers.size() || m_layers[layer].objects == nullptr) {
+      return objects;
+    }
+
+    const LayerState& state = m_layers[layer];
+
+    for (auto object : *state.objects) {
+      auto it = state.overrides.find(object->getId());
+
+      if (it == state.overrides.end()) {
+        objects.push_back(object);
+      } else if (it->second) {
+        objects.push_back(it->second.get());
+      }
+    }
+
+    for (auto& override : state.overrides) {
+      if (override.second && state.objects->getObject(override.first) == nullptr) {
+        objects.push_back(override.second.get());
+      }
+    }
+
+    return objects;
+  }
+
+  MapInstance::LayerState *MapInstance::getObjectLayer(unsigned layer) noexcept {
+    if (layer >= m_layers.size() || m_layers[layer].objects == nullptr) {
+      return nullptr;
+    }
+
+    return &m_layers[layer];
+  }
+
+  bool MapInstance::addObject(unsigned layer, std::unique_ptr<Object> obj) {
+    LayerState *state = getObjectLayer(layer);
+
+    if (state == nullptr || !obj) {
+      return false;
+    }
+
+    unsigned id = obj->getId();
+
+    if (getObject(layer, id) != nullptr) {
+      std::clog << "Error! An object with this id already exists: " << id << '\n';
+      return false;
+    }
+
+    state->overrides[id] = std::move(obj);
+    return true;
+  }
+
+  bool MapInstance::removeObject(unsigned layer, unsigned id) {
+    LayerState *state = getObjectLayer(layer);
+
+    if (state == nullptr || getObject(layer, id) == nullptr) {
+      return false;
+    }
+
+    if (state->objects->getObject(id) != nullptr) {
+      state->overrides[id].reset();
+    } else {
+      state->overrides.erase(id);
+    }
+
+    return true;
+  }
+
+  bool MapInstance::replaceObject(unsigned layer, std::unique_ptr<Object> obj) {
+    LayerState *state = getObjectLayer(layer);
+
+    if (state == nullptr || !obj || getObject(layer, obj->getId()) == nullptr) {
+      return false;
+    }
+
+    unsigned id = obj->getId();
+    state->overrides[id] = std::move(obj);
+    return true;
+  }
+
+  bool MapInstance::setObjectProperty(unsigned layer, unsigned id, const std::string& key, const std::string& value) {
+    LayerState *state = getObjectLayer(layer);
+    const Object *current = getObject(layer, id);
+
+    if (state == nullptr || current == nullptr) {
+      return false;
+    }
+
+    if (current->hasProperty(key) && current->getProperty(key, value) == value) {
+      return false;
+    }
+
+    auto& override = state->overrides[id];
+
+    if (!override) {
+      // copy the object from the template
+      override = cloneObject(*current);
+    }
+
+    return override->setProperty(key, value);
+  }
+
+  const std::string& MapInstance::getOverriddenProperty(const PropertyOverrides& overrides, const Component& component,
+      const std::string& key, const std::string& def) noexcept {
+    auto it = overrides.find(key);
+
+    if (it != overrides.end()) {
+      return it->second.first ? it->second.second : def;
+    }
+
+    return component.getProperty(key, def);
+  }
+
+  const std::string& MapInstance::getProperty(const std::string& key, const std::string& def) const noexcept {
+    return getOverriddenProperty(m_properties, *m_template, key, def);
+  }
+
+  void MapInstance::setProperty(const std::string& key, const std::string& value) {
+    m_properties[key] = std::make_pair(true, value);
+  }
+
+  void MapInstance::removeProperty(const std::string& key) {
+    m_properties[key] = std::make_pair(false, std::string());
+  }
+
+  const std::string& MapInstance::getLayerProperty(unsigned layer, const std::string& key, const std::string& def) const noexcept {
+    if (layer >= m_layers.size()) {
+      return def;
+    }
+
+    return getOverriddenProperty(m_layers[layer].properties, *m_layers[layer].layer, key, def);
+  }
+
+  void MapInstance::setLayerProperty(unsigned layer, const std::string& key, const std::string& value) {
+    if (layer < m_layers.size()) {
+      m_layers[layer].properties[key] = std::make_pair(true, value);
+    }
+  }
+
+  void MapInstance::removeLayerProperty(unsigned layer, const std::string& key) {
+    if (layer < m_layers.size()) {
+      m_layers[layer].properties[key] = std::make_pair(false, std::string());
+    }
+  }
+
+  InstanceStatistics MapInstance::getStatistics() const {
+    InstanceStatistics stats;
+    stats.copiedChunks = stats.totalChunks = 0;
+    stats.changedObjects = stats.changedProperties = 0;
+    stats.overheadBytes = sizeof(MapInstance) + m_layers.capacity() * sizeof(LayerState);
+
+    auto addProperties = [&stats](const PropertyOverrides& properties) {
+      stats.changedProperties += properties.size();
+
+      for (auto& property : properties) {
+        stats.overheadBytes += MapNodeOverhead + sizeof(property) + getStringSize(property.first) + getStringSize(property.second.second);
+      }
+    };
+
+    addProperties(m_properties);
+
+    for (auto& state : m_layers) {
+      if (state.tiles != nullptr) {
+        stats.totalChunks += static_cast<std::size_t>(m_chunkColumns) * m_chunkRows;
+      }
+
+      stats.overheadBytes += state.chunks.capacity() * sizeof(std::unique_ptr<std::vector<Cell>>);
+
+      for (auto& chunk : state.chunks) {
+        if (chunk) {
+          stats.copiedChunks++;
+          stats.overheadBytes += sizeof(std::vector<Cell>) + chunk->capacity() * sizeof(Cell);
+        }
+      }
+
+      stats.changedObjects += state.overrides.size();
+
+      for (auto& override : state.overrides) {
+        stats.overheadBytes += MapNodeOverhead + sizeof(override);
+
+        if (override.second) {
+          stats.overheadBytes += getObjectSize(*override.second);
+        }
+      }
+
+      addProperties(state.properties);
+    }
+
+    return stats;
+  }
+
+  std::unique_ptr<Layer> MapInstance::copyLayer(std::size_t& index) const {
+    const LayerState& state = m_layers[index];
+    const Layer& layer = *state.layer;
+    unsigned current = index++;
+
+    std::unique_ptr<Layer> copy;
+
+    if (auto tiles = dynamic_cast<const TileLayer *>(&layer)) {
+      std::unique_ptr<TileLayer> tileLayer(new TileLayer(layer.getName(), layer.getOpacity(), layer.isVisible()));
+      unsigned width = m_template->getWidth();
+
+      for (std::size_t k = 0; k < tiles->getCellCount(); ++k) {
+        tileLayer->addCell(state.tiles != nullptr ? getCell(current, k % width, k / width) : tiles->getCell(k));
+      }
+
+      copy = std::move(tileLayer);
+    } else if (auto objects = dynamic_cast<const ObjectLayer *>(&layer)) {
+      std::unique_ptr<ObjectLayer> objectLayer(new ObjectLayer(layer.getName(), layer.getOpacity(), layer.isVisible(), objects->getColor(), objects->getDrawOrder()));
+
+      for (auto object : getObjects(current)) {
+        objectLayer->addObject(cloneObject(*object));
+      }
+
+      copy = std::move(objectLayer);
+    } else if (auto image = dynamic_cast<const ImageLayer *>(&layer)) {
+      std::unique_ptr<ImageLayer> imageLayer(new ImageLayer(layer.getName(), layer.getOpacity(), layer.isVisible()));
+      imageLayer->setImage(copyImage(image->getImage()));
+      copy = std::move(imageLayer);
+    } else if (auto group = dynamic_cast<const GroupLayer *>(&layer)) {
+      std::unique_ptr<GroupLayer> groupLayer(new GroupLayer(layer.getName(), layer.getOpacity(), layer.isVisible()));
+
+      // the layers of the group follow the group in the list of the layers
+      for (std::size_t i = 0; i < group->getLayerCount(); ++i) {
+        groupLayer->addLayer(copyLayer(index));
+      }
+
+      copy = std::move(groupLayer);
+    }
+
+    assert(copy);
+    copy->setOffset(layer.getOffset().x, layer.getOffset().y);
+    copyProperties(layer, *copy);
+    overrideProperties(state.properties, *copy);
+    return copy;
+  }
+
+  std::unique_ptr<Map> MapInstance::toMap() const {
+    const Map& map = *m_template;
+
+    std::unique_ptr<Map> copy(new Map(map.getVersion(), map.getOrientation(), map.getWidth(), map.getHeight(),
+        map.getTileWidth(), map.getTileHeight(), map.getBackgroundColor(), map.getRenderOrder(),
+        map.getHexSideLength(), map.getStaggerAxis(), map.getStaggerIndex(), m_nextObjectId));
+
+    copyProperties(map, *copy);
+
+    if (map.getCompressionDictionary()) {
+      copy->setCompressionDictionary(map.getProperty(CompressionDictionary::getPropertyName(), ""), map.getCompressionDictionary());
+    }
+
+    overrideProperties(m_properties, *copy);
+
+    for (auto tileset : map.getTileSets()) {
+      copy->addTileSet(copyTileSet(*tileset, tileset->getFirstGID()));
+    }
+
+    std::size_t index = 0;
+
+    while (index < m_layers.size()) {
+      copy->addLayer(copyLayer(index));
+    }
+
+    return copy;
+  }
+
+}
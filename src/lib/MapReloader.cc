@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/MapReloader.h>
+
+#include <cassert>
+#include <iostream>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <tmx/Layer.h>
+#include <tmx/TileSet.h>
+
+#include "Parser.h"
+
+namespace fs = boost::filesystem;
+
+namespace tmx {
+
+  namespace {
+
+    fs::path normalizePath(const fs::path& path) {
+      return fs::absolute(path).lexically_normal();
+    }
+
+  }
+
+  MapReloader::MapReloader(const fs::path& filename, FileSystem& filesystem)
+  : m_filename(filename)
+  , m_filesystem(filesystem)
+  , m_notify(-1)
+  {
+  }
+
+  MapReloader::~MapReloader() {
+#ifdef __linux__
+    if (m_notify != -1) {
+      ::close(m_notify);
+    }
+#endif
+  }
+
+  ReloadReport MapReloader::reload() {
+    auto start = std::chrono::steady_clock::now();
+
+    ReloadReport report;
+    report.reloaded = false;
+    report.reusedTileSets = report.reusedLayers = 0;
+    report.removedTileSets = report.removedLayers = 0;
+
+    ReuseCache cache;
+
+    if (m_map) {
+      auto tilesets = m_map->releaseTileSets();
+      assert(tilesets.size() == m_tilesetHashes.size());
+
+      for (std::size_t i = 0; i < tilesets.size(); ++i) {
+        cache.tilesets.emplace_back(m_tilesetHashes[i], std::move(tilesets[i]));
+      }
+
+      auto layers = m_map->releaseLayers();
+      assert(layers.size() == m_layerHashes.size());
+
+      for (std::size_t i = 0; i < layers.size(); ++i) {
+        cache.layers.emplace_back(m_layerHashes[i], std::move(layers[i]));
+      }
+    }
+
+    ParseContext context;
+    context.filesystem = &m_filesystem;
+    context.reuse = &cache;
+
+    auto map = parseMapFile(m_filename, context);
+
+    if (!map) {
+      // the parser fails before it takes any element, give them back
+      if (m_map) {
+        for (auto& tileset : cache.tilesets) {
+          m_map->addTileSet(std::move(tileset.second));
+        }
+
+        for (auto& layer : cache.layers) {
+          if (layer.second) {
+            m_map->addLayer(std::move(layer.second));
+          }
+        }
+      }
+
+      report.duration = std::chrono::steady_clock::now() - start;
+      return report;
+    }
+
+    report.reloaded = true;
+    report.changedTileSets = std::move(cache.decodedTileSets);
+    report.changedLayers = std::move(cache.decodedLayers);
+    report.reusedTileSets = cache.tilesetHashes.size() - report.changedTileSets.size();
+    report.reusedLayers = cache.layerHashes.size() - report.changedLayers.size();
+
+    for (auto& tileset : cache.tilesets) {
+      if (tileset.second) {
+        report.removedTileSets++;
+      }
+    }
+
+    for (auto& layer : cache.layers) {
+      if (layer.second) {
+        report.removedLayers++;
+      }
+    }
+
+    m_map = std::move(map);
+    m_tilesetHashes = std::move(cache.tilesetHashes);
+    m_layerHashes = std::move(cache.layerHashes);
+
+    m_files.clear();
+
+    for (auto& file : cache.files) {
+      m_files.insert(normalizePath(file));
+    }
+
+    if (m_notify != -1) {
+      updateWatches();
+    }
+
+    report.duration = std::chrono::steady_clock::now() - start;
+    return report;
+  }
+
+  bool MapReloader::watch() {
+#ifdef __linux__
+    if (m_notify == -1) {
+      m_notify = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+      if (m_notify == -1) {
+        std::clog << "Error! Unable to watch the files of the map: " << m_filename << '\n';
+        return false;
+      }
+    }
+
+    if (m_files.empty()) {
+      m_files.insert(normalizePath(m_filename));
+    }
+
+    updateWatches();
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  void MapReloader::updateWatches() {
+#ifdef __linux__
+    std::set<fs::path> directories;
+
+    for (auto& file : m_files) {
+      directories.insert(file.parent_path());
+    }
+
+    for (auto it = m_watches.begin(); it != m_watches.end(); ) {
+      if (directories.count(it->second) == 0) {
+        ::inotify_rm_watch(m_notify, it->first);
+        it = m_watches.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    for (auto& directory : directories) {
+      int wd = ::inotify_add_watch(m_notify, directory.string().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+
+      if (wd == -1) {
+        std::clog << "Error! Unable to watch the directory: " << directory << '\n';
+        continue;
+      }
+
+      m_watches[wd] = directory;
+    }
+#endif
+  }
+
+  bool MapReloader::readEvents() {
+    bool changed = false;
+
+#ifdef __linux__
+    alignas(inotify_event) char buffer[4096];
+
+    for (;;) {
+      ssize_t size = ::read(m_notify, buffer, sizeof buffer);
+
+      if (size <= 0) {
+        break;
+      }
+
+      for (char *ptr = buffer; ptr < buffer + size; ) {
+        auto event = reinterpret_cast<const inotify_event *>(ptr);
+        auto it = m_watches.find(event->wd);
+
+        if (it != m_watches.end() && event->len > 0 && m_files.count(it->second / event->name) > 0) {
+          changed = true;
+        }
+
+        ptr += sizeof(inotify_event) + event->len;
+      }
+    }
+#endif
+
+    return changed;
+  }
+
+  bool MapReloader::hasChanged() {
+    if (m_notify == -1) {
+      return false;
+    }
+
+    return readEvents();
+  }
+
+  bool MapReloader::waitForChange(std::chrono::milliseconds timeout) {
+    if (m_notify == -1) {
+      return false;
+    }
+
+#ifdef __linux__
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    for (;;) {
+      if (readEvents()) {
+        return true;
+      }
+
+      auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+
+      if (remaining.count() <= 0) {
+        return false;
+      }
+
+      pollfd fd;
+      fd.fd = m_notify;
+      fd.events = POLLIN;
+      fd.revents = 0;
+      ::poll(&fd, 1, remaining.count());
+    }
+#else
+    return false;
+#endif
+  }
+
+  bool MapReloader::reloadIfChanged(ReloadReport& report) {
+    if (!hasChanged()) {
+      return false;
+    }
+
+    report = reload();
+    return report.reloaded;
+  }
+
+}
@@ -0,0 +1,444 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/MapServer.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <tmx/Map.h>
+
+namespace fs = boost::filesystem;
+
+namespace tmx {
+
+  namespace {
+
+    const uint32_t MaxNameLength = 4096;
+
+    // the response of the server, the file descriptor is sent along
+    struct Response {
+      uint32_t status;  // 0 if the map is sent
+      uint32_t reserved;
+      uint64_t size;
+    };
+
+    bool readFully(int fd, void *buffer, std::size_t size) {
+      char *ptr = static_cast<char *>(buffer);
+
+      while (size > 0) {
+        ssize_t count = ::read(fd, ptr, size);
+
+        if (count < 0 && errno == EINTR) {
+          continue;
+        }
+
+        if (count <= 0) {
+          return false;
+        }
+
+        ptr += count;
+        size -= count;
+      }
+
+      return true;
+    }
+
+    bool writeFully(int fd, const void *buffer, std::size_t size) {
+      const char *ptr = static_cast<const char *>(buffer);
+
+      while (size > 0) {
+        ssize_t count = ::write(fd, ptr, size);
+
+        if (count < 0 && errno == EINTR) {
+          continue;
+        }
+
+        if (count <= 0) {
+          return false;
+        }
+
+        ptr += count;
+        size -= count;
+      }
+
+      return true;
+    }
+
+    bool makeAddress(const fs::path& socket, sockaddr_un& address) {
+      std::string path = socket.string();
+
+      if (path.size() >= sizeof address.sun_path) {
+        std::clog << "Error! Socket path too long: " << socket << '\n';
+        return false;
+      }
+
+      std::memset(&address, 0, sizeof address);
+      address.sun_family = AF_UNIX;
+      std::memcpy(address.sun_path, path.c_str(), path.size());
+      return true;
+    }
+
+    // only plain relative paths inside the root are accepted, "." are removed
+    bool normalizeName(const std::string& name, std::string& normalized) {
+      fs::path path(name);
+
+      if (path.is_absolute() || path.has_root_name()) {
+        return false;
+      }
+
+      fs::path result;
+
+      for (auto& element : path) {
+        if (element == "..") {
+          return false;
+        }
+
+        if (element != "." && !element.empty()) {
+          result /= element;
+        }
+      }
+
+      normalized = result.string();
+      return !normalized.empty();
+    }
+
+  }
+
+  MapServer::Entry::Entry()
+  : fd(-1)
+  , size(0)
+  {
+  }
+
+  MapServer::Entry::~Entry() {
+    if (fd != -1) {
+      ::close(fd);
+    }
+  }
+
+  MapServer::MapServer(const fs::path& root, Executor& executor)
+  : m_root(root)
+  , m_executor(executor)
+  , m_socket(-1)
+  , m_stopped(false)
+  , m_mapCount(0)
+  {
+  }
+
+  MapServer::~MapServer() {
+    if (m_socket != -1) {
+      ::close(m_socket);
+      ::unlink(m_socketPath.string().c_str());
+    }
+  }
+
+  bool MapServer::listen(const fs::path& socket) {
+    sockaddr_un address;
+
+    if (!makeAddress(socket, address)) {
+      return false;
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    if (fd == -1) {
+      std::clog << "Error! Unable to create a socket: " << std::strerror(errno) << '\n';
+      return false;
+    }
+
+    ::unlink(address.sun_path);
+
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof address) == -1 || ::listen(fd, SOMAXCONN) == -1) {
+      std::clog << "Error! Unable to listen on " << socket << ": " << std::strerror(errno) << '\n';
+      ::close(fd);
+      return false;
+    }
+
+    m_socket = fd;
+    m_socketPath = socket;
+    return true;
+  }
+
+  void MapServer::run() {
+    while (!m_stopped) {
+      int client = ::accept4(m_socket, nullptr, nullptr, SOCK_CLOEXEC);
+
+      if (client == -1) {
+        if (errno == EINTR || errno == ECONNABORTED) {
+          continue;
+        }
+
+        if (!m_stopped) {
+          std::clog << "Error! Unable to accept a client: " << std::strerror(errno) << '\n';
+        }
+
+        break;
+      }
+
+      // a client that does not send its request is not waited for ever
+      timeval timeout = { 5, 0 };
+      ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_clients.insert(client);
+      }
+
+      m_executor.execute([this, client]() {
+        serve(client);
+      });
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (int client : m_clients) {
+      ::shutdown(client, SHUT_RDWR);
+    }
+
+    m_idle.wait(lock, [this]() { return m_clients.empty(); });
+  }
+
+  void MapServer::stop() {
+    m_stopped = true;
+
+    if (m_socket != -1) {
+      ::shutdown(m_socket, SHUT_RDWR);
+    }
+  }
+
+  bool MapServer::preload(const std::string& name) {
+    int fd;
+    std::size_t size;
+    return load(name, fd, size);
+  }
+
+  std::size_t MapServer::getMapCount() const {
+    return m_mapCount.load();
+  }
+
+  bool MapServer::load(const std::string& name, int& fd, std::size_t& size) {
+    std::string normalized;
+
+    if (!normalizeName(name, normalized)) {
+      std::clog << "Error! Invalid map name: '" << name << "'\n";
+      return false;
+    }
+
+    Entry *entry = nullptr;
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto& slot = m_entries[normalized];
+
+      if (!slot) {
+        slot.reset(new Entry);
+      }
+
+      entry = slot.get();
+    }
+
+    // the first caller loads the map, the others wait for it
+    std::lock_guard<std::mutex> lock(entry->mutex);
+
+    if (entry->fd == -1) {
+      auto map = Map::parseFile(m_root / normalized);
+
+      if (!map) {
+        return false;
+      }
+
+      std::vector<char> data = CompiledMap::compile(*map);
+
+      int memfd = ::memfd_create(("tmx:" + normalized).c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING);
+
+      if (memfd == -1) {
+        std::clog << "Error! Unable to create a shared memory file: " << std::strerror(errno) << '\n';
+        return false;
+      }
+
+      // the seals guarantee to the clients that the map never changes
+      if (!writeFully(memfd, data.data(), data.size())
+          || ::fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == -1) {
+        std::clog << "Error! Unable to fill the shared memory file: " << std::strerror(errno) << '\n';
+        ::close(memfd);
+        return false;
+      }
+
+      entry->fd = memfd;
+      entry->size = data.size();
+      m_mapCount++;
+    }
+
+    fd = entry->fd;
+    size = entry->size;
+    return true;
+  }
+
+  void MapServer::serve(int client) {
+    uint32_t length;
+    std::string name;
+
+    if (readFully(client, &length, sizeof length) && length > 0 && length <= MaxNameLength) {
+      name.resize(length);
+
+      if (readFully(client, &name[0], length)) {
+        Response response;
+        std::memset(&response, 0, sizeof response);
+
+        int fd = -1;
+        std::size_t size = 0;
+
+        if (load(name, fd, size)) {
+          response.size = size;
+        } else {
+          response.status = 1;
+        }
+
+        iovec iov;
+        iov.iov_base = &response;
+        iov.iov_len = sizeof response;
+
+        msghdr message;
+        std::memset(&message, 0, sizeof message);
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+
+        char control[CMSG_SPACE(sizeof(int))];
+
+        if (fd != -1) {
+          std::memset(control, 0, sizeof control);
+          message.msg_control = control;
+          message.msg_controllen = sizeof control;
+
+          cmsghdr *cmsg = CMSG_FIRSTHDR(&message);
+          cmsg->cmsg_level = SOL_SOCKET;
+          cmsg->cmsg_type = SCM_RIGHTS;
+          cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+          std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+        }
+
+        ::sendmsg(client, &message, MSG_NOSIGNAL);
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ::close(client);
+    m_clients.erase(client);
+    m_idle.notify_all();
+  }
+
+  std::unique_ptr<CompiledMap> MapClient::attach(const fs::path& socket, const std::string& name) {
+    sockaddr_un address;
+
+    if (!makeAddress(socket, address)) {
+      return nullptr;
+    }
+
+    int client = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    if (client == -1) {
+      std::clog << "Error! Unable to create a socket: " << std::strerror(errno) << '\n';
+      return nullptr;
+    }
+
+    if (::connect(client, reinterpret_cast<sockaddr *>(&address), sizeof address) == -1) {
+      std::clog << "Error! Unable to connect to " << socket << ": " << std::strerror(errno) << '\n';
+      ::close(client);
+      return nullptr;
+    }
+
+    uint32_t length = name.size();
+
+    if (length == 0 || length > MaxNameLength || !writeFully(client, &length, sizeof length) || !writeFully(client, name.data(), length)) {
+      std::clog << "Error! Unable to send the request for '" << name << "'\n";
+      ::close(client);
+      return nullptr;
+    }
+
+    Response response;
+    std::memset(&response, 0, sizeof response);
+
+    iovec iov;
+    iov.iov_base = &response;
+    iov.iov_len = sizeof response;
+
+    char control[CMSG_SPACE(sizeof(int))];
+    std::memset(control, 0, sizeof control);
+
+    msghdr message;
+    std::memset(&message, 0, sizeof message);
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof control;
+
+    ssize_t count;
+
+    do {
+      count = ::recvmsg(client, &message, MSG_CMSG_CLOEXEC | MSG_WAITALL);
+    } while (count == -1 && errno == EINTR);
+
+    ::close(client);
+
+    int fd = -1;
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&message);
+
+    if (count == sizeof response && cmsg != nullptr && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+      std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    }
+
+    if (count != sizeof response || response.status != 0 || fd == -1) {
+      std::clog << "Error! The map '" << name << "' is not available\n";
+
+      if (fd != -1) {
+        ::close(fd);
+      }
+
+      return nullptr;
+    }
+
+    std::size_t size = response.size;
+    void *data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (data == MAP_FAILED) {
+      std::clog << "Error! Unable to map the map '" << name << "': " << std::strerror(errno) << '\n';
+      return nullptr;
+    }
+
+    std::shared_ptr<const void> owner(data, [size](const void *ptr) {
+      ::munmap(const_cast<void *>(ptr), size);
+    });
+
+    auto map = CompiledMap::fromMemory(data, size, owner);
+
+    if (!map) {
+      std::clog << "Error! Invalid compiled map: '" << name << "'\n";
+      return nullptr;
+    }
+
+    return map;
+  }
+
+}
@@ -0,0 +1,891 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/Map.h>
+
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+
+#include <zlib.h>
+
+#include <tmx/CompressionDictionary.h>
+#include <tmx/GroupLayer.h>
+#include <tmx/ImageLayer.h>
+#include <tmx/ObjectLayer.h>
+#include <tmx/ObjectTemplate.h>
+#include <tmx/TileLayer.h>
+
+namespace fs = boost::filesystem;
+
+namespace tmx {
+
+  namespace {
+
+    const unsigned InvalidTerrain = static_cast<unsigned>(-1);
+
+    const char Base64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    // encodes 3 bytes in 4 characters, 12 bytes at a time in the main loop
+    void encodeBase64(const uint8_t *data, std::size_t size, std::string& out) {
+      std::size_t start = out.size();
+      out.resize(start + (size + 2) / 3 * 4);
+      char *dst = &out[start];
+      std::size_t i = 0;
+
+      for (; i + 12 <= size; i += 12, dst += 16) {
+        for (std::size_t k = 0; k < 4; ++k) {
+          uint32_t triple = (static_cast<uint32_t>(data[i + 3 * k]) << 16) | (static_cast<uint32_t>(data[i + 3 * k + 1]) << 8) | data[i + 3 * k + 2];
+          dst[4 * k] = Base64Alphabet[(triple >> 18) & 0x3F];
+          dst[4 * k + 1] = Base64Alphabet[(triple >> 12) & 0x3F];
+          dst[4 * k + 2] = Base64Alphabet[(triple >> 6) & 0x3F];
+          dst[4 * k + 3] = Base64Alphabet[triple & 0x3F];
+        }
+      }
+
+      for (; i + 3 <= size; i += 3, dst += 4) {
+        uint32_t triple = (static_cast<uint32_t>(data[i]) << 16) | (static_cast<uint32_t>(data[i + 1]) << 8) | data[i + 2];
+        dst[0] = Base64Alphabet[(triple >> 18) & 0x3F];
+        dst[1] = Base64Alphabet[(triple >> 12) & 0x3F];
+        dst[2] = Base64Alphabet[(triple >> 6) & 0x3F];
+        dst[3] = Base64Alphabet[triple & 0x3F];
+      }
+
+      if (i < size) {
+        uint32_t triple = static_cast<uint32_t>(data[i]) << 16;
+
+        if (i + 1 < size) {
+          triple |= static_cast<uint32_t>(data[i + 1]) << 8;
+        }
+
+        dst[0] = Base64Alphabet[(triple >> 18) & 0x3F];
+        dst[1] = Base64Alphabet[(triple >> 12) & 0x3F];
+        dst[2] = (i + 1 < size) ? Base64Alphabet[(triple >> 6) & 0x3F] : '=';
+        dst[3] = '=';
+      }
+    }
+
+    bool compress(const std::vector<uint8_t>& input, std::vector<uint8_t>& output, bool gzip, const CompressionDictionary *dictionary) {
+      z_stream stream;
+      std::memset(&stream, 0, sizeof(stream));
+
+      // 15 bits of window, +16 for a gzip header
+      if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, gzip ? 15 + 16 : 15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+      }
+
+      // the gzip format has no preset dictionary
+      if (!gzip && dictionary != nullptr && deflateSetDictionary(&stream, dictionary->getData(), dictionary->getSize()) != Z_OK) {
+        deflateEnd(&stream);
+        return false;
+      }
+
+      output.resize(deflateBound(&stream, input.size()) + 32);
+      stream.next_in = input.data();
+      stream.avail_in = input.size();
+      stream.next_out = output.data();
+      stream.avail_out = output.size();
+
+      int err = deflate(&stream, Z_FINISH);
+      output.resize(stream.total_out);
+      deflateEnd(&stream);
+
+      return err == Z_STREAM_END;
+    }
+
+    void appendUnsigned(std::string& out, unsigned value) {
+      char buffer[10];
+      char *ptr = buffer + sizeof buffer;
+
+      do {
+        *--ptr = '0' + value % 10;
+        value /= 10;
+      } while (value != 0);
+
+      out.append(ptr, buffer + sizeof buffer);
+    }
+
+    void appendEscaped(std::string& out, const std::string& str) {
+      for (char c : str) {
+        switch (c) {
+          case '&':
+            out += "&amp;";
+            break;
+          case '<':
+            out += "&lt;";
+            break;
+          case '>':
+            out += "&gt;";
+            break;
+          case '"':
+            out += "&quot;";
+            break;
+          case '\n':
+            out += "&#10;";
+            break;
+          default:
+            out += c;
+            break;
+        }
+      }
+    }
+
+    std::string formatDouble(double value) {
+      char buffer[32];
+
+      // the shortest representation that reads back to the same value
+      for (int precision = 6; precision <= 17; ++precision) {
+        std::snprintf(buffer, sizeof buffer, "%.*g", precision, value);
+
+        if (std::strtod(buffer, nullptr) == value) {
+          break;
+        }
+      }
+
+      return buffer;
+    }
+
+    // the shortest representation that reads back to the same float
+    std::string formatFloat(float value) {
+      char buffer[32];
+
+      for (int precision = 6; precision <= 9; ++precision) {
+        std::snprintf(buffer, sizeof buffer, "%.*g", precision, value);
+
+        if (std::strtof(buffer, nullptr) == value) {
+          break;
+        }
+      }
+
+      return buffer;
+    }
+
+    const char *getOrientationString(Orientation orientation) {
+      switch (orientation) {
+        case Orientation::ORTHOGONAL:
+          return "orthogonal";
+        case Orientation::ISOMETRIC:
+          return "isometric";
+        case Orientation::STAGGERED:
+          return "staggered";
+        case Orientation::HEXAGONAL:
+          return "hexagonal";
+        default:
+          break;
+      }
+
+      return "unknown";
+    }
+
+    const char *getRenderOrderString(RenderOrder order) {
+      switch (order) {
+        case RenderOrder::RIGHT_DOWN:
+          return "right-down";
+        case RenderOrder::RIGHT_UP:
+          return "right-up";
+        case RenderOrder::LEFT_DOWN:
+          return "left-down";
+        case RenderOrder::LEFT_UP:
+          return "left-up";
+      }
+
+      return "right-down";
+    }
+
+    class Writer {
+    public:
+      Writer(const Map& map, LayerEncoding encoding, const fs::path& base)
+      : m_map(map), m_encoding(encoding), m_base(base)
+      {
+      }
+
+      // encodes the data of the tile layers, in parallel, before the XML is written
+      void encodeLayers(Executor& executor) {
+        std::vector<const TileLayer *> layers;
+
+        for (auto& flattened : m_map.getFlattenedLayers()) {
+          auto tileLayer = dynamic_cast<const TileLayer *>(flattened.layer);
+
+          if (tileLayer != nullptr) {
+            layers.push_back(tileLayer);
+          }
+        }
+
+        m_data.resize(layers.size());
+        m_layers = layers;
+
+        if (layers.empty()) {
+          return;
+        }
+
+        struct Shared {
+          std::atomic<std::size_t> next;
+          std::size_t done;
+          std::mutex mutex;
+          std::condition_variable finished;
+        };
+
+        auto shared = std::make_shared<Shared>();
+        shared->next = 0;
+        shared->done = 0;
+        std::size_t count = layers.size();
+
+        // each worker takes the next layer until there is none, the caller works too
+        auto work = [this, shared, count]() {
+          for (;;) {
+            std::size_t index = shared->next.fetch_add(1);
+
+            if (index >= count) {
+              return;
+            }
+
+            m_data[index] = encodeLayer(*m_layers[index]);
+
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            shared->done++;
+
+            if (shared->done == count) {
+              shared->finished.notify_all();
+            }
+          }
+        };
+
+        for (std::size_t i = 1; i < count; ++i) {
+          executor.execute(work);
+        }
+
+        work();
+
+        std::unique_lock<std::mutex> lock(shared->mutex);
+        shared->finished.wait(lock, [shared, count]() { return shared->done == count; });
+      }
+
+      std::string write() {
+        m_out.clear();
+        m_out += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+        m_out += "<map";
+        addAttribute("version", m_map.getVersion());
+        addAttribute("orientation", getOrientationString(m_map.getOrientation()));
+        addAttribute("renderorder", getRenderOrderString(m_map.getRenderOrder()));
+        addAttribute("width", m_map.getWidth());
+        addAttribute("height", m_map.getHeight());
+        addAttribute("tilewidth", m_map.getTileWidth());
+        addAttribute("tileheight", m_map.getTileHeight());
+
+        if (m_map.getOrientation() == Orientation::HEXAGONAL) {
+          addAttribute("hexsidelength", m_map.getHexSideLength());
+        }
+
+        if (m_map.getOrientation() == Orientation::STAGGERED || m_map.getOrientation() == Orientation::HEXAGONAL) {
+          addAttribute("staggeraxis", m_map.getStaggerAxis() == StaggerAxis::X ? "x" : "y");
+          addAttribute("staggerindex", m_map.getStaggerIndex() == StaggerIndex::ODD ? "odd" : "even");
+        }
+
+        addAttribute("backgroundcolor", m_map.getBackgroundColor());
+        addAttribute("nextobjectid", m_map.getNextObjectId());
+        m_out += ">\n";
+
+        writeProperties(m_map, 1);
+
+        for (auto tileset : m_map.getTileSets()) {
+          writeTileSet(*tileset);
+        }
+
+        m_tileLayer = 0;
+        m_depth = 0;
+
+        for (auto layer : m_map.getLayers()) {
+          writeLayer(*layer);
+        }
+
+        m_out += "</map>\n";
+        return std::move(m_out);
+      }
+
+    private:
+      std::string encodeLayer(const TileLayer& layer) {
+        std::string out;
+
+        switch (m_encoding) {
+          case LayerEncoding::XML:
+            out.reserve(layer.getCellCount() * 20);
+
+            for (auto cell : layer) {
+              out += "   <tile gid=\"";
+              appendUnsigned(out, cell.getRawGID());
+              out += "\"/>\n";
+            }
+            break;
+
+          case LayerEncoding::CSV: {
+            std::size_t width = m_map.getWidth();
+            std::size_t i = 0;
+            out.reserve(layer.getCellCount() * 4);
+            out += '\n';
+
+            for (auto cell : layer) {
+              appendUnsigned(out, cell.getRawGID());
+              ++i;
+
+              if (i < layer.getCellCount()) {
+                out += ',';
+              }
+
+              if (width > 0 && i % width == 0) {
+                out += '\n';
+              }
+            }
+            break;
+          }
+
+          case LayerEncoding::BASE64:
+          case LayerEncoding::BASE64_ZLIB:
+          case LayerEncoding::BASE64_GZIP: {
+            std::vector<uint8_t> raw(layer.getCellCount() * 4);
+            uint8_t *ptr = raw.data();
+
+            // little-endian, whatever the host
+            for (auto cell : layer) {
+              unsigned gid = cell.getRawGID();
+              ptr[0] = gid & 0xFF;
+              ptr[1] = (gid >> 8) & 0xFF;
+              ptr[2] = (gid >> 16) & 0xFF;
+              ptr[3] = (gid >> 24) & 0xFF;
+              ptr += 4;
+            }
+
+            if (m_encoding != LayerEncoding::BASE64) {
+              std::vector<uint8_t> compressed;
+
+              if (!compress(raw, compressed, m_encoding == LayerEncoding::BASE64_GZIP, m_map.getCompressionDictionary().get())) {
+                std::clog << "Error! Unable to compress the layer: " << layer.getName() << '\n';
+              }
+
+              raw.swap(compressed);
+            }
+
+            encodeBase64(raw.data(), raw.size(), out);
+            break;
+          }
+        }
+
+        return out;
+      }
+
+      void indent(unsigned level) {
+        m_out.append(level + m_depth, ' ');
+      }
+
+      void addAttribute(const char *name, const std::string& value) {
+        m_out += ' ';
+        m_out += name;
+        m_out += "=\"";
+        appendEscaped(m_out, value);
+        m_out += '"';
+      }
+
+      void addAttribute(const char *name, const char *value) {
+        addAttribute(name, std::string(value));
+      }
+
+      void addAttribute(const char *name, unsigned value) {
+        addAttribute(name, std::to_string(value));
+      }
+
+      void addAttribute(const char *name, int value) {
+        addAttribute(name, std::to_string(value));
+      }
+
+      void addAttribute(const char *name, double value) {
+        addAttribute(name, formatDouble(value));
+      }
+
+      void addAttribute(const char *name, float value) {
+        addAttribute(name, formatFloat(value));
+      }
+
+      void writeProperties(const Component& component, unsigned level) {
+        if (component.getProperties().empty()) {
+          return;
+        }
+
+        indent(level);
+        m_out += "<properties>\n";
+
+        for (auto& property : component.getProperties()) {
+          indent(level + 1);
+          m_out += "<property";
+          addAttribute("name", property.first);
+          addAttribute("value", property.second);
+          m_out += "/>\n";
+        }
+
+        indent(level);
+        m_out += "</properties>\n";
+      }
+
+      std::string getSource(const fs::path& source) {
+        if (m_base.empty()) {
+          return source.generic_string();
+        }
+
+        fs::path relative = fs::absolute(source).lexically_normal().lexically_relative(fs::absolute(m_base).lexically_normal());
+
+        if (relative.empty()) {
+          return source.generic_string();
+        }
+
+        return relative.generic_string();
+      }
+
+      void writeImage(const Image& image, unsigned level) {
+        indent(level);
+        m_out += "<image";
+
+        if (!image.getFormat().empty()) {
+          addAttribute("format", image.getFormat());
+        }
+
+        if (!image.getSource().empty()) {
+          addAttribute("source", getSource(image.getSource()));
+        }
+
+        if (!image.getTransparent().empty()) {
+          addAttribute("trans", image.getTransparent());
+        }
+
+        if (image.hasSize()) {
+          addAttribute("width", image.getWidth());
+          addAttribute("height", image.getHeight());
+        }
+
+        if (!image.hasData()) {
+          m_out += "/>\n";
+          return;
+        }
+
+        m_out += ">\n";
+        indent(level + 1);
+        m_out += "<data encoding=\"base64\">";
+        encodeBase64(image.getData(), image.getDataSize(), m_out);
+        m_out += "</data>\n";
+        indent(level);
+        m_out += "</image>\n";
+      }
+
+      void writeTileSet(const TileSet& tileset) {
+        indent(1);
+        m_out += "<tileset";
+        addAttribute("firstgid", tileset.getFirstGID());
+        addAttribute("name", tileset.getName());
+        addAttribute("tilewidth", tileset.getTileWidth());
+        addAttribute("tileheight", tileset.getTileHeight());
+
+        if (tileset.getSpacing() != 0) {
+          addAttribute("spacing", tileset.getSpacing());
+        }
+
+        if (tileset.getMargin() != 0) {
+          addAttribute("margin", tileset.getMargin());
+        }
+
+        if (tileset.getTileCount() != 0) {
+          addAttribute("tilecount", tileset.getTileCount());
+        }
+
+        m_out += ">\n";
+
+        if (tileset.getOffsetX() != 0 || tileset.getOffsetY() != 0) {
+          indent(2);
+          m_out += "<tileoffset";
+          addAttribute("x", tileset.getOffsetX());
+          addAttribute("y", tileset.getOffsetY());
+          m_out += "/>\n";
+        }
+
+        writeProperties(tileset, 2);
+
+        if (tileset.hasImage()) {
+          writeImage(*tileset.getImage(), 2);
+        }
+
+        auto terrains = tileset.getTerrains();
+
+        if (!terrains.empty()) {
+          indent(2);
+          m_out += "<terraintypes>\n";
+
+          for (auto terrain : terrains) {
+            indent(3);
+            m_out += "<terrain";
+            addAttribute("name", terrain->getName());
+            addAttribute("tile", terrain->getTile());
+
+            if (terrain->getProperties().empty()) {
+              m_out += "/>\n";
+            } else {
+              m_out += ">\n";
+              writeProperties(*terrain, 4);
+              indent(3);
+              m_out += "</terrain>\n";
+            }
+          }
+
+          indent(2);
+          m_out += "</terraintypes>\n";
+        }
+
+        for (auto tile : tileset) {
+          indent(2);
+          m_out += "<tile";
+          addAttribute("id", tile->getId());
+
+          const std::array<unsigned, 4>& terrain = tile->getTerrain();
+
+          if (terrain[0] != InvalidTerrain || terrain[1] != InvalidTerrain || terrain[2] != InvalidTerrain || terrain[3] != InvalidTerrain) {
+            std::string value;
+
+            for (std::size_t i = 0; i < terrain.size(); ++i) {
+              if (i > 0) {
+                value += ',';
+              }
+
+              if (terrain[i] != InvalidTerrain) {
+                value += std::to_string(terrain[i]);
+              }
+            }
+
+            addAttribute("terrain", value);
+          }
+
+          if (tile->getProbability() != 100) {
+            addAttribute("probability", tile->getProbability());
+          }
+
+          if (tile->getProperties().empty() && !tile->hasImage() && !tile->hasAnimation() && !tile->hasObjects()) {
+            m_out += "/>\n";
+            continue;
+          }
+
+          m_out += ">\n";
+          writeProperties(*tile, 3);
+
+          if (tile->hasImage()) {
+            writeImage(*tile->getImage(), 3);
+          }
+
+          if (tile->hasAnimation()) {
+            indent(3);
+            m_out += "<animation>\n";
+
+            for (auto& frame : tile->getAnimation()) {
+              indent(4);
+              m_out += "<frame";
+              addAttribute("tileid", frame.tileId);
+              addAttribute("duration", frame.duration);
+              m_out += "/>\n";
+            }
+
+            indent(3);
+            m_out += "</animation>\n";
+          }
+
+          if (tile->hasObjects()) {
+            m_depth = 2;
+            writeObjectLayer(*tile->getObjects());
+            m_depth = 0;
+          }
+
+          indent(2);
+          m_out += "</tile>\n";
+        }
+
+        indent(1);
+        m_out += "</tileset>\n";
+      }
+
+      void writeLayerAttributes(const Layer& layer) {
+        addAttribute("name", layer.getName());
+
+        if (layer.getOpacity() != 1.0) {
+          addAttribute("opacity", layer.getOpacity());
+        }
+
+        if (!layer.isVisible()) {
+          addAttribute("visible", 0u);
+        }
+
+        if (layer.getOffset().x != 0) {
+          addAttribute("offsetx", layer.getOffset().x);
+        }
+
+        if (layer.getOffset().y != 0) {
+          addAttribute("offsety", layer.getOffset().y);
+        }
+      }
+
+      // the tile layers come in the same order as in the flattened layers
+      void writeLayer(const Layer& layer) {
+        if (m_tileLayer < m_layers.size() && &layer == m_layers[m_tileLayer]) {
+          writeTileLayer(*m_layers[m_tileLayer], m_data[m_tileLayer]);
+          m_tileLayer++;
+        } else if (auto objectLayer = dynamic_cast<const ObjectLayer *>(&layer)) {
+          writeObjectLayer(*objectLayer);
+        } else if (auto imageLayer = dynamic_cast<const ImageLayer *>(&layer)) {
+          writeImageLayer(*imageLayer);
+        } else if (auto groupLayer = dynamic_cast<const GroupLayer *>(&layer)) {
+          writeGroupLayer(*groupLayer);
+        }
+      }
+
+      void writeTileLayer(const TileLayer& layer, const std::string& data) {
+        indent(1);
+        m_out += "<layer";
+        writeLayerAttributes(layer);
+        addAttribute("width", m_map.getWidth());
+        addAttribute("height", m_map.getHeight());
+        m_out += ">\n";
+
+        writeProperties(layer, 2);
+
+        indent(2);
+
+        switch (m_encoding) {
+          case LayerEncoding::XML:
+            m_out += "<data>\n";
+            m_out += data;
+            indent(2);
+            break;
+          case LayerEncoding::CSV:
+            m_out += "<data encoding=\"csv\">";
+            m_out += data;
+            break;
+          case LayerEncoding::BASE64:
+            m_out += "<data encoding=\"base64\">";
+            m_out += data;
+            break;
+          case LayerEncoding::BASE64_ZLIB:
+            m_out += "<data encoding=\"base64\" compression=\"zlib\">";
+            m_out += data;
+            break;
+          case LayerEncoding::BASE64_GZIP:
+            m_out += "<data encoding=\"base64\" compression=\"gzip\">";
+            m_out += data;
+            break;
+        }
+
+        m_out += "</data>\n";
+        indent(1);
+        m_out += "</layer>\n";
+      }
+
+      void writeObject(const Object& object) {
+        indent(2);
+        m_out += "<object";
+        addAttribute("id", object.getId());
+
+        // an instance only writes what it overrides in its template
+        const Object *base = nullptr;
+        bool ellipse = object.isEllipse();
+        bool points = object.isChain();
+
+        if (object.getTemplate()) {
+          base = &object.getTemplate()->getObject();
+          addAttribute("template", getSource(object.getTemplate()->getSource()));
+          ellipse = false;
+
+          if (points && base->isChain() && static_cast<const Chain *>(&object)->sharesPoints(*static_cast<const Chain *>(base))) {
+            points = false;
+          }
+        }
+
+        if (!object.getName().empty() && (base == nullptr || object.getName() != base->getName())) {
+          addAttribute("name", object.getName());
+        }
+
+        if (!object.getType().empty() && (base == nullptr || object.getType() != base->getType())) {
+          addAttribute("type", object.getType());
+        }
+
+        if (object.isTile()) {
+          auto tile = static_cast<const TileObject *>(&object);
+          addAttribute("gid", Cell(tile->getGID(), tile->isHorizontallyFlipped(), tile->isVerticallyFlipped(), tile->isDiagonallyFlipped()).getRawGID());
+        }
+
+        addAttribute("x", object.getX());
+        addAttribute("y", object.getY());
+
+        if (object.isRectangle() || object.isEllipse()) {
+          auto boxed = static_cast<const Boxed *>(&object);
+          auto baseBoxed = (base != nullptr && (base->isRectangle() || base->isEllipse())) ? static_cast<const Boxed *>(base) : nullptr;
+
+          if (baseBoxed == nullptr || boxed->getWidth() != baseBoxed->getWidth()) {
+            addAttribute("width", boxed->getWidth());
+          }
+
+          if (baseBoxed == nullptr || boxed->getHeight() != baseBoxed->getHeight()) {
+            addAttribute("height", boxed->getHeight());
+          }
+        }
+
+        if (object.getRotation() != (base ? base->getRotation() : 0.0)) {
+          addAttribute("rotation", object.getRotation());
+        }
+
+        if (object.isVisible() != (base ? base->isVisible() : true)) {
+          addAttribute("visible", object.isVisible() ? 1u : 0u);
+        }
+
+        if (object.getProperties().empty() && !ellipse && !points) {
+          m_out += "/>\n";
+          return;
+        }
+
+        m_out += ">\n";
+        writeProperties(object, 3);
+
+        if (ellipse) {
+          indent(3);
+          m_out += "<ellipse/>\n";
+        } else if (points) {
+          auto chain = static_cast<const Chain *>(&object);
+          std::string list;
+
+          for (auto point : *chain) {
+            if (!list.empty()) {
+              list += ' ';
+            }
+
+            list += std::to_string(point.x);
+            list += ',';
+            list += std::to_string(point.y);
+          }
+
+          indent(3);
+          m_out += object.isPolygon() ? "<polygon" : "<polyline";
+          addAttribute("points", list);
+          m_out += "/>\n";
+        }
+
+        indent(2);
+        m_out += "</object>\n";
+      }
+
+      void writeObjectLayer(const ObjectLayer& layer) {
+        indent(1);
+        m_out += "<objectgroup";
+        writeLayerAttributes(layer);
+
+        if (!layer.getColor().empty()) {
+          addAttribute("color", layer.getColor());
+        }
+
+        if (layer.getDrawOrder() == DrawOrder::INDEX) {
+          addAttribute("draworder", "index");
+        }
+
+        m_out += ">\n";
+        writeProperties(layer, 2);
+
+        for (auto object : layer) {
+          writeObject(*object);
+        }
+
+        indent(1);
+        m_out += "</objectgroup>\n";
+      }
+
+      void writeImageLayer(const ImageLayer& layer) {
+        indent(1);
+        m_out += "<imagelayer";
+        writeLayerAttributes(layer);
+        m_out += ">\n";
+        writeProperties(layer, 2);
+
+        if (layer.getImage() != nullptr) {
+          writeImage(*layer.getImage(), 2);
+        }
+
+        indent(1);
+        m_out += "</imagelayer>\n";
+      }
+
+      void writeGroupLayer(const GroupLayer& layer) {
+        indent(1);
+        m_out += "<group";
+        writeLayerAttributes(layer);
+        m_out += ">\n";
+        writeProperties(layer, 2);
+
+        m_depth++;
+
+        for (auto child : layer.getLayers()) {
+          writeLayer(*child);
+        }
+
+        m_depth--;
+
+        indent(1);
+        m_out += "</group>\n";
+      }
+
+    private:
+      const Map& m_map;
+      LayerEncoding m_encoding;
+      fs::path m_base;
+      std::vector<const TileLayer *> m_layers;
+      std::vector<std::string> m_data;
+      std::size_t m_tileLayer = 0;
+      unsigned m_depth = 0;
+      std::string m_out;
+    };
+
+  }
+
+  std::string Map::saveMemory(LayerEncoding encoding, const fs::path& base) const {
+    return saveMemory(encoding, base, Executor::getDefault());
+  }
+
+  std::string Map::saveMemory(LayerEncoding encoding, const fs::path& base, Executor& executor) const {
+    Writer writer(*this, encoding, base);
+    writer.encodeLayers(executor);
+    return writer.write();
+  }
+
+  bool Map::saveFile(const fs::path& filename, LayerEncoding encoding) const {
+    return saveFile(filename, encoding, Executor::getDefault());
+  }
+
+  bool Map::saveFile(const fs::path& filename, LayerEncoding encoding, Executor& executor) const {
+    std::string content = saveMemory(encoding, filename.parent_path().empty() ? fs::path(".") : filename.parent_path(), executor);
+
+    std::ofstream out(filename.string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    out.write(content.data(), content.size());
+
+    if (!out) {
+      std::clog << "Error! Unable to write the TMX file: " << filename << '\n';
+      return false;
+    }
+
+    return true;
+  }
+
+}
@@ -15,9 +15,22 @@
  */
 #include <tmx/Object.h>
 
+#include <tmx/ObjectTemplate.h>
+
 namespace tmx {
 
   Object::~Object() {
   }
 
+  void Object::setTemplate(std::shared_ptr<const ObjectTemplate> objectTemplate) {
+    m_template = std::move(objectTemplate);
+    m_base = m_template ? &m_template->getObject() : nullptr;
+    setDefaults(m_base);
+  }
+
+  const std::vector<Vector2i>& Chain::getPoints() const noexcept {
+    static const std::vector<Vector2i> none;
+    return m_points ? *m_points : none;
+  }
+
 }
\ No newline at end of file
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/ObjectTemplate.h>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "Parser.h"
+
+namespace fs = boost::filesystem;
+
+namespace tmx {
+
+  namespace {
+
+    // a template is valid as long as the content of its file is the same
+    struct CacheEntry {
+      std::vector<char> content;
+      std::shared_ptr<const ObjectTemplate> objectTemplate;
+    };
+
+    std::mutex cacheMutex;
+    std::map<std::pair<FileSystem *, fs::path>, CacheEntry> cache;
+
+    bool readContent(File& file, std::vector<char>& content) {
+      content.resize(file.getSize());
+      const char *data = file.map();
+
+      if (data != nullptr) {
+        std::copy(data, data + content.size(), content.begin());
+        return true;
+      }
+
+      return file.read(0, content.data(), content.size()) == content.size();
+    }
+
+  }
+
+  std::shared_ptr<const ObjectTemplate> ObjectTemplate::load(const fs::path& filename, FileSystem& filesystem) {
+    auto key = std::make_pair(&filesystem, filename.lexically_normal());
+
+    auto file = filesystem.open(filename);
+    std::vector<char> content;
+
+    if (!file || !readContent(*file, content)) {
+      std::clog << "Error! Unknown template: " << filename << '\n';
+
+      std::lock_guard<std::mutex> lock(cacheMutex);
+      cache.erase(key);
+      return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto it = cache.find(key);
+
+    if (it != cache.end() && it->second.content == content) {
+      return it->second.objectTemplate;
+    }
+
+    // a template that can not be parsed is cached too, until its file
+    // changes, its instances would parse it again and again otherwise
+    CacheEntry& entry = cache[key];
+    entry.content = std::move(content);
+    entry.objectTemplate = parseTemplateFile(filename, filesystem);
+    return entry.objectTemplate;
+  }
+
+}
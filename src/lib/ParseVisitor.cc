@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/ParseVisitor.h>
+
+namespace tmx {
+
+  ParseVisitor::~ParseVisitor() {
+  }
+
+  ParseAction ParseVisitor::visitTileSet(const Map& map, const TileSet& tileset) {
+    return ParseAction::KEEP;
+  }
+
+  ParseAction ParseVisitor::visitTileLayer(const Map& map, const TileLayer& layer) {
+    return ParseAction::KEEP;
+  }
+
+  ParseAction ParseVisitor::visitObjectLayer(const Map& map, const ObjectLayer& layer) {
+    return ParseAction::KEEP;
+  }
+
+  ParseAction ParseVisitor::visitImageLayer(const Map& map, const ImageLayer& layer) {
+    return ParseAction::KEEP;
+  }
+
+  ParseAction ParseVisitor::visitGroupLayer(const Map& map, const GroupLayer& layer) {
+    return ParseAction::KEEP;
+  }
+
+  ParseAction ParseVisitor::visitObject(const Map& map, const ObjectLayer& layer, const Object& object) {
+    return ParseAction::KEEP;
+  }
+
+}
@@ -13,12 +13,13 @@
  * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
-#include <tmx/Map.h>
+#include "Parser.h"
 
 #include <cassert>
 #include <cstring>
 #include <cstdlib>
 
+#include <future>
 #include <string>
 #include <iostream>
 
@@ -29,16 +30,25 @@
 #include <tinyxml2.h>
 #include <zlib.h>
 
+#include <tmx/CompressionDictionary.h>
+#include <tmx/FileSystem.h>
+#include <tmx/GroupLayer.h>
 #include <tmx/Image.h>
 #include <tmx/ImageLayer.h>
 #include <tmx/Layer.h>
+#include <tmx/LoadProgress.h>
+#include <tmx/Map.h>
 #include <tmx/Object.h>
 #include <tmx/ObjectLayer.h>
+#include <tmx/ObjectTemplate.h>
+#include <tmx/ParseVisitor.h>
 #include <tmx/Terrain.h>
 #include <tmx/Tile.h>
 #include <tmx/TileLayer.h>
 #include <tmx/TileSet.h>
 
+#include "TileSetCache.h"
+
 #define INVALID static_cast<unsigned>(-1)
 
 namespace fs = boost::filesystem;
@@ -66,6 +76,124 @@ namespace tmx {
     return std::make_tuple(hflip, vflip, dflip, gid);
   }
 
+  // http://en.wikibooks.org/wiki/Algorithm_implementation/Miscellaneous/Base64
+  std::vector<uint8_t> decodeBase64(const std::string& input) {
+    std::string cleanInput = boost::algorithm::erase_all_copy(input, "\n");
+    cleanInput = boost::algorithm::erase_all_copy(cleanInput, " ");
+
+    std::size_t len = cleanInput.size();
+    assert(len % 4 == 0);
+
+    size_t padding = 0;
+    if (len >= 2) {
+      if (input[len - 1] == '=') {
+        padding++;
+      }
+
+      if (input[len - 2] == '=') {
+        padding++;
+      }
+    }
+
+    // Setup a vector to hold the result
+    std::vector<uint8_t> decoded;
+    decoded.reserve(((len / 4) * 3) - padding);
+
+    for (std::size_t i = 0; i < len; ) {
+
+      uint32_t tmp = 0; // Holds decoded quanta
+      for (int k = 0; k < 4; ++k) {
+        tmp <<= 6;
+
+        char c = cleanInput.at(i);
+
+        if (c >= 'A' && c <= 'Z') {
+          tmp |= c - 'A';
+        } else if (c >= 'a' && c <= 'z') {
+          tmp |= c - 'a' + 26;
+        } else if (c >= '0' && c <= '9') {
+          tmp |= c - '0' + 52;
+        } else if (c == '+') {
+          tmp |= 0x3E;
+        } else if (c == '/') {
+          tmp |= 0x3F;
+        } else if (c == '=') { //pad
+          switch(len - i) {
+          case 1: // One pad character
+            decoded.push_back((tmp >> 16) & 0x000000FF);
+            decoded.push_back((tmp >> 8 ) & 0x000000FF);
+            return decoded;
+          case 2: // Two pad characters
+            decoded.push_back((tmp >> 10) & 0x000000FF);
+            return decoded;
+          default:
+            assert(false);
+          }
+        } else {
+          std::clog << "Unknown character: '" << c << "' (" << static_cast<int>(c) << ")\n";
+          assert(false);
+        }
+
+        ++i;
+      }
+
+      decoded.push_back((tmp >> 16) & 0x000000FF);
+      decoded.push_back((tmp >> 8 ) & 0x000000FF);
+      decoded.push_back((tmp      ) & 0x000000FF);
+    }
+
+    return decoded;
+  }
+
+  #define TMPLEN 1024
+
+  std::vector<uint8_t> decodeCompressed(const std::vector<uint8_t>& input, const CompressionDictionary *dictionary) {
+    std::vector<uint8_t> uncompressed;
+
+    uint8_t tmp[TMPLEN];
+
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+
+    stream.next_in = input.data();
+    stream.avail_in = input.size();
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+
+    inflateInit2(&stream, 15 + 32); // allow to decode gzip and zlib format
+
+    int n = 0;
+    for (;;) {
+      n++;
+      stream.next_out = tmp;
+      stream.avail_out = TMPLEN;
+
+      int err = inflate(&stream, Z_SYNC_FLUSH);
+
+      if (err == Z_OK) {
+        uncompressed.insert(uncompressed.end(), tmp, tmp + TMPLEN - stream.avail_out);
+      } else if (err == Z_STREAM_END) {
+        uncompressed.insert(uncompressed.end(), tmp, tmp + TMPLEN - stream.avail_out);
+        break;
+      } else if (err == Z_NEED_DICT) {
+        // the data has been compressed with the dictionary of the map
+        if (!dictionary || inflateSetDictionary(&stream, dictionary->getData(), dictionary->getSize()) != Z_OK) {
+          std::clog << "Error! Missing or wrong compression dictionary for the layer data\n";
+          inflateEnd(&stream);
+          return std::vector<uint8_t>();
+        }
+      } else {
+        assert(false);
+      }
+    }
+
+    assert(stream.avail_in == 0);
+
+    inflateEnd(&stream);
+
+    return uncompressed;
+  }
+
   namespace {
 
     enum class Requirement {
@@ -80,6 +208,10 @@ namespace tmx {
       {
       }
 
+      const tinyxml2::XMLElement *getElement() const {
+        return m_elt;
+      }
+
       bool is(const char *name) const {
         return !std::strcmp(m_elt->Name(), name);
       }
@@ -194,6 +326,33 @@ namespace tmx {
       }
     };
 
+    // FNV-1a, stable between runs
+    uint64_t hashBytes(const char *data, std::size_t size, uint64_t hash = UINT64_C(14695981039346656037)) {
+      for (std::size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= UINT64_C(1099511628211);
+      }
+
+      return hash;
+    }
+
+    uint64_t hashElement(const XMLElementWrapper elt) {
+      tinyxml2::XMLPrinter printer(nullptr, true);
+      elt.getElement()->Accept(&printer);
+      return hashBytes(printer.CStr(), printer.CStrSize() - 1);
+    }
+
+    template<typename T>
+    std::unique_ptr<T> takeReusable(std::vector<std::pair<uint64_t, std::unique_ptr<T>>>& elements, uint64_t hash) {
+      for (auto& element : elements) {
+        if (element.first == hash && element.second) {
+          return std::move(element.second);
+        }
+      }
+
+      return nullptr;
+    }
+
     enum class Format {
       XML,
       BASE64,
@@ -205,118 +364,6 @@ namespace tmx {
     class Parser {
     public:
 
-      // http://en.wikibooks.org/wiki/Algorithm_implementation/Miscellaneous/Base64
-      std::vector<uint8_t> parseDataBase64(const std::string& input) {
-        std::string cleanInput = boost::algorithm::erase_all_copy(input, "\n");
-        cleanInput = boost::algorithm::erase_all_copy(cleanInput, " ");
-
-        std::size_t len = cleanInput.size();
-        assert(len % 4 == 0);
-
-        size_t padding = 0;
-        if (len >= 2) {
-          if (input[len - 1] == '=') {
-            padding++;
-          }
-
-          if (input[len - 2] == '=') {
-            padding++;
-          }
-        }
-
-        // Setup a vector to hold the result
-        std::vector<uint8_t> decoded;
-        decoded.reserve(((len / 4) * 3) - padding);
-
-        for (std::size_t i = 0; i < len; ) {
-
-          uint32_t tmp = 0; // Holds decoded quanta
-          for (int k = 0; k < 4; ++k) {
-            tmp <<= 6;
-
-            char c = cleanInput.at(i);
-
-            if (c >= 'A' && c <= 'Z') {
-              tmp |= c - 'A';
-            } else if (c >= 'a' && c <= 'z') {
-              tmp |= c - 'a' + 26;
-            } else if (c >= '0' && c <= '9') {
-              tmp |= c - '0' + 52;
-            } else if (c == '+') {
-              tmp |= 0x3E;
-            } else if (c == '/') {
-              tmp |= 0x3F;
-            } else if (c == '=') { //pad
-              switch(len - i) {
-              case 1: // One pad character
-                decoded.push_back((tmp >> 16) & 0x000000FF);
-                decoded.push_back((tmp >> 8 ) & 0x000000FF);
-                return decoded;
-              case 2: // Two pad characters
-                decoded.push_back((tmp >> 10) & 0x000000FF);
-                return decoded;
-              default:
-                assert(false);
-              }
-            } else {
-              std::clog << "Unknown character: '" << c << "' (" << static_cast<int>(c) << ")\n";
-              assert(false);
-            }
-
-            ++i;
-          }
-
-          decoded.push_back((tmp >> 16) & 0x000000FF);
-          decoded.push_back((tmp >> 8 ) & 0x000000FF);
-          decoded.push_back((tmp      ) & 0x000000FF);
-        }
-
-        return decoded;
-      }
-
-      #define TMPLEN 1024
-
-      std::vector<uint8_t> parseDataCompressed(const std::vector<uint8_t>& input) {
-        std::vector<uint8_t> uncompressed;
-
-        uint8_t tmp[TMPLEN];
-
-        z_stream stream;
-        std::memset(&stream, 0, sizeof(stream));
-
-        stream.next_in = input.data();
-        stream.avail_in = input.size();
-        stream.zalloc = Z_NULL;
-        stream.zfree = Z_NULL;
-
-        inflateInit2(&stream, 15 + 32); // allow to decode gzip and zlib format
-
-        int n = 0;
-        for (;;) {
-          n++;
-          stream.next_out = tmp;
-          stream.avail_out = TMPLEN;
-
-          int err = inflate(&stream, Z_SYNC_FLUSH);
-
-          if (err == Z_OK) {
-            uncompressed.insert(uncompressed.end(), tmp, tmp + TMPLEN - stream.avail_out);
-          } else if (err == Z_STREAM_END) {
-            uncompressed.insert(uncompressed.end(), tmp, tmp + TMPLEN - stream.avail_out);
-            break;
-          } else {
-            assert(false);
-          }
-        }
-
-        assert(stream.avail_in == 0);
-
-        inflateEnd(&stream);
-
-        return uncompressed;
-      }
-
-
       /*
        * Fragment parsers
        */
@@ -357,12 +404,12 @@ namespace tmx {
             break;
 
           case Format::BASE64:
-            data = parseDataBase64(elt.getText());
+            data = decodeBase64(elt.getText());
             break;
 
           case Format::BASE64_ZLIB:
           case Format::BASE64_GZIP:
-            data = parseDataCompressed(parseDataBase64(elt.getText()));
+            data = decodeCompressed(decodeBase64(elt.getText()), dictionary.get());
             break;
         }
 
@@ -383,20 +430,49 @@ namespace tmx {
         });
       }
 
+      void parseLayerOffset(const XMLElementWrapper elt, Layer *layer) {
+        double x = elt.getDoubleAttribute("offsetx", Requirement::OPTIONAL);
+        double y = elt.getDoubleAttribute("offsety", Requirement::OPTIONAL);
+        layer->setOffset(static_cast<float>(x), static_cast<float>(y));
+      }
+
       std::unique_ptr<Image> parseImage(const XMLElementWrapper elt) {
         assert(elt.is("image"));
 
         std::string format = elt.getStringAttribute("format", Requirement::OPTIONAL);
-        std::string source = elt.getStringAttribute("source");
         std::string trans = elt.getStringAttribute("trans", Requirement::OPTIONAL);
         unsigned width = elt.getUIntAttribute("width", Requirement::OPTIONAL);
         unsigned height = elt.getUIntAttribute("height", Requirement::OPTIONAL);
 
-        elt.parseOneElement("data", [](const XMLElementWrapper elt) {
-          assert(false && "Not implemented"); // TODO
+        bool embedded = false;
+        std::vector<uint8_t> data;
+
+        elt.parseOneElement("data", [&embedded,&data,this](const XMLElementWrapper elt) {
+          embedded = true;
+
+          // the layer dictionary is not used for the images
+          switch (parseDataFormat(elt)) {
+            case Format::BASE64:
+              data = decodeBase64(elt.getText());
+              break;
+
+            case Format::BASE64_ZLIB:
+            case Format::BASE64_GZIP:
+              data = decodeCompressed(decodeBase64(elt.getText()), nullptr);
+              break;
+
+            case Format::XML:
+            case Format::CSV:
+              std::clog << "Error! Wrong encoding for the data of an image\n";
+              break;
+          }
         });
 
-        return makeUnique<Image>(format, currentPath / source, trans, width, height);
+        std::string source = elt.getStringAttribute("source", embedded ? Requirement::OPTIONAL : Requirement::MANDATORY);
+
+        auto image = makeUnique<Image>(format, source.empty() ? fs::path() : currentPath / source, trans, width, height);
+        image->setData(std::move(data));
+        return image;
       }
 
       std::unique_ptr<ImageLayer> parseImageLayer(const XMLElementWrapper elt) {
@@ -410,6 +486,7 @@ namespace tmx {
         auto imageLayer = imageLayerPtr.get();
 
         parseComponent(elt, imageLayer);
+        parseLayerOffset(elt, imageLayer);
 
         elt.parseOneElement("image", [imageLayer,this](const XMLElementWrapper elt) {
           imageLayer->setImage(parseImage(elt));
@@ -444,14 +521,97 @@ namespace tmx {
         return ret;
       }
 
+      // a template is loaded once by map, all its instances see the same file
+      std::shared_ptr<const ObjectTemplate> loadTemplate(const fs::path& templatePath) {
+        fs::path key = templatePath.lexically_normal();
+        auto it = templates.find(key);
+
+        if (it != templates.end()) {
+          return it->second;
+        }
+
+        if (context.reuse) {
+          context.reuse->files.push_back(templatePath);
+        }
+
+        auto objectTemplate = ObjectTemplate::load(templatePath, getFileSystem());
+        templates.emplace(key, objectTemplate);
+        return objectTemplate;
+      }
+
+      std::unique_ptr<Object> parseTemplateInstance(const XMLElementWrapper elt) {
+        fs::path templatePath = currentPath / elt.getStringAttribute("template");
+
+        if (parsingTemplate) {
+          std::clog << "Error! A template can not refer to another template: " << templatePath << '\n';
+          return nullptr;
+        }
+
+        auto objectTemplate = loadTemplate(templatePath);
+
+        if (!objectTemplate) {
+          return nullptr;
+        }
+
+        TemplateInstance instance;
+        instance.id = elt.getUIntAttribute("id", Requirement::OPTIONAL);
+        instance.origin.x = elt.getUIntAttribute("x");
+        instance.origin.y = elt.getUIntAttribute("y");
+        instance.name = elt.getStringAttribute("name", Requirement::OPTIONAL);
+        instance.type = elt.getStringAttribute("type", Requirement::OPTIONAL);
+
+        if ((instance.hasRotation = elt.hasAttribute("rotation"))) {
+          instance.rotation = elt.getDoubleAttribute("rotation");
+        }
+
+        if ((instance.hasVisible = elt.hasAttribute("visible"))) {
+          instance.visible = elt.getBoolAttribute("visible");
+        }
+
+        if ((instance.hasWidth = elt.hasAttribute("width"))) {
+          instance.width = elt.getUIntAttribute("width");
+        }
+
+        if ((instance.hasHeight = elt.hasAttribute("height"))) {
+          instance.height = elt.getUIntAttribute("height");
+        }
+
+        if ((instance.hasGID = elt.hasAttribute("gid"))) {
+          instance.gid = elt.getUIntAttribute("gid");
+        }
+
+        auto parsePointsOf = [&instance,this](const XMLElementWrapper elt) {
+          instance.hasPoints = true;
+          instance.points = parsePoints(elt.getStringAttribute("points"));
+        };
+
+        elt.parseOneElement("polygon", parsePointsOf);
+        elt.parseOneElement("polyline", parsePointsOf);
+
+        auto object = instantiateTemplate(std::move(objectTemplate), instance, tilesetSources);
+        parseComponent(elt, object.get());
+        return object;
+      }
+
       std::unique_ptr<Object> parseObject(const XMLElementWrapper elt) {
         assert(elt.is("object"));
 
+        if (elt.hasAttribute("template")) {
+          auto object = parseTemplateInstance(elt);
+
+          if (object) {
+            return object;
+          }
+        }
+
+        // the object of a template has no position
+        Requirement position = parsingTemplate ? Requirement::OPTIONAL : Requirement::MANDATORY;
+
         unsigned id = elt.getUIntAttribute("id", Requirement::OPTIONAL);
         std::string name = elt.getStringAttribute("name", Requirement::OPTIONAL);
         std::string type = elt.getStringAttribute("type", Requirement::OPTIONAL);
-        unsigned x = elt.getUIntAttribute("x");
-        unsigned y = elt.getUIntAttribute("y");
+        unsigned x = elt.getUIntAttribute("x", position);
+        unsigned y = elt.getUIntAttribute("y", position);
         double rotation = elt.getDoubleAttribute("rotation", Requirement::OPTIONAL);
         bool visible = elt.getBoolAttribute("visible", Requirement::OPTIONAL, true);
 
@@ -519,10 +679,12 @@ namespace tmx {
         return std::move(objectPtr);
       }
 
-      std::unique_ptr<ObjectLayer> parseObjectGroup(const XMLElementWrapper elt) {
+      // the objects of the tiles are not visited, the visitor only sees the objects of the map
+      std::unique_ptr<ObjectLayer> parseObjectGroup(const XMLElementWrapper elt, bool visit) {
         assert(elt.is("objectgroup"));
 
-        std::string name = elt.getStringAttribute("name");
+        // the object groups of the tiles have no name
+        std::string name = elt.getStringAttribute("name", Requirement::OPTIONAL);
         double opacity = elt.getDoubleAttribute("opacity", Requirement::OPTIONAL, 1.0);
         bool visible = elt.getBoolAttribute("visible", Requirement::OPTIONAL, true);
 
@@ -544,14 +706,63 @@ namespace tmx {
         auto objectLayer = objectLayerPtr.get();
 
         parseComponent(elt, objectLayer);
+        parseLayerOffset(elt, objectLayer);
+
+        elt.parseManyElements("object", [objectLayer,visit,this](const XMLElementWrapper elt) {
+          auto object = parseObject(elt);
 
-        elt.parseManyElements("object", [objectLayer,this](const XMLElementWrapper elt) {
-          objectLayer->addObject(parseObject(elt));
+          if (!visit || mustKeep(&ParseVisitor::visitObject, *objectLayer, *object)) {
+            objectLayer->addObject(std::move(object));
+          }
         });
 
         return objectLayerPtr;
       }
 
+      std::unique_ptr<GroupLayer> parseGroup(const XMLElementWrapper elt) {
+        assert(elt.is("group"));
+
+        std::string name = elt.getStringAttribute("name", Requirement::OPTIONAL);
+        double opacity = elt.getDoubleAttribute("opacity", Requirement::OPTIONAL, 1.0);
+        bool visible = elt.getBoolAttribute("visible", Requirement::OPTIONAL, true);
+
+        auto groupPtr = makeUnique<GroupLayer>(name, opacity, visible);
+        auto group = groupPtr.get();
+
+        parseComponent(elt, group);
+        parseLayerOffset(elt, group);
+
+        elt.parseEachElement([group,this](const XMLElementWrapper elt) {
+          if (elt.is("layer")) {
+            auto layer = parseLayer(elt);
+
+            if (mustKeep(&ParseVisitor::visitTileLayer, *layer)) {
+              group->addLayer(std::move(layer));
+            }
+          } else if (elt.is("objectgroup")) {
+            auto layer = parseObjectGroup(elt, true);
+
+            if (mustKeep(&ParseVisitor::visitObjectLayer, *layer)) {
+              group->addLayer(std::move(layer));
+            }
+          } else if (elt.is("imagelayer")) {
+            auto layer = parseImageLayer(elt);
+
+            if (mustKeep(&ParseVisitor::visitImageLayer, *layer)) {
+              group->addLayer(std::move(layer));
+            }
+          } else if (elt.is("group")) {
+            auto layer = parseGroup(elt);
+
+            if (mustKeep(&ParseVisitor::visitGroupLayer, *layer)) {
+              group->addLayer(std::move(layer));
+            }
+          }
+        });
+
+        return groupPtr;
+      }
+
       std::unique_ptr<TileLayer> parseLayer(const XMLElementWrapper elt) {
         assert(elt.is("layer"));
 
@@ -563,6 +774,7 @@ namespace tmx {
         auto tileLayer = tileLayerPtr.get();
 
         parseComponent(elt, tileLayer);
+        parseLayerOffset(elt, tileLayer);
 
         elt.parseOneElement("data", [tileLayer,this](const XMLElementWrapper elt) {
           Format format = parseDataFormat(elt);
@@ -628,13 +840,20 @@ namespace tmx {
 
           unsigned t = 0;
           for (auto item : items) {
+            if (t == terrain.size()) {
+              break;
+            }
+
+            // an empty item is a corner without terrain
             if (!item.empty()) {
 #if __cplusplus >= 201103L
-              terrain[t++] = std::stoul(item);
+              terrain[t] = std::stoul(item);
 #else
-              terrain[t++] = std::strtoul(item.c_str(), nullptr, 0);
+              terrain[t] = std::strtoul(item.c_str(), nullptr, 0);
 #endif
             }
+
+            ++t;
           }
         }
 
@@ -649,6 +868,22 @@ namespace tmx {
           tile->setImage(parseImage(elt));
         });
 
+        elt.parseOneElement("animation", [tile](const XMLElementWrapper elt) {
+          std::vector<Frame> frames;
+
+          elt.parseEachElement([&frames](const XMLElementWrapper elt) {
+            if (elt.is("frame")) {
+              frames.push_back({ elt.getUIntAttribute("tileid"), elt.getUIntAttribute("duration") });
+            }
+          });
+
+          tile->setAnimation(std::move(frames));
+        });
+
+        elt.parseOneElement("objectgroup", [tile,this](const XMLElementWrapper elt) {
+          tile->setObjects(parseObjectGroup(elt, false));
+        });
+
         return tilePtr;
       }
 
@@ -707,16 +942,21 @@ namespace tmx {
       std::unique_ptr<TileSet> parseTileSetFromFile(unsigned firstgid, const std::string& filename) {
         fs::path tilesetPath = currentPath / filename;
 
+        if (isJsonFile(tilesetPath)) {
+          return parseJsonTileSetFile(tilesetPath, firstgid, context);
+        }
+
         tinyxml2::XMLDocument doc;
-        int err = doc.LoadFile(tilesetPath.string().c_str());
+        auto file = getFileSystem().open(tilesetPath);
 
-        if (doc.Error()) {
+        if (!file || !loadDocument(*file, doc)) {
           std::clog << "Error! Unable to load a TSX file: " << tilesetPath << '\n';
-          assert(err != tinyxml2::XML_NO_ERROR);
           return nullptr;
         }
 
-        assert(err == tinyxml2::XML_NO_ERROR);
+        if (context.progress) {
+          context.progress->addBytesRead(file->getSize());
+        }
 
         currentPath = tilesetPath.parent_path();
 
@@ -737,6 +977,92 @@ namespace tmx {
         return tileset;
       }
 
+      // the hash of an external tileset includes the content of its TSX file
+      uint64_t hashTileSet(const XMLElementWrapper elt) {
+        uint64_t hash = hashElement(elt);
+        std::string source = elt.getStringAttribute("source", Requirement::OPTIONAL);
+
+        if (!source.empty()) {
+          fs::path tilesetPath = currentPath / source;
+          context.reuse->files.push_back(tilesetPath);
+          hash = hashFile(tilesetPath, hash);
+        }
+
+        return hash;
+      }
+
+      uint64_t hashFile(const fs::path& path, uint64_t hash) {
+        auto file = getFileSystem().open(path);
+
+        if (file) {
+          const char *data = file->map();
+
+          if (data != nullptr) {
+            hash = hashBytes(data, file->getSize(), hash);
+          } else {
+            std::vector<char> buffer(file->getSize());
+            std::size_t size = file->read(0, buffer.data(), buffer.size());
+            hash = hashBytes(buffer.data(), size, hash);
+          }
+        }
+
+        return hash;
+      }
+
+      // the hash of a layer includes the content of the templates of its objects
+      uint64_t hashTemplates(const tinyxml2::XMLElement *elt, uint64_t hash) {
+        for (auto child = elt->FirstChildElement(); child != nullptr; child = child->NextSiblingElement()) {
+          const char *source = child->Attribute("template");
+
+          if (source != nullptr && std::strcmp(child->Name(), "object") == 0) {
+            fs::path templatePath = currentPath / source;
+            fs::path key = templatePath.lexically_normal();
+            auto it = templateHashes.find(key);
+
+            if (it == templateHashes.end()) {
+              context.reuse->files.push_back(templatePath);
+              it = templateHashes.emplace(key, hashFile(templatePath, UINT64_C(14695981039346656037))).first;
+            }
+
+            hash = hashBytes(reinterpret_cast<const char *>(&it->second), sizeof it->second, hash);
+          }
+
+          hash = hashTemplates(child, hash);
+        }
+
+        return hash;
+      }
+
+      template<typename T>
+      std::unique_ptr<T> reuseLayer(const XMLElementWrapper elt, uint64_t& hash) {
+        if (context.reuse == nullptr) {
+          return nullptr;
+        }
+
+        // the name of the element is in the hash, so the kind of layer is the same
+        hash = hashTemplates(elt.getElement(), hashElement(elt));
+
+        // the same data decodes differently with another dictionary
+        if (dictionary) {
+          hash ^= dictionary->getId();
+        }
+
+        std::unique_ptr<Layer> layer = takeReusable(context.reuse->layers, hash);
+        return std::unique_ptr<T>(static_cast<T *>(layer.release()));
+      }
+
+      void addLayer(Map *map, std::unique_ptr<Layer> layer, uint64_t hash, bool decoded) {
+        if (context.reuse) {
+          context.reuse->layerHashes.push_back(hash);
+
+          if (decoded) {
+            context.reuse->decodedLayers.push_back(layer->getName());
+          }
+        }
+
+        map->addLayer(std::move(layer));
+      }
+
       std::unique_ptr<TileSet> parseTileSet(const XMLElementWrapper elt) {
         assert(elt.is("tileset"));
 
@@ -744,7 +1070,7 @@ namespace tmx {
         std::string source = elt.getStringAttribute("source", Requirement::OPTIONAL);
 
         if (!source.empty()) {
-          return parseTileSetFromFile(firstgid, source);
+          return loadTileSetFile(currentPath / source, firstgid, context);
         }
 
         return parseTileSetFromElement(firstgid, elt);
@@ -825,55 +1151,451 @@ namespace tmx {
         auto map = mapPtr.get();
         parseComponent(elt, map);
 
+        if (map->hasProperty(CompressionDictionary::getPropertyName())) {
+          fs::path source = map->getProperty(CompressionDictionary::getPropertyName(), "");
+          fs::path dictionaryPath = currentPath / source;
+          dictionary = CompressionDictionary::load(dictionaryPath, getFileSystem());
+
+          if (dictionary) {
+            map->setCompressionDictionary(source, dictionary);
+          }
+
+          if (context.reuse) {
+            context.reuse->files.push_back(dictionaryPath);
+          }
+        }
+
+        currentMap = map;
+
+        if (context.progress) {
+          unsigned tilesets = 0;
+          unsigned layers = 0;
+
+          elt.parseEachElement([&tilesets,&layers](const XMLElementWrapper elt) {
+            if (elt.is("tileset")) {
+              tilesets++;
+            } else if (elt.is("layer") || elt.is("objectgroup") || elt.is("imagelayer") || elt.is("group")) {
+              layers++;
+            }
+          });
+
+          context.progress->setCounts(tilesets, layers);
+        }
+
         elt.parseManyElements("tileset", [map,this](const XMLElementWrapper elt) {
-          map->addTileSet(parseTileSet(elt));
+          if (isCancelled()) {
+            return;
+          }
+
+          std::string source = elt.getStringAttribute("source", Requirement::OPTIONAL);
+
+          if (!source.empty()) {
+            tilesetSources[(currentPath / source).lexically_normal()] = elt.getUIntAttribute("firstgid");
+          }
+
+          std::unique_ptr<TileSet> tileset;
+          uint64_t hash = 0;
+          bool decoded = false;
+
+          if (context.reuse) {
+            hash = hashTileSet(elt);
+            tileset = takeReusable(context.reuse->tilesets, hash);
+          }
+
+          if (!tileset) {
+            tileset = parseTileSet(elt);
+            decoded = true;
+          }
+
+          if (tileset && mustKeep(&ParseVisitor::visitTileSet, *tileset)) {
+            if (context.reuse) {
+              context.reuse->tilesetHashes.push_back(hash);
+
+              if (decoded) {
+                context.reuse->decodedTileSets.push_back(tileset->getName());
+              }
+            }
+
+            map->addTileSet(std::move(tileset));
+          }
+
+          if (context.progress) {
+            context.progress->addTileSetDecoded();
+          }
         });
 
         elt.parseEachElement([map,this](const XMLElementWrapper elt) {
+          if (isCancelled()) {
+            return;
+          }
+
+          uint64_t hash = 0;
+
           if (elt.is("layer")) {
-            map->addLayer(parseLayer(elt));
+            auto layer = reuseLayer<TileLayer>(elt, hash);
+            bool decoded = !layer;
+
+            if (decoded) {
+              layer = parseLayer(elt);
+            }
+
+            if (mustKeep(&ParseVisitor::visitTileLayer, *layer)) {
+              addLayer(map, std::move(layer), hash, decoded);
+            }
           } else if (elt.is("objectgroup")) {
-            map->addLayer(parseObjectGroup(elt));
+            auto layer = reuseLayer<ObjectLayer>(elt, hash);
+            bool decoded = !layer;
+
+            if (decoded) {
+              layer = parseObjectGroup(elt, true);
+            }
+
+            if (mustKeep(&ParseVisitor::visitObjectLayer, *layer)) {
+              addLayer(map, std::move(layer), hash, decoded);
+            }
           } else if (elt.is("imagelayer")) {
-            map->addLayer(parseImageLayer(elt));
+            auto layer = reuseLayer<ImageLayer>(elt, hash);
+            bool decoded = !layer;
+
+            if (decoded) {
+              layer = parseImageLayer(elt);
+            }
+
+            if (mustKeep(&ParseVisitor::visitImageLayer, *layer)) {
+              addLayer(map, std::move(layer), hash, decoded);
+            }
+          } else if (elt.is("group")) {
+            auto layer = reuseLayer<GroupLayer>(elt, hash);
+            bool decoded = !layer;
+
+            if (decoded) {
+              layer = parseGroup(elt);
+            }
+
+            if (mustKeep(&ParseVisitor::visitGroupLayer, *layer)) {
+              addLayer(map, std::move(layer), hash, decoded);
+            }
+          } else {
+            return;
+          }
+
+          if (context.progress) {
+            context.progress->addLayerDecoded();
           }
         });
 
+        if (isCancelled()) {
+          return nullptr;
+        }
+
         return mapPtr;
       }
 
-      Parser(const boost::filesystem::path& filename) : mapPath(filename) { }
+      std::shared_ptr<const ObjectTemplate> parseTemplate() {
+        auto file = getFileSystem().open(mapPath);
+
+        if (!file) {
+          std::clog << "Error! Unknown TX file: " << mapPath << '\n';
+          return nullptr;
+        }
+
+        tinyxml2::XMLDocument doc;
+
+        if (!loadDocument(*file, doc)) {
+          std::clog << "Error! Unable to load the TX file: " << mapPath << '\n';
+          return nullptr;
+        }
+
+        const XMLElementWrapper elt(doc.RootElement());
+
+        if (!elt.is("template")) {
+          std::clog << "Error! Not a template: " << mapPath << '\n';
+          return nullptr;
+        }
+
+        currentPath = mapPath.parent_path();
+        parsingTemplate = true;
+
+        unsigned firstgid = 0;
+        fs::path tilesetPath;
+
+        elt.parseOneElement("tileset", [&firstgid,&tilesetPath,this](const XMLElementWrapper elt) {
+          firstgid = elt.getUIntAttribute("firstgid");
+          tilesetPath = (currentPath / elt.getStringAttribute("source")).lexically_normal();
+        });
+
+        std::unique_ptr<Object> object;
+
+        elt.parseOneElement("object", [&object,this](const XMLElementWrapper elt) {
+          object = parseObject(elt);
+        });
+
+        if (!object) {
+          std::clog << "Error! No object in the template: " << mapPath << '\n';
+          return nullptr;
+        }
+
+        return std::make_shared<const ObjectTemplate>(mapPath, std::move(object), tilesetPath, firstgid);
+      }
+
+      Parser(const boost::filesystem::path& filename, const ParseContext& context)
+        : mapPath(filename), context(context), currentMap(nullptr), parsingTemplate(false) { }
+
+      FileSystem& getFileSystem() const {
+        return context.filesystem ? *context.filesystem : FileSystem::getDefault();
+      }
+
+      bool isCancelled() const {
+        return context.progress != nullptr && context.progress->isCancelled();
+      }
+
+      template<typename... Elements>
+      bool mustKeep(ParseAction (ParseVisitor::*visit)(const Map&, const Elements&...), const Elements&... elements) {
+        if (context.visitor == nullptr) {
+          return true;
+        }
+
+        assert(currentMap);
+        return (context.visitor->*visit)(*currentMap, elements...) == ParseAction::KEEP;
+      }
 
       std::unique_ptr<Map> parse() {
-        if (!fs::is_regular_file(mapPath)) {
+        auto file = getFileSystem().open(mapPath);
+
+        if (!file) {
           std::clog << "Error! Unknown TMX file: " << mapPath << '\n';
           return nullptr;
         }
 
-        tinyxml2::XMLDocument doc;
-        int err = doc.LoadFile(mapPath.string().c_str());
+        tinyxml2::XMLDocument localDoc;
+        tinyxml2::XMLDocument& doc = context.document ? *context.document : localDoc;
 
-        if (doc.Error()) {
-          assert(err != tinyxml2::XML_NO_ERROR);
+        if (!loadDocument(*file, doc)) {
           std::clog << "Error! Unable to load the TMX file: " << mapPath << '\n';
           return nullptr;
         }
 
         currentPath = mapPath.parent_path();
 
-        assert(err == tinyxml2::XML_NO_ERROR);
-        return parseMap(doc.RootElement());
+        if (context.progress) {
+          context.progress->addBytesRead(file->getSize());
+        }
+
+        if (context.reuse) {
+          context.reuse->files.push_back(mapPath);
+        }
+
+        const XMLElementWrapper elt(doc.RootElement());
+
+        // a file being saved by an editor may be seen by a reloader
+        if (!elt.is("map")) {
+          std::clog << "Error! Not a map: " << mapPath << '\n';
+          return nullptr;
+        }
+
+        return parseMap(elt);
       }
 
       fs::path mapPath;
       fs::path currentPath;
+      const ParseContext& context;
+      const Map *currentMap;
+      std::shared_ptr<const CompressionDictionary> dictionary;
+      TileSetSources tilesetSources;
+      std::map<fs::path, std::shared_ptr<const ObjectTemplate>> templates;
+      std::map<fs::path, uint64_t> templateHashes;
+      bool parsingTemplate;
     };
 
   }
 
-  std::unique_ptr<Map> Map::parseFile(const boost::filesystem::path& filename) {
-    Parser parser(filename);
+  ParseContext::ParseContext()
+    : progress(nullptr), visitor(nullptr), tilesets(nullptr), document(nullptr), filesystem(nullptr), reuse(nullptr)
+  {
+  }
+
+  ReuseCache::ReuseCache() {
+  }
+
+  TemplateInstance::TemplateInstance()
+    : id(0), hasRotation(false), rotation(0.0), hasVisible(false), visible(true)
+    , hasWidth(false), width(0), hasHeight(false), height(0)
+    , hasGID(false), gid(0), hasPoints(false)
+  {
+  }
+
+  ReuseCache::~ReuseCache() {
+  }
+
+  bool loadDocument(File& file, tinyxml2::XMLDocument& doc) {
+    const std::size_t size = file.getSize();
+    const char *data = file.map();
+    std::vector<char> buffer;
+
+    if (data == nullptr) {
+      buffer.resize(size);
+
+      if (file.read(0, buffer.data(), size) != size) {
+        return false;
+      }
+
+      data = buffer.data();
+    }
+
+    int err = doc.Parse(data, size);
+
+    if (doc.Error()) {
+      assert(err != tinyxml2::XML_NO_ERROR);
+      return false;
+    }
+
+    assert(err == tinyxml2::XML_NO_ERROR);
+    return true;
+  }
+
+  std::unique_ptr<Map> parseMapFile(const boost::filesystem::path& filename, const ParseContext& context) {
+    if (isJsonFile(filename)) {
+      return parseJsonMapFile(filename, context);
+    }
+
+    Parser parser(filename, context);
     return parser.parse();
   }
 
+  std::unique_ptr<TileSet> parseTileSetFile(const boost::filesystem::path& filename, unsigned firstgid, const ParseContext& context) {
+    if (isJsonFile(filename)) {
+      return parseJsonTileSetFile(filename, firstgid, context);
+    }
+
+    // there is no map under construction, the tileset is visited as a whole by the parser of the map
+    ParseContext tilesetContext = context;
+    tilesetContext.visitor = nullptr;
+
+    Parser parser(filename, tilesetContext);
+    parser.currentPath = filename.parent_path();
+    return parser.parseTileSetFromFile(firstgid, filename.filename().string());
+  }
+
+  std::unique_ptr<Object> instantiateTemplate(std::shared_ptr<const ObjectTemplate> objectTemplate, TemplateInstance& instance, const TileSetSources& tilesets) {
+    const Object& base = objectTemplate->getObject();
+    double rotation = instance.hasRotation ? instance.rotation : base.getRotation();
+    bool visible = instance.hasVisible ? instance.visible : base.isVisible();
+
+    std::unique_ptr<Object> object;
+
+    switch (base.getKind()) {
+      case Object::RECTANGLE:
+      case Object::ELLIPSE: {
+        auto& boxed = static_cast<const Boxed&>(base);
+        unsigned width = instance.hasWidth ? instance.width : boxed.getWidth();
+        unsigned height = instance.hasHeight ? instance.height : boxed.getHeight();
+
+        if (base.isRectangle()) {
+          object = makeUnique<Rectangle>(instance.id, instance.name, instance.type, instance.origin, rotation, visible, width, height);
+        } else {
+          object = makeUnique<Ellipse>(instance.id, instance.name, instance.type, instance.origin, rotation, visible, width, height);
+        }
+
+        break;
+      }
+
+      case Object::POLYLINE:
+      case Object::POLYGON: {
+        std::unique_ptr<Chain> chain;
+
+        if (base.isPolyline()) {
+          chain = makeUnique<Polyline>(instance.id, instance.name, instance.type, instance.origin, rotation, visible);
+        } else {
+          chain = makeUnique<Polygon>(instance.id, instance.name, instance.type, instance.origin, rotation, visible);
+        }
+
+        if (instance.hasPoints) {
+          chain->setPoints(std::move(instance.points));
+        } else {
+          chain->sharePoints(static_cast<const Chain&>(base));
+        }
+
+        object = std::move(chain);
+        break;
+      }
+
+      case Object::TILE: {
+        auto& tile = static_cast<const TileObject&>(base);
+        bool hflip = tile.isHorizontallyFlipped();
+        bool vflip = tile.isVerticallyFlipped();
+        bool dflip = tile.isDiagonallyFlipped();
+        unsigned gid = tile.getGID();
+
+        if (instance.hasGID) {
+          std::tie(hflip, vflip, dflip, gid) = decodeGID(instance.gid);
+        } else if (objectTemplate->hasTileSet()) {
+          // the tileset of the template may have another first gid in the map
+          auto it = tilesets.find(objectTemplate->getTileSetSource());
+
+          if (it != tilesets.end()) {
+            gid = gid - objectTemplate->getFirstGID() + it->second;
+          } else {
+            std::clog << "Error! The tileset of the template is not in the map: " << objectTemplate->getTileSetSource() << '\n';
+          }
+        }
+
+        object = makeUnique<TileObject>(instance.id, instance.name, instance.type, instance.origin, rotation, visible, gid, hflip, vflip, dflip);
+        break;
+      }
+    }
+
+    assert(object);
+    object->setTemplate(std::move(objectTemplate));
+    return object;
+  }
+
+  std::shared_ptr<const ObjectTemplate> parseTemplateFile(const boost::filesystem::path& filename, FileSystem& filesystem) {
+    if (isJsonFile(filename)) {
+      return parseJsonTemplateFile(filename, filesystem);
+    }
+
+    ParseContext context;
+    context.filesystem = &filesystem;
+
+    Parser parser(filename, context);
+    return parser.parseTemplate();
+  }
+
+  std::unique_ptr<Map> Map::parseFile(const boost::filesystem::path& filename) {
+    ParseContext context;
+    return parseMapFile(filename, context);
+  }
+
+  std::unique_ptr<Map> Map::parseFile(const boost::filesystem::path& filename, FileSystem& filesystem) {
+    ParseContext context;
+    context.filesystem = &filesystem;
+    return parseMapFile(filename, context);
+  }
+
+  std::unique_ptr<Map> Map::parseFile(const boost::filesystem::path& filename, ParseVisitor& visitor) {
+    ParseContext context;
+    context.visitor = &visitor;
+    return parseMapFile(filename, context);
+  }
+
+  std::future<std::unique_ptr<Map>> Map::parseFileAsync(const boost::filesystem::path& filename,
+      Executor& executor, std::shared_ptr<LoadProgress> progress) {
+    typedef std::packaged_task<std::unique_ptr<Map>()> Task;
+
+    auto task = std::make_shared<Task>([filename, progress]() {
+      ParseContext context;
+      context.progress = progress.get();
+      return parseMapFile(filename, context);
+    });
+
+    auto future = task->get_future();
+    executor.execute([task]() { (*task)(); });
+    return future;
+  }
+
+  std::future<std::unique_ptr<Map>> Map::parseFileAsync(const boost::filesystem::path& filename,
+      std::shared_ptr<LoadProgress> progress) {
+    return parseFileAsync(filename, Executor::getDefault(), std::move(progress));
+  }
+
 }
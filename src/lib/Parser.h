@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_PARSER_H
+#define TMX_PARSER_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <tmx/Geometry.h>
+
+namespace tinyxml2 {
+  class XMLDocument;
+}
+
+namespace tmx {
+  class CompressionDictionary;
+  class File;
+  class FileSystem;
+  class Layer;
+  class LoadProgress;
+  class Map;
+  class Object;
+  class ObjectTemplate;
+  class ParseVisitor;
+  class TileSet;
+  class TileSetCache;
+
+  /*
+   * The elements of a previous version of a map, with the hash of their XML
+   * subtree (and of the TSX file for external tilesets). The parser takes an
+   * element instead of decoding it when the new subtree has the same hash.
+   * The parser records the hashes of the new map and the elements it had to
+   * decode.
+   */
+  struct ReuseCache {
+    ReuseCache();
+    ~ReuseCache();
+
+    // input: the elements of the previous map, taken elements are null
+    std::vector<std::pair<uint64_t, std::unique_ptr<TileSet>>> tilesets;
+    std::vector<std::pair<uint64_t, std::unique_ptr<Layer>>> layers;
+
+    // output: the hashes of the elements of the new map, in order
+    std::vector<uint64_t> tilesetHashes;
+    std::vector<uint64_t> layerHashes;
+
+    // output: the names of the decoded elements
+    std::vector<std::string> decodedTileSets;
+    std::vector<std::string> decodedLayers;
+
+    // output: all the files read by the parser
+    std::vector<boost::filesystem::path> files;
+  };
+
+  /*
+   * The optional state shared by a parser with its caller. Every pointer
+   * may be null.
+   */
+  struct ParseContext {
+    ParseContext();
+
+    LoadProgress *progress;           // reports the progress and the cancellation
+    ParseVisitor *visitor;            // visits the elements while they are parsed
+    TileSetCache *tilesets;           // shares TSX files between parsers
+    tinyxml2::XMLDocument *document;  // the document to use for the TMX file
+    FileSystem *filesystem;           // the file system of the files, or the default one
+    ReuseCache *reuse;                // the elements of a previous version of the map
+  };
+
+  /*
+   * The attributes of an instance of a template in a map. The instance
+   * keeps the attributes of the template that it does not override.
+   */
+  struct TemplateInstance {
+    TemplateInstance();
+
+    unsigned id;
+    Vector2u origin;
+    std::string name;                 // empty for the name of the template
+    std::string type;                 // empty for the type of the template
+    bool hasRotation;
+    double rotation;
+    bool hasVisible;
+    bool visible;
+    bool hasWidth;
+    unsigned width;
+    bool hasHeight;
+    unsigned height;
+    bool hasGID;
+    unsigned gid;                     // with the flags
+    bool hasPoints;
+    std::vector<Vector2i> points;
+  };
+
+  // the first gid of the external tilesets of a map, by normalized path
+  typedef std::map<boost::filesystem::path, unsigned> TileSetSources;
+
+  // creates an instance of a template, the gid of a tile template is translated in the map
+  std::unique_ptr<Object> instantiateTemplate(std::shared_ptr<const ObjectTemplate> objectTemplate, TemplateInstance& instance, const TileSetSources& tilesets);
+
+  // chooses the format with the extension: .json and .tj for JSON, TX otherwise
+  std::shared_ptr<const ObjectTemplate> parseTemplateFile(const boost::filesystem::path& filename, FileSystem& filesystem);
+
+  std::shared_ptr<const ObjectTemplate> parseJsonTemplateFile(const boost::filesystem::path& filename, FileSystem& filesystem);
+
+  // returns the flags (horizontal, vertical, diagonal) and the gid without the flags
+  std::tuple<bool, bool, bool, unsigned> decodeGID(unsigned gid);
+
+  // the decoding of the layer data, shared by the TMX and JSON formats
+  std::vector<uint8_t> decodeBase64(const std::string& input);
+  std::vector<uint8_t> decodeCompressed(const std::vector<uint8_t>& input, const CompressionDictionary *dictionary);
+
+  // returns true if the document has been successfully parsed
+  bool loadDocument(File& file, tinyxml2::XMLDocument& doc);
+
+  // chooses the format with the extension: .json and .tmj for JSON, TMX otherwise
+  std::unique_ptr<Map> parseMapFile(const boost::filesystem::path& filename, const ParseContext& context);
+
+  std::unique_ptr<Map> parseJsonMapFile(const boost::filesystem::path& filename, const ParseContext& context);
+
+  // chooses the format with the extension: .json and .tsj for JSON, TSX otherwise
+  std::unique_ptr<TileSet> parseTileSetFile(const boost::filesystem::path& filename, unsigned firstgid, const ParseContext& context);
+
+  std::unique_ptr<TileSet> parseJsonTileSetFile(const boost::filesystem::path& filename, unsigned firstgid, const ParseContext& context);
+
+  bool isJsonFile(const boost::filesystem::path& filename);
+
+}
+
+#endif // TMX_PARSER_H
@@ -0,0 +1,402 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/RegionLoader.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include <tmx/Object.h>
+#include <tmx/ObjectLayer.h>
+#include <tmx/TileLayer.h>
+
+#include "MapCompiler.h"
+
+namespace fs = boost::filesystem;
+
+namespace tmx {
+
+  RegionLoader::RegionLoader(std::unique_ptr<File> file)
+  : m_file(std::move(file))
+  , m_bytesRead(0)
+  {
+    std::memset(&m_header, 0, sizeof m_header);
+  }
+
+  bool RegionLoader::readBytes(uint64_t offset, void *buffer, std::size_t size) {
+    if (size == 0) {
+      return true;
+    }
+
+    std::size_t read = m_file->read(offset, buffer, size);
+    m_bytesRead += read;
+    return read == size;
+  }
+
+  bool RegionLoader::readString(uint32_t index, std::string& str) {
+    auto it = m_strings.find(index);
+
+    if (it != m_strings.end()) {
+      str = it->second;
+      return true;
+    }
+
+    // the end of a string is the beginning of the next one
+    uint32_t offsets[2];
+    uint64_t count = m_header.sections[compiled::STRING_OFFSETS].count;
+
+    if (index + 1 < count) {
+      if (!readElements(compiled::STRING_OFFSETS, index, 2, offsets)) {
+        return false;
+      }
+    } else {
+      if (!readElements(compiled::STRING_OFFSETS, index, 1, offsets)) {
+        return false;
+      }
+
+      offsets[1] = m_header.sections[compiled::STRING_DATA].count;
+    }
+
+    if (offsets[1] <= offsets[0]) {
+      return false;
+    }
+
+    std::vector<char> data(offsets[1] - offsets[0]);
+
+    if (!readElements(compiled::STRING_DATA, offsets[0], data.size(), data.data())) {
+      return false;
+    }
+
+    str.assign(data.data(), data.size() - 1);
+    m_strings.emplace(index, str);
+    return true;
+  }
+
+  bool RegionLoader::readProperties(const compiled::Range& range, Component& component) {
+    std::vector<compiled::Property> properties(range.count);
+
+    if (!readElements(compiled::PROPERTIES, range.first, range.count, properties.data())) {
+      return false;
+    }
+
+    for (auto& property : properties) {
+      std::string key, value;
+
+      if (!readString(property.key, key) || !readString(property.value, value)) {
+        return false;
+      }
+
+      component.addProperty(key, value);
+    }
+
+    return true;
+  }
+
+  bool RegionLoader::readTileLayer(const compiled::Layer& data, const Rect& rect, MapRegion& region) {
+    unsigned size = m_header.chunkSize;
+    unsigned chunksPerRow = (m_header.width + size - 1) / size;
+
+    std::vector<uint32_t> cells(rect.width * rect.height, 0);
+
+    if (rect.width > 0 && rect.height > 0) {
+      unsigned cxmin = rect.x / size;
+      unsigned cxmax = (rect.x + rect.width - 1) / size;
+      unsigned cymin = rect.y / size;
+      unsigned cymax = (rect.y + rect.height - 1) / size;
+
+      std::vector<compiled::Chunk> chunks(cxmax - cxmin + 1);
+      std::vector<uint32_t> buffer;
+
+      for (unsigned cy = cymin; cy <= cymax; ++cy) {
+        // the chunks of a row of the region are contiguous in the index
+        if (!readElements(compiled::CHUNKS, data.chunks.first + cy * chunksPerRow + cxmin, chunks.size(), chunks.data())) {
+          return false;
+        }
+
+        unsigned ymin = std::max(rect.y, cy * size);
+        unsigned ymax = std::min(rect.y + rect.height, (cy + 1) * size);
+
+        for (unsigned cx = cxmin; cx <= cxmax; ++cx) {
+          unsigned chunkWidth = std::min(size, m_header.width - cx * size);
+          unsigned xmin = std::max(rect.x, cx * size);
+          unsigned xmax = std::min(rect.x + rect.width, cx * size + chunkWidth);
+
+          // read the rows of the chunk in a single block
+          buffer.resize((ymax - ymin) * chunkWidth);
+          uint64_t first = chunks[cx - cxmin].cells + (ymin - cy * size) * chunkWidth;
+
+          if (!readElements(compiled::CELLS, first, buffer.size(), buffer.data())) {
+            return false;
+          }
+
+          for (unsigned y = ymin; y < ymax; ++y) {
+            auto row = buffer.begin() + (y - ymin) * chunkWidth;
+            std::copy(row + (xmin - cx * size), row + (xmax - cx * size), cells.begin() + (y - rect.y) * rect.width + (xmin - rect.x));
+          }
+        }
+      }
+    }
+
+    std::string name;
+
+    if (!readString(data.name, name)) {
+      return false;
+    }
+
+    std::unique_ptr<TileLayer> layer(new TileLayer(name, data.opacity, data.visible != 0));
+    layer->setOffset(data.offset.x, data.offset.y);
+
+    if (!readProperties(data.properties, *layer)) {
+      return false;
+    }
+
+    for (uint32_t raw : cells) {
+      layer->addCell(Cell::fromRawGID(raw));
+    }
+
+    region.addLayer(std::move(layer));
+    return true;
+  }
+
+  bool RegionLoader::readObjectLayer(const compiled::Layer& data, const Rect& rect, MapRegion& region) {
+    unsigned size = m_header.chunkSize;
+    unsigned chunksPerRow = (m_header.width + size - 1) / size;
+
+    std::vector<uint32_t> indices;
+
+    if (rect.width > 0 && rect.height > 0) {
+      unsigned cxmin = rect.x / size;
+      unsigned cxmax = (rect.x + rect.width - 1) / size;
+      unsigned cymin = rect.y / size;
+      unsigned cymax = (rect.y + rect.height - 1) / size;
+
+      std::vector<compiled::Chunk> chunks(cxmax - cxmin + 1);
+
+      for (unsigned cy = cymin; cy <= cymax; ++cy) {
+        if (!readElements(compiled::CHUNKS, data.chunks.first + cy * chunksPerRow + cxmin, chunks.size(), chunks.data())) {
+          return false;
+        }
+
+        for (auto& chunk : chunks) {
+          std::size_t offset = indices.size();
+          indices.resize(offset + chunk.objects.count);
+
+          if (!readElements(compiled::OBJECT_REFS, chunk.objects.first, chunk.objects.count, indices.data() + offset)) {
+            return false;
+          }
+        }
+      }
+
+      // an object may be in several chunks, keep the objects in their original order
+      std::sort(indices.begin(), indices.end());
+      indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+    }
+
+    std::string name, color;
+
+    if (!readString(data.name, name) || !readString(data.color, color)) {
+      return false;
+    }
+
+    std::unique_ptr<ObjectLayer> layer(new ObjectLayer(name, data.opacity, data.visible != 0, color, static_cast<DrawOrder>(data.drawOrder)));
+    layer->setOffset(data.offset.x, data.offset.y);
+
+    if (!readProperties(data.properties, *layer)) {
+      return false;
+    }
+
+    int left = rect.x * m_header.tilewidth;
+    int top = rect.y * m_header.tileheight;
+    int right = (rect.x + rect.width) * m_header.tilewidth;
+    int bottom = (rect.y + rect.height) * m_header.tileheight;
+
+    for (uint32_t index : indices) {
+      compiled::Bounds bounds;
+
+      if (!readElements(compiled::OBJECT_BOUNDS, index, 1, &bounds)) {
+        return false;
+      }
+
+      if (bounds.right < left || bounds.left >= right || bounds.bottom < top || bounds.top >= bottom) {
+        continue;
+      }
+
+      auto object = readObject(index);
+
+      if (!object) {
+        return false;
+      }
+
+      layer->addObject(std::move(object));
+    }
+
+    region.addLayer(std::move(layer));
+    return true;
+  }
+
+  std::unique_ptr<Object> RegionLoader::readObject(uint32_t index) {
+    uint8_t kind, visible;
+    uint32_t id, name, type, gid;
+    Vector2u origin;
+    double rotation;
+    Size size;
+    compiled::Range points, properties;
+
+    if (!readElements(compiled::OBJECT_KINDS, index, 1, &kind)
+        || !readElements(compiled::OBJECT_VISIBLE, index, 1, &visible)
+        || !readElements(compiled::OBJECT_IDS, index, 1, &id)
+        || !readElements(compiled::OBJECT_NAMES, index, 1, &name)
+        || !readElements(compiled::OBJECT_TYPES, index, 1, &type)
+        || !readElements(compiled::OBJECT_ORIGINS, index, 1, &origin)
+        || !readElements(compiled::OBJECT_ROTATIONS, index, 1, &rotation)
+        || !readElements(compiled::OBJECT_SIZES, index, 1, &size)
+        || !readElements(compiled::OBJECT_GIDS, index, 1, &gid)
+        || !readElements(compiled::OBJECT_POINTS, index, 1, &points)
+        || !readElements(compiled::OBJECT_PROPERTIES, index, 1, &properties)) {
+      return nullptr;
+    }
+
+    std::vector<Vector2i> pointData(points.count);
+    std::string nameData, typeData;
+
+    if (!readElements(compiled::POINTS, points.first, points.count, pointData.data())
+        || !readString(name, nameData) || !readString(type, typeData)) {
+      return nullptr;
+    }
+
+    auto object = makeObject(kind, id, nameData, typeData, origin, rotation, visible != 0, size, gid, std::move(pointData));
+
+    if (!object || !readProperties(properties, *object)) {
+      return nullptr;
+    }
+
+    return object;
+  }
+
+  std::unique_ptr<MapRegion> RegionLoader::loadRegion(const std::vector<std::string>& layers, const Rect& rect) {
+    std::size_t bytesRead = m_bytesRead;
+
+    // clip the rectangle to the map
+    Rect clipped = { 0, 0, 0, 0 };
+
+    if (rect.x < m_header.width && rect.y < m_header.height) {
+      clipped.x = rect.x;
+      clipped.y = rect.y;
+      clipped.width = std::min(rect.width, m_header.width - rect.x);
+      clipped.height = std::min(rect.height, m_header.height - rect.y);
+    }
+
+    std::string version, bgcolor;
+
+    if (!readString(m_header.mapVersion, version) || !readString(m_header.backgroundColor, bgcolor)) {
+      std::clog << "Error! Unable to read the compiled map\n";
+      return nullptr;
+    }
+
+    std::unique_ptr<MapRegion> region(new MapRegion(version, static_cast<Orientation>(m_header.orientation),
+        m_header.width, m_header.height, m_header.tilewidth, m_header.tileheight, bgcolor,
+        static_cast<RenderOrder>(m_header.renderOrder), m_header.hexSideLength,
+        static_cast<StaggerAxis>(m_header.staggerAxis), static_cast<StaggerIndex>(m_header.staggerIndex),
+        m_header.nextObjectId, clipped));
+
+    if (!readProperties(m_header.properties, *region)) {
+      std::clog << "Error! Unable to read the compiled map\n";
+      return nullptr;
+    }
+
+    for (auto& data : m_layers) {
+      if (data.kind != compiled::TILE_LAYER && data.kind != compiled::OBJECT_LAYER) {
+        continue;
+      }
+
+      if (!layers.empty()) {
+        std::string name;
+
+        if (!readString(data.name, name)) {
+          std::clog << "Error! Unable to read the compiled map\n";
+          return nullptr;
+        }
+
+        if (std::find(layers.begin(), layers.end(), name) == layers.end()) {
+          continue;
+        }
+      }
+
+      bool ok;
+
+      if (data.kind == compiled::TILE_LAYER) {
+        ok = readTileLayer(data, clipped, *region);
+      } else {
+        ok = readObjectLayer(data, clipped, *region);
+      }
+
+      if (!ok) {
+        std::clog << "Error! Unable to read the compiled map\n";
+        return nullptr;
+      }
+    }
+
+    region->setBytesRead(m_bytesRead - bytesRead);
+    return region;
+  }
+
+  std::unique_ptr<RegionLoader> RegionLoader::open(const fs::path& filename, FileSystem& filesystem) {
+    std::unique_ptr<File> file = filesystem.open(filename);
+
+    if (!file) {
+      std::clog << "Error! Unknown compiled map: " << filename << '\n';
+      return nullptr;
+    }
+
+    std::unique_ptr<RegionLoader> loader(new RegionLoader(std::move(file)));
+    compiled::Header& header = loader->m_header;
+
+    if (!loader->readBytes(0, &header, sizeof header) || !isValidHeader(header)) {
+      std::clog << "Error! Invalid compiled map: " << filename << '\n';
+      return nullptr;
+    }
+
+    loader->m_layers.resize(header.sections[compiled::LAYERS].count);
+
+    if (!loader->readElements(compiled::LAYERS, 0, loader->m_layers.size(), loader->m_layers.data())) {
+      std::clog << "Error! Invalid compiled map: " << filename << '\n';
+      return nullptr;
+    }
+
+    // a region is flat, its layers get the opacity, the visibility and the offset of their groups
+    for (std::size_t i = 0; i < loader->m_layers.size(); ++i) {
+      compiled::Layer& layer = loader->m_layers[i];
+
+      if (layer.parent == compiled::None) {
+        continue;
+      }
+
+      if (layer.parent > i) {
+        std::clog << "Error! Invalid compiled map: " << filename << '\n';
+        return nullptr;
+      }
+
+      const compiled::Layer& group = loader->m_layers[layer.parent - 1];
+      layer.opacity *= group.opacity;
+      layer.visible = (layer.visible != 0 && group.visible != 0) ? 1 : 0;
+      layer.offset.x += group.offset.x;
+      layer.offset.y += group.offset.y;
+    }
+
+    return loader;
+  }
+
+}
@@ -0,0 +1,407 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/TileColliders.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <tmx/Object.h>
+#include <tmx/ObjectLayer.h>
+#include <tmx/Tile.h>
+#include <tmx/TileSet.h>
+
+namespace tmx {
+
+  constexpr std::size_t TileColliders::EllipseSegments;
+
+  namespace {
+
+    typedef std::vector<Vector2i> Contour;
+
+    bool operator==(const Vector2i& lhs, const Vector2i& rhs) {
+      return lhs.x == rhs.x && lhs.y == rhs.y;
+    }
+
+    int64_t cross(const Vector2i& o, const Vector2i& a, const Vector2i& b) {
+      return static_cast<int64_t>(a.x - o.x) * (b.y - o.y) - static_cast<int64_t>(a.y - o.y) * (b.x - o.x);
+    }
+
+    int64_t area(const Contour& contour) {
+      int64_t sum = 0;
+
+      for (std::size_t i = 0; i < contour.size(); ++i) {
+        const Vector2i& a = contour[i];
+        const Vector2i& b = contour[(i + 1) % contour.size()];
+        sum += static_cast<int64_t>(a.x) * b.y - static_cast<int64_t>(a.y) * b.x;
+      }
+
+      return sum;
+    }
+
+    // removes the repeated points and the points in the middle of a straight line
+    Contour simplify(const Contour& contour) {
+      Contour out;
+
+      for (auto& point : contour) {
+        if (out.empty() || !(point == out.back())) {
+          out.push_back(point);
+        }
+      }
+
+      while (out.size() > 1 && out.front() == out.back()) {
+        out.pop_back();
+      }
+
+      std::size_t i = 0;
+
+      while (out.size() >= 3 && i < out.size()) {
+        std::size_t size = out.size();
+
+        if (cross(out[(i + size - 1) % size], out[i], out[(i + 1) % size]) == 0) {
+          out.erase(out.begin() + i);
+          i = 0;
+        } else {
+          ++i;
+        }
+      }
+
+      return out;
+    }
+
+    bool isConvex(const Contour& contour) {
+      std::size_t size = contour.size();
+
+      for (std::size_t i = 0; i < size; ++i) {
+        if (cross(contour[(i + size - 1) % size], contour[i], contour[(i + 1) % size]) < 0) {
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    bool isInTriangle(const Vector2i& p, const Vector2i& a, const Vector2i& b, const Vector2i& c) {
+      return cross(a, b, p) >= 0 && cross(b, c, p) >= 0 && cross(c, a, p) >= 0;
+    }
+
+    // ear clipping, the contour is simple and counter-clockwise
+    bool triangulate(const Contour& contour, std::vector<Contour>& triangles) {
+      std::vector<std::size_t> indices(contour.size());
+
+      for (std::size_t i = 0; i < indices.size(); ++i) {
+        indices[i] = i;
+      }
+
+      while (indices.size() > 3) {
+        std::size_t size = indices.size();
+        bool clipped = false;
+
+        for (std::size_t i = 0; i < size && !clipped; ++i) {
+          std::size_t prev = indices[(i + size - 1) % size];
+          std::size_t next = indices[(i + 1) % size];
+
+          const Vector2i& a = contour[prev];
+          const Vector2i& b = contour[indices[i]];
+          const Vector2i& c = contour[next];
+
+          if (cross(a, b, c) <= 0) {
+            continue;
+          }
+
+          bool ear = true;
+
+          for (std::size_t j = 0; j < size && ear; ++j) {
+            std::size_t k = indices[j];
+
+            if (k == prev || k == indices[i] || k == next) {
+              continue;
+            }
+
+            if (isInTriangle(contour[k], a, b, c)) {
+              ear = false;
+            }
+          }
+
+          if (ear) {
+            triangles.push_back({ a, b, c });
+            indices.erase(indices.begin() + i);
+            clipped = true;
+          }
+        }
+
+        if (!clipped) {
+          return false;
+        }
+      }
+
+      triangles.push_back({ contour[indices[0]], contour[indices[1]], contour[indices[2]] });
+      return true;
+    }
+
+    // merges two pieces along a common edge if the result is convex
+    bool merge(const Contour& lhs, const Contour& rhs, Contour& merged) {
+      std::size_t n = lhs.size();
+      std::size_t m = rhs.size();
+
+      for (std::size_t i = 0; i < n; ++i) {
+        const Vector2i& a = lhs[i];
+        const Vector2i& b = lhs[(i + 1) % n];
+
+        for (std::size_t j = 0; j < m; ++j) {
+          if (!(rhs[j] == b) || !(rhs[(j + 1) % m] == a)) {
+            continue;
+          }
+
+          merged.clear();
+
+          for (std::size_t k = 0; k < n; ++k) {
+            merged.push_back(lhs[(i + 1 + k) % n]);
+          }
+
+          for (std::size_t k = 0; k + 2 < m; ++k) {
+            merged.push_back(rhs[(j + 2 + k) % m]);
+          }
+
+          if (isConvex(merged)) {
+            return true;
+          }
+        }
+      }
+
+      return false;
+    }
+
+    // Hertel-Mehlhorn: a triangulation where the useless diagonals are removed
+    bool decompose(const Contour& polygon, std::vector<Contour>& pieces) {
+      Contour contour = simplify(polygon);
+
+      if (contour.size() < 3) {
+        return false;
+      }
+
+      bool reversed = area(contour) < 0;
+
+      if (reversed) {
+        std::reverse(contour.begin(), contour.end());
+      }
+
+      if (isConvex(contour)) {
+        pieces.push_back(std::move(contour));
+      } else {
+        if (!triangulate(contour, pieces)) {
+          return false;
+        }
+
+        Contour merged;
+        bool changed = true;
+
+        while (changed) {
+          changed = false;
+
+          for (std::size_t i = 0; i < pieces.size() && !changed; ++i) {
+            for (std::size_t j = i + 1; j < pieces.size() && !changed; ++j) {
+              if (merge(pieces[i], pieces[j], merged)) {
+                pieces[i] = merged;
+                pieces.erase(pieces.begin() + j);
+                changed = true;
+              }
+            }
+          }
+        }
+
+        for (auto& piece : pieces) {
+          piece = simplify(piece);
+        }
+      }
+
+      // keep the orientation of the original polygon
+      if (reversed) {
+        for (auto& piece : pieces) {
+          std::reverse(piece.begin(), piece.end());
+        }
+      }
+
+      return true;
+    }
+
+    // the rotation of Tiled is clockwise, in degrees, around the origin of the object
+    struct Transform {
+      float x;
+      float y;
+      float c;
+      float s;
+
+      explicit Transform(const Object& object)
+      : x(object.getX())
+      , y(object.getY())
+      , c(1.0f)
+      , s(0.0f)
+      {
+        if (object.getRotation() != 0.0) {
+          double angle = object.getRotation() * M_PI / 180.0;
+          c = static_cast<float>(std::cos(angle));
+          s = static_cast<float>(std::sin(angle));
+        }
+      }
+
+      Vector2f apply(float px, float py) const {
+        return { x + px * c - py * s, y + px * s + py * c };
+      }
+    };
+
+    ColliderBox getBounds(const std::vector<Vector2f>& points) {
+      ColliderBox bounds = { points.front(), points.front() };
+
+      for (auto& point : points) {
+        bounds.min.x = std::min(bounds.min.x, point.x);
+        bounds.min.y = std::min(bounds.min.y, point.y);
+        bounds.max.x = std::max(bounds.max.x, point.x);
+        bounds.max.y = std::max(bounds.max.y, point.y);
+      }
+
+      return bounds;
+    }
+
+  }
+
+  TileColliders::TileColliders(const Map& map) {
+    for (auto tileset : map.getTileSets()) {
+      for (auto tile : *tileset) {
+        if (!tile->hasObjects()) {
+          continue;
+        }
+
+        TileCollider collider;
+        collider.first = m_shapes.size();
+
+        for (auto object : *tile->getObjects()) {
+          addObject(*object);
+        }
+
+        collider.count = m_shapes.size() - collider.first;
+
+        if (collider.count == 0) {
+          continue;
+        }
+
+        collider.bounds = m_shapes[collider.first].bounds;
+
+        for (auto& shape : getShapes(collider)) {
+          collider.bounds.min.x = std::min(collider.bounds.min.x, shape.bounds.min.x);
+          collider.bounds.min.y = std::min(collider.bounds.min.y, shape.bounds.min.y);
+          collider.bounds.max.x = std::max(collider.bounds.max.x, shape.bounds.max.x);
+          collider.bounds.max.y = std::max(collider.bounds.max.y, shape.bounds.max.y);
+        }
+
+        unsigned gid = tileset->getFirstGID() + tile->getId();
+
+        if (gid >= m_index.size()) {
+          m_index.resize(gid + 1, 0);
+        }
+
+        m_colliders.push_back(collider);
+        m_index[gid] = m_colliders.size();
+      }
+    }
+  }
+
+  void TileColliders::addObject(const Object& object) {
+    Transform transform(object);
+    std::vector<Vector2f> points;
+
+    switch (object.getKind()) {
+      case Object::RECTANGLE:
+      case Object::ELLIPSE: {
+        auto& boxed = static_cast<const Boxed&>(object);
+        float width = boxed.getWidth();
+        float height = boxed.getHeight();
+
+        if (object.getRotation() == 0.0) {
+          ColliderBox bounds = { transform.apply(0.0f, 0.0f), transform.apply(width, height) };
+          addShape(object.getKind() == Object::RECTANGLE ? ColliderKind::BOX : ColliderKind::ELLIPSE, object, bounds, points);
+          break;
+        }
+
+        if (object.getKind() == Object::RECTANGLE) {
+          points.push_back(transform.apply(0.0f, 0.0f));
+          points.push_back(transform.apply(width, 0.0f));
+          points.push_back(transform.apply(width, height));
+          points.push_back(transform.apply(0.0f, height));
+        } else {
+          for (std::size_t i = 0; i < EllipseSegments; ++i) {
+            double angle = 2 * M_PI * i / EllipseSegments;
+            points.push_back(transform.apply(width / 2 * (1 + std::cos(angle)), height / 2 * (1 + std::sin(angle))));
+          }
+        }
+
+        addShape(ColliderKind::CONVEX, object, getBounds(points), points);
+        break;
+      }
+
+      case Object::POLYGON: {
+        auto& chain = static_cast<const Chain&>(object);
+        Contour polygon(chain.begin(), chain.end());
+        std::vector<Contour> pieces;
+
+        if (!decompose(polygon, pieces)) {
+          std::clog << "Error! Unable to decompose the polygon of the object: " << object.getId() << '\n';
+          break;
+        }
+
+        for (auto& piece : pieces) {
+          points.clear();
+
+          for (auto& point : piece) {
+            points.push_back(transform.apply(point.x, point.y));
+          }
+
+          addShape(ColliderKind::CONVEX, object, getBounds(points), points);
+        }
+        break;
+      }
+
+      case Object::POLYLINE: {
+        auto& chain = static_cast<const Chain&>(object);
+
+        for (auto& point : chain) {
+          points.push_back(transform.apply(point.x, point.y));
+        }
+
+        if (points.size() >= 2) {
+          addShape(ColliderKind::CHAIN, object, getBounds(points), points);
+        }
+        break;
+      }
+
+      case Object::TILE:
+        break;
+    }
+  }
+
+  void TileColliders::addShape(ColliderKind kind, const Object& object, ColliderBox bounds, const std::vector<Vector2f>& points) {
+    ColliderShape shape;
+    shape.kind = kind;
+    shape.object = object.getId();
+    shape.bounds = bounds;
+    shape.first = m_points.size();
+    shape.count = points.size();
+    m_shapes.push_back(shape);
+
+    m_points.insert(m_points.end(), points.begin(), points.end());
+  }
+
+}
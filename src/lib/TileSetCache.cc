@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include "TileSetCache.h"
+
+#include <tmx/TileSet.h>
+
+#include "MapCompiler.h"
+#include "Parser.h"
+
+namespace fs = boost::filesystem;
+
+namespace tmx {
+
+  TileSetCache::TileSetCache() {
+  }
+
+  TileSetCache::~TileSetCache() {
+  }
+
+  std::shared_ptr<const TileSet> TileSetCache::load(const fs::path& filename, const std::function<std::unique_ptr<TileSet>()>& decode) {
+    Entry *entry = nullptr;
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto& slot = m_entries[filename.lexically_normal().string()];
+
+      if (!slot) {
+        slot.reset(new Entry);
+      }
+
+      entry = slot.get();
+    }
+
+    // the first caller decodes the file, the others wait for it
+    std::call_once(entry->once, [entry,&decode]() {
+      entry->tileset = decode();
+    });
+
+    return entry->tileset;
+  }
+
+  std::unique_ptr<TileSet> loadTileSetFile(const fs::path& filename, unsigned firstgid, const ParseContext& context) {
+    if (context.tilesets == nullptr) {
+      return parseTileSetFile(filename, firstgid, context);
+    }
+
+    std::shared_ptr<const TileSet> tileset = context.tilesets->load(filename, [&filename,&context]() {
+      return parseTileSetFile(filename, 0, context);
+    });
+
+    if (!tileset) {
+      return nullptr;
+    }
+
+    return copyTileSet(*tileset, firstgid);
+  }
+
+}
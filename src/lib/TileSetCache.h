@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef TMX_TILE_SET_CACHE_H
+#define TMX_TILE_SET_CACHE_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <boost/filesystem.hpp>
+
+namespace tmx {
+  class TileSet;
+  struct ParseContext;
+
+  /*
+   * A cache of decoded external tilesets, shared by several parsers. Each
+   * tileset file is read and decoded only once, with a first gid of 0,
+   * whatever the map that refers to it. Each map then gets a copy of the
+   * cached tileset with its own first gid. All the functions are
+   * thread-safe.
+   */
+  class TileSetCache {
+  public:
+    TileSetCache();
+    ~TileSetCache();
+
+    TileSetCache(const TileSetCache&) = delete;
+    TileSetCache& operator=(const TileSetCache&) = delete;
+
+    // the decoder is only called by the first caller for a file, returns null if the file can not be decoded
+    std::shared_ptr<const TileSet> load(const boost::filesystem::path& filename, const std::function<std::unique_ptr<TileSet>()>& decode);
+
+  private:
+    struct Entry {
+      std::once_flag once;
+      std::shared_ptr<const TileSet> tileset;
+    };
+
+    std::mutex m_mutex;
+    std::map<std::string, std::unique_ptr<Entry>> m_entries;
+  };
+
+  // parses an external tileset, through the tileset cache of the context if any
+  std::unique_ptr<TileSet> loadTileSetFile(const boost::filesystem::path& filename, unsigned firstgid, const ParseContext& context);
+
+}
+
+#endif // TMX_TILE_SET_CACHE_H
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/WorkStealingExecutor.h>
+
+#include <cassert>
+
+namespace tmx {
+
+  namespace {
+
+    // the index of the queue of the current thread, if it belongs to a pool
+    thread_local const WorkStealingExecutor *currentExecutor = nullptr;
+    thread_local std::size_t currentIndex = 0;
+
+    int64_t elapsedSince(std::chrono::steady_clock::time_point start) {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+  }
+
+  WorkStealingExecutor::WorkStealingExecutor(unsigned threads)
+    : m_next(0), m_pending(0), m_stop(false), m_tasksRun(0), m_stealTime(0), m_idleTime(0)
+  {
+    if (threads == 0) {
+      threads = std::thread::hardware_concurrency();
+    }
+
+    if (threads == 0) {
+      threads = 1;
+    }
+
+    for (unsigned i = 0; i < threads; ++i) {
+      m_queues.emplace_back(new Queue);
+    }
+
+    for (unsigned i = 0; i < threads; ++i) {
+      m_threads.emplace_back(&WorkStealingExecutor::run, this, i);
+    }
+  }
+
+  WorkStealingExecutor::~WorkStealingExecutor() {
+    {
+      std::lock_guard<std::mutex> lock(m_sleepMutex);
+      m_stop = true;
+    }
+
+    m_sleepCondition.notify_all();
+
+    for (auto& thread : m_threads) {
+      thread.join();
+    }
+  }
+
+  void WorkStealingExecutor::execute(std::function<void()> task) {
+    std::size_t index;
+
+    if (currentExecutor == this) {
+      index = currentIndex;
+    } else {
+      index = m_next.fetch_add(1) % m_queues.size();
+    }
+
+    {
+      Queue& queue = *m_queues[index];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.tasks.push_back(std::move(task));
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_sleepMutex);
+      m_pending.fetch_add(1);
+    }
+
+    m_sleepCondition.notify_one();
+  }
+
+  ExecutorStatistics WorkStealingExecutor::getStatistics() const {
+    ExecutorStatistics stats;
+    stats.tasksRun = m_tasksRun.load();
+    stats.stealTime = std::chrono::nanoseconds(m_stealTime.load());
+    stats.idleTime = std::chrono::nanoseconds(m_idleTime.load());
+    return stats;
+  }
+
+  bool WorkStealingExecutor::popLocal(std::size_t index, std::function<void()>& task) {
+    Queue& queue = *m_queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.tasks.empty()) {
+      return false;
+    }
+
+    // newest task first, its data is more likely to be in the cache
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+  }
+
+  bool WorkStealingExecutor::steal(std::size_t index, std::function<void()>& task) {
+    auto start = std::chrono::steady_clock::now();
+    bool found = false;
+
+    for (std::size_t i = 1; i < m_queues.size() && !found; ++i) {
+      Queue& queue = *m_queues[(index + i) % m_queues.size()];
+      std::unique_lock<std::mutex> lock(queue.mutex, std::try_to_lock);
+
+      if (!lock.owns_lock() || queue.tasks.empty()) {
+        continue;
+      }
+
+      // oldest task of the victim
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      found = true;
+    }
+
+    m_stealTime.fetch_add(elapsedSince(start));
+    return found;
+  }
+
+  void WorkStealingExecutor::run(std::size_t index) {
+    currentExecutor = this;
+    currentIndex = index;
+
+    for (;;) {
+      std::function<void()> task;
+
+      if (popLocal(index, task) || steal(index, task)) {
+        m_pending.fetch_sub(1);
+        task();
+        m_tasksRun.fetch_add(1);
+        continue;
+      }
+
+      auto start = std::chrono::steady_clock::now();
+      std::unique_lock<std::mutex> lock(m_sleepMutex);
+
+      m_sleepCondition.wait(lock, [this]() {
+        return m_stop || m_pending.load() > 0;
+      });
+
+      m_idleTime.fetch_add(elapsedSince(start));
+
+      if (m_stop && m_pending.load() == 0) {
+        break;
+      }
+    }
+
+    currentExecutor = nullptr;
+  }
+
+}
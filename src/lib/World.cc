@@ -0,0 +1,499 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <tmx/World.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <regex>
+
+#include <tinyxml2.h>
+
+#include <tmx/LoadProgress.h>
+
+#include "Json.h"
+#include "Parser.h"
+#include "TileSetCache.h"
+
+namespace fs = boost::filesystem;
+
+namespace tmx {
+
+  namespace {
+
+    // the number of children of a node of the index
+    const std::size_t Fanout = 8;
+
+    bool readText(File& file, std::vector<char>& text) {
+      const std::size_t size = file.getSize();
+      text.resize(size + 1);
+
+      if (file.read(0, text.data(), size) != size) {
+        return false;
+      }
+
+      text[size] = '\0';
+      return true;
+    }
+
+    void parseMaps(const json::Value& maps, const fs::path& directory, std::vector<WorldMap>& result) {
+      for (auto& value : maps) {
+        WorldMap map;
+        map.fileName = directory / value.getString("fileName");
+        map.x = value.getInt("x");
+        map.y = value.getInt("y");
+        map.width = value.getUInt("width");
+        map.height = value.getUInt("height");
+
+        if (map.width == 0 || map.height == 0) {
+          std::clog << "Error! Missing size of a map of the world: " << map.fileName << '\n';
+          continue;
+        }
+
+        result.push_back(map);
+      }
+    }
+
+    void parsePatterns(const json::Value& patterns, const fs::path& directory, FileSystem& filesystem, std::vector<WorldMap>& result) {
+      // the files of the directory, in a deterministic order
+      std::vector<fs::path> files;
+
+      if (!filesystem.list(directory, files)) {
+        std::clog << "Error! Unable to list the directory of the world for its patterns: " << directory << '\n';
+        return;
+      }
+
+      std::sort(files.begin(), files.end());
+
+      for (auto& pattern : patterns) {
+        std::regex regexp;
+
+        try {
+          regexp.assign(pattern.getString("regexp"));
+        } catch (std::regex_error&) {
+          std::clog << "Error! Wrong pattern in the world file: '" << pattern.getString("regexp") << "'\n";
+          continue;
+        }
+
+        int multiplierX = pattern.getInt("multiplierX", 1);
+        int multiplierY = pattern.getInt("multiplierY", 1);
+        int offsetX = pattern.getInt("offsetX");
+        int offsetY = pattern.getInt("offsetY");
+        unsigned width = pattern.getUInt("mapWidth", std::abs(multiplierX));
+        unsigned height = pattern.getUInt("mapHeight", std::abs(multiplierY));
+
+        for (auto& file : files) {
+          std::string name = file.string();
+          std::smatch match;
+
+          if (!std::regex_search(name, match, regexp) || match.size() < 3) {
+            continue;
+          }
+
+          WorldMap map;
+          map.fileName = directory / file;
+          map.x = std::strtol(match[1].str().c_str(), nullptr, 10) * multiplierX + offsetX;
+          map.y = std::strtol(match[2].str().c_str(), nullptr, 10) * multiplierY + offsetY;
+          map.width = width;
+          map.height = height;
+          result.push_back(map);
+        }
+      }
+    }
+
+    // Sort-Tile-Recursive: the items are sorted in vertical slices, then
+    // each slice is sorted vertically, so that consecutive groups of Fanout
+    // items are close to each other
+    template<typename Box>
+    void sortTileRecursive(std::vector<uint32_t>& order, const std::vector<Box>& boxes) {
+      auto centerX = [&boxes](uint32_t i) { return static_cast<int64_t>(boxes[i].x0) + boxes[i].x1; };
+      auto centerY = [&boxes](uint32_t i) { return static_cast<int64_t>(boxes[i].y0) + boxes[i].y1; };
+
+      std::sort(order.begin(), order.end(), [&centerX](uint32_t lhs, uint32_t rhs) {
+        return centerX(lhs) < centerX(rhs);
+      });
+
+      std::size_t groups = (order.size() + Fanout - 1) / Fanout;
+      std::size_t slices = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(groups))));
+      std::size_t sliceSize = slices * Fanout;
+
+      for (std::size_t i = 0; i < order.size(); i += sliceSize) {
+        auto last = order.begin() + std::min(i + sliceSize, order.size());
+
+        std::sort(order.begin() + i, last, [&centerY](uint32_t lhs, uint32_t rhs) {
+          return centerY(lhs) < centerY(rhs);
+        });
+      }
+    }
+
+  }
+
+  constexpr std::size_t World::NoMap;
+  constexpr unsigned World::DefaultPrefetchDistance;
+
+  World::World(std::vector<WorldMap> maps, Executor& executor, FileSystem& filesystem)
+  : m_maps(std::move(maps))
+  , m_leaves(0)
+  , m_executor(executor)
+  , m_filesystem(filesystem)
+  , m_tilesets(new TileSetCache)
+  , m_prefetchDistance(DefaultPrefetchDistance)
+  , m_evictionDistance(2 * DefaultPrefetchDistance)
+  , m_loading(0)
+  {
+    m_stats.hits = m_stats.misses = m_stats.evictions = m_stats.prefetches = 0;
+    m_stats.residentMaps = m_stats.loadingMaps = 0;
+    buildIndex();
+  }
+
+  World::~World() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (auto& entry : m_entries) {
+      entry.second.progress->cancel();
+    }
+
+    m_done.wait(lock, [this]() { return m_loading == 0; });
+  }
+
+  void World::buildIndex() {
+    m_boxes.reserve(m_maps.size());
+
+    for (auto& map : m_maps) {
+      m_boxes.push_back({ map.x, map.y, static_cast<int>(map.x + map.width), static_cast<int>(map.y + map.height) });
+    }
+
+    if (m_maps.empty()) {
+      return;
+    }
+
+    // the leaves, built on the maps
+    m_order.resize(m_maps.size());
+
+    for (uint32_t i = 0; i < m_order.size(); ++i) {
+      m_order[i] = i;
+    }
+
+    sortTileRecursive(m_order, m_boxes);
+
+    auto addNode = [this](const std::vector<Box>& boxes, const std::vector<uint32_t>& order, uint32_t first, uint32_t count) {
+      Node node;
+      node.box = boxes[order[first]];
+      node.first = first;
+      node.count = count;
+
+      for (uint32_t i = first + 1; i < first + count; ++i) {
+        const Box& box = boxes[order[i]];
+        node.box.x0 = std::min(node.box.x0, box.x0);
+        node.box.y0 = std::min(node.box.y0, box.y0);
+        node.box.x1 = std::max(node.box.x1, box.x1);
+        node.box.y1 = std::max(node.box.y1, box.y1);
+      }
+
+      m_nodes.push_back(node);
+    };
+
+    for (uint32_t i = 0; i < m_order.size(); i += Fanout) {
+      addNode(m_boxes, m_order, i, std::min<uint32_t>(Fanout, m_order.size() - i));
+    }
+
+    m_leaves = m_nodes.size();
+
+    // the upper levels, until there is only one node
+    std::size_t levelFirst = 0;
+
+    while (m_nodes.size() - levelFirst > 1) {
+      std::size_t levelCount = m_nodes.size() - levelFirst;
+
+      std::vector<Box> boxes;
+      std::vector<uint32_t> order(levelCount);
+
+      for (std::size_t i = 0; i < levelCount; ++i) {
+        boxes.push_back(m_nodes[levelFirst + i].box);
+        order[i] = i;
+      }
+
+      sortTileRecursive(order, boxes);
+
+      // the children of a node must be contiguous, so the level is reordered
+      std::vector<Node> level;
+
+      for (auto i : order) {
+        level.push_back(m_nodes[levelFirst + i]);
+      }
+
+      std::copy(level.begin(), level.end(), m_nodes.begin() + levelFirst);
+
+      for (std::size_t i = 0; i < levelCount; ++i) {
+        boxes[i] = m_nodes[levelFirst + i].box;
+        order[i] = i;
+      }
+
+      std::size_t nextFirst = m_nodes.size();
+
+      for (std::size_t i = 0; i < levelCount; i += Fanout) {
+        addNode(boxes, order, i, std::min<std::size_t>(Fanout, levelCount - i));
+        m_nodes.back().first += levelFirst;
+      }
+
+      levelFirst = nextFirst;
+    }
+  }
+
+  template<typename Function>
+  void World::query(const Box& box, Function function) const {
+    if (m_nodes.empty()) {
+      return;
+    }
+
+    auto intersects = [&box](const Box& other) {
+      return other.x0 < box.x1 && box.x0 < other.x1 && other.y0 < box.y1 && box.y0 < other.y1;
+    };
+
+    // each level pushes at most Fanout nodes, and there are less than 12 levels
+    uint32_t stack[12 * Fanout];
+    std::size_t size = 0;
+    stack[size++] = m_nodes.size() - 1;
+
+    while (size > 0) {
+      uint32_t index = stack[--size];
+
+      const Node& node = m_nodes[index];
+
+      if (!intersects(node.box)) {
+        continue;
+      }
+
+      if (index < m_leaves) {
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+          if (intersects(m_boxes[m_order[i]])) {
+            function(m_order[i]);
+          }
+        }
+      } else {
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+          assert(size < sizeof stack / sizeof stack[0]);
+          stack[size++] = i;
+        }
+      }
+    }
+  }
+
+  std::size_t World::findMapAt(int x, int y) const {
+    std::size_t found = NoMap;
+
+    query({ x, y, x + 1, y + 1 }, [&found](std::size_t index) {
+      found = std::min(found, index);
+    });
+
+    return found;
+  }
+
+  std::vector<std::size_t> World::findMaps(int x, int y, unsigned width, unsigned height) const {
+    std::vector<std::size_t> found;
+
+    query({ x, y, static_cast<int>(x + width), static_cast<int>(y + height) }, [&found](std::size_t index) {
+      found.push_back(index);
+    });
+
+    std::sort(found.begin(), found.end());
+    return found;
+  }
+
+  World::future_map World::requestMap(std::size_t index) {
+    assert(index < m_maps.size());
+    return request(index, false);
+  }
+
+  std::shared_ptr<const Map> World::getMapAt(int x, int y) {
+    std::size_t index = findMapAt(x, y);
+
+    if (index == NoMap) {
+      return nullptr;
+    }
+
+    return request(index, false).get();
+  }
+
+  std::shared_ptr<const Map> World::tryGetMapAt(int x, int y) {
+    std::size_t index = findMapAt(x, y);
+
+    if (index == NoMap) {
+      return nullptr;
+    }
+
+    future_map map = request(index, false);
+
+    if (map.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      return nullptr;
+    }
+
+    return map.get();
+  }
+
+  void World::updateFocus(const Vector2i& focus) {
+    unsigned prefetch, eviction;
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      prefetch = m_prefetchDistance;
+      eviction = m_evictionDistance;
+    }
+
+    for (auto index : findMaps(focus.x - static_cast<int>(prefetch), focus.y - static_cast<int>(prefetch), 2 * prefetch + 1, 2 * prefetch + 1)) {
+      request(index, true);
+    }
+
+    Box area = { focus.x - static_cast<int>(eviction), focus.y - static_cast<int>(eviction),
+        focus.x + static_cast<int>(eviction) + 1, focus.y + static_cast<int>(eviction) + 1 };
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto it = m_entries.begin(); it != m_entries.end(); ) {
+      const Box& box = m_boxes[it->first];
+
+      if (box.x0 < area.x1 && area.x0 < box.x1 && box.y0 < area.y1 && area.y0 < box.y1) {
+        ++it;
+        continue;
+      }
+
+      // a load in progress stops as soon as possible
+      it->second.progress->cancel();
+      it = m_entries.erase(it);
+      m_stats.evictions++;
+    }
+  }
+
+  void World::setDistances(unsigned prefetch, unsigned eviction) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_prefetchDistance = prefetch;
+    m_evictionDistance = std::max(prefetch, eviction);
+  }
+
+  WorldStatistics World::getStatistics() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    WorldStatistics stats = m_stats;
+    stats.residentMaps = stats.loadingMaps = 0;
+
+    for (auto& entry : m_entries) {
+      if (entry.second.map.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        stats.residentMaps++;
+      } else {
+        stats.loadingMaps++;
+      }
+    }
+
+    return stats;
+  }
+
+  World::future_map World::request(std::size_t index, bool prefetch) {
+    std::shared_ptr<std::promise<std::shared_ptr<const Map>>> promise;
+    std::shared_ptr<LoadProgress> progress;
+    future_map map;
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto it = m_entries.find(index);
+
+      if (it != m_entries.end()) {
+        if (!prefetch) {
+          m_stats.hits++;
+        }
+
+        return it->second.map;
+      }
+
+      if (prefetch) {
+        m_stats.prefetches++;
+      } else {
+        m_stats.misses++;
+      }
+
+      promise = std::make_shared<std::promise<std::shared_ptr<const Map>>>();
+      progress = std::make_shared<LoadProgress>();
+
+      Entry& entry = m_entries[index];
+      entry.map = promise->get_future().share();
+      entry.progress = progress;
+      map = entry.map;
+
+      m_loading++;
+    }
+
+    m_executor.execute([this, promise, progress, index]() {
+      promise->set_value(load(index, *progress));
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_loading--;
+      m_done.notify_all();
+    });
+
+    return map;
+  }
+
+  std::shared_ptr<const Map> World::load(std::size_t index, LoadProgress& progress) {
+    // the document of the thread is reused from one map to the next
+    static thread_local tinyxml2::XMLDocument doc;
+
+    ParseContext context;
+    context.progress = &progress;
+    context.tilesets = m_tilesets.get();
+    context.document = &doc;
+    context.filesystem = &m_filesystem;
+
+    std::shared_ptr<const Map> map = parseMapFile(m_maps[index].fileName, context);
+
+    if (!map && !progress.isCancelled()) {
+      std::clog << "Error! Unable to load a map of the world: " << m_maps[index].fileName << '\n';
+    }
+
+    return map;
+  }
+
+  std::unique_ptr<World> World::parseFile(const fs::path& filename, Executor& executor, FileSystem& filesystem) {
+    auto file = filesystem.open(filename);
+    std::vector<char> text;
+
+    if (!file || !readText(*file, text)) {
+      std::clog << "Error! Unknown world file: " << filename << '\n';
+      return nullptr;
+    }
+
+    json::Document doc;
+
+    if (!doc.parse(text.data()) || !doc.getRoot().is(json::Type::OBJECT)) {
+      std::clog << "Error! Unable to parse the world file: " << filename << '\n';
+      return nullptr;
+    }
+
+    const json::Value& root = doc.getRoot();
+    fs::path directory = filename.parent_path();
+    std::vector<WorldMap> maps;
+
+    if (const json::Value *list = root.find("maps")) {
+      parseMaps(*list, directory, maps);
+    }
+
+    if (const json::Value *patterns = root.find("patterns")) {
+      parsePatterns(*patterns, directory, filesystem, maps);
+    }
+
+    return std::unique_ptr<World>(new World(std::move(maps), executor, filesystem));
+  }
+
+}
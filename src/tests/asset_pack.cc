@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <tmx/AssetPack.h>
+
+namespace fs = boost::filesystem;
+
+static bool check(bool condition, const char *message) {
+  if (!condition) {
+    std::printf("Error! %s\n", message);
+  }
+
+  return condition;
+}
+
+int main() {
+  fs::path root(TMX_TESTS_DATA);
+  fs::path filename = fs::temp_directory_path() / fs::unique_path("tmx-%%%%-%%%%.pack");
+
+  bool ok = check(!tmx::AssetPack::createPack(filename, root, { root / "sample.tmx" }), "An absolute path has been added to a pack.");
+  ok = check(!tmx::AssetPack::createPack(filename, root, { "parity/../../sample.tmx" }), "A path outside the root has been added to a pack.") && ok;
+
+  if (!check(tmx::AssetPack::createPack(filename, root, { "sample.tmx", "./parity/sub/../map.tmx" }), "The pack can not be created.")) {
+    return EXIT_FAILURE;
+  }
+
+  auto pack = tmx::AssetPack::openPack(filename);
+
+  if (!check(pack != nullptr && pack->getFileCount() == 2, "The pack can not be opened.")) {
+    fs::remove(filename);
+    return EXIT_FAILURE;
+  }
+
+  ok = check(pack->open("sample.tmx") != nullptr && pack->open("parity/sub/../map.tmx") != nullptr, "A relative path is not found in the pack.") && ok;
+
+  // the paths of a pack are relative to its root, the leading slash is not silently dropped
+  ok = check(pack->open("/sample.tmx") == nullptr && pack->open("../data/sample.tmx") == nullptr, "An absolute path or a path outside the root is found in the pack.") && ok;
+
+  std::vector<fs::path> files;
+  ok = check(pack->list("parity", files) && files.size() == 1, "The directory of the pack can not be listed.") && ok;
+  ok = check(!pack->list("/parity", files), "An absolute directory can be listed in the pack.") && ok;
+
+  pack.reset();
+  fs::remove(filename);
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
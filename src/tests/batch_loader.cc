@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+
+#include <boost/filesystem.hpp>
+
+#include <tmx/BatchLoader.h>
+#include <tmx/Map.h>
+#include <tmx/Tile.h>
+#include <tmx/TileSet.h>
+#include <tmx/WorkStealingExecutor.h>
+
+namespace fs = boost::filesystem;
+
+static bool check(bool condition, const char *message) {
+  if (!condition) {
+    std::printf("Error! %s\n", message);
+  }
+
+  return condition;
+}
+
+int main() {
+  fs::path directory = fs::path(TMX_TESTS_DATA) / "batch";
+  fs::path tileset = fs::path(TMX_TESTS_DATA) / "parity" / "sub" / "things.tsx";
+
+  tmx::WorkStealingExecutor executor(2);
+  tmx::BatchLoader loader(executor);
+
+  // both maps use the same external tileset, with different first gids
+  if (loader.addFiles(directory) != 2) {
+    return EXIT_FAILURE;
+  }
+
+  auto maps = loader.load();
+
+  if (!check(maps.size() == 2 && maps[0] && maps[1], "The maps of the batch can not be loaded.")) {
+    return EXIT_FAILURE;
+  }
+
+  bool ok = true;
+
+  for (std::size_t i = 0; i < maps.size(); ++i) {
+    auto expected = tmx::Map::parseFile(loader.getFiles()[i]);
+    ok = check(expected && maps[i]->saveMemory(tmx::LayerEncoding::CSV) == expected->saveMemory(tmx::LayerEncoding::CSV), "A map of the batch differs from the same map loaded alone.") && ok;
+  }
+
+  auto things = maps[1]->getTileSetFromGID(5);
+  ok = check(things != nullptr && things->getFirstGID() == 5 && things->getName() == "things", "The cached tileset does not have the first gid of the map.") && ok;
+
+  if (things != nullptr) {
+    auto tile = things->getTile(1);
+    ok = check(tile != nullptr && tile->hasObjects() && std::distance(tile->getObjects()->begin(), tile->getObjects()->end()) == 2, "The cached tileset is not complete.") && ok;
+  }
+
+  // the tileset file is read once for the whole batch
+  uintmax_t bytes = fs::file_size(directory / "first.tmx") + fs::file_size(directory / "second.tmx") + fs::file_size(tileset);
+  ok = check(loader.getStatistics().bytes == bytes, "The tileset file has not been read once.") && ok;
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <tmx/ChunkPager.h>
+#include <tmx/CompiledMap.h>
+#include <tmx/Executor.h>
+#include <tmx/Map.h>
+#include <tmx/TileLayer.h>
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+  // loads the chunks at once, so that the order of the loads is known
+  class InlineExecutor : public tmx::Executor {
+  public:
+    virtual void execute(std::function<void()> task) override {
+      task();
+    }
+  };
+
+}
+
+static const unsigned MapSize = 32;
+static const unsigned ChunkSize = 8;
+
+static bool check(bool condition, const char *message) {
+  if (!condition) {
+    std::printf("Error! %s\n", message);
+  }
+
+  return condition;
+}
+
+static unsigned gidAt(unsigned x, unsigned y) {
+  return (y * MapSize + x) % 50 + 1;
+}
+
+static bool compileMap(const fs::path& filename) {
+  tmx::Map map("1.0", tmx::Orientation::ORTHOGONAL, MapSize, MapSize, 16, 16, "",
+      tmx::RenderOrder::RIGHT_DOWN, 0, tmx::StaggerAxis::Y, tmx::StaggerIndex::ODD, 1);
+
+  std::unique_ptr<tmx::TileLayer> layer(new tmx::TileLayer("ground", 1.0, true));
+
+  for (unsigned y = 0; y < MapSize; ++y) {
+    for (unsigned x = 0; x < MapSize; ++x) {
+      layer->addCell(tmx::Cell(gidAt(x, y)));
+    }
+  }
+
+  map.addLayer(std::move(layer));
+
+  std::vector<char> data = tmx::CompiledMap::compile(map, ChunkSize);
+
+  if (data.empty()) {
+    return false;
+  }
+
+  std::ofstream out(filename.string().c_str(), std::ios::binary);
+  out.write(data.data(), data.size());
+  return static_cast<bool>(out);
+}
+
+static bool testEviction(tmx::ChunkPager& pager) {
+  auto first = pager.getChunkAt(0, 0, 0);
+
+  if (!check(first != nullptr, "The first chunk can not be loaded.")) {
+    return false;
+  }
+
+  // room for three chunks
+  std::size_t budget = 3 * first->getMemorySize();
+  pager.setBudget(budget);
+
+  auto second = pager.getChunkAt(0, ChunkSize, 0);
+  pager.getChunkAt(0, 2 * ChunkSize, 0);
+
+  auto stats = pager.getStatistics();
+  bool ok = check(stats.misses == 3 && stats.evictions == 0 && stats.residentChunks == 3, "The chunks under the budget are not resident.");
+
+  // the first chunk is used again, so the second one is the least recently used
+  ok = check(pager.getChunkAt(0, 0, 0) == first, "A resident chunk is loaded again.") && ok;
+  pager.getChunkAt(0, 3 * ChunkSize, 0);
+
+  stats = pager.getStatistics();
+  ok = check(stats.hits == 1 && stats.evictions == 1, "The chunk over the budget does not evict a chunk.") && ok;
+  ok = check(stats.residentChunks == 3 && stats.residentBytes <= budget, "The resident chunks are over the budget.") && ok;
+
+  pager.getChunkAt(0, 0, 0);
+  ok = check(pager.getStatistics().hits == 2, "The most recently used chunk has been evicted.") && ok;
+  pager.getChunkAt(0, ChunkSize, 0);
+  ok = check(pager.getStatistics().misses == 5, "The least recently used chunk is still resident.") && ok;
+
+  // an evicted chunk stays alive while it is used
+  ok = check(second->getCell(ChunkSize + 1, 2).getGID() == gidAt(ChunkSize + 1, 2), "A chunk used outside the pager has been released.") && ok;
+
+  pager.setBudget(0);
+  stats = pager.getStatistics();
+  ok = check(stats.residentChunks == 0 && stats.residentBytes == 0, "A lower budget does not evict the chunks.") && ok;
+  return ok;
+}
+
+static bool testCells(tmx::ChunkPager& pager) {
+  bool ok = true;
+
+  for (unsigned y = 0; y < MapSize; y += 5) {
+    for (unsigned x = 0; x < MapSize; x += 3) {
+      ok = check(pager.getCell(0, x, y).getGID() == gidAt(x, y), "A cell of the pager is wrong.") && ok;
+    }
+  }
+
+  auto misses = pager.getStatistics().misses;
+  ok = check(pager.getChunkAt(0, MapSize, 0) == nullptr && pager.getChunkAt(1, 0, 0) == nullptr, "A chunk outside the map is loaded.") && ok;
+  ok = check(pager.getStatistics().misses == misses, "A chunk outside the map is counted as a miss.") && ok;
+  return ok;
+}
+
+int main() {
+  fs::path filename = fs::temp_directory_path() / fs::unique_path("tmx-%%%%-%%%%.tmc");
+
+  if (!check(compileMap(filename), "The map can not be compiled.")) {
+    fs::remove(filename);
+    return EXIT_FAILURE;
+  }
+
+  InlineExecutor executor;
+  auto pager = tmx::ChunkPager::open(filename, 1 << 20, executor);
+
+  if (!check(pager != nullptr, "The compiled map can not be paged.")) {
+    fs::remove(filename);
+    return EXIT_FAILURE;
+  }
+
+  bool ok = testEviction(*pager);
+  ok = testCells(*pager) && ok;
+
+  pager.reset();
+  fs::remove(filename);
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <tmx/CompiledMap.h>
+#include <tmx/Map.h>
+#include <tmx/TileLayer.h>
+
+static bool check(bool condition, const char *message) {
+  if (!condition) {
+    std::printf("Error! %s\n", message);
+  }
+
+  return condition;
+}
+
+// the compiled data must be aligned on 8 bytes
+static std::vector<uint64_t> align(const std::vector<char>& data) {
+  std::vector<uint64_t> aligned((data.size() + 7) / 8);
+  std::memcpy(aligned.data(), data.data(), data.size());
+  return aligned;
+}
+
+static bool testContent(const tmx::Map& map) {
+  std::vector<char> data = tmx::CompiledMap::compile(map, 2);
+  std::vector<uint64_t> aligned = align(data);
+
+  auto compiled = tmx::CompiledMap::fromMemory(aligned.data(), data.size());
+
+  if (!check(compiled != nullptr, "A compiled map can not be opened.")) {
+    return false;
+  }
+
+  // the layers are in depth-first order, a group before its layers
+  auto layers = map.getAllLayers();
+  bool ok = check(compiled->getLayerCount() == layers.size() && compiled->getChunkSize() == 2, "The layers of the compiled map are wrong.");
+
+  for (std::size_t i = 0; i < layers.size() && i < compiled->getLayerCount(); ++i) {
+    ok = check(layers[i]->getName() == compiled->getLayer(i).getName(), "The name of a compiled layer is wrong.") && ok;
+  }
+
+  // the cells are cut in chunks, they must be found at the same place
+  auto ground = static_cast<const tmx::TileLayer *>(layers[0]);
+  auto compiledGround = compiled->getLayer(0);
+
+  for (unsigned y = 0; y < map.getHeight(); ++y) {
+    for (unsigned x = 0; x < map.getWidth(); ++x) {
+      ok = check(compiledGround.getRawGID(x, y) == ground->getCell(y * map.getWidth() + x).getRawGID(), "A compiled cell is wrong.") && ok;
+    }
+  }
+
+  auto details = compiled->getLayer(2);
+  ok = check(details.getCell(2, 2).getGID() == 1 && details.getCell(2, 2).isHorizontallyFlipped(), "The flags of a compiled cell are lost.") && ok;
+  ok = check(details.hasParent() && details.getParentIndex() == 1 && compiled->getLayer(1).getDescendantCount() == 4, "The nesting of the compiled layers is wrong.") && ok;
+
+  auto things = compiled->getLayer(4);
+  ok = check(things.isObjectLayer() && things.getObjectCount() == 3, "The objects of the compiled map are lost.") && ok;
+
+  if (things.getObjectCount() > 0) {
+    auto chest = things.getObject(0);
+    ok = check(std::string(chest.getName()) == "chest" && std::string(chest.getProperty("gold", "")) == "12", "A compiled object is wrong.") && ok;
+  }
+
+  ok = check(std::string(compiled->getProperty("title", "")) == "sample", "The properties of the compiled map are lost.") && ok;
+
+  // the map rebuilt from the compiled map is saved like the original map
+  auto rebuilt = compiled->toMap();
+  boost::filesystem::path base(TMX_TESTS_DATA);
+  ok = check(rebuilt && rebuilt->saveMemory(tmx::LayerEncoding::CSV, base) == map.saveMemory(tmx::LayerEncoding::CSV, base), "The compiled map does not give the original map back.") && ok;
+  return ok;
+}
+
+static bool testValidate(const tmx::Map& map) {
+  std::vector<char> data = tmx::CompiledMap::compile(map);
+  std::vector<uint64_t> aligned = align(data);
+
+  auto compiled = tmx::CompiledMap::fromMemory(aligned.data(), data.size());
+  bool ok = check(compiled && compiled->validate(), "A compiled map is not valid.");
+
+  // a range outside its section is only detected by the explicit check
+  auto header = reinterpret_cast<const tmx::compiled::Header *>(aligned.data());
+  auto layers = reinterpret_cast<tmx::compiled::Layer *>(reinterpret_cast<char *>(aligned.data()) + header->sections[tmx::compiled::LAYERS].offset);
+  layers[0].properties.count = 0xFFFFFFFF;
+
+  compiled = tmx::CompiledMap::fromMemory(aligned.data(), data.size());
+  ok = check(compiled != nullptr, "A compiled map with a valid header can not be opened.") && ok;
+  ok = check(!compiled || !compiled->validate(), "A corrupted range is not detected.") && ok;
+
+  // the header is always checked
+  aligned = align(data);
+  reinterpret_cast<tmx::compiled::Header *>(aligned.data())->sections[tmx::compiled::CELLS].count = UINT64_C(1) << 40;
+  ok = check(tmx::CompiledMap::fromMemory(aligned.data(), data.size()) == nullptr, "A section outside the data is not detected.") && ok;
+
+  return ok;
+}
+
+int main() {
+  boost::filesystem::path filename = boost::filesystem::path(TMX_TESTS_DATA) / "sample.tmx";
+
+  auto map = tmx::Map::parseFile(filename);
+
+  if (!map) {
+    return EXIT_FAILURE;
+  }
+
+  bool ok = testContent(*map);
+  ok = testValidate(*map) && ok;
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <tmx/ConcurrentTileEditor.h>
+#include <tmx/Map.h>
+#include <tmx/MapEditor.h>
+#include <tmx/TileLayer.h>
+
+static const unsigned BatchSize = 256;
+
+static std::unique_ptr<tmx::Map> makeMap(unsigned size) {
+  std::unique_ptr<tmx::Map> map(new tmx::Map("1.0", tmx::Orientation::ORTHOGONAL, size, size, 16, 16, "",
+      tmx::RenderOrder::RIGHT_DOWN, 0, tmx::StaggerAxis::Y, tmx::StaggerIndex::ODD, 1));
+
+  std::unique_ptr<tmx::TileLayer> layer(new tmx::TileLayer("ground", 1.0, true));
+
+  for (unsigned i = 0; i < size * size; ++i) {
+    layer->addCell(tmx::Cell(1));
+  }
+
+  map->addLayer(std::move(layer));
+  return map;
+}
+
+// a cheap generator so that the benchmark measures the edits, not the random numbers
+static uint32_t next(uint32_t& state) {
+  state = state * 1664525u + 1013904223u;
+  return state >> 8;
+}
+
+template<typename Function>
+static double measure(unsigned threads, Function function) {
+  std::vector<std::thread> workers;
+  auto start = std::chrono::steady_clock::now();
+
+  for (unsigned i = 0; i < threads; ++i) {
+    workers.emplace_back(function, i);
+  }
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 3) {
+    std::printf("Usage: tmx_concurrent_edit_benchmark [size] [edits]\n");
+    return EXIT_FAILURE;
+  }
+
+  unsigned size = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1024;
+  unsigned edits = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000;
+
+  if (size == 0 || edits == 0) {
+    std::printf("The size and the number of edits must be positive. Exiting.\n");
+    return EXIT_FAILURE;
+  }
+
+  unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<unsigned> counts = { 1, 2, 4 };
+
+  if (hardware > 4) {
+    counts.push_back(hardware);
+  }
+
+  std::printf("%ux%u, %u edits per thread, in edits per ms\n", size, size, edits);
+  std::printf("threads   global lock   chunk locks   chunk batches\n");
+
+  for (unsigned threads : counts) {
+    // the baseline: a map editor behind a single lock
+    auto globalMap = makeMap(size);
+    tmx::MapEditor globalEditor(*globalMap);
+    std::mutex globalMutex;
+
+    double global = measure(threads, [&](unsigned seed) {
+      uint32_t state = seed + 1;
+
+      for (unsigned i = 0; i < edits; ++i) {
+        uint32_t position = next(state) % (size * size);
+        std::lock_guard<std::mutex> lock(globalMutex);
+        globalEditor.setCell(0, position % size, position / size, tmx::Cell(2 + i % 8));
+      }
+    });
+
+    auto chunkMap = makeMap(size);
+    tmx::ConcurrentTileEditor chunkEditor(*chunkMap, 0);
+
+    double chunk = measure(threads, [&](unsigned seed) {
+      uint32_t state = seed + 1;
+
+      for (unsigned i = 0; i < edits; ++i) {
+        uint32_t position = next(state) % (size * size);
+        chunkEditor.setCell(position % size, position / size, tmx::Cell(2 + i % 8));
+      }
+    });
+
+    auto batchMap = makeMap(size);
+    tmx::ConcurrentTileEditor batchEditor(*batchMap, 0);
+
+    double batch = measure(threads, [&](unsigned seed) {
+      uint32_t state = seed + 1;
+      std::vector<tmx::CellEdit> batchEdits;
+
+      for (unsigned i = 0; i < edits; ++i) {
+        uint32_t position = next(state) % (size * size);
+        batchEdits.push_back({ position % size, position / size, tmx::Cell(2 + i % 8) });
+
+        if (batchEdits.size() == BatchSize || i + 1 == edits) {
+          batchEditor.apply(batchEdits);
+          batchEdits.clear();
+        }
+      }
+    });
+
+    double total = static_cast<double>(edits) * threads;
+    std::printf("%7u %13.0f %13.0f %15.0f\n", threads, total / global, total / chunk, total / batch);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,12 @@
+<?xml version="1.0" encoding="UTF-8"?>
+<tileset name="things" tilewidth="32" tileheight="32" tilecount="2">
+ <tileoffset x="0" y="4"/>
+ <tile id="0"><image width="32" height="32" source="a.png"/></tile>
+ <tile id="1">
+  <image width="32" height="32" source="b.png"/>
+  <objectgroup draworder="index">
+   <object id="1" x="0" y="16" width="32" height="16"/>
+   <object id="2" x="4" y="4"><polygon points="0,0 24,0 12,12"/></object>
+  </objectgroup>
+ </tile>
+</tileset>
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <zlib.h>
+
+#include <tmx/Map.h>
+#include <tmx/TileLayer.h>
+
+namespace fs = boost::filesystem;
+
+static const unsigned LayerCount = 4;
+
+static std::vector<unsigned> makeCells(unsigned size, unsigned layer) {
+  std::vector<unsigned> cells(size * size);
+
+  for (unsigned i = 0; i < cells.size(); ++i) {
+    cells[i] = (i * 7 + layer) % 97 < 60 ? (i / 13) % 50 + 1 : 0;
+  }
+
+  return cells;
+}
+
+static std::string makeCSV(const std::vector<unsigned>& cells) {
+  std::string csv;
+
+  for (auto gid : cells) {
+    if (!csv.empty()) {
+      csv += ',';
+    }
+
+    csv += std::to_string(gid);
+  }
+
+  return csv;
+}
+
+static std::string makeZlib(const std::vector<unsigned>& cells) {
+  static const char Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+  std::vector<uint8_t> raw;
+
+  for (auto gid : cells) {
+    for (unsigned shift = 0; shift < 32; shift += 8) {
+      raw.push_back((gid >> shift) & 0xFF);
+    }
+  }
+
+  uLongf size = compressBound(raw.size());
+  std::vector<uint8_t> compressed(size);
+  compress2(compressed.data(), &size, raw.data(), raw.size(), Z_BEST_COMPRESSION);
+  compressed.resize(size);
+
+  std::string base64;
+
+  for (std::size_t i = 0; i < compressed.size(); i += 3) {
+    uint32_t chunk = compressed[i] << 16;
+    std::size_t count = compressed.size() - i;
+
+    if (count > 1) {
+      chunk |= compressed[i + 1] << 8;
+    }
+
+    if (count > 2) {
+      chunk |= compressed[i + 2];
+    }
+
+    base64 += Alphabet[(chunk >> 18) & 0x3F];
+    base64 += Alphabet[(chunk >> 12) & 0x3F];
+    base64 += count > 1 ? Alphabet[(chunk >> 6) & 0x3F] : '=';
+    base64 += count > 2 ? Alphabet[chunk & 0x3F] : '=';
+  }
+
+  return base64;
+}
+
+static void writeMaps(const fs::path& directory, const std::string& name, unsigned size, bool zlib) {
+  std::string dimensions = "width=\"" + std::to_string(size) + "\" height=\"" + std::to_string(size) + "\"";
+  std::string tmx = "<?xml version=\"1.0\"?>\n<map version=\"1.0\" orientation=\"orthogonal\" " + dimensions + " tilewidth=\"16\" tileheight=\"16\">\n";
+  tmx += " <tileset firstgid=\"1\" name=\"a\" tilewidth=\"16\" tileheight=\"16\"/>\n";
+
+  std::string tmj = "{\"version\":\"1.0\",\"orientation\":\"orthogonal\",\"width\":" + std::to_string(size) + ",\"height\":" + std::to_string(size);
+  tmj += ",\"tilewidth\":16,\"tileheight\":16,\"tilesets\":[{\"firstgid\":1,\"name\":\"a\",\"tilewidth\":16,\"tileheight\":16}],\"layers\":[";
+
+  for (unsigned layer = 0; layer < LayerCount; ++layer) {
+    auto cells = makeCells(size, layer);
+    std::string layerName = "l" + std::to_string(layer);
+
+    tmx += " <layer name=\"" + layerName + "\" " + dimensions + ">";
+    tmj += std::string(layer == 0 ? "" : ",") + "{\"type\":\"tilelayer\",\"name\":\"" + layerName + "\",\"width\":" + std::to_string(size) + ",\"height\":" + std::to_string(size);
+
+    if (zlib) {
+      std::string data = makeZlib(cells);
+      tmx += "<data encoding=\"base64\" compression=\"zlib\">" + data + "</data>";
+      tmj += ",\"encoding\":\"base64\",\"compression\":\"zlib\",\"data\":\"" + data + "\"}";
+    } else {
+      std::string data = makeCSV(cells);
+      tmx += "<data encoding=\"csv\">" + data + "</data>";
+      tmj += ",\"data\":[" + data + "]}";
+    }
+
+    tmx += "</layer>\n";
+  }
+
+  tmx += "</map>\n";
+  tmj += "]}\n";
+
+  std::ofstream((directory / (name + ".tmx")).string().c_str()) << tmx;
+  std::ofstream((directory / (name + ".tmj")).string().c_str()) << tmj;
+}
+
+static bool haveSameCells(const tmx::Map& lhs, const tmx::Map& rhs) {
+  if (lhs.getLayerCount() != rhs.getLayerCount()) {
+    return false;
+  }
+
+  for (std::size_t i = 0; i < lhs.getLayerCount(); ++i) {
+    auto l = dynamic_cast<const tmx::TileLayer *>(lhs.getLayer(i));
+    auto r = dynamic_cast<const tmx::TileLayer *>(rhs.getLayer(i));
+
+    if (l == nullptr || r == nullptr || l->getCellCount() != r->getCellCount()) {
+      return false;
+    }
+
+    for (std::size_t k = 0; k < l->getCellCount(); ++k) {
+      if (l->getCell(k).getRawGID() != r->getCell(k).getRawGID()) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+static double measure(const fs::path& filename, unsigned repeat) {
+  auto start = std::chrono::steady_clock::now();
+
+  for (unsigned i = 0; i < repeat; ++i) {
+    if (!tmx::Map::parseFile(filename)) {
+      std::printf("Could not load '%s'. Exiting.\n", filename.string().c_str());
+      std::exit(EXIT_FAILURE);
+    }
+  }
+
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / repeat;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 3) {
+    std::printf("Usage: tmx_load_benchmark [size] [repeat]\n");
+    return EXIT_FAILURE;
+  }
+
+  unsigned size = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 512;
+  unsigned repeat = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5;
+
+  if (size == 0 || repeat == 0) {
+    std::printf("The size and the repeat count must be positive. Exiting.\n");
+    return EXIT_FAILURE;
+  }
+
+  fs::path directory = fs::temp_directory_path() / fs::unique_path("tmx-benchmark-%%%%-%%%%");
+  fs::create_directories(directory);
+
+  int status = EXIT_SUCCESS;
+
+  for (auto name : { "csv", "zlib" }) {
+    writeMaps(directory, name, size, std::string(name) == "zlib");
+
+    fs::path tmx = directory / (std::string(name) + ".tmx");
+    fs::path tmj = directory / (std::string(name) + ".tmj");
+
+    auto tmxMap = tmx::Map::parseFile(tmx);
+    auto tmjMap = tmx::Map::parseFile(tmj);
+
+    if (!tmxMap || !tmjMap || !haveSameCells(*tmxMap, *tmjMap)) {
+      std::printf("Error! The TMX and TMJ %s maps differ.\n", name);
+      status = EXIT_FAILURE;
+      break;
+    }
+
+    std::printf("%-4s %ux%ux%u: TMX %.1f ms, TMJ %.1f ms\n", name, size, size, LayerCount, measure(tmx, repeat), measure(tmj, repeat));
+  }
+
+  fs::remove_all(directory);
+  return status;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <string>
+
+#include <tmx/Map.h>
+#include <tmx/MapDiff.h>
+#include <tmx/MapEditor.h>
+#include <tmx/Object.h>
+#include <tmx/ObjectLayer.h>
+#include <tmx/ObjectTemplate.h>
+
+static bool check(bool condition, const char *message) {
+  if (!condition) {
+    std::printf("Error! %s\n", message);
+  }
+
+  return condition;
+}
+
+// applies the patch from 'from' to 'to' on 'client', that must then be saved like 'to'
+static bool checkRoundTrip(const tmx::Map& from, const tmx::Map& to, tmx::Map& client, const boost::filesystem::path& base) {
+  auto patch = tmx::diff(from, to);
+  bool ok = check(!patch.empty(), "The maps could not be compared.");
+  ok = check(tmx::apply(client, patch), "The patch could not be applied.") && ok;
+
+  // the ids of the objects of the patch are not allocated again on the client
+  ok = check(client.getNextObjectId() == to.getNextObjectId(), "The next object id is not part of the patch.") && ok;
+  ok = check(client.saveMemory(tmx::LayerEncoding::CSV, base) == to.saveMemory(tmx::LayerEncoding::CSV, base), "The patched map differs from the modified map.") && ok;
+  return ok;
+}
+
+static bool testEdits() {
+  static const unsigned GroundLayer = 0;
+  static const unsigned ObjectLayerIndex = 3;
+
+  boost::filesystem::path base = boost::filesystem::path(TMX_TESTS_DATA) / "parity";
+
+  auto from = tmx::Map::parseFile(base / "map.tmx");
+  auto to = tmx::Map::parseFile(base / "map.tmx");
+  auto client = tmx::Map::parseFile(base / "map.tmx");
+
+  if (!from || !to || !client) {
+    return false;
+  }
+
+  tmx::MapEditor editor(*to);
+  editor.setCell(GroundLayer, 1, 2, tmx::Cell(7, true));
+  editor.setProperty("music", "boss.ogg");
+  editor.removeObject(ObjectLayerIndex, 2);
+
+  unsigned id = editor.allocateObjectId();
+  editor.addObject(ObjectLayerIndex, std::unique_ptr<tmx::Object>(new tmx::Rectangle(id, "door", "exit", { 48, 16 }, 0.0, true, 16, 32)));
+  editor.setObjectProperty(ObjectLayerIndex, id, "target", "cave.tmx");
+
+  return checkRoundTrip(*from, *to, *client, base);
+}
+
+static bool testTemplates() {
+  static const unsigned ObjectLayerIndex = 1;
+
+  boost::filesystem::path base = boost::filesystem::path(TMX_TESTS_DATA) / "diff";
+
+  auto from = tmx::Map::parseFile(base / "map.tmx");
+  auto to = tmx::Map::parseFile(base / "map.tmx");
+  auto client = tmx::Map::parseFile(base / "map.tmx");
+  auto zone = tmx::ObjectTemplate::load(base / "zone.tx");
+
+  if (!from || !to || !client || !zone) {
+    return false;
+  }
+
+  // a new instance in the middle of the layer, that shares the points of its template
+  auto object = std::unique_ptr<tmx::Polygon>(new tmx::Polygon(to->allocateObjectId(), "", "", { 48, 48 }, 45.0, true));
+  object->sharePoints(static_cast<const tmx::Chain&>(zone->getObject()));
+  object->setTemplate(zone);
+  object->setProperty("depth", "2");
+
+  auto layer = static_cast<tmx::ObjectLayer *>(to->getLayer(ObjectLayerIndex));
+  layer->insertObject(1, std::move(object));
+
+  // a modified instance that overrides a property of its template
+  tmx::MapEditor editor(*to);
+  editor.setObjectProperty(ObjectLayerIndex, 1, "b", "5");
+
+  bool ok = checkRoundTrip(*from, *to, *client, base);
+
+  auto patched = static_cast<const tmx::ObjectLayer *>(client->getLayer(ObjectLayerIndex));
+  auto inserted = *std::next(patched->begin());
+  ok = check(inserted->getTemplate() == zone, "The new object is not an instance of its template.") && ok;
+  ok = check(inserted->isChain() && static_cast<const tmx::Chain *>(inserted)->sharesPoints(static_cast<const tmx::Chain&>(zone->getObject())), "The new object does not share the points of its template.") && ok;
+  ok = check(inserted->getProperty("kind", "") == "water", "The new object does not have the properties of its template.") && ok;
+  return ok;
+}
+
+int main() {
+  bool ok = testEdits();
+  ok = testTemplates() && ok;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
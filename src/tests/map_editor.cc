@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <tmx/Map.h>
+#include <tmx/MapEditor.h>
+
+static const unsigned GroundLayer = 0;
+static const unsigned DecorLayer = 1;
+static const unsigned DetailsLayer = 2;
+static const unsigned ThingsLayer = 4;
+
+static bool check(bool condition, const char *message) {
+  if (!condition) {
+    std::printf("Error! %s\n", message);
+  }
+
+  return condition;
+}
+
+static bool isOnlyChunk(const std::vector<tmx::Vector2u>& chunks, unsigned x, unsigned y) {
+  return chunks.size() == 1 && chunks.front().x == x && chunks.front().y == y;
+}
+
+static bool testNoChange(tmx::MapEditor& editor) {
+  // setting the current value is not a change
+  bool ok = check(editor.setCell(GroundLayer, 1, 1, editor.getCell(GroundLayer, 1, 1)), "An existing cell can not be set.");
+  ok = check(!editor.setCell(GroundLayer, 4, 0, tmx::Cell(1)) && !editor.setCell(ThingsLayer, 0, 0, tmx::Cell(1)), "A cell outside a tile layer can be set.") && ok;
+  ok = check(!editor.setProperty("title", "sample"), "A property set to its value is a change.") && ok;
+  ok = check(!editor.setLayerProperty(DecorLayer, "kind", "decor"), "A layer property set to its value is a change.") && ok;
+  ok = check(!editor.setObjectProperty(ThingsLayer, 1, "gold", "12"), "An object property set to its value is a change.") && ok;
+  ok = check(!editor.removeProperty("missing") && editor.removeObject(ThingsLayer, 42) == nullptr, "Removing nothing is a change.") && ok;
+  ok = check(editor.getDirtySet().isEmpty(), "The dirty set is not empty without a change.") && ok;
+  return ok;
+}
+
+static bool testChanges(tmx::MapEditor& editor) {
+  editor.setCell(GroundLayer, 3, 2, tmx::Cell(7));
+  editor.setCell(GroundLayer, 2, 3, tmx::Cell(8));
+  editor.setCell(DetailsLayer, 0, 0, tmx::Cell(5, true));
+  editor.setProperty("title", "other");
+  editor.setLayerProperty(DecorLayer, "kind", "ruins");
+  editor.setObjectProperty(ThingsLayer, 1, "gold", "13");
+  editor.removeObject(ThingsLayer, 2);
+
+  const tmx::DirtySet& dirty = editor.getDirtySet();
+
+  // the two cells are in the same chunk, the layers of the groups are edited too
+  bool ok = check(dirty.getDirtyLayers() == std::vector<unsigned>({ GroundLayer, DetailsLayer }), "The dirty layers are wrong.");
+  ok = check(isOnlyChunk(dirty.getDirtyChunks(GroundLayer), 1, 1) && isOnlyChunk(dirty.getDirtyChunks(DetailsLayer), 0, 0), "The dirty chunks are wrong.") && ok;
+  ok = check(dirty.isChunkDirty(GroundLayer, { 1, 1 }) && !dirty.isChunkDirty(GroundLayer, { 0, 0 }), "The dirty state of a chunk is wrong.") && ok;
+  ok = check(editor.getCell(DetailsLayer, 0, 0).getGID() == 5 && editor.getCell(DetailsLayer, 0, 0).isHorizontallyFlipped(), "The cell has not been set.") && ok;
+
+  std::set<std::pair<unsigned, unsigned>> objects = { { ThingsLayer, 1 }, { ThingsLayer, 2 } };
+  ok = check(dirty.getDirtyObjects() == objects, "The dirty objects are wrong.") && ok;
+  ok = check(dirty.getDirtyProperties() == std::set<std::string>({ "title" }), "The dirty properties of the map are wrong.") && ok;
+  ok = check(dirty.getDirtyLayerProperties().size() == 1 && dirty.getDirtyLayerProperties().begin()->first == DecorLayer, "The dirty properties of the layers are wrong.") && ok;
+
+  // the changes are taken once
+  tmx::DirtySet taken = editor.takeDirtySet();
+  ok = check(!taken.isEmpty() && taken.getDirtyObjects() == objects, "The taken dirty set is wrong.") && ok;
+  ok = check(editor.getDirtySet().isEmpty(), "The dirty set is not empty after it has been taken.") && ok;
+
+  editor.setCell(GroundLayer, 0, 0, tmx::Cell(2));
+  taken.merge(editor.getDirtySet());
+  ok = check(taken.getDirtyChunks(GroundLayer).size() == 2 && taken.getDirtyObjects() == objects, "The merged dirty set is wrong.") && ok;
+
+  taken.clear();
+  ok = check(taken.isEmpty() && taken.getDirtyLayers().empty(), "The cleared dirty set is not empty.") && ok;
+  return ok;
+}
+
+static bool testGeometry() {
+  // the chunks on the edges of the map are clipped
+  tmx::DirtySet dirty(5, 3, 2);
+  bool ok = check(dirty.getChunkCount().x == 3 && dirty.getChunkCount().y == 2, "The number of chunks is wrong.");
+
+  tmx::Rect rect = dirty.getChunkRect({ 2, 1 });
+  ok = check(rect.x == 4 && rect.y == 2 && rect.width == 1 && rect.height == 1, "The rectangle of a chunk is not clipped.") && ok;
+
+  dirty.markCell(3, 4, 2);
+  ok = check(dirty.getDirtyLayers() == std::vector<unsigned>({ 3 }) && isOnlyChunk(dirty.getDirtyChunks(3), 2, 1), "The chunk of a cell on the edge is wrong.") && ok;
+  return ok;
+}
+
+int main() {
+  boost::filesystem::path filename = boost::filesystem::path(TMX_TESTS_DATA) / "sample.tmx";
+
+  auto map = tmx::Map::parseFile(filename);
+
+  if (!map) {
+    return EXIT_FAILURE;
+  }
+
+  tmx::MapEditor editor(*map, 2);
+
+  bool ok = testNoChange(editor);
+  ok = testChanges(editor) && ok;
+  ok = testGeometry() && ok;
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
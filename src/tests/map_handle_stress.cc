@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tmx/Map.h>
+#include <tmx/MapEditor.h>
+#include <tmx/MapHandle.h>
+#include <tmx/TileLayer.h>
+
+static const unsigned ReaderCount = 8;
+static const unsigned GenerationCount = 200;
+
+static std::unique_ptr<const tmx::Map> makeGeneration(const boost::filesystem::path& filename, unsigned generation) {
+  auto map = tmx::Map::parseFile(filename);
+
+  if (!map) {
+    return nullptr;
+  }
+
+  tmx::MapEditor editor(*map);
+
+  for (unsigned y = 0; y < map->getHeight(); ++y) {
+    for (unsigned x = 0; x < map->getWidth(); ++x) {
+      editor.setCell(0, x, y, tmx::Cell(1 + generation % 8));
+    }
+  }
+
+  editor.setProperty("generation", std::to_string(generation));
+  return std::move(map);
+}
+
+// a snapshot must never mix the cells of a generation with the properties of another
+static bool isConsistent(const tmx::Map& map, unsigned& last) {
+  unsigned generation = std::stoul(map.getProperty("generation", "0"));
+
+  if (generation < last) {
+    std::printf("Error! Generation %u seen after generation %u.\n", generation, last);
+    return false;
+  }
+
+  last = generation;
+
+  auto layer = dynamic_cast<const tmx::TileLayer *>(map.getLayer(0));
+
+  if (layer == nullptr) {
+    std::printf("Error! The first layer is not a tile layer.\n");
+    return false;
+  }
+
+  for (auto& cell : *layer) {
+    if (cell.getGID() != 1 + generation % 8) {
+      std::printf("Error! Cell %u in generation %u.\n", cell.getGID(), generation);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int main() {
+  boost::filesystem::path filename = boost::filesystem::path(TMX_TESTS_DATA) / "sample.tmx";
+
+  auto first = makeGeneration(filename, 0);
+
+  if (!first) {
+    return EXIT_FAILURE;
+  }
+
+  tmx::MapHandle handle(std::move(first));
+
+  std::atomic<bool> done(false);
+  std::atomic<unsigned> failures(0);
+  std::atomic<unsigned long> reads(0);
+
+  std::vector<std::thread> readers;
+
+  for (unsigned i = 0; i < ReaderCount; ++i) {
+    readers.emplace_back([&]() {
+      unsigned last = 0;
+      unsigned long count = 0;
+
+      while (!done.load()) {
+        tmx::MapHandle::Snapshot snapshot = handle.acquire();
+
+        if (!snapshot || !isConsistent(*snapshot, last)) {
+          ++failures;
+          break;
+        }
+
+        // a nested acquisition must not see an older generation
+        tmx::MapHandle::Snapshot nested = handle.acquire();
+
+        if (!nested || !isConsistent(*nested, last)) {
+          ++failures;
+          break;
+        }
+
+        ++count;
+      }
+
+      reads += count;
+    });
+  }
+
+  std::thread writer([&]() {
+    for (unsigned generation = 1; generation <= GenerationCount; ++generation) {
+      auto map = makeGeneration(filename, generation);
+
+      if (!map) {
+        ++failures;
+        break;
+      }
+
+      handle.publish(std::move(map));
+      handle.reclaim();
+    }
+
+    done = true;
+  });
+
+  writer.join();
+
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  // every snapshot is released, so every retired map can be reclaimed
+  handle.reclaim();
+
+  if (handle.getRetiredCount() != 0) {
+    std::printf("Error! %zu maps are still retired.\n", handle.getRetiredCount());
+    ++failures;
+  }
+
+  if (handle.getVersion() < GenerationCount) {
+    std::printf("Error! Only %llu versions were published.\n", static_cast<unsigned long long>(handle.getVersion()));
+    ++failures;
+  }
+
+  std::printf("%lu reads during %u publications\n", reads.load(), GenerationCount);
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include <tmx/Map.h>
+#include <tmx/MapDiff.h>
+#include <tmx/MapInstance.h>
+#include <tmx/TileLayer.h>
+
+// the layers of the sample map, in the order of Map::getAllLayers()
+static const unsigned DecorGroup = 1;
+static const unsigned DetailsLayer = 2;
+static const unsigned ThingsLayer = 4;
+
+static bool check(bool condition, const char *message) {
+  if (!condition) {
+    std::printf("Error! %s\n", message);
+  }
+
+  return condition;
+}
+
+static unsigned getGID(const tmx::Map& map, unsigned layer, unsigned x, unsigned y) {
+  auto tileLayer = static_cast<const tmx::TileLayer *>(map.getAllLayers()[layer]);
+  return tileLayer->getCell(y * map.getWidth() + x).getGID();
+}
+
+int main() {
+  boost::filesystem::path filename = boost::filesystem::path(TMX_TESTS_DATA) / "sample.tmx";
+
+  std::shared_ptr<const tmx::Map> shared = tmx::Map::parseFile(filename);
+  auto patched = tmx::Map::parseFile(filename);
+
+  if (!shared || !patched) {
+    return EXIT_FAILURE;
+  }
+
+  auto instance = tmx::MapInstance::instantiate(shared);
+
+  // without changes, the map of the instance is a copy of the template
+  auto copy = instance->toMap();
+  bool ok = check(copy && copy->saveMemory(tmx::LayerEncoding::CSV) == shared->saveMemory(tmx::LayerEncoding::CSV), "The map of an unchanged instance differs from the template.");
+
+  instance->setCell(DetailsLayer, 3, 3, tmx::Cell(6));
+  instance->setProperty("level", "2");
+  instance->setLayerProperty(DecorGroup, "kind", "ruins");
+  instance->setObjectProperty(ThingsLayer, 1, "gold", "13");
+  instance->removeObject(ThingsLayer, 2);
+  instance->allocateObjectId();
+
+  auto map = instance->toMap();
+
+  if (!check(map != nullptr, "The instance can not be converted to a map.")) {
+    return EXIT_FAILURE;
+  }
+
+  auto things = static_cast<const tmx::ObjectLayer *>(map->getAllLayers()[ThingsLayer]);
+  ok = check(getGID(*map, DetailsLayer, 3, 3) == 6 && getGID(*shared, DetailsLayer, 3, 3) == 3, "The cells of the instance are not in the map.") && ok;
+  ok = check(map->getProperty("level", "") == "2" && map->getAllLayers()[DecorGroup]->getProperty("kind", "") == "ruins", "The properties of the instance are not in the map.") && ok;
+  ok = check(things->getObject(1) != nullptr && things->getObject(1)->getProperty("gold", "") == "13" && things->getObject(2) == nullptr, "The objects of the instance are not in the map.") && ok;
+  ok = check(map->getNextObjectId() == shared->getNextObjectId() + 1, "The next object id of the instance is not in the map.") && ok;
+
+  // the patch of the instance reproduces the instance on another copy of the template
+  auto patch = tmx::diff(*shared, *map);
+  ok = check(!patch.empty() && tmx::apply(*patched, patch), "The patch of the instance can not be applied.") && ok;
+  ok = check(patched->saveMemory(tmx::LayerEncoding::CSV) == map->saveMemory(tmx::LayerEncoding::CSV), "The patch of the instance does not reproduce the instance.") && ok;
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <tmx/Map.h>
+#include <tmx/MapReloader.h>
+#include <tmx/Object.h>
+#include <tmx/ObjectLayer.h>
+
+namespace fs = boost::filesystem;
+
+static bool check(bool condition, const char *message) {
+  if (!condition) {
+    std::printf("Error! %s\n", message);
+  }
+
+  return condition;
+}
+
+static void writeFile(const fs::path& filename, const std::string& content) {
+  std::ofstream(filename.string().c_str()) << content;
+}
+
+static std::string makeMap(const std::string& ground, const std::string& details) {
+  return "<map version=\"1.2\" orientation=\"orthogonal\" renderorder=\"right-down\" width=\"2\" height=\"2\" tilewidth=\"16\" tileheight=\"16\" nextobjectid=\"2\">"
+      "<tileset firstgid=\"1\" source=\"tiles.tsx\"/>"
+      "<layer name=\"ground\" width=\"2\" height=\"2\"><data encoding=\"csv\">" + ground + "</data></layer>"
+      "<layer name=\"details\" width=\"2\" height=\"2\"><data encoding=\"csv\">" + details + "</data></layer>"
+      "<objectgroup name=\"things\"><object id=\"1\" template=\"box.tx\" x=\"0\" y=\"0\"/></objectgroup>"
+      "</map>";
+}
+
+static std::string makeTileSet(unsigned tilecount) {
+  return "<tileset name=\"tiles\" tilewidth=\"16\" tileheight=\"16\" tilecount=\"" + std::to_string(tilecount) + "\"/>";
+}
+
+static std::string makeTemplate(const std::string& name) {
+  return "<template><object name=\"" + name + "\" width=\"8\" height=\"8\"/></template>";
+}
+
+static bool isOnly(const std::vector<std::string>& names, const char *name) {
+  return names.size() == 1 && names.front() == name;
+}
+
+int main() {
+  fs::path directory = fs::temp_directory_path() / fs::unique_path("tmx-%%%%-%%%%");
+  fs::create_directories(directory);
+  fs::path filename = directory / "map.tmx";
+
+  writeFile(filename, makeMap("1,2,3,4", "0,0,0,1"));
+  writeFile(directory / "tiles.tsx", makeTileSet(4));
+  writeFile(directory / "box.tx", makeTemplate("box"));
+
+  tmx::MapReloader reloader(filename);
+
+  auto report = reloader.reload();
+  bool ok = check(report.reloaded && reloader.getMap() != nullptr, "The map can not be loaded.");
+
+  if (!ok) {
+    fs::remove_all(directory);
+    return EXIT_FAILURE;
+  }
+
+  ok = check(report.changedLayers.size() == 3 && report.changedTileSets.size() == 1 && report.reusedLayers == 0, "The first load does not decode everything.") && ok;
+
+  const tmx::Layer *ground = reloader.getMap()->getLayer(0);
+  const tmx::Layer *details = reloader.getMap()->getLayer(1);
+
+  // nothing changed, everything is taken from the previous map
+  report = reloader.reload();
+  ok = check(report.reloaded && report.changedLayers.empty() && report.changedTileSets.empty(), "An unchanged map is decoded again.") && ok;
+  ok = check(report.reusedLayers == 3 && report.reusedTileSets == 1, "The unchanged elements are not reused.") && ok;
+  ok = check(reloader.getMap()->getLayer(0) == ground && reloader.getMap()->getLayer(1) == details, "A reused layer has moved.") && ok;
+
+  // only the changed layer is decoded
+  writeFile(filename, makeMap("1,2,3,4", "0,0,2,1"));
+  report = reloader.reload();
+  ok = check(isOnly(report.changedLayers, "details") && report.reusedLayers == 2 && report.changedTileSets.empty(), "The unchanged layers are decoded again.") && ok;
+  ok = check(reloader.getMap()->getLayer(0) == ground, "An unchanged layer has moved.") && ok;
+
+  // a change of an external tileset or a template is seen in the map file
+  writeFile(directory / "tiles.tsx", makeTileSet(8));
+  report = reloader.reload();
+  ok = check(isOnly(report.changedTileSets, "tiles") && report.changedLayers.empty(), "A changed external tileset is not decoded again.") && ok;
+
+  writeFile(directory / "box.tx", makeTemplate("crate"));
+  report = reloader.reload();
+  ok = check(isOnly(report.changedLayers, "things") && report.reusedLayers == 2, "The layer of a changed template is not decoded again.") && ok;
+
+  auto things = static_cast<const tmx::ObjectLayer *>(reloader.getMap()->getLayer(2));
+  ok = check(things->getObject(1) != nullptr && things->getObject(1)->getName() == "crate", "The new template is not used.") && ok;
+
+  // a file that is not a map keeps the previous map and its layers
+  writeFile(filename, "<tileset name=\"tiles\"/>");
+  report = reloader.reload();
+  ok = check(!report.reloaded && reloader.getMap() != nullptr && reloader.getMap()->getLayer(0) == ground, "A file that is not a map replaces the previous map.") && ok;
+
+  writeFile(filename, makeMap("1,2,3,4", "0,0,2,1"));
+  report = reloader.reload();
+  ok = check(report.reloaded && report.reusedLayers == 3 && reloader.getMap()->getLayer(0) == ground, "The layers are lost after a file that is not a map.") && ok;
+
+  fs::remove_all(directory);
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
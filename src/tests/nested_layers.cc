@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include <tmx/CompiledMap.h>
+#include <tmx/ConcurrentTileEditor.h>
+#include <tmx/GroupLayer.h>
+#include <tmx/Map.h>
+#include <tmx/MapEditor.h>
+#include <tmx/MapInstance.h>
+#include <tmx/RegionLoader.h>
+#include <tmx/TileLayer.h>
+
+// the layers of the sample map, in the order of Map::getAllLayers()
+static const unsigned DecorGroup = 1;
+static const unsigned DetailsLayer = 2;
+static const unsigned ThingsLayer = 4;
+
+static bool check(bool condition, const char *message) {
+  if (!condition) {
+    std::printf("Error! %s\n", message);
+  }
+
+  return condition;
+}
+
+static unsigned getGID(const tmx::Map& map, unsigned layer, unsigned x, unsigned y) {
+  auto tileLayer = static_cast<const tmx::TileLayer *>(map.getAllLayers()[layer]);
+  return tileLayer->getCell(y * map.getWidth() + x).getGID();
+}
+
+static bool testEditor(tmx::Map& map) {
+  tmx::MapEditor editor(map);
+
+  bool ok = check(editor.setCell(DetailsLayer, 1, 1, tmx::Cell(5)), "A nested tile layer can not be edited.");
+  ok = check(getGID(map, DetailsLayer, 1, 1) == 5 && editor.getCell(DetailsLayer, 1, 1).getGID() == 5, "The cell of the nested tile layer is not set.") && ok;
+  ok = check(editor.getDirtySet().getDirtyLayers() == std::vector<unsigned>{ DetailsLayer }, "The nested tile layer is not dirty.") && ok;
+  ok = check(editor.setObjectProperty(ThingsLayer, 1, "gold", "13"), "An object of a nested object layer can not be edited.") && ok;
+  ok = check(editor.setLayerProperty(DecorGroup, "kind", "ruins") && map.getAllLayers()[DecorGroup]->getProperty("kind", "") == "ruins", "A group can not be edited.") && ok;
+  return ok;
+}
+
+static bool testInstance(std::shared_ptr<const tmx::Map> map) {
+  auto instance = tmx::MapInstance::instantiate(map);
+
+  bool ok = check(instance->setCell(DetailsLayer, 3, 3, tmx::Cell(6)), "A nested tile layer of an instance can not be edited.");
+  ok = check(instance->getCell(DetailsLayer, 3, 3).getGID() == 6, "The cell of the instance is not set.") && ok;
+  ok = check(getGID(*map, DetailsLayer, 3, 3) == 3, "The template has been modified.") && ok;
+  ok = check(instance->getObject(ThingsLayer, 1) != nullptr, "The objects of a nested object layer are not in the instance.") && ok;
+  return ok;
+}
+
+static bool testConcurrentEditor(tmx::Map& map) {
+  tmx::ConcurrentTileEditor editor(map, DetailsLayer);
+
+  bool ok = check(editor.isValid(), "A nested tile layer can not be edited concurrently.");
+  ok = check(ok && editor.setCell(0, 0, tmx::Cell(8)) && getGID(map, DetailsLayer, 0, 0) == 8, "The cell of the nested tile layer is not set concurrently.") && ok;
+  return ok;
+}
+
+static bool testRegion(const tmx::Map& map) {
+  boost::filesystem::path filename = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("tmx-%%%%-%%%%.tmc");
+  std::vector<char> data = tmx::CompiledMap::compile(map);
+
+  {
+    std::ofstream file(filename.string(), std::ios::binary);
+    file.write(data.data(), data.size());
+  }
+
+  auto loader = tmx::RegionLoader::open(filename);
+  auto region = loader ? loader->loadRegion({ }, { 0, 0, 4, 4 }) : nullptr;
+  boost::filesystem::remove(filename);
+
+  // ground, details, things
+  bool ok = check(region && region->getLayerCount() == 3, "The region of the compiled map can not be loaded.");
+
+  if (ok) {
+    auto details = region->getLayer(1);
+    auto things = region->getLayer(2);
+    ok = check(details->getOffset().x == 11.5f && details->getOffset().y == 20.0f && details->getOpacity() == 0.25, "The region does not compose the offset of a layer and its group.") && ok;
+    ok = check(things->getOffset().x == 15.0f && things->getOffset().y == 23.0f && !things->isVisible(), "The region does not compose the offsets of the nested groups.") && ok;
+  }
+
+  return ok;
+}
+
+static bool testFlattened(tmx::Map& map) {
+  auto group = static_cast<tmx::GroupLayer *>(map.getAllLayers()[DecorGroup]);
+  group->setOpacity(0.25);
+  group->setVisible(false);
+  group->setOffset(100.0f, 200.0f);
+  group->addLayer(std::unique_ptr<tmx::Layer>(new tmx::TileLayer("late", 1.0, true)));
+
+  // ground, details, things, sky, late
+  auto flattened = map.getFlattenedLayers();
+  bool ok = check(flattened.size() == 5 && flattened[4].layer->getName() == "late", "A layer added to a group is not flattened.");
+
+  if (ok) {
+    // details has an opacity of 0.5 and an offset of (1.5, 0)
+    ok = check(flattened[1].opacity == 0.125 && !flattened[1].visible, "The opacity or the visibility of the group is stale.") && ok;
+    ok = check(flattened[1].offset.x == 101.5f && flattened[1].offset.y == 200.0f, "The offset of the group is stale.") && ok;
+  }
+
+  return ok;
+}
+
+int main() {
+  boost::filesystem::path filename = boost::filesystem::path(TMX_TESTS_DATA) / "sample.tmx";
+
+  std::shared_ptr<tmx::Map> edited = tmx::Map::parseFile(filename);
+  std::shared_ptr<const tmx::Map> shared = tmx::Map::parseFile(filename);
+
+  if (!edited || !shared) {
+    return EXIT_FAILURE;
+  }
+
+  bool ok = check(edited->getAllLayers().size() == 6 && edited->getAllLayers()[DetailsLayer]->getName() == "details", "The layers are not in depth-first order.");
+  ok = testEditor(*edited) && ok;
+  ok = testConcurrentEditor(*edited) && ok;
+  ok = testInstance(shared) && ok;
+  ok = testRegion(*shared) && ok;
+  ok = testFlattened(*edited) && ok;
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+
+#include <boost/filesystem.hpp>
+
+#include <tmx/Map.h>
+#include <tmx/Object.h>
+#include <tmx/ObjectLayer.h>
+#include <tmx/ObjectTemplate.h>
+
+namespace fs = boost::filesystem;
+
+static bool check(bool condition, const char *message) {
+  if (!condition) {
+    std::printf("Error! %s\n", message);
+  }
+
+  return condition;
+}
+
+static bool testDefaults() {
+  static const unsigned ObjectLayerIndex = 1;
+
+  fs::path base = fs::path(TMX_TESTS_DATA) / "diff";
+
+  auto map = tmx::Map::parseFile(base / "map.tmx");
+  auto other = tmx::Map::parseFile(base / "map.tmx");
+
+  if (!map || !other) {
+    return false;
+  }
+
+  auto layer = static_cast<const tmx::ObjectLayer *>(map->getLayer(ObjectLayerIndex));
+  auto box = layer->getObject(1);
+  auto zone = layer->getObject(2);
+  auto plain = layer->getObject(3);
+
+  if (!check(box != nullptr && zone != nullptr && plain != nullptr, "The objects of the map are missing.")) {
+    return false;
+  }
+
+  // the attributes of the instance override the ones of the template
+  bool ok = check(box->getTemplate() != nullptr && box->isRectangle(), "The instance does not have the kind of its template.");
+  ok = check(box->getName() == "special" && box->getType() == "crate", "The name or the type of the instance is wrong.") && ok;
+
+  if (box->isRectangle()) {
+    auto rectangle = static_cast<const tmx::Rectangle *>(box);
+    ok = check(rectangle->getWidth() == 64 && rectangle->getHeight() == 16, "The size of the instance is wrong.") && ok;
+  }
+
+  // the properties of the template are defaults, they are not copied in the instance
+  ok = check(box->getProperty("a", "") == "1" && box->getProperty("b", "") == "2", "The instance does not have the properties of its template.") && ok;
+  ok = check(box->getProperties().empty() && box->getAllProperties().size() == 2, "The properties of the template are copied in the instance.") && ok;
+
+  ok = check(zone->getName() == "zone" && zone->getRotation() == 45.0 && zone->getProperty("kind", "") == "water", "The instance does not have the defaults of its template.") && ok;
+
+  if (zone->isPolygon()) {
+    auto chain = static_cast<const tmx::Chain *>(zone);
+    ok = check(std::distance(chain->begin(), chain->end()) == 4 && chain->sharesPoints(static_cast<const tmx::Chain&>(zone->getTemplate()->getObject())), "The instance does not share the points of its template.") && ok;
+  } else {
+    ok = check(false, "The instance does not have the kind of its template.") && ok;
+  }
+
+  ok = check(plain->getTemplate() == nullptr && plain->getType().empty(), "An object without a template has defaults.") && ok;
+
+  // all the instances of a template share it, across the maps
+  auto otherLayer = static_cast<const tmx::ObjectLayer *>(other->getLayer(ObjectLayerIndex));
+  ok = check(otherLayer->getObject(1)->getTemplate() == box->getTemplate(), "The template is not shared by the maps.") && ok;
+  ok = check(tmx::ObjectTemplate::load(base / "box.tx") == box->getTemplate(), "The template is not cached.") && ok;
+  return ok;
+}
+
+static bool testReload() {
+  fs::path directory = fs::temp_directory_path() / fs::unique_path("tmx-%%%%-%%%%");
+  fs::create_directories(directory);
+  fs::path filename = directory / "crate.tx";
+
+  std::ofstream(filename.string().c_str()) << "<template><object name=\"crate\" width=\"8\" height=\"8\"/></template>";
+  auto first = tmx::ObjectTemplate::load(filename);
+  auto same = tmx::ObjectTemplate::load(filename);
+
+  // a changed file gives a new template, the previous one is still valid
+  std::ofstream(filename.string().c_str()) << "<template><object name=\"barrel\" width=\"8\" height=\"8\"/></template>";
+  auto second = tmx::ObjectTemplate::load(filename);
+
+  bool ok = check(first != nullptr && first == same, "An unchanged template is parsed again.");
+  ok = check(second != nullptr && second != first && second->getObject().getName() == "barrel", "A changed template is not parsed again.") && ok;
+  ok = check(first && first->getObject().getName() == "crate", "The previous template has been modified.") && ok;
+
+  // a removed file drops the template
+  fs::remove(filename);
+  ok = check(tmx::ObjectTemplate::load(filename) == nullptr, "A removed template is still loaded.") && ok;
+
+  fs::remove_all(directory);
+  return ok;
+}
+
+int main() {
+  bool ok = testDefaults();
+  ok = testReload() && ok;
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+
+#include <tmx/GroupLayer.h>
+#include <tmx/Map.h>
+#include <tmx/ObjectLayer.h>
+#include <tmx/ParseVisitor.h>
+#include <tmx/Tile.h>
+#include <tmx/TileSet.h>
+
+namespace {
+
+  class ObjectDiscarder : public tmx::ParseVisitor {
+  public:
+    virtual tmx::ParseAction visitObject(const tmx::Map& map, const tmx::ObjectLayer& layer, const tmx::Object& object) override {
+      return tmx::ParseAction::DISCARD;
+    }
+  };
+
+  class GroupFilter : public tmx::ParseVisitor {
+  public:
+    GroupFilter()
+    : tileLayers(0)
+    , groupLayers(0)
+    , hiddenLayers(0)
+    {
+    }
+
+    virtual tmx::ParseAction visitTileLayer(const tmx::Map& map, const tmx::TileLayer& layer) override {
+      ++tileLayers;
+      return tmx::ParseAction::KEEP;
+    }
+
+    virtual tmx::ParseAction visitGroupLayer(const tmx::Map& map, const tmx::GroupLayer& layer) override {
+      ++groupLayers;
+
+      if (layer.getName() != "hidden") {
+        return tmx::ParseAction::KEEP;
+      }
+
+      hiddenLayers = layer.getLayerCount();
+      return tmx::ParseAction::DISCARD;
+    }
+
+    int tileLayers;
+    int groupLayers;
+    std::size_t hiddenLayers;
+  };
+
+  int testGroups(const boost::filesystem::path& filename) {
+    GroupFilter visitor;
+    auto map = tmx::Map::parseFile(filename, visitor);
+
+    if (!map) {
+      return 1;
+    }
+
+    int failures = 0;
+
+    // the nested layers are visited like the layers of the map
+    if (visitor.tileLayers != 2 || visitor.groupLayers != 2) {
+      std::printf("Error! The layers of the groups have not been visited.\n");
+      ++failures;
+    }
+
+    if (visitor.hiddenLayers != 1) {
+      std::printf("Error! The group has been visited before its layers.\n");
+      ++failures;
+    }
+
+    auto layers = map->getAllLayers();
+
+    if (layers.size() != 4 || layers[3]->getName() != "sky") {
+      std::printf("Error! The nested group has not been discarded.\n");
+      ++failures;
+    }
+
+    return failures;
+  }
+
+}
+
+int main() {
+  boost::filesystem::path filename = boost::filesystem::path(TMX_TESTS_DATA) / "sample.tmx";
+
+  ObjectDiscarder visitor;
+  auto map = tmx::Map::parseFile(filename, visitor);
+
+  if (!map) {
+    return EXIT_FAILURE;
+  }
+
+  int failures = 0;
+
+  for (auto& flattened : map->getFlattenedLayers()) {
+    auto layer = dynamic_cast<const tmx::ObjectLayer *>(flattened.layer);
+
+    if (layer != nullptr && layer->begin() != layer->end()) {
+      std::printf("Error! The objects of '%s' have not been discarded.\n", layer->getName().c_str());
+      ++failures;
+    }
+  }
+
+  // the collision shapes of the tiles are not objects of the map
+  auto tile = (*map->getTileSets().begin())->getTile(2);
+
+  if (tile == nullptr || !tile->hasObjects() || std::distance(tile->getObjects()->begin(), tile->getObjects()->end()) != 2) {
+    std::printf("Error! The collision shapes of the tile have been discarded.\n");
+    ++failures;
+  }
+
+  failures += testGroups(filename);
+
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
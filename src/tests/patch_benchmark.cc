@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <tmx/Map.h>
+#include <tmx/MapDiff.h>
+#include <tmx/MapEditor.h>
+#include <tmx/TileLayer.h>
+
+static const unsigned LayerCount = 4;
+
+static std::unique_ptr<tmx::Map> makeMap(unsigned size) {
+  std::unique_ptr<tmx::Map> map(new tmx::Map("1.0", tmx::Orientation::ORTHOGONAL, size, size, 16, 16, "",
+      tmx::RenderOrder::RIGHT_DOWN, 0, tmx::StaggerAxis::Y, tmx::StaggerIndex::ODD, 1));
+
+  for (unsigned layer = 0; layer < LayerCount; ++layer) {
+    std::unique_ptr<tmx::TileLayer> tileLayer(new tmx::TileLayer("l" + std::to_string(layer), 1.0, true));
+
+    for (unsigned i = 0; i < size * size; ++i) {
+      tileLayer->addCell(tmx::Cell((i * 7 + layer) % 97 < 60 ? (i / 13) % 50 + 1 : 0));
+    }
+
+    map->addLayer(std::move(tileLayer));
+  }
+
+  return map;
+}
+
+// scattered edits touch random cells, clustered edits fill a square of the first layer
+static void edit(tmx::Map& map, unsigned count, bool clustered) {
+  tmx::MapEditor editor(map);
+  unsigned size = map.getWidth();
+  uint32_t state = 1;
+
+  for (unsigned i = 0; i < count; ++i) {
+    unsigned x, y, layer;
+
+    if (clustered) {
+      unsigned side = 1;
+
+      while (side * side < count) {
+        ++side;
+      }
+
+      x = i % side;
+      y = i / side;
+      layer = 0;
+    } else {
+      state = state * 1664525u + 1013904223u;
+      uint32_t position = (state >> 8) % (size * size * LayerCount);
+      x = position % size;
+      y = (position / size) % size;
+      layer = position / (size * size);
+    }
+
+    editor.setCell(layer, x, y, tmx::Cell(100 + i % 8));
+  }
+}
+
+static bool haveSameCells(const tmx::Map& lhs, const tmx::Map& rhs) {
+  for (std::size_t i = 0; i < LayerCount; ++i) {
+    auto l = static_cast<const tmx::TileLayer *>(lhs.getLayer(i));
+    auto r = static_cast<const tmx::TileLayer *>(rhs.getLayer(i));
+
+    for (std::size_t k = 0; k < l->getCellCount(); ++k) {
+      if (l->getCell(k).getRawGID() != r->getCell(k).getRawGID()) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+template<typename Function>
+static double measure(unsigned repeat, Function function) {
+  auto start = std::chrono::steady_clock::now();
+
+  for (unsigned i = 0; i < repeat; ++i) {
+    function();
+  }
+
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / repeat;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 3) {
+    std::printf("Usage: tmx_patch_benchmark [size] [repeat]\n");
+    return EXIT_FAILURE;
+  }
+
+  unsigned size = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 512;
+  unsigned repeat = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5;
+
+  if (size == 0 || repeat == 0) {
+    std::printf("The size and the repeat count must be positive. Exiting.\n");
+    return EXIT_FAILURE;
+  }
+
+  auto original = makeMap(size);
+  std::string full;
+  double saveTime = measure(repeat, [&]() { full = original->saveMemory(tmx::LayerEncoding::BASE64_ZLIB); });
+
+  std::printf("%ux%ux%u: full save %zu bytes in %.1f ms\n", size, size, LayerCount, full.size(), saveTime);
+
+  unsigned total = size * size * LayerCount;
+
+  for (unsigned permille : { 1, 10, 100 }) {
+    for (bool clustered : { false, true }) {
+      unsigned count = std::max(1u, total / 1000 * permille);
+      auto modified = makeMap(size);
+      edit(*modified, count, clustered);
+
+      std::vector<char> patch;
+      double diffTime = measure(repeat, [&]() { patch = tmx::diff(*original, *modified); });
+
+      std::vector<std::unique_ptr<tmx::Map>> targets;
+
+      for (unsigned i = 0; i < repeat; ++i) {
+        targets.push_back(makeMap(size));
+      }
+
+      unsigned next = 0;
+      bool applied = true;
+      double applyTime = measure(repeat, [&]() { applied = tmx::apply(*targets[next++], patch) && applied; });
+
+      if (!applied || !haveSameCells(*targets.front(), *modified)) {
+        std::printf("Error! The patch does not reproduce the modified map.\n");
+        return EXIT_FAILURE;
+      }
+
+      std::printf("%5.1f%% %-9s: patch %zu bytes (%.2f%% of the save), diff %.1f ms, apply %.1f ms\n",
+          permille / 10.0, clustered ? "clustered" : "scattered", patch.size(), 100.0 * patch.size() / full.size(), diffTime, applyTime);
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
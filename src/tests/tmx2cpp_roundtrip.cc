@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <tmx/Map.h>
+
+#include "sample.h"
+
+int main() {
+  boost::filesystem::path base(TMX_TESTS_DATA);
+
+  auto expected = tmx::Map::parseFile(base / "sample.tmx");
+
+  if (!expected) {
+    return EXIT_FAILURE;
+  }
+
+  auto actual = sample().toMap();
+
+  if (!actual) {
+    std::printf("Error! Could not rebuild the map from the generated header.\n");
+    return EXIT_FAILURE;
+  }
+
+  std::string expectedContent = expected->saveMemory(tmx::LayerEncoding::CSV, base);
+  std::string actualContent = actual->saveMemory(tmx::LayerEncoding::CSV, base);
+
+  if (actualContent != expectedContent) {
+    std::printf("Error! The map from the generated header differs from the parsed map.\n");
+    std::printf("Expected:\n%s\nActual:\n%s\n", expectedContent.c_str(), actualContent.c_str());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
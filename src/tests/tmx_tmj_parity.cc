@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include <tmx/Map.h>
+#include <tmx/ParseVisitor.h>
+
+static const char *Variants[] = {
+  "map.tmj",      // JSON map with the current property layout and a TSJ tileset
+  "map_old.json", // JSON map with the old property layout
+  "map_tsx.tmj",  // JSON map with a TSX tileset
+  "map_tsj.tmx",  // TMX map with a TSJ tileset
+};
+
+namespace {
+
+  class ObjectDiscarder : public tmx::ParseVisitor {
+  public:
+    virtual tmx::ParseAction visitObject(const tmx::Map& map, const tmx::ObjectLayer& layer, const tmx::Object& object) override {
+      return tmx::ParseAction::DISCARD;
+    }
+  };
+
+}
+
+static std::unique_ptr<tmx::Map> parse(const boost::filesystem::path& filename, tmx::ParseVisitor *visitor) {
+  return visitor ? tmx::Map::parseFile(filename, *visitor) : tmx::Map::parseFile(filename);
+}
+
+static int compareVariants(const boost::filesystem::path& base, tmx::ParseVisitor *visitor) {
+  auto reference = parse(base / "map.tmx", visitor);
+
+  if (!reference) {
+    return 1;
+  }
+
+  // the writer puts every tileset inline, so the outputs only differ if the maps differ
+  std::string expected = reference->saveMemory(tmx::LayerEncoding::CSV, base);
+  int failures = 0;
+
+  for (auto variant : Variants) {
+    auto map = parse(base / variant, visitor);
+
+    if (!map) {
+      ++failures;
+      continue;
+    }
+
+    std::string actual = map->saveMemory(tmx::LayerEncoding::CSV, base);
+
+    if (actual != expected) {
+      std::printf("Error! '%s' differs from 'map.tmx'%s.\n", variant, visitor ? " with a visitor" : "");
+      std::printf("Expected:\n%s\nActual:\n%s\n", expected.c_str(), actual.c_str());
+      ++failures;
+    }
+  }
+
+  return failures;
+}
+
+int main() {
+  boost::filesystem::path base = boost::filesystem::path(TMX_TESTS_DATA) / "parity";
+
+  // the external tilesets are parsed while a visitor is active, in both formats
+  ObjectDiscarder visitor;
+  int failures = compareVariants(base, nullptr) + compareVariants(base, &visitor);
+
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <cstdio>
+#include <cstdlib>
+
+#include <boost/filesystem.hpp>
+
+#include <tmx/Map.h>
+#include <tmx/World.h>
+
+static bool check(bool condition, const char *message) {
+  if (!condition) {
+    std::printf("Error! %s\n", message);
+  }
+
+  return condition;
+}
+
+static bool isMap(const tmx::WorldMap& map, const char *name, int x, int y, unsigned width, unsigned height) {
+  return map.fileName.filename() == name && map.x == x && map.y == y && map.width == width && map.height == height;
+}
+
+int main() {
+  boost::filesystem::path filename = boost::filesystem::path(TMX_TESTS_DATA) / "world" / "world.world";
+
+  auto world = tmx::World::parseFile(filename);
+
+  if (!world) {
+    return EXIT_FAILURE;
+  }
+
+  // the explicit maps come first, then the files that match the patterns, in the order of their names
+  auto& maps = world->getMaps();
+  bool ok = check(maps.size() == 4, "The patterns do not match the right files.");
+
+  if (ok) {
+    ok = check(isMap(maps[0], "hub.tmx", -128, 0, 128, 64), "The explicit map is wrong.") && ok;
+    ok = check(isMap(maps[1], "area_0_-1.tmx", 0, -64, 64, 64), "A negative coordinate of a pattern is wrong.") && ok;
+    ok = check(isMap(maps[2], "area_0_0.tmx", 0, 0, 64, 64), "A map of a pattern is wrong.") && ok;
+    ok = check(isMap(maps[3], "area_1_0.tmx", 64, 0, 64, 64), "The multiplier of a pattern is not applied.") && ok;
+  }
+
+  ok = check(world->findMapAt(-10, 10) == 0 && world->findMapAt(70, 10) == 3 && world->findMapAt(10, -10) == 1, "The maps are not found at their position.") && ok;
+  ok = check(world->findMapAt(200, 200) == tmx::World::NoMap, "A map is found outside the world.") && ok;
+
+  auto map = world->getMapAt(70, 10);
+  ok = check(map && map->getWidth() == 2, "A map of a pattern can not be loaded.") && ok;
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2013-2014, Julien Bernard
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tmx/Executor.h>
+#include <tmx/Map.h>
+#include <tmx/TileLayer.h>
+#include <tmx/WorkStealingExecutor.h>
+
+namespace {
+
+  // runs the tasks in the calling thread, so the layers are encoded one after the other
+  class InlineExecutor : public tmx::Executor {
+  public:
+    virtual void execute(std::function<void()> task) override {
+      task();
+    }
+  };
+
+}
+
+static std::unique_ptr<tmx::Map> makeMap(unsigned size, unsigned layers) {
+  std::unique_ptr<tmx::Map> map(new tmx::Map("1.0", tmx::Orientation::ORTHOGONAL, size, size, 16, 16, "",
+      tmx::RenderOrder::RIGHT_DOWN, 0, tmx::StaggerAxis::Y, tmx::StaggerIndex::ODD, 1));
+
+  for (unsigned layer = 0; layer < layers; ++layer) {
+    std::unique_ptr<tmx::TileLayer> tileLayer(new tmx::TileLayer("l" + std::to_string(layer), 1.0, true));
+
+    for (unsigned i = 0; i < size * size; ++i) {
+      tileLayer->addCell(tmx::Cell((i * 7 + layer) % 97 < 60 ? (i / 13) % 50 + 1 : 0));
+    }
+
+    map->addLayer(std::move(tileLayer));
+  }
+
+  return map;
+}
+
+static double measure(const tmx::Map& map, tmx::LayerEncoding encoding, tmx::Executor& executor, unsigned repeat, std::string& output) {
+  auto start = std::chrono::steady_clock::now();
+
+  for (unsigned i = 0; i < repeat; ++i) {
+    output = map.saveMemory(encoding, boost::filesystem::path(), executor);
+  }
+
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / repeat;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 4) {
+    std::printf("Usage: tmx_writer_benchmark [size] [layers] [repeat]\n");
+    return EXIT_FAILURE;
+  }
+
+  unsigned size = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 512;
+  unsigned layers = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 8;
+  unsigned repeat = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 5;
+
+  if (size == 0 || layers == 0 || repeat == 0) {
+    std::printf("The size, the number of layers and the repeat count must be positive. Exiting.\n");
+    return EXIT_FAILURE;
+  }
+
+  auto map = makeMap(size, layers);
+
+  InlineExecutor sequential;
+  tmx::WorkStealingExecutor parallel;
+
+  struct {
+    const char *name;
+    tmx::LayerEncoding encoding;
+  } encodings[] = {
+    { "csv", tmx::LayerEncoding::CSV },
+    { "zlib", tmx::LayerEncoding::BASE64_ZLIB },
+    { "gzip", tmx::LayerEncoding::BASE64_GZIP },
+  };
+
+  std::printf("%ux%ux%u, %u threads\n", size, size, layers, std::max(1u, std::thread::hardware_concurrency()));
+
+  for (auto& encoding : encodings) {
+    std::string sequentialOutput, parallelOutput;
+    double sequentialTime = measure(*map, encoding.encoding, sequential, repeat, sequentialOutput);
+    double parallelTime = measure(*map, encoding.encoding, parallel, repeat, parallelOutput);
+
+    if (sequentialOutput != parallelOutput) {
+      std::printf("Error! The parallel output differs from the sequential output.\n");
+      return EXIT_FAILURE;
+    }
+
+    std::printf("%-4s: sequential %.1f ms, parallel %.1f ms (%.1fx), %zu bytes\n", encoding.name,
+        sequentialTime, parallelTime, sequentialTime / parallelTime, parallelOutput.size());
+  }
+
+  return EXIT_SUCCESS;
+}